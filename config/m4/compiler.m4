@@ -246,6 +246,16 @@ CHECK_SPECIFIC_ATTRIBUTE([optimize], [NOOPTIMIZE],
                          [int foo (int arg) __attribute__ ((optimize("O0")));])
 
 
+#
+# Check for compiler attribute which enables instruction sets per-function,
+# used to select vector memory copy routines at runtime.
+#
+CHECK_SPECIFIC_ATTRIBUTE([target], [TARGET],
+                         [#include <immintrin.h>
+                          __attribute__ ((target("avx512f")))
+                          void foo (void *p) { _mm512_stream_si512(p, _mm512_setzero_si512()); }])
+
+
 #
 # Check for C++11 support
 #
@@ -226,6 +226,7 @@ build_release_pkg() {
 
 	# Show UCX info
 	./src/tools/info/ucx_info -s -f -c -v -y -d -b -p -w -e -uart
+	./src/tools/info/ucx_info -P -uarts -m 1:1048576
 
 	if [ -f /etc/redhat-release -o -f /etc/fedora-release ]; then
 		rpm_based=yes
@@ -643,6 +644,30 @@ run_ucx_perftest_mpi() {
 	fi
 }
 
+#
+# Run UCX performance test with locally launched processes
+#
+run_ucx_perftest_local() {
+	echo "==== Running ucx_perf with local processes ===="
+	for pattern in pair incast alltoall
+	do
+		UCX_TLS=self,mm ./src/tools/perf/ucx_perftest -l 4 -L $pattern \
+			-t tag_bw -n 1000 -w 10
+	done
+
+	# Every thread uses its own worker, so a multi-thread build is not required
+	UCX_TLS=self,mm ./src/tools/perf/ucx_perftest -l 2 -T 2 -e worker \
+		-t tag_bw -n 1000 -w 10
+
+	echo "==== Running ucx_perf baseline comparison ===="
+	results=$(mktemp)
+	UCX_TLS=self,mm ../contrib/ucx_perftest_compare.py run -o $results \
+		-p ./src/tools/perf/ucx_perftest -- -l 2 -n 1000 -w 10 \
+		-b ../contrib/ucx_perftest_config/test_types_ucp
+	../contrib/ucx_perftest_compare.py compare -s $results $results
+	rm -f $results
+}
+
 #
 # Test malloc hooks with mpi
 #
@@ -731,6 +756,18 @@ test_dlopen() {
 	! grep '^socket' strace.log
 }
 
+#
+# Run UCS data structures and UCT active message microbenchmarks with few
+# iterations, to make sure they work, including the multi-threaded mode
+#
+run_ucs_bench() {
+	echo "==== Running UCS microbenchmarks ===="
+	./test/bench/ucs_bench -n 100 -r 1
+	./test/bench/ucs_bench -n 100 -r 1 -t 4 -f json
+	./test/bench/uct_am_bench -x mm -d posix -n 1000 -r 1
+	./test/bench/uct_am_bench -x mm -d posix -D bcopy -s 1024 -n 1000 -r 1
+}
+
 test_memtrack() {
 	../contrib/configure-devel --prefix=$ucx_inst
 	$MAKE clean
@@ -958,9 +995,11 @@ run_tests() {
 	do_distributed_task 1 4 run_ucp_hello
 	do_distributed_task 2 4 run_uct_hello
 	do_distributed_task 1 4 run_ucp_client_server
+	do_distributed_task 2 4 run_ucx_perftest_local
 	do_distributed_task 3 4 test_profiling
 	do_distributed_task 3 4 test_dlopen
 	do_distributed_task 3 4 test_memtrack
+	do_distributed_task 0 4 run_ucs_bench
 	do_distributed_task 0 4 test_unused_env_var
 	do_distributed_task 1 3 test_malloc_hook
 
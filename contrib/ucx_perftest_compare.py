@@ -0,0 +1,194 @@
+#!/usr/bin/env python
+#
+# Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+#
+# See file LICENSE for terms.
+#
+
+#
+# Run a sweep of ucx_perftest tests and compare the results with a baseline.
+#
+#  Run the tests from batch files and save the results:
+#    ucx_perftest_compare.py run -o results.json -- \
+#        -l 2 -b ucx_perftest_config/test_types_ucp -b ucx_perftest_config/msg_pow2
+#
+#  Compare with a baseline, and exit with non-zero status if any test is
+#  slower than the baseline by more than the tolerance:
+#    ucx_perftest_compare.py compare baseline.json results.json -t 0.1
+#
+# The results are files written by "ucx_perftest -J", one JSON object per test.
+#
+
+from __future__ import print_function
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+
+# Metric path in the result, whether a higher value is better, and the scale
+# to print it in usec, MB/s or msg/s
+METRICS = {
+    "latency"   : (("latency", "overall"),   False, 1e6),
+    "p99"       : (("latency", "p99"),       False, 1e6),
+    "bandwidth" : (("bandwidth", "overall"), True,  1.0 / (1024 * 1024)),
+    "msgrate"   : (("msgrate", "overall"),   True,  1.0),
+}
+
+
+def load_results(filename):
+    results = {}
+    with open(filename) as f:
+        for line_num, line in enumerate(f, 1):
+            line = line.strip()
+            if not line:
+                continue
+            try:
+                record = json.loads(line)
+            except ValueError as e:
+                sys.exit("%s:%d: invalid JSON: %s" % (filename, line_num, e))
+            results[test_key(record)] = record
+    return results
+
+
+def test_key(record):
+    params = record["params"]
+    transport = params.get("uct", {})
+    return (record["test"],
+            "/".join(record["batch"]),
+            record["row"] or "",
+            transport.get("tl", ""),
+            transport.get("dev", ""),
+            ",".join(str(size) for size in params["msg_size"]))
+
+
+def key_str(key):
+    test, batch, row, tl, dev, msg_size = key
+    name = batch if batch else test
+    if tl:
+        name += " %s/%s" % (tl, dev)
+    name += " size %s" % msg_size
+    if row:
+        name += " [%s]" % row
+    return name
+
+
+def metric_value(record, metric):
+    value = record["result"]
+    for field in METRICS[metric][0]:
+        value = value[field]
+    return float(value) * METRICS[metric][2]
+
+
+def do_run(args):
+    if not args.perftest_args:
+        sys.exit("missing ucx_perftest arguments")
+
+    perftest_args = args.perftest_args
+    if perftest_args[0] == "--":
+        perftest_args = perftest_args[1:]
+
+    if os.path.exists(args.output):
+        os.remove(args.output)
+
+    cmd = [args.perftest, "-f", "-J", args.output] + perftest_args
+    print("running: %s" % " ".join(cmd))
+    status = subprocess.call(cmd)
+    if status != 0:
+        sys.exit("ucx_perftest failed with status %d" % status)
+
+    print("results saved to %s" % args.output)
+
+
+def do_compare(args):
+    baseline = load_results(args.baseline)
+    current  = load_results(args.results)
+    metrics  = args.metrics.split(",")
+    for metric in metrics:
+        if metric not in METRICS:
+            sys.exit("unknown metric '%s', expected one of: %s" %
+                     (metric, ", ".join(sorted(METRICS))))
+
+    regressions = 0
+    missing     = 0
+    print("%-60s %-10s %14s %14s %8s" %
+          ("test", "metric", "baseline", "current", "change"))
+    for key in sorted(baseline):
+        if key not in current:
+            print("%-60s missing" % key_str(key))
+            missing += 1
+            continue
+
+        for metric in metrics:
+            base_value = metric_value(baseline[key], metric)
+            value      = metric_value(current[key], metric)
+            if base_value == 0:
+                continue
+
+            change = (value - base_value) / base_value
+            if not METRICS[metric][1]:
+                change = -change
+
+            if change < -args.tolerance:
+                status = "REGRESSION"
+                regressions += 1
+            elif args.verbose:
+                status = ""
+            else:
+                continue
+
+            print("%-60s %-10s %14.3f %14.3f %+7.1f%% %s" %
+                  (key_str(key), metric, base_value, value, change * 100.0,
+                   status))
+
+    print("%d tests compared, %d regressions, %d missing" %
+          (len(baseline) - missing, regressions, missing))
+    if regressions or (missing and args.strict):
+        sys.exit(1)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Run ucx_perftest and compare the results with a baseline")
+    subparsers = parser.add_subparsers(dest="command")
+
+    run_parser = subparsers.add_parser(
+        "run", help="run ucx_perftest and save the results")
+    run_parser.add_argument("-o", "--output", required=True,
+                            help="file to save the results to")
+    run_parser.add_argument("-p", "--perftest", default="ucx_perftest",
+                            help="path to ucx_perftest (default: %(default)s)")
+    run_parser.add_argument("perftest_args", nargs=argparse.REMAINDER,
+                            help="arguments for ucx_perftest, usually batch "
+                                 "files given with -b")
+    run_parser.set_defaults(func=do_run)
+
+    compare_parser = subparsers.add_parser(
+        "compare", help="compare results with a baseline")
+    compare_parser.add_argument("baseline", help="baseline results file")
+    compare_parser.add_argument("results", help="results file to check")
+    compare_parser.add_argument("-t", "--tolerance", type=float, default=0.05,
+                                help="allowed relative degradation "
+                                     "(default: %(default)s)")
+    compare_parser.add_argument("-m", "--metrics",
+                                default="latency,bandwidth,msgrate",
+                                help="comma-separated metrics to compare: " +
+                                     ", ".join(sorted(METRICS)) +
+                                     " (default: %(default)s)")
+    compare_parser.add_argument("-s", "--strict", action="store_true",
+                                help="fail if a baseline test is missing")
+    compare_parser.add_argument("-v", "--verbose", action="store_true",
+                                help="print all compared values")
+    compare_parser.set_defaults(func=do_compare)
+
+    args = parser.parse_args()
+    if args.command is None:
+        parser.print_help()
+        sys.exit(1)
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,165 @@
+#!/usr/bin/env python
+#
+# Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+#
+# See file LICENSE for terms.
+#
+
+#
+# Find protocol thresholds for the current system with ucx_perftest, and save
+# them to a configuration file.
+#
+#  Tune the thresholds for shared memory transports, running both sides of the
+#  test on the local host:
+#    UCX_TLS=sm ucx_perftest_tune.py -o ucx_tuned.conf
+#
+#  Load the file from an application with ucp_config_read(NULL, filename, ...),
+#  or from a shell with "set -a; . ucx_tuned.conf; set +a".
+#
+# Every threshold is found by running the same test twice for every message
+# size, once with each protocol forced by the environment. The threshold is the
+# smallest size from which the protocol for larger messages is always faster.
+# The thresholds are global, so they are tuned for the given UCX_TLS setting.
+#
+
+from __future__ import print_function
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+
+INF = "inf"
+
+
+def run_perftest(args, test, size, env_overrides):
+    fd, output = tempfile.mkstemp(prefix="ucx_perftest_tune_",
+                                  suffix=".json")
+    os.close(fd)
+    try:
+        env = dict(os.environ)
+        env.update(env_overrides)
+        cmd = [args.perftest, "-f", "-J", output, "-t", test,
+               "-s", str(size), "-n", str(args.iters),
+               "-w", str(args.warmup)] + args.perftest_args
+        if args.verbose:
+            print("running: %s %s" %
+                  (" ".join("%s=%s" % kv for kv in sorted(env_overrides.items())),
+                   " ".join(cmd)))
+        with open(os.devnull, "w") as devnull:
+            status = subprocess.call(cmd, env=env, stdout=devnull)
+        if status != 0:
+            sys.exit("ucx_perftest failed with status %d: %s" %
+                     (status, " ".join(cmd)))
+
+        latency = None
+        with open(output) as f:
+            for line in f:
+                if line.strip():
+                    latency = json.loads(line)["result"]["latency"]["overall"]
+        if latency is None:
+            sys.exit("ucx_perftest did not report results: %s" % " ".join(cmd))
+        return float(latency) * 1e6
+    finally:
+        os.remove(output)
+
+
+def find_threshold(args, name, test, low_env, high_env):
+    """
+    Return the smallest message size from which the protocol selected by
+    high_env is faster than the one selected by low_env for all larger sizes,
+    or None if it is never faster.
+    """
+    print("tuning %s with %s" % (name, test))
+    print("  %10s %12s %12s" % ("size", "low (usec)", "high (usec)"))
+    threshold = None
+    size      = args.min_size
+    while size <= args.max_size:
+        low  = run_perftest(args, test, size, low_env)
+        high = run_perftest(args, test, size, high_env)
+        print("  %10d %12.3f %12.3f" % (size, low, high))
+        if high < low:
+            if threshold is None:
+                threshold = size
+        else:
+            threshold = None
+        size *= 2
+    return threshold
+
+
+def do_tune(args):
+    settings = []
+
+    # RMA put uses short messages, fragmented if needed, up to BCOPY_THRESH
+    bcopy_thresh = find_threshold(args, "BCOPY_THRESH", "ucp_put_lat",
+                                  {"UCX_BCOPY_THRESH" : str(args.max_size)},
+                                  {"UCX_BCOPY_THRESH" : "0"})
+    if bcopy_thresh is not None:
+        settings.append(("BCOPY_THRESH", str(bcopy_thresh - 1)))
+
+    # Zero-copy for eager send, rendezvous is disabled to compare only eager
+    zcopy_thresh = find_threshold(args, "ZCOPY_THRESH", "tag_lat",
+                                  {"UCX_RNDV_THRESH" : INF,
+                                   "UCX_ZCOPY_THRESH" : INF},
+                                  {"UCX_RNDV_THRESH" : INF,
+                                   "UCX_ZCOPY_THRESH" : "0"})
+    zcopy_value = INF if zcopy_thresh is None else str(zcopy_thresh)
+    settings.append(("ZCOPY_THRESH", zcopy_value))
+
+    # Rendezvous, compared with the best eager protocol found above
+    rndv_thresh = find_threshold(args, "RNDV_THRESH", "tag_lat",
+                                 {"UCX_ZCOPY_THRESH" : zcopy_value,
+                                  "UCX_RNDV_THRESH" : INF},
+                                 {"UCX_ZCOPY_THRESH" : zcopy_value,
+                                  "UCX_RNDV_THRESH" : "0"})
+    settings.append(("RNDV_THRESH",
+                     INF if rndv_thresh is None else str(rndv_thresh)))
+
+    with open(args.output, "w") as f:
+        f.write("# Generated by ucx_perftest_tune.py\n")
+        f.write("# UCX_TLS=%s\n" % os.environ.get("UCX_TLS", "all"))
+        f.write("# ucx_perftest arguments: %s\n" % " ".join(args.perftest_args))
+        for name, value in settings:
+            f.write("UCX_%s=%s\n" % (name, value))
+
+    for name, value in settings:
+        print("UCX_%s=%s" % (name, value))
+    print("settings saved to %s" % args.output)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Tune UCX protocol thresholds with ucx_perftest")
+    parser.add_argument("-o", "--output", required=True,
+                        help="configuration file to write")
+    parser.add_argument("-p", "--perftest", default="ucx_perftest",
+                        help="path to ucx_perftest (default: %(default)s)")
+    parser.add_argument("-m", "--min-size", type=int, default=64,
+                        help="smallest message size (default: %(default)s)")
+    parser.add_argument("-M", "--max-size", type=int, default=1024 * 1024,
+                        help="largest message size (default: %(default)s)")
+    parser.add_argument("-n", "--iters", type=int, default=1000,
+                        help="iterations per test (default: %(default)s)")
+    parser.add_argument("-w", "--warmup", type=int, default=100,
+                        help="warmup iterations per test (default: %(default)s)")
+    parser.add_argument("-v", "--verbose", action="store_true",
+                        help="print ucx_perftest command lines")
+    parser.add_argument("perftest_args", nargs=argparse.REMAINDER,
+                        help="additional arguments for ucx_perftest, for "
+                             "example the server address (default: -l 2)")
+
+    args = parser.parse_args()
+    if args.perftest_args and args.perftest_args[0] == "--":
+        args.perftest_args = args.perftest_args[1:]
+    if not args.perftest_args:
+        args.perftest_args = ["-l", "2"]
+    if args.min_size <= 0 or args.max_size < args.min_size:
+        sys.exit("invalid message size range")
+    do_tune(args)
+
+
+if __name__ == "__main__":
+    main()
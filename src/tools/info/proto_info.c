@@ -7,6 +7,7 @@
 #include "ucx_info.h"
 
 #include <ucp/api/ucp.h>
+#include <ucp/core/ucp_ep.h>
 #include <ucs/time/time.h>
 #include <sys/resource.h>
 #include <dirent.h>
@@ -88,9 +89,59 @@ static void print_resource_usage(const resource_usage_t *usage_before,
     printf("#\n");
 }
 
+/*
+ * Print protocol selection of a loopback endpoint. For RMA and atomics, map
+ * a buffer and unpack its remote key on the endpoint.
+ */
+static void print_ucp_proto_select(ucp_context_h context, ucp_ep_h ep,
+                                   size_t min_length, size_t max_length)
+{
+    ucp_mem_map_params_t mem_params;
+    ucp_rkey_h rkey = NULL;
+    void *rkey_buffer;
+    ucp_mem_h memh;
+    size_t rkey_size;
+    ucs_status_t status;
+
+    mem_params.field_mask = UCP_MEM_MAP_PARAM_FIELD_ADDRESS |
+                            UCP_MEM_MAP_PARAM_FIELD_LENGTH |
+                            UCP_MEM_MAP_PARAM_FIELD_FLAGS;
+    mem_params.address    = NULL;
+    mem_params.length     = 4096;
+    mem_params.flags      = UCP_MEM_MAP_ALLOCATE;
+
+    status = ucp_mem_map(context, &mem_params, &memh);
+    if (status != UCS_OK) {
+        printf("<Failed to map memory>\n");
+        return;
+    }
+
+    status = ucp_rkey_pack(context, memh, &rkey_buffer, &rkey_size);
+    if (status != UCS_OK) {
+        printf("<Failed to pack remote key>\n");
+        goto out_unmap;
+    }
+
+    status = ucp_ep_rkey_unpack(ep, rkey_buffer, &rkey);
+    ucp_rkey_buffer_release(rkey_buffer);
+    if (status != UCS_OK) {
+        printf("<Failed to unpack remote key>\n");
+        rkey = NULL;
+    }
+
+    ucp_ep_print_proto_select(ep, rkey, min_length, max_length, stdout);
+
+    if (rkey != NULL) {
+        ucp_rkey_destroy(rkey);
+    }
+out_unmap:
+    ucp_mem_unmap(context, memh);
+}
+
 void print_ucp_info(int print_opts, ucs_config_print_flags_t print_flags,
                     uint64_t ctx_features, const ucp_ep_params_t *base_ep_params,
-                    size_t estimated_num_eps, unsigned dev_type_bitmap)
+                    size_t estimated_num_eps, unsigned dev_type_bitmap,
+                    size_t min_length, size_t max_length)
 {
     ucp_config_t *config;
     ucs_status_t status;
@@ -139,7 +190,7 @@ void print_ucp_info(int print_opts, ucs_config_print_flags_t print_flags,
         print_resource_usage(&usage, "UCP context");
     }
 
-    if (!(print_opts & (PRINT_UCP_WORKER|PRINT_UCP_EP))) {
+    if (!(print_opts & (PRINT_UCP_WORKER|PRINT_UCP_EP|PRINT_UCP_PROTO))) {
         goto out_cleanup_context;
     }
 
@@ -159,7 +210,7 @@ void print_ucp_info(int print_opts, ucs_config_print_flags_t print_flags,
         print_resource_usage(&usage, "UCP worker");
     }
 
-    if (print_opts & PRINT_UCP_EP) {
+    if (print_opts & (PRINT_UCP_EP|PRINT_UCP_PROTO)) {
         status = ucp_worker_get_address(worker, &address, &address_length);
         if (status != UCS_OK) {
             printf("<Failed to get UCP worker address>\n");
@@ -178,7 +229,13 @@ void print_ucp_info(int print_opts, ucs_config_print_flags_t print_flags,
             goto out_destroy_worker;
         }
 
-        ucp_ep_print_info(ep, stdout);
+        if (print_opts & PRINT_UCP_EP) {
+            ucp_ep_print_info(ep, stdout);
+        }
+
+        if (print_opts & PRINT_UCP_PROTO) {
+            print_ucp_proto_select(context, ep, min_length, max_length);
+        }
 
         status_ptr = ucp_disconnect_nb(ep);
         if (UCS_PTR_IS_PTR(status_ptr)) {
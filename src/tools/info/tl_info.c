@@ -193,6 +193,8 @@ static void print_iface_info(uct_worker_h worker, uct_md_h md,
 
         PRINT_CAP(AM_SHORT,  iface_attr.cap.flags, iface_attr.cap.am.max_short);
         PRINT_CAP(AM_BCOPY,  iface_attr.cap.flags, iface_attr.cap.am.max_bcopy);
+        PRINT_CAP(AM_BCAST_BCOPY, iface_attr.cap.flags,
+                  iface_attr.cap.am.max_bcopy);
         PRINT_ZCAP(AM_ZCOPY,  iface_attr.cap.flags, iface_attr.cap.am.min_zcopy,
                    iface_attr.cap.am.max_zcopy, iface_attr.cap.am.max_iov);
         if (iface_attr.cap.flags & UCT_IFACE_FLAG_AM_ZCOPY) {
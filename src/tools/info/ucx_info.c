@@ -8,6 +8,7 @@
 
 #include <ucs/config/parser.h>
 #include <ucs/config/global_opts.h>
+#include <ucs/sys/math.h>
 #include <ucm/api/ucm.h>
 #include <getopt.h>
 #include <stdlib.h>
@@ -28,11 +29,15 @@ static void usage() {
     printf("  -p              Show UCP context information\n");
     printf("  -w              Show UCP worker information\n");
     printf("  -e              Show UCP endpoint configuration\n");
+    printf("  -P              Show UCP protocol selection and modeled performance\n");
+    printf("                  per message size, on a loopback endpoint\n");
+    printf("  -m <min>:<max>  Message size range for -P, in powers of 2 (1:4194304)\n");
     printf("  -u <features>   UCP context features to use. String of one or more of:\n");
     printf("                    'a' : atomic operations\n");
     printf("                    'r' : remote memory access\n");
     printf("                    't' : tag matching \n");
     printf("                    'w' : wakeup\n");
+    printf("                    's' : stream\n");
     printf("                    'e' : error handling\n");
     printf("  -n <count>      Estimated UCP endpoint count (for ucp_init)\n");
     printf("  -D <type>       Set which device types to use when creating UCP context:\n");
@@ -52,6 +57,7 @@ int main(int argc, char **argv)
     unsigned dev_type_bitmap;
     uint64_t ucp_features;
     size_t ucp_num_eps;
+    size_t min_length, max_length;
     unsigned print_opts;
     char *tl_name;
     const char *f;
@@ -63,8 +69,10 @@ int main(int argc, char **argv)
     ucp_features             = 0;
     ucp_num_eps              = 1;
     dev_type_bitmap          = -1;
+    min_length               = 1;
+    max_length               = 4 * UCS_MBYTE;
     ucp_ep_params.field_mask = 0;
-    while ((c = getopt(argc, argv, "fahvcydbswpet:n:u:D:")) != -1) {
+    while ((c = getopt(argc, argv, "fahvcydbswpePt:n:u:D:m:")) != -1) {
         switch (c) {
         case 'f':
             print_flags |= UCS_CONFIG_PRINT_CONFIG | UCS_CONFIG_PRINT_HEADER | UCS_CONFIG_PRINT_DOC;
@@ -99,6 +107,16 @@ int main(int argc, char **argv)
         case 'e':
             print_opts |= PRINT_UCP_EP;
             break;
+        case 'P':
+            print_opts |= PRINT_UCP_PROTO;
+            break;
+        case 'm':
+            if ((sscanf(optarg, "%zu:%zu", &min_length, &max_length) != 2) ||
+                (min_length > max_length)) {
+                usage();
+                return -1;
+            }
+            break;
         case 't':
             tl_name = optarg;
             break;
@@ -117,6 +135,9 @@ int main(int argc, char **argv)
                 case 't':
                     ucp_features |= UCP_FEATURE_TAG;
                     break;
+                case 's':
+                    ucp_features |= UCP_FEATURE_STREAM;
+                    break;
                 case 'w':
                     ucp_features |= UCP_FEATURE_WAKEUP;
                     break;
@@ -182,13 +203,14 @@ int main(int argc, char **argv)
         print_uct_info(print_opts, print_flags, tl_name);
     }
 
-    if (print_opts & (PRINT_UCP_CONTEXT|PRINT_UCP_WORKER|PRINT_UCP_EP)) {
+    if (print_opts & (PRINT_UCP_CONTEXT|PRINT_UCP_WORKER|PRINT_UCP_EP|
+                      PRINT_UCP_PROTO)) {
         if (ucp_features == 0) {
             printf("Please select UCP features using -u switch\n");
             return -1;
         }
         print_ucp_info(print_opts, print_flags, ucp_features, &ucp_ep_params,
-                       ucp_num_eps, dev_type_bitmap);
+                       ucp_num_eps, dev_type_bitmap, min_length, max_length);
     }
 
     return 0;
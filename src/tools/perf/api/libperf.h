@@ -38,6 +38,8 @@ typedef enum {
     UCX_PERF_CMD_TAG,
     UCX_PERF_CMD_TAG_SYNC,
     UCX_PERF_CMD_STREAM,
+    UCX_PERF_CMD_WIREUP,
+    UCX_PERF_CMD_TAG_MATCH,
     UCX_PERF_CMD_LAST
 } ucx_perf_cmd_t;
 
@@ -50,6 +52,25 @@ typedef enum {
 } ucx_perf_test_type_t;
 
 
+typedef enum {
+    UCX_PERF_PATTERN_PAIR,               /* Ranks 0 and 1 talk to each other */
+    UCX_PERF_PATTERN_INCAST,             /* All ranks send to rank 0 */
+    UCX_PERF_PATTERN_ALLTOALL,           /* Every rank sends to all other ranks */
+    UCX_PERF_PATTERN_LAST
+} ucx_perf_pattern_t;
+
+
+typedef enum {
+    UCP_PERF_THREAD_MODEL_SHARED_EP,     /* All threads use the same worker and
+                                            endpoints */
+    UCP_PERF_THREAD_MODEL_SHARED_WORKER, /* All threads use the same worker,
+                                            every thread has its own endpoints */
+    UCP_PERF_THREAD_MODEL_WORKER,        /* Every thread has its own worker and
+                                            endpoints */
+    UCP_PERF_THREAD_MODEL_LAST
+} ucp_perf_thread_model_t;
+
+
 typedef enum {
     UCP_PERF_DATATYPE_CONTIG,
     UCP_PERF_DATATYPE_IOV,
@@ -80,7 +101,11 @@ enum ucx_perf_test_flags {
     UCX_PERF_TEST_FLAG_TAG_WILDCARD     = UCS_BIT(4), /* For tag tests, use wildcard mask */
     UCX_PERF_TEST_FLAG_TAG_UNEXP_PROBE  = UCS_BIT(5), /* For tag tests, use probe to get unexpected receive */
     UCX_PERF_TEST_FLAG_VERBOSE          = UCS_BIT(7), /* Print error messages */
-    UCX_PERF_TEST_FLAG_STREAM_RECV_DATA = UCS_BIT(8)  /* For stream tests, use recv data API */
+    UCX_PERF_TEST_FLAG_STREAM_RECV_DATA = UCS_BIT(8), /* For stream tests, use recv data API */
+    UCX_PERF_TEST_FLAG_REALLOC_BUFFERS  = UCS_BIT(9), /* Unmap and map again every send buffer
+                                                         before reusing it */
+    UCX_PERF_TEST_FLAG_TAG_RANDOM_ORDER = UCS_BIT(10) /* For tag matching test, post receives
+                                                         in random order */
 };
 
 
@@ -94,6 +119,12 @@ enum {
 typedef uint64_t ucx_perf_counter_t;
 
 
+/**
+ * Histogram of iteration latencies.
+ */
+typedef struct ucx_perf_histogram ucx_perf_histogram_t;
+
+
 /*
  * Performance test result.
  *
@@ -110,6 +141,47 @@ typedef struct ucx_perf_result {
         double              total_average;  /* Average of the whole test */
     }
     latency, bandwidth, msgrate;
+    struct {
+        double              p50;
+        double              p90;
+        double              p99;
+        double              p999;
+        double              max;
+    }
+    latency_percentile; /* Latency distribution of the whole test */
+    struct {
+        double              ep_create;    /* Time to create an endpoint */
+        double              first_msg;    /* Round trip of the first message
+                                             on a new endpoint */
+        double              ep_close;     /* Time to flush and close an endpoint */
+        size_t              address_size; /* Size of the worker address */
+    }
+    wireup; /* Per-endpoint averages of the wireup test */
+    struct {
+        ucx_perf_counter_t  gets;          /* Registration cache lookups */
+        ucx_perf_counter_t  regs;          /* Memory registrations */
+        ucx_perf_counter_t  invalidations; /* Regions invalidated by unmap */
+        double              hit_ratio;     /* Fraction of lookups which found
+                                              a registered region */
+        double              reg_time;      /* Average time of a registration */
+    }
+    rcache; /* Registration cache activity during the test */
+    struct {
+        unsigned            count;        /* Number of threads, the result is
+                                             the sum of the thread results */
+        const struct ucx_perf_result *results; /* Result of every thread, valid
+                                             only during the report callback */
+        ucx_perf_counter_t  lock_waits;   /* Acquisitions of the UCP worker
+                                             lock which had to wait */
+        double              lock_wait_time; /* Total time threads waited for
+                                               the UCP worker lock */
+    }
+    threads; /* Multi-threaded test results */
+    const ucx_perf_histogram_t *latency_histogram; /* Valid only during the
+                                                      report callback */
+    const char              *ep_info;  /* UCP endpoint configuration, as printed
+                                          by ucp_ep_print_info(), valid only
+                                          during the report callback */
 } ucx_perf_result_t;
 
 
@@ -148,6 +220,7 @@ typedef struct ucx_perf_params {
     ucx_perf_api_t         api;             /* Which API to test */
     ucx_perf_cmd_t         command;         /* Command to perform */
     ucx_perf_test_type_t   test_type;       /* Test communication type */
+    ucx_perf_pattern_t     pattern;         /* Traffic pattern between group members */
     ucs_thread_mode_t      thread_mode;     /* Thread mode for communication objects */
     unsigned               thread_count;    /* Number of threads in the test program */
     ucs_async_mode_t       async_mode;      /* how async progress and locking is done */
@@ -165,6 +238,9 @@ typedef struct ucx_perf_params {
     size_t                 am_hdr_size;     /* Active message header size (included in message size) */
     size_t                 alignment;       /* Message buffer alignment */
     unsigned               max_outstanding; /* Maximal number of outstanding sends */
+    unsigned               send_buffers;    /* Number of send buffers to use in
+                                               round-robin order, 0 or 1 - use
+                                               a single preregistered buffer */
     ucx_perf_counter_t     warmup_iter;     /* Number of warm-up iterations */
     ucx_perf_counter_t     max_iter;        /* Iterations limit, 0 - unlimited */
     double                 max_time;        /* Time limit (seconds), 0 - unlimited */
@@ -185,6 +261,17 @@ typedef struct ucx_perf_params {
         unsigned               nonblocking_mode; /* TBD */
         ucp_perf_datatype_t    send_datatype;
         ucp_perf_datatype_t    recv_datatype;
+        unsigned               wireup_eps;  /* Endpoints to create on every
+                                               iteration of the wireup test */
+        unsigned               tag_depth;   /* Messages matched on every iteration
+                                               of the tag matching test */
+        unsigned               tag_count;   /* Number of distinct tags used by
+                                               the tag matching test */
+        unsigned               tag_any_source_percent; /* Percent of receives
+                                               which match a message from any
+                                               source */
+        ucp_perf_thread_model_t thread_model; /* How threads share the workers
+                                               and endpoints */
     } ucp;
 
 } ucx_perf_params_t;
@@ -207,6 +294,30 @@ void ucx_perf_global_init();
 ucs_status_t ucx_perf_run(ucx_perf_params_t *params, ucx_perf_result_t *result);
 
 
+/**
+ * Print a latency histogram to a stream. Every line has the latency range of
+ * a bucket in usec, the number of iterations in the bucket, and the fraction
+ * of iterations with the same or lower latency. Empty buckets are omitted.
+ */
+void ucx_perf_histogram_print(const ucx_perf_histogram_t *histogram,
+                              FILE *stream);
+
+
+/**
+ * Add the samples of one latency histogram to another. Used to combine the
+ * histograms of several processes which ran the same test.
+ */
+void ucx_perf_histogram_merge(ucx_perf_histogram_t *dst,
+                              const ucx_perf_histogram_t *src);
+
+
+/**
+ * Fill the latency percentiles of a result from a latency histogram.
+ */
+void ucx_perf_histogram_calc_percentiles(const ucx_perf_histogram_t *histogram,
+                                         ucx_perf_result_t *result);
+
+
 END_C_DECLS
 
 #endif /* UCX_PERF_H_ */
@@ -9,10 +9,12 @@
 
 #include <ucs/debug/log.h>
 #include <ucs/arch/bitops.h>
+#include <ucs/config/global_opts.h>
 #include <string.h>
 #include <malloc.h>
 #include <tools/perf/lib/libperf_int.h>
 #include <unistd.h>
+#include <sys/mman.h>
 
 #define ATOMIC_OP_CONFIG(_size, _op32, _op64, _op, _msg, _params, _status)        \
     _status = __get_atomic_flag((_size), (_op32), (_op64), (_op));                \
@@ -236,6 +238,7 @@ void ucx_perf_test_start_clock(ucx_perf_context_t *perf)
     perf->prev.time        = start_time;
     perf->prev.time_acc    = perf->start_time_acc;
     perf->current.time_acc = perf->start_time_acc;
+    ucs_rcache_get_counters(&perf->send_rotation.start);
 }
 
 static void ucx_perf_test_reset(ucx_perf_context_t *perf,
@@ -256,15 +259,129 @@ static void ucx_perf_test_reset(ucx_perf_context_t *perf,
     perf->prev.iters        = 0;
     perf->timing_queue_head = 0;
     perf->offset            = 0;
+    perf->wireup.ep_create  = 0;
+    perf->wireup.first_msg  = 0;
+    perf->wireup.ep_close   = 0;
+    perf->wireup.eps        = 0;
     perf->allocator         = ucx_perf_mem_type_allocators[params->mem_type];
     for (i = 0; i < TIMING_QUEUE_SIZE; ++i) {
         perf->timing_queue[i] = 0;
     }
+    memset(&perf->histogram, 0, sizeof(perf->histogram));
+    perf->histogram.factor  = (params->test_type == UCX_PERF_TEST_TYPE_PINGPONG) ?
+                              2.0 : 1.0;
     ucx_perf_test_start_clock(perf);
 }
 
+static ucs_time_t ucx_perf_histogram_bucket_min(unsigned index)
+{
+    unsigned shift;
+
+    if (index < UCS_BIT(UCX_PERF_HISTOGRAM_SUB_BITS)) {
+        return index;
+    }
+
+    shift = (index >> (UCX_PERF_HISTOGRAM_SUB_BITS - 1)) - 1;
+    return (ucs_time_t)(index - (shift << (UCX_PERF_HISTOGRAM_SUB_BITS - 1)))
+           << shift;
+}
+
+static ucs_time_t ucx_perf_histogram_bucket_width(unsigned index)
+{
+    return ucx_perf_histogram_bucket_min(index + 1) -
+           ucx_perf_histogram_bucket_min(index);
+}
+
+static double ucx_perf_histogram_to_sec(const ucx_perf_histogram_t *histogram,
+                                        ucs_time_t value)
+{
+    return ucs_time_to_sec(value) / histogram->factor;
+}
+
+/* Returns the latency in seconds below which 'fraction' of the samples are */
+static double ucx_perf_histogram_percentile(const ucx_perf_histogram_t *histogram,
+                                            double fraction)
+{
+    uint64_t target, count;
+    ucs_time_t value;
+    unsigned index;
+
+    if (histogram->count == 0) {
+        return 0.0;
+    }
+
+    target = ucs_max((uint64_t)(fraction * histogram->count + 0.5), 1ul);
+    count  = 0;
+    for (index = 0; index < UCX_PERF_HISTOGRAM_SIZE; ++index) {
+        count += histogram->buckets[index];
+        if (count >= target) {
+            /* middle of the bucket, but not more than the maximal value */
+            value = ucx_perf_histogram_bucket_min(index) +
+                    (ucx_perf_histogram_bucket_width(index) / 2);
+            return ucx_perf_histogram_to_sec(histogram,
+                                              ucs_min(value, histogram->max));
+        }
+    }
+
+    return ucx_perf_histogram_to_sec(histogram, histogram->max);
+}
+
+void ucx_perf_histogram_print(const ucx_perf_histogram_t *histogram,
+                              FILE *stream)
+{
+    ucs_time_t bucket_min;
+    uint64_t count;
+    unsigned index;
+
+    fprintf(stream, "# %14s %14s %14s %10s\n", "min_lat(usec)", "max_lat(usec)",
+            "count", "fraction");
+
+    count = 0;
+    for (index = 0; index < UCX_PERF_HISTOGRAM_SIZE; ++index) {
+        if (histogram->buckets[index] == 0) {
+            continue;
+        }
+
+        count     += histogram->buckets[index];
+        bucket_min = ucx_perf_histogram_bucket_min(index);
+        fprintf(stream, "  %14.3f %14.3f %14lu %10.6f\n",
+                ucx_perf_histogram_to_sec(histogram, bucket_min) * 1e6,
+                ucx_perf_histogram_to_sec(histogram, bucket_min +
+                                          ucx_perf_histogram_bucket_width(index)) * 1e6,
+                histogram->buckets[index], (double)count / histogram->count);
+    }
+}
+
+void ucx_perf_histogram_merge(ucx_perf_histogram_t *dst,
+                              const ucx_perf_histogram_t *src)
+{
+    unsigned index;
+
+    for (index = 0; index < UCX_PERF_HISTOGRAM_SIZE; ++index) {
+        dst->buckets[index] += src->buckets[index];
+    }
+    dst->count += src->count;
+    dst->max    = ucs_max(dst->max, src->max);
+}
+
+void ucx_perf_histogram_calc_percentiles(const ucx_perf_histogram_t *histogram,
+                                         ucx_perf_result_t *result)
+{
+    result->latency_percentile.p50  =
+        ucx_perf_histogram_percentile(histogram, 0.5);
+    result->latency_percentile.p90  =
+        ucx_perf_histogram_percentile(histogram, 0.9);
+    result->latency_percentile.p99  =
+        ucx_perf_histogram_percentile(histogram, 0.99);
+    result->latency_percentile.p999 =
+        ucx_perf_histogram_percentile(histogram, 0.999);
+    result->latency_percentile.max  =
+        ucx_perf_histogram_to_sec(histogram, histogram->max);
+}
+
 void ucx_perf_calc_result(ucx_perf_context_t *perf, ucx_perf_result_t *result)
 {
+    ucs_rcache_counters_t rcache;
     ucs_time_t median;
     double factor;
 
@@ -318,6 +435,49 @@ void ucx_perf_calc_result(ucx_perf_context_t *perf, ucx_perf_result_t *result)
         perf->current.msgs /
         (perf->current.time_acc - perf->start_time_acc) * factor;
 
+
+    /* Latency distribution */
+
+    ucx_perf_histogram_calc_percentiles(&perf->histogram, result);
+    result->latency_histogram = &perf->histogram;
+    result->ep_info           = (perf->params.api == UCX_PERF_API_UCP) ?
+                                perf->ucp.ep_info : NULL;
+
+
+    /* Wireup */
+
+    memset(&result->wireup, 0, sizeof(result->wireup));
+    if (perf->wireup.eps > 0) {
+        result->wireup.ep_create    = ucs_time_to_sec(perf->wireup.ep_create) /
+                                      perf->wireup.eps;
+        result->wireup.first_msg    = ucs_time_to_sec(perf->wireup.first_msg) /
+                                      perf->wireup.eps;
+        result->wireup.ep_close     = ucs_time_to_sec(perf->wireup.ep_close) /
+                                      perf->wireup.eps;
+        result->wireup.address_size = perf->ucp.address_length;
+    }
+
+    /* Registration cache */
+
+    ucs_rcache_get_counters(&rcache);
+    result->rcache.gets          = rcache.gets - perf->send_rotation.start.gets;
+    result->rcache.regs          = rcache.regs - perf->send_rotation.start.regs;
+    result->rcache.invalidations = rcache.invalidations -
+                                   perf->send_rotation.start.invalidations;
+    result->rcache.hit_ratio     = (result->rcache.gets == 0) ? 0.0 :
+                                   (double)(rcache.hits -
+                                            perf->send_rotation.start.hits) /
+                                   result->rcache.gets;
+    result->rcache.reg_time      = (result->rcache.regs == 0) ? 0.0 :
+                                   ucs_time_to_sec(rcache.reg_time -
+                                                   perf->send_rotation.start.reg_time) /
+                                   result->rcache.regs;
+
+    /* Threads, filled by ucx_perf_thread_calc_result() for multi-threaded
+     * tests */
+
+    memset(&result->threads, 0, sizeof(result->threads));
+    result->threads.count = 1;
 }
 
 static ucs_status_t ucx_perf_test_check_params(ucx_perf_params_t *params)
@@ -338,6 +498,69 @@ static ucs_status_t ucx_perf_test_check_params(ucx_perf_params_t *params)
         return UCS_ERR_INVALID_PARAM;
     }
 
+    if ((params->command == UCX_PERF_CMD_WIREUP) &&
+        ((params->test_type != UCX_PERF_TEST_TYPE_STREAM_UNI) ||
+         (params->ucp.wireup_eps < 1) || (params->thread_count > 1)))
+    {
+        if (params->flags & UCX_PERF_TEST_FLAG_VERBOSE) {
+            ucs_error("Wireup test requires single thread, stream type and at "
+                      "least one endpoint per iteration");
+        }
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    if ((params->command == UCX_PERF_CMD_TAG_MATCH) &&
+        ((params->test_type != UCX_PERF_TEST_TYPE_STREAM_UNI) ||
+         (params->pattern != UCX_PERF_PATTERN_PAIR) ||
+         (params->thread_count > 1) || (params->ucp.tag_depth < 1) ||
+         (params->ucp.tag_count < 1) ||
+         (params->ucp.tag_any_source_percent > 100)))
+    {
+        if (params->flags & UCX_PERF_TEST_FLAG_VERBOSE) {
+            ucs_error("Tag matching test requires single thread, stream type, "
+                      "pair pattern, at least one message and one tag, and "
+                      "any-source percent of at most 100");
+        }
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    if (params->pattern != UCX_PERF_PATTERN_PAIR) {
+        if ((params->api != UCX_PERF_API_UCP) ||
+            (params->test_type != UCX_PERF_TEST_TYPE_STREAM_UNI) ||
+            (params->thread_count > 1))
+        {
+            if (params->flags & UCX_PERF_TEST_FLAG_VERBOSE) {
+                ucs_error("Incast and all-to-all patterns are supported only "
+                          "by single-threaded UCP bandwidth tests");
+            }
+            return UCS_ERR_UNSUPPORTED;
+        }
+
+        if ((params->pattern == UCX_PERF_PATTERN_ALLTOALL) &&
+            (params->flags & UCX_PERF_TEST_FLAG_TAG_UNEXP_PROBE)) {
+            if (params->flags & UCX_PERF_TEST_FLAG_VERBOSE) {
+                ucs_error("All-to-all pattern cannot be used with tag probe");
+            }
+            return UCS_ERR_UNSUPPORTED;
+        }
+    }
+
+    if ((params->send_buffers > 1) ||
+        (params->flags & UCX_PERF_TEST_FLAG_REALLOC_BUFFERS)) {
+        if ((params->api != UCX_PERF_API_UCP) ||
+            (params->ucp.send_datatype != UCP_PERF_DATATYPE_CONTIG) ||
+            (params->mem_type != UCT_MD_MEM_TYPE_HOST) ||
+            (params->thread_count > 1))
+        {
+            if (params->flags & UCX_PERF_TEST_FLAG_VERBOSE) {
+                ucs_error("Multiple or reallocated send buffers are supported "
+                          "only by single-threaded UCP tests with contiguous "
+                          "host memory");
+            }
+            return UCS_ERR_UNSUPPORTED;
+        }
+    }
+
     /* check if particular message size fit into stride size */
     if (params->iov_stride) {
         for (it = 0; it < params->msg_size_cnt; ++it) {
@@ -809,6 +1032,8 @@ static ucs_status_t ucp_perf_test_fill_params(ucx_perf_params_t *params,
         break;
     case UCX_PERF_CMD_TAG:
     case UCX_PERF_CMD_TAG_SYNC:
+    case UCX_PERF_CMD_WIREUP:
+    case UCX_PERF_CMD_TAG_MATCH:
         ucp_params->features    |= UCP_FEATURE_TAG;
         ucp_params->field_mask  |= UCP_PARAM_FIELD_REQUEST_SIZE;
         ucp_params->request_size = sizeof(ucp_perf_request_t);
@@ -898,6 +1123,103 @@ static void ucp_perf_test_free_host(ucx_perf_context_t *perf, void *address,
     }
 }
 
+static void *ucx_perf_map_send_buffer(ucx_perf_context_t *perf)
+{
+    void *buffer;
+
+    buffer = mmap(NULL, perf->send_rotation.length, PROT_READ|PROT_WRITE,
+                  MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (buffer == MAP_FAILED) {
+        return NULL;
+    }
+
+    memset(buffer, 0, perf->send_rotation.length);
+    return buffer;
+}
+
+/*
+ * Rotating send buffers are mapped outside of UCP, so UCP has to register
+ * them on demand, and unmapping them invalidates the registration cache.
+ */
+static ucs_status_t ucp_perf_test_alloc_send_rotation(ucx_perf_context_t *perf,
+                                                      size_t buffer_size)
+{
+    ucx_perf_params_t *params = &perf->params;
+    ucs_status_t status;
+    unsigned i;
+
+    perf->send_rotation.count   = 0;
+    perf->send_rotation.next    = 0;
+    perf->send_rotation.buffers = NULL;
+    if ((params->send_buffers <= 1) &&
+        !(params->flags & UCX_PERF_TEST_FLAG_REALLOC_BUFFERS)) {
+        return UCS_OK;
+    }
+
+    /* Report registration cache activity of the test */
+    status = ucs_global_opts_set_value("RCACHE_COUNTERS", "y");
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    perf->send_rotation.length  = ucs_align_up_pow2(buffer_size,
+                                                    ucs_get_page_size());
+    perf->send_rotation.buffers = calloc(ucs_max(params->send_buffers, 1),
+                                         sizeof(*perf->send_rotation.buffers));
+    if (perf->send_rotation.buffers == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    for (i = 0; i < ucs_max(params->send_buffers, 1); ++i) {
+        perf->send_rotation.buffers[i] = ucx_perf_map_send_buffer(perf);
+        if (perf->send_rotation.buffers[i] == NULL) {
+            ucs_error("failed to map send buffer of %zu bytes: %m",
+                      perf->send_rotation.length);
+            goto err_unmap;
+        }
+        ++perf->send_rotation.count;
+    }
+
+    return UCS_OK;
+
+err_unmap:
+    for (i = 0; i < perf->send_rotation.count; ++i) {
+        munmap(perf->send_rotation.buffers[i], perf->send_rotation.length);
+    }
+    free(perf->send_rotation.buffers);
+    perf->send_rotation.count = 0;
+    return UCS_ERR_NO_MEMORY;
+}
+
+static void ucp_perf_test_free_send_rotation(ucx_perf_context_t *perf)
+{
+    unsigned i;
+
+    for (i = 0; i < perf->send_rotation.count; ++i) {
+        munmap(perf->send_rotation.buffers[i], perf->send_rotation.length);
+    }
+    free(perf->send_rotation.buffers);
+    perf->send_rotation.count = 0;
+}
+
+void *ucx_perf_rotate_send_buffer(ucx_perf_context_t *perf)
+{
+    unsigned index = perf->send_rotation.next;
+
+    perf->send_rotation.next = (index + 1) % perf->send_rotation.count;
+
+    if (perf->params.flags & UCX_PERF_TEST_FLAG_REALLOC_BUFFERS) {
+        munmap(perf->send_rotation.buffers[index], perf->send_rotation.length);
+        perf->send_rotation.buffers[index] = ucx_perf_map_send_buffer(perf);
+        if (perf->send_rotation.buffers[index] == NULL) {
+            ucs_fatal("failed to map send buffer of %zu bytes: %m",
+                      perf->send_rotation.length);
+        }
+    }
+
+    return perf->send_rotation.buffers[index];
+}
+
 static ucs_status_t ucp_perf_test_alloc_mem(ucx_perf_context_t *perf)
 {
     ucx_perf_params_t *params = &perf->params;
@@ -947,8 +1269,15 @@ static ucs_status_t ucp_perf_test_alloc_mem(ucx_perf_context_t *perf)
         goto err_free_send_iov_buffers;
     }
 
+    status = ucp_perf_test_alloc_send_rotation(perf, buffer_size);
+    if (status != UCS_OK) {
+        goto err_free_recv_iov_buffers;
+    }
+
     return UCS_OK;
 
+err_free_recv_iov_buffers:
+    free(perf->ucp.recv_iov);
 err_free_send_iov_buffers:
     free(perf->ucp.send_iov);
 err_free_buffers:
@@ -961,38 +1290,65 @@ err:
 
 static void ucp_perf_test_free_mem(ucx_perf_context_t *perf)
 {
+    ucp_perf_test_free_send_rotation(perf);
     free(perf->ucp.recv_iov);
     free(perf->ucp.send_iov);
     perf->allocator->ucp_free(perf, perf->recv_buffer, perf->ucp.recv_memh);
     perf->allocator->ucp_free(perf, perf->send_buffer, perf->ucp.send_memh);
 }
 
+/* Number of endpoint sets to every group member */
+static unsigned ucp_perf_num_ep_sets(const ucx_perf_params_t *params)
+{
+    return (params->ucp.thread_model == UCP_PERF_THREAD_MODEL_SHARED_EP) ?
+           1 : params->thread_count;
+}
+
+/* Number of workers, all endpoint sets are created on the first worker unless
+ * every thread has its own worker */
+static unsigned ucp_perf_num_workers(const ucx_perf_params_t *params)
+{
+    return (params->ucp.thread_model == UCP_PERF_THREAD_MODEL_WORKER) ?
+           params->thread_count : 1;
+}
+
+static void ucp_perf_test_progress_workers(ucx_perf_context_t *perf)
+{
+    unsigned i;
+
+    for (i = 0; i < perf->ucp.num_workers; ++i) {
+        ucp_worker_progress(perf->ucp.workers[i]);
+    }
+}
+
 static void ucp_perf_test_destroy_eps(ucx_perf_context_t* perf,
                                       unsigned group_size)
 {
+    unsigned num_eps = group_size * ucp_perf_num_ep_sets(&perf->params);
     ucs_status_ptr_t    *reqs;
     ucp_tag_recv_info_t info;
     ucs_status_t        status;
     unsigned i;
 
-    reqs = calloc(sizeof(*reqs), group_size);
+    reqs = calloc(sizeof(*reqs), num_eps);
 
-    for (i = 0; i < group_size; ++i) {
+    for (i = 0; i < num_eps; ++i) {
         if (perf->ucp.peers[i].rkey != NULL) {
             ucp_rkey_destroy(perf->ucp.peers[i].rkey);
         }
         if (perf->ucp.peers[i].ep != NULL) {
             reqs[i] = ucp_disconnect_nb(perf->ucp.peers[i].ep);
         }
+        free(perf->ucp.peers[i].address);
     }
 
-    for (i = 0; i < group_size; ++i) {
+    for (i = 0; i < num_eps; ++i) {
         if (!UCS_PTR_IS_PTR(reqs[i])) {
             continue;
         }
 
         do {
-            ucp_worker_progress(perf->ucp.worker);
+            ucp_perf_test_progress_workers(perf);
             status = ucp_request_test(reqs[i], &info);
         } while (status == UCS_INPROGRESS);
         ucp_request_release(reqs[i]);
@@ -1025,8 +1381,12 @@ static ucs_status_t ucp_perf_test_exchange_status(ucx_perf_context_t *perf,
     return collective_status;
 }
 
-static ucs_status_t ucp_perf_test_setup_endpoints(ucx_perf_context_t *perf,
-                                                  uint64_t features)
+/* Exchange the addresses of a worker with the group, and connect a set of
+ * endpoints to the same workers of the other group members */
+static ucs_status_t ucp_perf_test_connect_peers(ucx_perf_context_t *perf,
+                                                uint64_t features,
+                                                ucp_worker_h worker,
+                                                ucp_peer_t *peers)
 {
     const size_t buffer_size = 2048;
     ucx_perf_ep_info_t info, *remote_info;
@@ -1043,16 +1403,17 @@ static ucs_status_t ucp_perf_test_setup_endpoints(ucx_perf_context_t *perf,
     group_size  = rte_call(perf, group_size);
     group_index = rte_call(perf, group_index);
 
-    status = ucp_worker_get_address(perf->ucp.worker, &address, &address_length);
+    status = ucp_worker_get_address(worker, &address, &address_length);
     if (status != UCS_OK) {
         if (perf->params.flags & UCX_PERF_TEST_FLAG_VERBOSE) {
             ucs_error("ucp_worker_get_address() failed: %s", ucs_status_string(status));
         }
-        goto err;
+        return status;
     }
 
     info.ucp.addr_len  = address_length;
     info.recv_buffer   = (uintptr_t)perf->recv_buffer;
+    perf->ucp.address_length = address_length;
 
     vec[0].iov_base    = &info;
     vec[0].iov_len     = sizeof(info);
@@ -1066,8 +1427,8 @@ static ucs_status_t ucp_perf_test_setup_endpoints(ucx_perf_context_t *perf,
             if (perf->params.flags & UCX_PERF_TEST_FLAG_VERBOSE) {
                 ucs_error("ucp_rkey_pack() failed: %s", ucs_status_string(status));
             }
-            ucp_worker_release_address(perf->ucp.worker, address);
-            goto err;
+            ucp_worker_release_address(worker, address);
+            return status;
         }
 
         vec[2].iov_base = rkey_buffer;
@@ -1079,19 +1440,13 @@ static ucs_status_t ucp_perf_test_setup_endpoints(ucx_perf_context_t *perf,
         rte_call(perf, post_vec, vec, 2, &req);
     }
 
-    ucp_worker_release_address(perf->ucp.worker, address);
+    ucp_worker_release_address(worker, address);
     rte_call(perf, exchange_vec, req);
 
-    perf->ucp.peers = calloc(group_size, sizeof(*perf->uct.peers));
-    if (perf->ucp.peers == NULL) {
-        goto err;
-    }
-
     buffer = malloc(buffer_size);
     if (buffer == NULL) {
         ucs_error("Failed to allocate RTE receive buffer");
-        status = UCS_ERR_NO_MEMORY;
-        goto err_destroy_eps;
+        return UCS_ERR_NO_MEMORY;
     }
 
     for (i = 0; i < group_size; ++i) {
@@ -1104,52 +1459,88 @@ static ucs_status_t ucp_perf_test_setup_endpoints(ucx_perf_context_t *perf,
         remote_info = buffer;
         address     = (void*)(remote_info + 1);
         rkey_buffer = (void*)address + remote_info->ucp.addr_len;
-        perf->ucp.peers[i].remote_addr = remote_info->recv_buffer;
+        peers[i].remote_addr = remote_info->recv_buffer;
+
+        /* Keep the address to create more endpoints during the test */
+        peers[i].address = malloc(remote_info->ucp.addr_len);
+        if (peers[i].address == NULL) {
+            ucs_error("Failed to allocate remote worker address");
+            status = UCS_ERR_NO_MEMORY;
+            goto out_free_buffer;
+        }
+        memcpy(peers[i].address, address, remote_info->ucp.addr_len);
 
         ep_params.field_mask = UCP_EP_PARAM_FIELD_REMOTE_ADDRESS;
         ep_params.address    = address;
 
-        status = ucp_ep_create(perf->ucp.worker, &ep_params, &perf->ucp.peers[i].ep);
+        status = ucp_ep_create(worker, &ep_params, &peers[i].ep);
         if (status != UCS_OK) {
             if (perf->params.flags & UCX_PERF_TEST_FLAG_VERBOSE) {
                 ucs_error("ucp_ep_create() failed: %s", ucs_status_string(status));
             }
-            goto err_free_buffer;
+            goto out_free_buffer;
         }
 
         if (remote_info->rkey_size > 0) {
-            status = ucp_ep_rkey_unpack(perf->ucp.peers[i].ep, rkey_buffer,
-                                        &perf->ucp.peers[i].rkey);
+            status = ucp_ep_rkey_unpack(peers[i].ep, rkey_buffer,
+                                        &peers[i].rkey);
             if (status != UCS_OK) {
                 if (perf->params.flags & UCX_PERF_TEST_FLAG_VERBOSE) {
                     ucs_fatal("ucp_rkey_unpack() failed: %s", ucs_status_string(status));
                 }
-                goto err_free_buffer;
+                goto out_free_buffer;
             }
         } else {
-            perf->ucp.peers[i].rkey = NULL;
+            peers[i].rkey = NULL;
         }
     }
 
+    status = UCS_OK;
+
+out_free_buffer:
     free(buffer);
+    return status;
+}
 
-    status = ucp_perf_test_exchange_status(perf, UCS_OK);
-    if (status != UCS_OK) {
-        ucp_perf_test_destroy_eps(perf, group_size);
+static ucs_status_t ucp_perf_test_setup_endpoints(ucx_perf_context_t *perf,
+                                                  uint64_t features)
+{
+    unsigned num_ep_sets = ucp_perf_num_ep_sets(&perf->params);
+    unsigned group_size, i;
+    ucp_worker_h worker;
+    ucs_status_t status;
+
+    group_size      = rte_call(perf, group_size);
+    perf->ucp.peers = calloc(group_size * num_ep_sets, sizeof(*perf->ucp.peers));
+    if (perf->ucp.peers == NULL) {
+        status = UCS_ERR_NO_MEMORY;
+        goto err;
+    }
+
+    /* Endpoint set i is used by thread i, and connected to the worker of
+     * the same thread on the remote side */
+    for (i = 0; i < num_ep_sets; ++i) {
+        worker = perf->ucp.workers[i % perf->ucp.num_workers];
+        status = ucp_perf_test_connect_peers(perf, features, worker,
+                                             perf->ucp.peers + (i * group_size));
+        status = ucp_perf_test_exchange_status(perf, status);
+        if (status != UCS_OK) {
+            ucp_perf_test_destroy_eps(perf, group_size);
+            return status;
+        }
     }
 
     /* force wireup completion */
-    status = ucp_worker_flush(perf->ucp.worker);
-    if (status != UCS_OK) {
-        ucs_warn("ucp_worker_flush() failed: %s", ucs_status_string(status));
+    for (i = 0; i < perf->ucp.num_workers; ++i) {
+        status = ucp_worker_flush(perf->ucp.workers[i]);
+        if (status != UCS_OK) {
+            ucs_warn("ucp_worker_flush() failed: %s", ucs_status_string(status));
+            return status;
+        }
     }
 
-    return status;
+    return UCS_OK;
 
-err_free_buffer:
-    free(buffer);
-err_destroy_eps:
-    ucp_perf_test_destroy_eps(perf, group_size);
 err:
     (void)ucp_perf_test_exchange_status(perf, status);
     return status;
@@ -1238,8 +1629,18 @@ void uct_perf_barrier(ucx_perf_context_t *perf)
 
 void ucp_perf_barrier(ucx_perf_context_t *perf)
 {
-    rte_call(perf, barrier, (void(*)(void*))ucp_worker_progress,
-             (void*)perf->ucp.worker);
+    if (perf->ucp.num_workers > 1) {
+        /* The master thread progresses the workers of all threads during the
+         * barrier, so the other threads must stop using them first */
+#if _OPENMP
+#pragma omp barrier
+#endif
+        rte_call(perf, barrier,
+                 (void(*)(void*))ucp_perf_test_progress_workers, perf);
+    } else {
+        rte_call(perf, barrier, (void(*)(void*))ucp_worker_progress,
+                 (void*)perf->ucp.worker);
+    }
 }
 
 static ucs_status_t uct_perf_setup(ucx_perf_context_t *perf)
@@ -1333,10 +1734,72 @@ static void uct_perf_cleanup(ucx_perf_context_t *perf)
     ucs_async_context_cleanup(&perf->uct.async);
 }
 
+/* Save the lanes and transports selected for the peer endpoint */
+static void ucp_perf_test_save_ep_info(ucx_perf_context_t *perf)
+{
+    unsigned my_index = rte_call(perf, group_index);
+    FILE *stream;
+    size_t size;
+
+    perf->ucp.ep_info = NULL;
+    if (rte_call(perf, group_size) < 2) {
+        return;
+    }
+
+    stream = open_memstream(&perf->ucp.ep_info, &size);
+    if (stream == NULL) {
+        ucs_warn("open_memstream() failed: %m");
+        return;
+    }
+
+    ucp_ep_print_info(perf->ucp.peers[(my_index == 0) ? 1 : 0].ep, stream);
+    fclose(stream);
+}
+
+static void ucp_perf_test_destroy_workers(ucx_perf_context_t *perf)
+{
+    unsigned i;
+
+    for (i = 0; i < perf->ucp.num_workers; ++i) {
+        ucp_worker_destroy(perf->ucp.workers[i]);
+    }
+    free(perf->ucp.workers);
+}
+
+static ucs_status_t ucp_perf_test_create_workers(ucx_perf_context_t *perf)
+{
+    ucp_worker_params_t worker_params;
+    ucs_status_t status;
+    unsigned num_workers;
+
+    num_workers = ucp_perf_num_workers(&perf->params);
+    perf->ucp.workers = calloc(num_workers, sizeof(*perf->ucp.workers));
+    if (perf->ucp.workers == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    /* A worker of a single thread needs no locking */
+    worker_params.field_mask  = UCP_WORKER_PARAM_FIELD_THREAD_MODE;
+    worker_params.thread_mode = (num_workers > 1) ? UCS_THREAD_MODE_SERIALIZED :
+                                perf->params.thread_mode;
+
+    for (perf->ucp.num_workers = 0; perf->ucp.num_workers < num_workers;
+         ++perf->ucp.num_workers) {
+        status = ucp_worker_create(perf->ucp.context, &worker_params,
+                                   &perf->ucp.workers[perf->ucp.num_workers]);
+        if (status != UCS_OK) {
+            ucp_perf_test_destroy_workers(perf);
+            return status;
+        }
+    }
+
+    perf->ucp.worker = perf->ucp.workers[0];
+    return UCS_OK;
+}
+
 static ucs_status_t ucp_perf_setup(ucx_perf_context_t *perf)
 {
     ucp_params_t ucp_params;
-    ucp_worker_params_t worker_params;
     ucp_config_t *config;
     ucs_status_t status;
 
@@ -1348,6 +1811,11 @@ static ucs_status_t ucp_perf_setup(ucx_perf_context_t *perf)
         goto err;
     }
 
+    if (ucp_perf_num_workers(&perf->params) > 1) {
+        ucp_params.field_mask       |= UCP_PARAM_FIELD_MT_WORKERS_SHARED;
+        ucp_params.mt_workers_shared = 1;
+    }
+
     status = ucp_config_read(NULL, NULL, &config);
     if (status != UCS_OK) {
         goto err;
@@ -1359,11 +1827,7 @@ static ucs_status_t ucp_perf_setup(ucx_perf_context_t *perf)
         goto err;
     }
 
-    worker_params.field_mask  = UCP_WORKER_PARAM_FIELD_THREAD_MODE;
-    worker_params.thread_mode = perf->params.thread_mode;
-
-    status = ucp_worker_create(perf->ucp.context, &worker_params,
-                               &perf->ucp.worker);
+    status = ucp_perf_test_create_workers(perf);
     if (status != UCS_OK) {
         goto err_cleanup;
     }
@@ -1371,7 +1835,7 @@ static ucs_status_t ucp_perf_setup(ucx_perf_context_t *perf)
     status = ucp_perf_test_alloc_mem(perf);
     if (status != UCS_OK) {
         ucs_warn("ucp test failed to alocate memory");
-        goto err_destroy_worker;
+        goto err_destroy_workers;
     }
 
     status = ucp_perf_test_setup_endpoints(perf, ucp_params.features);
@@ -1382,12 +1846,13 @@ static ucs_status_t ucp_perf_setup(ucx_perf_context_t *perf)
         goto err_free_mem;
     }
 
+    ucp_perf_test_save_ep_info(perf);
     return UCS_OK;
 
 err_free_mem:
     ucp_perf_test_free_mem(perf);
-err_destroy_worker:
-    ucp_worker_destroy(perf->ucp.worker);
+err_destroy_workers:
+    ucp_perf_test_destroy_workers(perf);
 err_cleanup:
     ucp_cleanup(perf->ucp.context);
 err:
@@ -1396,10 +1861,11 @@ err:
 
 static void ucp_perf_cleanup(ucx_perf_context_t *perf)
 {
+    free(perf->ucp.ep_info);
     ucp_perf_test_cleanup_endpoints(perf);
     ucp_perf_barrier(perf);
     ucp_perf_test_free_mem(perf);
-    ucp_worker_destroy(perf->ucp.worker);
+    ucp_perf_test_destroy_workers(perf);
     ucp_cleanup(perf->ucp.context);
 }
 
@@ -1437,7 +1903,7 @@ ucs_status_t ucx_perf_run(ucx_perf_params_t *params, ucx_perf_result_t *result)
         goto out;
     }
 
-    perf = malloc(sizeof(*perf));
+    perf = calloc(1, sizeof(*perf));
     if (perf == NULL) {
         status = UCS_ERR_NO_MEMORY;
         goto out;
@@ -1493,7 +1959,7 @@ out:
 }
 
 #if _OPENMP
-/* multiple threads sharing the same worker/iface */
+/* multiple threads sharing the same worker/iface, or using a worker per thread */
 #include <omp.h>
 
 typedef struct {
@@ -1506,6 +1972,28 @@ typedef struct {
 } ucx_perf_thread_context_t;
 
 
+/* Total contention on the UCP worker locks since the workers were created */
+static void ucx_perf_get_lock_waits(ucx_perf_context_t *perf,
+                                    ucx_perf_counter_t *lock_waits_p,
+                                    double *lock_wait_time_p)
+{
+    ucp_worker_attr_t worker_attr;
+    unsigned i;
+
+    *lock_waits_p     = 0;
+    *lock_wait_time_p = 0;
+    if (perf->params.api != UCX_PERF_API_UCP) {
+        return;
+    }
+
+    worker_attr.field_mask = UCP_WORKER_ATTR_FIELD_LOCK_WAITS;
+    for (i = 0; i < perf->ucp.num_workers; ++i) {
+        ucp_worker_query(perf->ucp.workers[i], &worker_attr);
+        *lock_waits_p     += worker_attr.lock_waits;
+        *lock_wait_time_p += worker_attr.lock_wait_time;
+    }
+}
+
 static void* ucx_perf_thread_run_test(void* arg)
 {
     ucx_perf_thread_context_t* tctx = (ucx_perf_thread_context_t*) arg;
@@ -1513,6 +2001,7 @@ static void* ucx_perf_thread_run_test(void* arg)
     ucx_perf_context_t* perf = &tctx->perf;
     ucx_perf_params_t* params = &perf->params;
     ucs_status_t* statuses = tctx->statuses;
+    ptrdiff_t offset = perf->offset;
     int tid = tctx->tid;
     int i;
 
@@ -1525,10 +2014,14 @@ static void* ucx_perf_thread_run_test(void* arg)
                 goto out;
             }
         }
-#pragma omp master
         ucx_perf_test_reset(perf, params);
+        perf->offset = offset;
     }
 
+#pragma omp master
+    ucx_perf_get_lock_waits(perf, &perf->threads.lock_waits,
+                            &perf->threads.lock_wait_time);
+
     /* Run test */
 #pragma omp barrier
     statuses[tid] = ucx_perf_funcs[params->api].run(perf);
@@ -1538,24 +2031,70 @@ static void* ucx_perf_thread_run_test(void* arg)
             goto out;
         }
     }
-#pragma omp master
-    {
-        /* Assuming all threads are fairly treated, reporting only tid==0
-            TODO: aggregate reports */
-        ucx_perf_calc_result(perf, result);
-        rte_call(perf, report, result, perf->params.report_arg, 1);
-    }
+
+    ucx_perf_calc_result(perf, result);
 
 out:
     return &statuses[tid];
 }
 
+/* Sum the results of all threads, and merge their latency histograms to the
+ * histogram of the master thread */
+static void ucx_perf_thread_calc_result(ucx_perf_thread_context_t *tctx,
+                                        int nti, ucx_perf_result_t *result,
+                                        ucx_perf_result_t *thread_results)
+{
+    ucx_perf_context_t *master = &tctx[0].perf;
+    ucx_perf_counter_t lock_waits;
+    double lock_wait_time;
+    ucx_perf_result_t *tres;
+    int ti;
+
+    *result = tctx[0].result;
+    for (ti = 0; ti < nti; ti++) {
+        tres  = &thread_results[ti];
+        *tres = tctx[ti].result;
+        tres->latency_histogram = NULL;
+        if (ti == 0) {
+            continue;
+        }
+
+        result->iters                    += tres->iters;
+        result->bytes                    += tres->bytes;
+        result->elapsed_time              = ucs_max(result->elapsed_time,
+                                                    tres->elapsed_time);
+        result->latency.typical          += tres->latency.typical;
+        result->latency.moment_average   += tres->latency.moment_average;
+        result->latency.total_average    += tres->latency.total_average;
+        result->bandwidth.moment_average += tres->bandwidth.moment_average;
+        result->bandwidth.total_average  += tres->bandwidth.total_average;
+        result->msgrate.moment_average   += tres->msgrate.moment_average;
+        result->msgrate.total_average    += tres->msgrate.total_average;
+        ucx_perf_histogram_merge(&master->histogram, &tctx[ti].perf.histogram);
+    }
+
+    result->latency.typical        /= nti;
+    result->latency.moment_average /= nti;
+    result->latency.total_average  /= nti;
+    ucx_perf_histogram_calc_percentiles(&master->histogram, result);
+    result->latency_histogram = &master->histogram;
+
+    ucx_perf_get_lock_waits(master, &lock_waits, &lock_wait_time);
+    result->threads.count          = nti;
+    result->threads.results        = thread_results;
+    result->threads.lock_waits     = lock_waits - master->threads.lock_waits;
+    result->threads.lock_wait_time = lock_wait_time -
+                                     master->threads.lock_wait_time;
+}
+
 static int ucx_perf_thread_spawn(ucx_perf_context_t *perf,
                                  ucx_perf_result_t* result)
 {
     ucx_perf_thread_context_t* tctx;
+    ucx_perf_result_t* thread_results;
     ucs_status_t* statuses;
     size_t message_size;
+    unsigned group_size;
     ucs_status_t status;
     int ti, nti;
 
@@ -1563,13 +2102,16 @@ static int ucx_perf_thread_spawn(ucx_perf_context_t *perf,
     omp_set_num_threads(perf->params.thread_count);
     nti = perf->params.thread_count;
 
-    tctx     = calloc(nti, sizeof(ucx_perf_thread_context_t));
-    statuses = calloc(nti, sizeof(ucs_status_t));
-    if ((tctx == NULL) || (statuses == NULL)) {
+    tctx           = calloc(nti, sizeof(ucx_perf_thread_context_t));
+    statuses       = calloc(nti, sizeof(ucs_status_t));
+    thread_results = calloc(nti, sizeof(ucx_perf_result_t));
+    if ((tctx == NULL) || (statuses == NULL) || (thread_results == NULL)) {
         status = UCS_ERR_NO_MEMORY;
         goto out_free;
     }
 
+    group_size = rte_call(perf, group_size);
+
 #pragma omp parallel private(ti)
 {
     ti = omp_get_thread_num();
@@ -1581,6 +2123,11 @@ static int ucx_perf_thread_spawn(ucx_perf_context_t *perf,
     tctx[ti].perf.send_buffer += ti * message_size;
     tctx[ti].perf.recv_buffer += ti * message_size;
     tctx[ti].perf.offset = ti * message_size;
+    if ((perf->params.api == UCX_PERF_API_UCP) &&
+        (ucp_perf_num_ep_sets(&perf->params) > 1)) {
+        tctx[ti].perf.ucp.peers  += ti * group_size;
+        tctx[ti].perf.ucp.worker  = perf->ucp.workers[ti % perf->ucp.num_workers];
+    }
     ucx_perf_thread_run_test((void*)&tctx[ti]);
 }
 
@@ -1593,7 +2140,14 @@ static int ucx_perf_thread_spawn(ucx_perf_context_t *perf,
         }
     }
 
+    if (status == UCS_OK) {
+        ucx_perf_thread_calc_result(tctx, nti, result, thread_results);
+        rte_call(perf, report, result, perf->params.report_arg, 1);
+        result->threads.results = NULL;
+    }
+
 out_free:
+    free(thread_results);
     free(statuses);
     free(tctx);
     return status;
@@ -15,11 +15,18 @@ BEGIN_C_DECLS
 
 #include <ucs/time/time.h>
 #include <ucs/async/async.h>
+#include <ucs/arch/bitops.h>
+#include <ucs/memory/rcache.h>
 
 
 #define TIMING_QUEUE_SIZE    2048
 #define UCT_PERF_TEST_AM_ID  5
 
+/* Latency histogram has 2^(SUB_BITS-1) linear buckets for every power of 2 */
+#define UCX_PERF_HISTOGRAM_SUB_BITS  7
+#define UCX_PERF_HISTOGRAM_SIZE      ((64 - UCX_PERF_HISTOGRAM_SUB_BITS + 2) << \
+                                      (UCX_PERF_HISTOGRAM_SUB_BITS - 1))
+
 
 typedef struct ucx_perf_context  ucx_perf_context_t;
 typedef struct uct_peer          uct_peer_t;
@@ -36,6 +43,14 @@ struct ucx_perf_allocator {
 };
 
 
+struct ucx_perf_histogram {
+    double                       factor;   /* Iterations per sample */
+    uint64_t                     count;    /* Number of samples */
+    ucs_time_t                   max;      /* Maximal sample */
+    uint64_t                     buckets[UCX_PERF_HISTOGRAM_SIZE];
+};
+
+
 struct ucx_perf_context {
     ucx_perf_params_t            params;
 
@@ -60,8 +75,32 @@ struct ucx_perf_context {
         double                   time_acc; /* accurate time (for avg latency/bw/msgrate) */
     } current, prev;
 
+    /* Accumulated time of wireup test phases */
+    struct {
+        ucs_time_t               ep_create;
+        ucs_time_t               first_msg;
+        ucs_time_t               ep_close;
+        ucx_perf_counter_t       eps;     /* number of created endpoints */
+    } wireup;
+
+    /* Send buffers rotated by ucx_perf_next_send_buffer() */
+    struct {
+        void                     **buffers;
+        unsigned                 count;   /* 0 - always use send_buffer */
+        unsigned                 next;
+        size_t                   length;
+        ucs_rcache_counters_t    start;   /* rcache counters at test start */
+    } send_rotation;
+
+    /* Worker lock contention at test start, for multi-threaded tests */
+    struct {
+        ucx_perf_counter_t       lock_waits;
+        double                   lock_wait_time;
+    } threads;
+
     ucs_time_t                   timing_queue[TIMING_QUEUE_SIZE];
     unsigned                     timing_queue_head;
+    ucx_perf_histogram_t         histogram;
     const ucx_perf_allocator_t   *allocator;
 
     union {
@@ -79,11 +118,18 @@ struct ucx_perf_context {
         struct {
             ucp_context_h        context;
             ucp_worker_h         worker;
-            ucp_peer_t           *peers;
+            ucp_worker_h         *workers;     /* All workers, a worker per
+                                                  thread or a single worker */
+            unsigned             num_workers;
+            size_t               address_length;
+            ucp_peer_t           *peers;       /* A set of endpoints to the
+                                                  group for every thread, or
+                                                  one set if they are shared */
             ucp_mem_h            send_memh;
             ucp_mem_h            recv_memh;
             ucp_dt_iov_t         *send_iov;
             ucp_dt_iov_t         *recv_iov;
+            char                 *ep_info;
         } ucp;
     };
 };
@@ -100,6 +146,7 @@ struct ucp_peer {
     ucp_ep_h                     ep;
     unsigned long                remote_addr;
     ucp_rkey_h                   rkey;
+    ucp_address_t                *address; /* Remote worker address */
 };
 
 
@@ -139,6 +186,9 @@ void ucp_perf_barrier(ucx_perf_context_t *perf);
 void ucx_perf_cuda_global_init();
 
 
+void *ucx_perf_rotate_send_buffer(ucx_perf_context_t *perf);
+
+
 static UCS_F_ALWAYS_INLINE int ucx_perf_context_done(ucx_perf_context_t *perf)
 {
     return ucs_unlikely((perf->current.iters >= perf->max_iter) ||
@@ -151,21 +201,52 @@ static inline void ucx_perf_get_time(ucx_perf_context_t *perf)
     perf->current.time_acc = ucs_get_accurate_time();
 }
 
-static inline void ucx_perf_update(ucx_perf_context_t *perf,
-                                   ucx_perf_counter_t iters, size_t bytes)
+/*
+ * Values below 2^SUB_BITS have a bucket each, and larger values are divided to
+ * 2^(SUB_BITS-1) buckets for every power of 2, so the relative error is
+ * bounded by 2^-(SUB_BITS-1).
+ */
+static UCS_F_ALWAYS_INLINE unsigned ucx_perf_histogram_index(ucs_time_t value)
+{
+    unsigned shift;
+
+    if (value < UCS_BIT(UCX_PERF_HISTOGRAM_SUB_BITS)) {
+        return value;
+    }
+
+    shift = ucs_ilog2(value) - UCX_PERF_HISTOGRAM_SUB_BITS + 1;
+    return (shift << (UCX_PERF_HISTOGRAM_SUB_BITS - 1)) + (value >> shift);
+}
+
+static UCS_F_ALWAYS_INLINE void
+ucx_perf_histogram_add(ucx_perf_histogram_t *histogram, ucs_time_t value)
+{
+    ++histogram->buckets[ucx_perf_histogram_index(value)];
+    ++histogram->count;
+    histogram->max = ucs_max(histogram->max, value);
+}
+
+static inline void ucx_perf_update_msgs(ucx_perf_context_t *perf,
+                                        ucx_perf_counter_t iters,
+                                        ucx_perf_counter_t msgs, size_t bytes)
 {
     ucx_perf_result_t result;
 
     perf->current.time   = ucs_get_time();
     perf->current.iters += iters;
     perf->current.bytes += bytes;
-    perf->current.msgs  += 1;
-
-    perf->timing_queue[perf->timing_queue_head] =
-                    perf->current.time - perf->prev_time;
-    ++perf->timing_queue_head;
-    if (perf->timing_queue_head == TIMING_QUEUE_SIZE) {
-        perf->timing_queue_head = 0;
+    perf->current.msgs  += msgs;
+
+    /* Updates without iterations, such as the final flush, are not samples */
+    if (iters > 0) {
+        perf->timing_queue[perf->timing_queue_head] =
+                        perf->current.time - perf->prev_time;
+        ucx_perf_histogram_add(&perf->histogram,
+                               perf->current.time - perf->prev_time);
+        ++perf->timing_queue_head;
+        if (perf->timing_queue_head == TIMING_QUEUE_SIZE) {
+            perf->timing_queue_head = 0;
+        }
     }
 
     perf->prev_time = perf->current.time;
@@ -178,6 +259,12 @@ static inline void ucx_perf_update(ucx_perf_context_t *perf,
     }
 }
 
+static inline void ucx_perf_update(ucx_perf_context_t *perf,
+                                   ucx_perf_counter_t iters, size_t bytes)
+{
+    ucx_perf_update_msgs(perf, iters, 1, bytes);
+}
+
 
 /**
  * Get the total length of the message size given by parameters
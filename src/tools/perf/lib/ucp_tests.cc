@@ -140,21 +140,66 @@ public:
         }
     }
 
+    ucs_status_t UCS_F_ALWAYS_INLINE
+    send_tag(ucp_ep_h ep, void *buffer, size_t length, ucp_datatype_t datatype,
+             ucp_tag_t tag)
+    {
+        void *request;
+
+        wait_window(1);
+        request = ucp_tag_send_nb(ep, buffer, length, datatype, tag, send_cb);
+        if (ucs_likely(!UCS_PTR_IS_PTR(request))) {
+            return UCS_PTR_STATUS(request);
+        }
+        reinterpret_cast<ucp_perf_request_t*>(request)->context = this;
+        send_started();
+        return UCS_OK;
+    }
+
+    ucs_status_t UCS_F_ALWAYS_INLINE
+    recv_tag(ucp_worker_h worker, void *buffer, size_t length,
+             ucp_datatype_t datatype, ucp_tag_t tag)
+    {
+        void *request;
+
+        request = ucp_tag_recv_nb(worker, buffer, length, datatype, tag,
+                                  (ucp_tag_t)-1,
+                                  (ucp_tag_recv_callback_t)ucs_empty_function);
+        return wait(request, false);
+    }
+
+    UCS_F_ALWAYS_INLINE void* next_send_buffer(void *buffer)
+    {
+        if (ucs_likely(m_perf.send_rotation.count == 0)) {
+            return buffer;
+        }
+
+        if (m_perf.params.flags & UCX_PERF_TEST_FLAG_REALLOC_BUFFERS) {
+            /* Outstanding sends could still use the buffer to be unmapped */
+            wait_window(m_max_outstanding);
+        }
+        return ucx_perf_rotate_send_buffer(&m_perf);
+    }
+
     ucs_status_t UCS_F_ALWAYS_INLINE
     send(ucp_ep_h ep, void *buffer, unsigned length, ucp_datatype_t datatype,
          uint8_t sn, uint64_t remote_addr, ucp_rkey_h rkey)
     {
         void *request;
 
+        buffer = next_send_buffer(buffer);
+
         /* coverity[switch_selector_expr_is_constant] */
         switch (CMD) {
         case UCX_PERF_CMD_TAG:
         case UCX_PERF_CMD_TAG_SYNC:
         case UCX_PERF_CMD_STREAM:
+        case UCX_PERF_CMD_WIREUP:
             wait_window(1);
             /* coverity[switch_selector_expr_is_constant] */
             switch (CMD) {
             case UCX_PERF_CMD_TAG:
+            case UCX_PERF_CMD_WIREUP:
                 request = ucp_tag_send_nb(ep, buffer, length, datatype, TAG,
                                           send_cb);
                 break;
@@ -229,6 +274,7 @@ public:
         switch (CMD) {
         case UCX_PERF_CMD_TAG:
         case UCX_PERF_CMD_TAG_SYNC:
+        case UCX_PERF_CMD_WIREUP:
             if (FLAGS & UCX_PERF_TEST_FLAG_TAG_UNEXP_PROBE) {
                 ucp_tag_recv_info_t tag_info;
                 while (ucp_tag_probe_nb(worker, TAG, TAG_MASK, 0, &tag_info) == NULL) {
@@ -414,6 +460,409 @@ public:
         return UCS_OK;
     }
 
+    /* Stream between more than two ranks. On every iteration, in the incast
+     * pattern rank 0 receives a message from each of the other ranks, and in
+     * the all-to-all pattern every rank sends a message to and receives a
+     * message from each of the other ranks. */
+    ucs_status_t run_stream_uni_multi()
+    {
+        unsigned group_size, my_index, num_send, num_recv, peer, i;
+        void **requests;
+        ucp_worker_h worker;
+        void *send_buffer, *recv_buffer;
+        ucp_datatype_t send_datatype, recv_datatype;
+        size_t length, send_length, recv_length;
+        bool prepost_recv;
+        uint8_t sn;
+
+        length        = ucx_perf_get_message_size(&m_perf.params);
+        ucs_assert(length >= sizeof(psn_t));
+
+        ucp_perf_test_prepare_iov_buffers();
+
+        ucp_perf_barrier(&m_perf);
+
+        group_size    = rte_call(&m_perf, group_size);
+        my_index      = rte_call(&m_perf, group_index);
+        if (m_perf.params.pattern == UCX_PERF_PATTERN_INCAST) {
+            num_send  = (my_index == 0) ? 0 : 1;
+            num_recv  = (my_index == 0) ? (group_size - 1) : 0;
+        } else {
+            num_send  = group_size - 1;
+            num_recv  = group_size - 1;
+        }
+
+        /* When a rank both sends and receives, post the tag receives before
+         * sending, so rendezvous and sync sends of all ranks can complete */
+        prepost_recv  = ((CMD == UCX_PERF_CMD_TAG) ||
+                         (CMD == UCX_PERF_CMD_TAG_SYNC)) &&
+                        (num_send > 0) && (num_recv > 0);
+        requests      = (void**)ucs_alloca(num_recv * sizeof(*requests));
+
+        ucx_perf_test_start_clock(&m_perf);
+
+        send_buffer   = m_perf.send_buffer;
+        recv_buffer   = m_perf.recv_buffer;
+        worker        = m_perf.ucp.worker;
+        sn            = 0;
+        send_length   = length;
+        recv_length   = length;
+        send_datatype = ucp_perf_test_get_datatype(m_perf.params.ucp.send_datatype,
+                                                   m_perf.ucp.send_iov, &send_length,
+                                                   &send_buffer);
+        recv_datatype = ucp_perf_test_get_datatype(m_perf.params.ucp.recv_datatype,
+                                                   m_perf.ucp.recv_iov, &recv_length,
+                                                   &recv_buffer);
+
+        UCX_PERF_TEST_FOREACH(&m_perf) {
+            if (prepost_recv) {
+                for (i = 0; i < num_recv; ++i) {
+                    requests[i] = ucp_tag_recv_nb(worker, recv_buffer, recv_length,
+                                                  recv_datatype, TAG, TAG_MASK,
+                                                  (ucp_tag_recv_callback_t)
+                                                  ucs_empty_function);
+                }
+            }
+
+            for (i = 0; i < num_send; ++i) {
+                peer = (m_perf.params.pattern == UCX_PERF_PATTERN_INCAST) ? 0 :
+                       ((my_index + 1 + i) % group_size);
+                send(m_perf.ucp.peers[peer].ep, send_buffer, send_length,
+                     send_datatype, sn,
+                     m_perf.ucp.peers[peer].remote_addr + m_perf.offset,
+                     m_perf.ucp.peers[peer].rkey);
+            }
+
+            for (i = 0; i < num_recv; ++i) {
+                if (prepost_recv) {
+                    wait(requests[i], false);
+                } else {
+                    peer = (my_index + 1 + i) % group_size;
+                    recv(worker, m_perf.ucp.peers[peer].ep, recv_buffer,
+                         recv_length, recv_datatype, sn);
+                }
+            }
+
+            ucx_perf_update_msgs(&m_perf, 1, ucs_max(num_send, num_recv),
+                                 ucs_max(num_send, num_recv) * length);
+            ++sn;
+        }
+
+        wait_window(m_max_outstanding);
+        ucp_worker_flush(m_perf.ucp.worker);
+        ucx_perf_get_time(&m_perf);
+
+        if (num_send > 0) {
+            ucx_perf_update_msgs(&m_perf, 0, 0, 0);
+        }
+
+        ucp_perf_barrier(&m_perf);
+        return UCS_OK;
+    }
+
+    ucs_status_t close_eps(ucp_ep_h *eps, void **requests, unsigned count)
+    {
+        ucs_status_t status = UCS_OK;
+        unsigned i;
+
+        for (i = 0; i < count; ++i) {
+            requests[i] = ucp_ep_close_nb(eps[i], UCP_EP_CLOSE_MODE_FLUSH);
+        }
+
+        for (i = 0; i < count; ++i) {
+            if (UCS_PTR_IS_ERR(requests[i])) {
+                status = UCS_PTR_STATUS(requests[i]);
+            } else if (requests[i] != NULL) {
+                while (ucp_request_check_status(requests[i]) == UCS_INPROGRESS) {
+                    progress_requestor();
+                }
+                ucp_request_free(requests[i]);
+            }
+        }
+
+        return status;
+    }
+
+    /* Every iteration, rank 1 creates endpoints to rank 0, sends a message on
+     * each new endpoint and waits for a reply on the existing endpoint, and
+     * then closes the new endpoints. Rank 0 takes over the endpoints created
+     * by the connection requests, by creating the same number of endpoints
+     * to rank 1, and closes them as well. */
+    ucs_status_t run_wireup()
+    {
+        const unsigned num_eps = m_perf.params.ucp.wireup_eps;
+        unsigned my_index, i;
+        ucp_worker_h worker;
+        ucp_ep_params_t ep_params;
+        ucp_ep_h peer_ep, *eps;
+        void *send_buffer, *recv_buffer, **requests;
+        ucp_datatype_t send_datatype, recv_datatype;
+        size_t length, send_length, recv_length;
+        ucs_time_t t_start, t_created, t_sent;
+        ucs_status_t status;
+
+        length        = ucx_perf_get_message_size(&m_perf.params);
+        ucs_assert(length >= sizeof(psn_t));
+
+        eps      = (ucp_ep_h*)malloc(num_eps * sizeof(*eps));
+        requests = (void**)malloc(num_eps * sizeof(*requests));
+        if ((eps == NULL) || (requests == NULL)) {
+            free(requests);
+            free(eps);
+            return UCS_ERR_NO_MEMORY;
+        }
+
+        ucp_perf_test_prepare_iov_buffers();
+
+        ucp_perf_barrier(&m_perf);
+
+        my_index      = rte_call(&m_perf, group_index);
+
+        ucx_perf_test_start_clock(&m_perf);
+
+        status        = UCS_OK;
+        send_buffer   = m_perf.send_buffer;
+        recv_buffer   = m_perf.recv_buffer;
+        worker        = m_perf.ucp.worker;
+        peer_ep       = m_perf.ucp.peers[1 - my_index].ep;
+        send_length   = length;
+        recv_length   = length;
+        send_datatype = ucp_perf_test_get_datatype(m_perf.params.ucp.send_datatype,
+                                                   m_perf.ucp.send_iov, &send_length,
+                                                   &send_buffer);
+        recv_datatype = ucp_perf_test_get_datatype(m_perf.params.ucp.recv_datatype,
+                                                   m_perf.ucp.recv_iov, &recv_length,
+                                                   &recv_buffer);
+
+        ep_params.field_mask = UCP_EP_PARAM_FIELD_REMOTE_ADDRESS;
+        ep_params.address    = m_perf.ucp.peers[1 - my_index].address;
+
+        if (my_index == 1) {
+            UCX_PERF_TEST_FOREACH(&m_perf) {
+                t_start = ucs_get_time();
+                for (i = 0; i < num_eps; ++i) {
+                    status = ucp_ep_create(worker, &ep_params, &eps[i]);
+                    if (status != UCS_OK) {
+                        close_eps(eps, requests, i);
+                        goto out;
+                    }
+                }
+
+                t_created = ucs_get_time();
+                for (i = 0; i < num_eps; ++i) {
+                    send(eps[i], send_buffer, send_length, send_datatype, 0, 0,
+                         NULL);
+                    recv(worker, peer_ep, recv_buffer, recv_length,
+                         recv_datatype, 0);
+                }
+                wait_window(m_max_outstanding);
+
+                t_sent = ucs_get_time();
+                status = close_eps(eps, requests, num_eps);
+                if (status != UCS_OK) {
+                    goto out;
+                }
+
+                m_perf.wireup.ep_create += t_created - t_start;
+                m_perf.wireup.first_msg += t_sent - t_created;
+                m_perf.wireup.ep_close  += ucs_get_time() - t_sent;
+                m_perf.wireup.eps       += num_eps;
+                ucx_perf_update(&m_perf, 1, num_eps * length);
+            }
+        } else if (my_index == 0) {
+            UCX_PERF_TEST_FOREACH(&m_perf) {
+                for (i = 0; i < num_eps; ++i) {
+                    recv(worker, peer_ep, recv_buffer, recv_length,
+                         recv_datatype, 0);
+                    send(peer_ep, send_buffer, send_length, send_datatype, 0,
+                         0, NULL);
+                }
+
+                /* Every endpoint is matched to the next connection request */
+                for (i = 0; i < num_eps; ++i) {
+                    status = ucp_ep_create(worker, &ep_params, &eps[i]);
+                    if (status != UCS_OK) {
+                        close_eps(eps, requests, i);
+                        goto out;
+                    }
+                }
+
+                status = close_eps(eps, requests, num_eps);
+                if (status != UCS_OK) {
+                    goto out;
+                }
+
+                ucx_perf_update(&m_perf, 1, num_eps * length);
+            }
+        }
+
+        wait_window(m_max_outstanding);
+        ucp_worker_flush(m_perf.ucp.worker);
+        ucx_perf_get_time(&m_perf);
+out:
+        ucp_perf_barrier(&m_perf);
+        free(requests);
+        free(eps);
+        return status;
+    }
+
+    /* Every iteration, rank 1 sends a batch of messages with different tags,
+     * and rank 0 matches all of them. With UCX_PERF_TEST_FLAG_TAG_UNEXP_PROBE,
+     * rank 0 posts the receives only after the whole batch arrived, so every
+     * receive searches the unexpected queue; otherwise the receives are posted
+     * before the batch is sent, so every message searches the expected queue.
+     * A control message, which has a tag outside of the batch tag range,
+     * separates the two phases. */
+    ucs_status_t run_tag_match()
+    {
+        const unsigned depth       = m_perf.params.ucp.tag_depth;
+        const unsigned tag_count   = m_perf.params.ucp.tag_count;
+        const unsigned any_percent = m_perf.params.ucp.tag_any_source_percent;
+        const bool unexpected      = m_perf.params.flags &
+                                     UCX_PERF_TEST_FLAG_TAG_UNEXP_PROBE;
+        unsigned my_index, i, j, seed;
+        ucp_worker_h worker;
+        ucp_ep_h ep;
+        void *send_buffer, *recv_buffer, **requests;
+        ucp_datatype_t send_datatype, recv_datatype;
+        size_t length, send_length, recv_length;
+        ucp_tag_t *recv_tags, *recv_masks, send_tag_base, ctrl_tag, tag;
+        ucs_status_t status;
+
+        length        = ucx_perf_get_message_size(&m_perf.params);
+        ucs_assert(length >= sizeof(psn_t));
+
+        requests   = (void**)malloc(depth * sizeof(*requests));
+        recv_tags  = (ucp_tag_t*)malloc(depth * sizeof(*recv_tags));
+        recv_masks = (ucp_tag_t*)malloc(depth * sizeof(*recv_masks));
+        if ((requests == NULL) || (recv_tags == NULL) || (recv_masks == NULL)) {
+            free(recv_masks);
+            free(recv_tags);
+            free(requests);
+            return UCS_ERR_NO_MEMORY;
+        }
+
+        ucp_perf_test_prepare_iov_buffers();
+
+        ucp_perf_barrier(&m_perf);
+
+        my_index      = rte_call(&m_perf, group_index);
+
+        /* Tag carries the sender index in the upper 32 bits, and a receive
+         * from any source ignores them */
+        send_tag_base = ((ucp_tag_t)my_index << 32) | TAG;
+        ctrl_tag      = TAG - 1;
+
+        /* Tag of i-th message is (i % tag_count). Receives are posted in either
+         * the same or random order, and any-source receives are spread evenly */
+        for (i = 0; i < depth; ++i) {
+            recv_tags[i] = ((ucp_tag_t)(1 - my_index) << 32) | (TAG + (i % tag_count));
+        }
+        if (m_perf.params.flags & UCX_PERF_TEST_FLAG_TAG_RANDOM_ORDER) {
+            seed = 1;
+            for (i = depth - 1; i > 0; --i) {
+                j            = rand_r(&seed) % (i + 1);
+                tag          = recv_tags[i];
+                recv_tags[i] = recv_tags[j];
+                recv_tags[j] = tag;
+            }
+        }
+        for (i = 0; i < depth; ++i) {
+            recv_masks[i] = (((i + 1) * any_percent / 100) != (i * any_percent / 100)) ?
+                            UCS_MASK(32) : (ucp_tag_t)-1;
+        }
+
+        ucx_perf_test_start_clock(&m_perf);
+
+        status        = UCS_OK;
+        send_buffer   = m_perf.send_buffer;
+        recv_buffer   = m_perf.recv_buffer;
+        worker        = m_perf.ucp.worker;
+        ep            = m_perf.ucp.peers[1 - my_index].ep;
+        send_length   = length;
+        recv_length   = length;
+        send_datatype = ucp_perf_test_get_datatype(m_perf.params.ucp.send_datatype,
+                                                   m_perf.ucp.send_iov, &send_length,
+                                                   &send_buffer);
+        recv_datatype = ucp_perf_test_get_datatype(m_perf.params.ucp.recv_datatype,
+                                                   m_perf.ucp.recv_iov, &recv_length,
+                                                   &recv_buffer);
+
+        if (my_index == 0) {
+            UCX_PERF_TEST_FOREACH(&m_perf) {
+                if (unexpected) {
+                    status = recv_tag(worker, recv_buffer, recv_length,
+                                      recv_datatype, ctrl_tag);
+                    if (status != UCS_OK) {
+                        goto out;
+                    }
+                }
+
+                for (i = 0; i < depth; ++i) {
+                    requests[i] = ucp_tag_recv_nb(worker, recv_buffer,
+                                                  recv_length, recv_datatype,
+                                                  recv_tags[i], recv_masks[i],
+                                                  (ucp_tag_recv_callback_t)
+                                                  ucs_empty_function);
+                }
+
+                if (!unexpected) {
+                    send_tag(ep, send_buffer, send_length, send_datatype,
+                             ctrl_tag);
+                }
+
+                for (i = 0; i < depth; ++i) {
+                    status = wait(requests[i], false);
+                    if (status != UCS_OK) {
+                        goto out;
+                    }
+                }
+
+                if (unexpected) {
+                    send_tag(ep, send_buffer, send_length, send_datatype,
+                             ctrl_tag);
+                }
+                ucx_perf_update_msgs(&m_perf, 1, depth, depth * length);
+            }
+        } else if (my_index == 1) {
+            UCX_PERF_TEST_FOREACH(&m_perf) {
+                if (!unexpected) {
+                    status = recv_tag(worker, recv_buffer, recv_length,
+                                      recv_datatype, ctrl_tag);
+                    if (status != UCS_OK) {
+                        goto out;
+                    }
+                }
+
+                for (i = 0; i < depth; ++i) {
+                    send_tag(ep, send_buffer, send_length, send_datatype,
+                             send_tag_base + (i % tag_count));
+                }
+
+                if (unexpected) {
+                    send_tag(ep, send_buffer, send_length, send_datatype,
+                             ctrl_tag);
+                    status = recv_tag(worker, recv_buffer, recv_length,
+                                      recv_datatype, ctrl_tag);
+                    if (status != UCS_OK) {
+                        goto out;
+                    }
+                }
+                ucx_perf_update_msgs(&m_perf, 1, depth, depth * length);
+            }
+        }
+
+        wait_window(m_max_outstanding);
+        ucp_worker_flush(m_perf.ucp.worker);
+        ucx_perf_get_time(&m_perf);
+out:
+        ucp_perf_barrier(&m_perf);
+        free(recv_masks);
+        free(recv_tags);
+        free(requests);
+        return status;
+    }
+
     ucs_status_t run()
     {
         /* coverity[switch_selector_expr_is_constant] */
@@ -421,6 +870,13 @@ public:
         case UCX_PERF_TEST_TYPE_PINGPONG:
             return run_pingpong();
         case UCX_PERF_TEST_TYPE_STREAM_UNI:
+            if (CMD == UCX_PERF_CMD_WIREUP) {
+                return run_wireup();
+            } else if (CMD == UCX_PERF_CMD_TAG_MATCH) {
+                return run_tag_match();
+            } else if (m_perf.params.pattern != UCX_PERF_PATTERN_PAIR) {
+                return run_stream_uni_multi();
+            }
             return run_stream_uni();
         case UCX_PERF_TEST_TYPE_STREAM_BI:
         default:
@@ -556,6 +1012,9 @@ ucs_status_t ucp_perf_test_dispatch(ucx_perf_context_t *perf)
         (UCX_PERF_CMD_STREAM,   UCX_PERF_TEST_TYPE_PINGPONG)
         );
 
+    TEST_CASE(perf, UCX_PERF_CMD_WIREUP, UCX_PERF_TEST_TYPE_STREAM_UNI, 0, 0);
+    TEST_CASE(perf, UCX_PERF_CMD_TAG_MATCH, UCX_PERF_TEST_TYPE_STREAM_UNI, 0, 0);
+
     ucs_error("Invalid test case: %d/%d/0x%x",
               perf->params.command, perf->params.test_type,
               perf->params.flags);
@@ -17,8 +17,13 @@
 
 #include <ucs/sys/string.h>
 #include <ucs/sys/sys.h>
+#include <ucs/config/parser.h>
 #include <ucs/debug/log.h>
+#include <ucs/arch/atomic.h>
+#include <ucs/arch/cpu.h>
 #include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
 #include <arpa/inet.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -29,6 +34,10 @@
 #include <sys/types.h>
 #include <sys/poll.h>
 #include <locale.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/utsname.h>
 #if HAVE_MPI
 #  include <mpi.h>
 #elif HAVE_RTE
@@ -36,8 +45,10 @@
 #endif
 
 #define MAX_BATCH_FILES         32
+#define SHM_RTE_MAX_DATA        65536
+#define SHM_RTE_MAX_THREADS     64
 #define TL_RESOURCE_NAME_NONE   "<none>"
-#define TEST_PARAMS_ARGS        "t:n:s:W:O:w:D:i:H:oSCqM:r:T:d:x:A:BUm:"
+#define TEST_PARAMS_ARGS        "t:n:s:W:O:w:D:i:H:oSCqM:r:T:d:x:A:BUm:E:k:RQ:j:y:ze:"
 
 
 enum {
@@ -55,6 +66,46 @@ typedef struct sock_rte_group {
 } sock_rte_group_t;
 
 
+typedef struct shm_rte_barrier {
+    volatile uint32_t            count;     /* Number of arrived ranks */
+    volatile uint32_t            sense;     /* Flipped by the last arriving rank */
+} shm_rte_barrier_t;
+
+
+/* Per-rank area in the memory shared by locally launched processes */
+typedef struct shm_rte_slot {
+    shm_rte_barrier_t            barrier;   /* Barrier of the group which
+                                               starts with this rank */
+    volatile uint64_t            post_sn;   /* Number of posted messages */
+    volatile uint32_t            readers;   /* Number of group members which
+                                               have read the last message */
+    size_t                       size;      /* Size of the last message */
+    char                         data[SHM_RTE_MAX_DATA];
+    ucx_perf_result_t            result;    /* Final result of the last test */
+    ucx_perf_histogram_t         histogram; /* Latency histogram of the last test */
+    ucx_perf_result_t            thread_results[SHM_RTE_MAX_THREADS];
+                                            /* Results of the first threads */
+} shm_rte_slot_t;
+
+
+typedef struct shm_rte_shared {
+    shm_rte_barrier_t            barrier;   /* Barrier of all ranks */
+    shm_rte_slot_t               slots[0];
+} shm_rte_shared_t;
+
+
+typedef struct shm_rte_group {
+    shm_rte_shared_t             *shared;
+    unsigned                     rank;          /* Rank among all processes */
+    unsigned                     first;         /* Rank of group member 0 */
+    unsigned                     size;          /* Number of group members */
+    uint32_t                     sense;         /* Local sense of group barrier */
+    uint32_t                     global_sense;  /* Local sense of global barrier */
+    uint64_t                     *recv_sn;      /* Number of messages received
+                                                   from each group member */
+} shm_rte_group_t;
+
+
 typedef struct test_type {
     const char                   *name;
     ucx_perf_api_t               api;
@@ -71,12 +122,30 @@ struct perftest_context {
     int                          mpi;
     unsigned                     cpu;
     unsigned                     flags;
+    const char                   *histogram_file;
+    const char                   *json_file;
+    unsigned                     num_procs;     /* Local processes to launch */
+    const char                   *row_label;    /* Label of the printed result */
 
     unsigned                     num_batch_files;
     char                         *batch_files[MAX_BATCH_FILES];
     char                         *test_names[MAX_BATCH_FILES];
 
     sock_rte_group_t             sock_rte_group;
+    shm_rte_group_t              shm_rte_group;
+};
+
+
+static const char *thread_model_names[] = {
+    [UCP_PERF_THREAD_MODEL_SHARED_EP]     = "shared_ep",
+    [UCP_PERF_THREAD_MODEL_SHARED_WORKER] = "shared_worker",
+    [UCP_PERF_THREAD_MODEL_WORKER]        = "worker"
+};
+
+static const char *pattern_names[] = {
+    [UCX_PERF_PATTERN_PAIR]     = "pair",
+    [UCX_PERF_PATTERN_INCAST]   = "incast",
+    [UCX_PERF_PATTERN_ALLTOALL] = "alltoall"
 };
 
 
@@ -150,6 +219,12 @@ test_type_t tests[] = {
     {"stream_lat", UCX_PERF_API_UCP, UCX_PERF_CMD_STREAM, UCX_PERF_TEST_TYPE_PINGPONG,
      "stream latency"},
 
+    {"ucp_wireup", UCX_PERF_API_UCP, UCX_PERF_CMD_WIREUP, UCX_PERF_TEST_TYPE_STREAM_UNI,
+     "endpoint creation / first message / close time"},
+
+    {"tag_match", UCX_PERF_API_UCP, UCX_PERF_CMD_TAG_MATCH, UCX_PERF_TEST_TYPE_STREAM_UNI,
+     "tag matching of a batch of expected or unexpected messages"},
+
      {NULL}
 };
 
@@ -202,13 +277,251 @@ static int safe_recv(int sock, void *data, size_t size,
     return sock_io(sock, recv, POLLIN, data, size, progress, arg, "recv");
 }
 
-static void print_progress(char **test_names, unsigned num_names,
-                           const ucx_perf_result_t *result, unsigned flags,
-                           int final)
+static void print_histogram(struct perftest_context *ctx,
+                            const ucx_perf_result_t *result)
+{
+    unsigned i;
+    FILE *f;
+
+    f = fopen(ctx->histogram_file, "a");
+    if (f == NULL) {
+        ucs_error("failed to open histogram file '%s': %m", ctx->histogram_file);
+        return;
+    }
+
+    fprintf(f, "# latency histogram");
+    for (i = 0; i < ctx->num_batch_files; ++i) {
+        fprintf(f, " %s", ctx->test_names[i]);
+    }
+    fprintf(f, "\n");
+    ucx_perf_histogram_print(result->latency_histogram, f);
+    fprintf(f, "\n");
+    fclose(f);
+}
+
+static void print_json_string(FILE *f, const char *str)
+{
+    const char *p;
+
+    if (str == NULL) {
+        fprintf(f, "null");
+        return;
+    }
+
+    fputc('"', f);
+    for (p = str; *p != '\0'; ++p) {
+        if ((*p == '"') || (*p == '\\')) {
+            fprintf(f, "\\%c", *p);
+        } else if (*p == '\n') {
+            fprintf(f, "\\n");
+        } else if ((unsigned char)*p < 0x20) {
+            fprintf(f, "\\u%04x", (unsigned char)*p);
+        } else {
+            fputc(*p, f);
+        }
+    }
+    fputc('"', f);
+}
+
+/* Print the effective UCX configuration, in the same form as "ucx_info -c" */
+static void print_json_config(FILE *f)
 {
-    static const char *fmt_csv     =  "%.0f,%.3f,%.3f,%.3f,%.2f,%.2f,%.0f,%.0f\n";
+    char *config, *line, *value, *saveptr;
+    FILE *stream;
+    size_t size;
+    int first;
+
+    config = NULL;
+    stream = open_memstream(&config, &size);
+    if (stream == NULL) {
+        fprintf(f, "{}");
+        return;
+    }
+
+    ucs_config_parser_print_all_opts(stream, UCS_CONFIG_PRINT_CONFIG);
+    fclose(stream);
+
+    fprintf(f, "{");
+    first = 1;
+    for (line = strtok_r(config, "\n", &saveptr); line != NULL;
+         line = strtok_r(NULL, "\n", &saveptr)) {
+        value = strchr(line, '=');
+        if ((line[0] == '#') || (value == NULL)) {
+            continue;
+        }
+
+        *(value++) = '\0';
+        fprintf(f, "%s", first ? "" : ", ");
+        print_json_string(f, line);
+        fprintf(f, ": ");
+        print_json_string(f, value);
+        first = 0;
+    }
+    fprintf(f, "}");
+    free(config);
+}
+
+static const char *test_name(const ucx_perf_params_t *params)
+{
+    test_type_t *test;
+
+    for (test = tests; test->name != NULL; ++test) {
+        if ((test->api == params->api) && (test->command == params->command) &&
+            (test->test_type == params->test_type)) {
+            return test->name;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Append the final result of the test, with the parameters it was run with
+ * and a description of the host and the configuration, as a single JSON
+ * object on a separate line.
+ */
+static void print_json(struct perftest_context *ctx,
+                       const ucx_perf_result_t *result)
+{
+    static const char *api_names[]       = {"uct", "ucp"};
+    static const char *test_type_names[] = {"pingpong", "stream_uni",
+                                            "stream_bi"};
+    static const char *thread_mode_names[] = {"single", "serialized", "multi"};
+    static const char *mem_type_names[]  = {"host", "cuda", "cuda-managed",
+                                            "rocm"};
+    static const char *layout_names[]    = {"short", "bcopy", "zcopy"};
+    static const char *datatype_names[]  = {"contig", "iov"};
+    const ucx_perf_params_t *params = &ctx->params;
+    struct utsname uts;
+    unsigned i;
+    FILE *f;
+
+    f = fopen(ctx->json_file, "a");
+    if (f == NULL) {
+        ucs_error("failed to open JSON output file '%s': %m", ctx->json_file);
+        return;
+    }
+
+    fprintf(f, "{\"timestamp\": %ld, \"test\": ", (long)time(NULL));
+    print_json_string(f, test_name(params));
+    fprintf(f, ", \"batch\": [");
+    for (i = 0; i < ctx->num_batch_files; ++i) {
+        fprintf(f, "%s", (i == 0) ? "" : ", ");
+        print_json_string(f, ctx->test_names[i]);
+    }
+    fprintf(f, "], \"row\": ");
+    print_json_string(f, (ctx->num_procs > 0) ? ctx->row_label : NULL);
+
+    fprintf(f, ", \"params\": {\"api\": \"%s\", \"test_type\": \"%s\", "
+            "\"pattern\": \"%s\", \"processes\": %u, \"thread_mode\": \"%s\", "
+            "\"threads\": %u, \"wait_mode\": %d, \"mem_type\": \"%s\", "
+            "\"flags\": %u, \"msg_size\": [",
+            api_names[params->api], test_type_names[params->test_type],
+            pattern_names[params->pattern], ucs_max(ctx->num_procs, 2),
+            thread_mode_names[params->thread_mode], params->thread_count,
+            params->wait_mode, mem_type_names[params->mem_type],
+            params->flags);
+    for (i = 0; i < params->msg_size_cnt; ++i) {
+        fprintf(f, "%s%zu", (i == 0) ? "" : ", ", params->msg_size_list[i]);
+    }
+    fprintf(f, "], \"iov_stride\": %zu, \"am_hdr_size\": %zu, "
+            "\"alignment\": %zu, \"max_outstanding\": %u, "
+            "\"send_buffers\": %u, \"warmup_iter\": %" PRIu64 ", "
+            "\"max_iter\": %" PRIu64 ", \"max_time\": %.3f",
+            params->iov_stride, params->am_hdr_size, params->alignment,
+            params->max_outstanding, params->send_buffers,
+            params->warmup_iter, params->max_iter, params->max_time);
+    if (params->api == UCX_PERF_API_UCT) {
+        fprintf(f, ", \"uct\": {\"tl\": ");
+        print_json_string(f, params->uct.tl_name);
+        fprintf(f, ", \"dev\": ");
+        print_json_string(f, params->uct.dev_name);
+        fprintf(f, ", \"data_layout\": \"%s\", \"fc_window\": %u}",
+                layout_names[params->uct.data_layout], params->uct.fc_window);
+    } else {
+        fprintf(f, ", \"ucp\": {\"send_datatype\": \"%s\", "
+                "\"recv_datatype\": \"%s\", \"wireup_eps\": %u, "
+                "\"tag_depth\": %u, \"tag_count\": %u, "
+                "\"tag_any_source_percent\": %u, \"thread_model\": \"%s\"}",
+                datatype_names[params->ucp.send_datatype],
+                datatype_names[params->ucp.recv_datatype],
+                params->ucp.wireup_eps, params->ucp.tag_depth,
+                params->ucp.tag_count, params->ucp.tag_any_source_percent,
+                thread_model_names[params->ucp.thread_model]);
+    }
+    fprintf(f, "}");
+
+    fprintf(f, ", \"result\": {\"iterations\": %" PRIu64 ", "
+            "\"bytes\": %" PRIu64 ", \"elapsed_time\": %.9f, "
+            "\"latency\": {\"typical\": %.9f, \"average\": %.9f, "
+            "\"overall\": %.9f, \"p50\": %.9f, \"p90\": %.9f, \"p99\": %.9f, "
+            "\"p999\": %.9f, \"max\": %.9f}, "
+            "\"bandwidth\": {\"average\": %.3f, \"overall\": %.3f}, "
+            "\"msgrate\": {\"average\": %.3f, \"overall\": %.3f}",
+            result->iters, result->bytes, result->elapsed_time,
+            result->latency.typical, result->latency.moment_average,
+            result->latency.total_average, result->latency_percentile.p50,
+            result->latency_percentile.p90, result->latency_percentile.p99,
+            result->latency_percentile.p999, result->latency_percentile.max,
+            result->bandwidth.moment_average, result->bandwidth.total_average,
+            result->msgrate.moment_average, result->msgrate.total_average);
+    if (params->command == UCX_PERF_CMD_WIREUP) {
+        fprintf(f, ", \"wireup\": {\"ep_create\": %.9f, \"first_msg\": %.9f, "
+                "\"ep_close\": %.9f, \"address_size\": %zu}",
+                result->wireup.ep_create, result->wireup.first_msg,
+                result->wireup.ep_close, result->wireup.address_size);
+    }
+    fprintf(f, ", \"rcache\": {\"gets\": %" PRIu64 ", \"regs\": %" PRIu64 ", "
+            "\"invalidations\": %" PRIu64 ", \"hit_ratio\": %.6f, "
+            "\"reg_time\": %.9f}",
+            result->rcache.gets, result->rcache.regs,
+            result->rcache.invalidations, result->rcache.hit_ratio,
+            result->rcache.reg_time);
+    if (result->threads.count > 1) {
+        fprintf(f, ", \"threads\": {\"lock_waits\": %" PRIu64 ", "
+                "\"lock_wait_time\": %.9f, \"results\": [",
+                result->threads.lock_waits, result->threads.lock_wait_time);
+        for (i = 0; (result->threads.results != NULL) &&
+                    (i < result->threads.count); ++i) {
+            fprintf(f, "%s{\"iterations\": %" PRIu64 ", \"latency\": %.9f, "
+                    "\"bandwidth\": %.3f, \"msgrate\": %.3f}",
+                    (i == 0) ? "" : ", ", result->threads.results[i].iters,
+                    result->threads.results[i].latency.total_average,
+                    result->threads.results[i].bandwidth.total_average,
+                    result->threads.results[i].msgrate.total_average);
+        }
+        fprintf(f, "]}");
+    }
+    fprintf(f, "}");
+
+    fprintf(f, ", \"ep_info\": ");
+    print_json_string(f, result->ep_info);
+
+    fprintf(f, ", \"host\": {\"hostname\": ");
+    print_json_string(f, ucs_get_host_name());
+    if (uname(&uts) == 0) {
+        fprintf(f, ", \"kernel\": ");
+        print_json_string(f, uts.release);
+        fprintf(f, ", \"machine\": ");
+        print_json_string(f, uts.machine);
+    }
+    fprintf(f, ", \"cpus\": %ld, \"ucx_version\": ",
+            sysconf(_SC_NPROCESSORS_ONLN));
+    print_json_string(f, ucp_get_version_string());
+    fprintf(f, "}, \"config\": ");
+    print_json_config(f);
+    fprintf(f, "}\n");
+    fclose(f);
+}
+
+static void print_progress(struct perftest_context *ctx,
+                           const ucx_perf_result_t *result, int final)
+{
+    static const char *fmt_csv     =  "%.0f,%.3f,%.3f,%.3f,%.2f,%.2f,%.0f,%.0f,"
+                                      "%.3f,%.3f,%.3f,%.3f,%.3f\n";
     static const char *fmt_numeric =  "%'14.0f %9.3f %9.3f %9.3f %10.2f %10.2f %'11.0f %'11.0f\n";
     static const char *fmt_plain   =  "%14.0f %9.3f %9.3f %9.3f %10.2f %10.2f %11.0f %11.0f\n";
+    unsigned flags = ctx->flags;
+    char buf[100];
     unsigned i;
 
     if (!(flags & TEST_FLAG_PRINT_RESULTS) ||
@@ -218,8 +531,11 @@ static void print_progress(char **test_names, unsigned num_names,
     }
 
     if (flags & TEST_FLAG_PRINT_CSV) {
-        for (i = 0; i < num_names; ++i) {
-            printf("%s,", test_names[i]);
+        if (ctx->num_procs > 0) {
+            printf("%s,", ctx->row_label);
+        }
+        for (i = 0; i < ctx->num_batch_files; ++i) {
+            printf("%s,", ctx->test_names[i]);
         }
     }
 
@@ -233,7 +549,93 @@ static void print_progress(char **test_names, unsigned num_names,
            result->bandwidth.moment_average / (1024.0 * 1024.0),
            result->bandwidth.total_average / (1024.0 * 1024.0),
            result->msgrate.moment_average,
-           result->msgrate.total_average);
+           result->msgrate.total_average,
+           result->latency_percentile.p50 * 1000000.0,
+           result->latency_percentile.p90 * 1000000.0,
+           result->latency_percentile.p99 * 1000000.0,
+           result->latency_percentile.p999 * 1000000.0,
+           result->latency_percentile.max * 1000000.0);
+
+    if (final && !(flags & TEST_FLAG_PRINT_CSV)) {
+        snprintf(buf, sizeof(buf),
+                 "latency (usec) p50: %.3f  p90: %.3f  p99: %.3f  p99.9: %.3f  max: %.3f",
+                 result->latency_percentile.p50 * 1000000.0,
+                 result->latency_percentile.p90 * 1000000.0,
+                 result->latency_percentile.p99 * 1000000.0,
+                 result->latency_percentile.p999 * 1000000.0,
+                 result->latency_percentile.max * 1000000.0);
+        printf("| %-88s |\n", buf);
+    }
+
+    if (final && !(flags & TEST_FLAG_PRINT_CSV) &&
+        (ctx->params.command == UCX_PERF_CMD_WIREUP)) {
+        snprintf(buf, sizeof(buf),
+                 "wireup (usec/ep) create: %.3f  first msg: %.3f  close: %.3f  "
+                 "address: %zu bytes",
+                 result->wireup.ep_create * 1000000.0,
+                 result->wireup.first_msg * 1000000.0,
+                 result->wireup.ep_close * 1000000.0,
+                 result->wireup.address_size);
+        printf("| %-88s |\n", buf);
+    }
+
+    if (final && !(flags & TEST_FLAG_PRINT_CSV) &&
+        (ctx->params.command == UCX_PERF_CMD_TAG_MATCH) &&
+        (result->msgrate.total_average > 0)) {
+        snprintf(buf, sizeof(buf),
+                 "tag matching (usec/msg): %.3f  depth: %u  tags: %u  "
+                 "any source: %u%%",
+                 1000000.0 / result->msgrate.total_average,
+                 ctx->params.ucp.tag_depth, ctx->params.ucp.tag_count,
+                 ctx->params.ucp.tag_any_source_percent);
+        printf("| %-88s |\n", buf);
+    }
+
+    if (final && !(flags & TEST_FLAG_PRINT_CSV) &&
+        ((ctx->params.send_buffers > 1) ||
+         (ctx->params.flags & UCX_PERF_TEST_FLAG_REALLOC_BUFFERS))) {
+        snprintf(buf, sizeof(buf),
+                 "rcache hit ratio: %.3f  registrations: %" PRIu64
+                 "  invalidations: %" PRIu64 "  reg time: %.3f usec",
+                 result->rcache.hit_ratio, result->rcache.regs,
+                 result->rcache.invalidations,
+                 result->rcache.reg_time * 1000000.0);
+        printf("| %-88s |\n", buf);
+    }
+
+    if (final && !(flags & TEST_FLAG_PRINT_CSV) &&
+        (result->threads.count > 1)) {
+        for (i = 0; (result->threads.results != NULL) &&
+                    (i < result->threads.count); ++i) {
+            snprintf(buf, sizeof(buf),
+                     "thread %-3u latency: %.3f usec  bandwidth: %.2f MB/s  "
+                     "rate: %.0f msg/s", i,
+                     result->threads.results[i].latency.total_average * 1000000.0,
+                     result->threads.results[i].bandwidth.total_average /
+                     (1024.0 * 1024.0),
+                     result->threads.results[i].msgrate.total_average);
+            printf("| %-88s |\n", buf);
+        }
+
+        snprintf(buf, sizeof(buf),
+                 "worker lock waits: %" PRIu64 "  wait time: %.3f usec "
+                 "(%.2f%% of thread time)", result->threads.lock_waits,
+                 result->threads.lock_wait_time * 1000000.0,
+                 (result->elapsed_time == 0) ? 0.0 :
+                 result->threads.lock_wait_time * 100.0 /
+                 (result->elapsed_time * result->threads.count));
+        printf("| %-88s |\n", buf);
+    }
+
+    if (final && (ctx->json_file != NULL)) {
+        print_json(ctx, result);
+    }
+
+    if (final && (ctx->histogram_file != NULL) &&
+        (result->latency_histogram != NULL)) {
+        print_histogram(ctx, result);
+    }
+
     fflush(stdout);
 }
 
@@ -279,15 +681,29 @@ static void print_header(struct perftest_context *ctx)
             printf("| Test:         %-60s               |\n", test->desc);
             printf("| Data layout:  %-60s               |\n", test_data_str);
             printf("| Message size: %-60zu               |\n", ucx_perf_get_message_size(&ctx->params));
+            if (ctx->num_procs > 0) {
+                printf("| Processes:    %-4u %-55s               |\n", ctx->num_procs,
+                       pattern_names[ctx->params.pattern]);
+            }
+            if (ctx->params.thread_count > 1) {
+                printf("| Threads:      %-4u %-55s               |\n",
+                       ctx->params.thread_count,
+                       (test->api == UCX_PERF_API_UCP) ?
+                       thread_model_names[ctx->params.ucp.thread_model] : "");
+            }
         }
     }
 
     if (ctx->flags & TEST_FLAG_PRINT_CSV) {
         if (ctx->flags & TEST_FLAG_PRINT_RESULTS) {
+            if (ctx->num_procs > 0) {
+                printf("rank,");
+            }
             for (i = 0; i < ctx->num_batch_files; ++i) {
                 printf("%s,", basename(ctx->batch_files[i]));
             }
-            printf("iterations,typical_lat,avg_lat,overall_lat,avg_bw,overall_bw,avg_mr,overall_mr\n");
+            printf("iterations,typical_lat,avg_lat,overall_lat,avg_bw,overall_bw,avg_mr,overall_mr,"
+                   "p50_lat,p90_lat,p99_lat,p999_lat,max_lat\n");
         }
     } else {
         if (ctx->flags & TEST_FLAG_PRINT_RESULTS) {
@@ -366,7 +782,8 @@ static void usage(const struct perftest_context *ctx, const char *program)
     printf("     -n <iters>     number of iterations to run (%ld)\n", ctx->params.max_iter);
     printf("     -w <iters>     number of warm-up iterations (%zu)\n",
                                 ctx->params.warmup_iter);
-    printf("     -c <cpu>       set affinity to this CPU (off)\n");
+    printf("     -c <cpu>       set affinity to this CPU, or to CPU <cpu>+N for local\n");
+    printf("                    process N (off)\n");
     printf("     -O <count>     maximal number of uncompleted outstanding sends (%u)\n",
                                 ctx->params.max_outstanding);
     printf("     -i <offset>    distance between consecutive scatter-gather entries (%zu)\n",
@@ -378,6 +795,14 @@ static void usage(const struct perftest_context *ctx, const char *program)
     printf("                    file is a test to run, first word is test name, the rest of\n");
     printf("                    the line is command-line arguments for the test.\n");
     printf("     -p <port>      TCP port to use for data exchange (%d)\n", ctx->port);
+    printf("     -l <procs>     launch this number of processes on the local host, and\n");
+    printf("                    exchange data over shared memory instead of TCP (off)\n");
+    printf("     -L <pattern>   traffic pattern between the processes (pair)\n");
+    printf("                        pair     - independent pairs of processes, every\n");
+    printf("                                   pair runs the test separately\n");
+    printf("                        incast   - all processes send to process 0\n");
+    printf("                        alltoall - every process sends to all others\n");
+    printf("                    incast and alltoall are supported only by UCP bandwidth tests\n");
 #if HAVE_MPI
     printf("     -P <0|1>       disable/enable MPI mode (%d)\n", ctx->mpi);
 #endif
@@ -387,6 +812,10 @@ static void usage(const struct perftest_context *ctx, const char *program)
     printf("     -N             use numeric formatting (thousands separator)\n");
     printf("     -f             print only final numbers\n");
     printf("     -v             print CSV-formatted output\n");
+    printf("     -g <file>      append the final latency histogram to a file\n");
+    printf("     -J <file>      append the final result with the test parameters,\n");
+    printf("                    endpoint configuration, UCX configuration and host\n");
+    printf("                    information to a file, as a JSON object per line\n");
     printf("\n");
     printf("  UCT only:\n");
     printf("     -d <device>    device to use for testing\n");
@@ -419,6 +848,26 @@ static void usage(const struct perftest_context *ctx, const char *program)
     printf("     -r <mode>      receive mode for stream tests (recv)\n");
     printf("                        recv       : Use ucp_stream_recv_nb\n");
     printf("                        recv_data  : Use ucp_stream_recv_data_nb\n");
+    printf("     -E <count>     number of endpoints to create on every iteration of\n");
+    printf("                    wireup test (%u)\n", ctx->params.ucp.wireup_eps);
+    printf("     -Q <depth>     messages matched on every iteration of tag_match\n");
+    printf("                    test (%u)\n", ctx->params.ucp.tag_depth);
+    printf("     -j <count>     number of distinct tags in tag_match test (%u)\n",
+                                ctx->params.ucp.tag_count);
+    printf("     -y <percent>   percent of receives from any source in tag_match\n");
+    printf("                    test (%u)\n", ctx->params.ucp.tag_any_source_percent);
+    printf("     -z             post receives in random order in tag_match test\n");
+    printf("                    (use -U to match unexpected messages)\n");
+    printf("     -k <count>     number of send buffers to use in round-robin order,\n");
+    printf("                    registered on demand by UCP (%u)\n",
+                                ctx->params.send_buffers);
+    printf("     -R             unmap and map again every send buffer before reusing\n");
+    printf("                    it, to measure registration cache invalidation\n");
+    printf("     -e <model>     how the threads of -T share UCP objects (%s)\n",
+                                thread_model_names[ctx->params.ucp.thread_model]);
+    printf("                        shared_ep     - same worker and endpoints\n");
+    printf("                        shared_worker - same worker, endpoints per thread\n");
+    printf("                        worker        - worker and endpoints per thread\n");
     printf("     -m <mem type>  memory type of messages\n");
     printf("                        host - system memory(default)\n");
     if (ucx_perf_mem_type_allocators[UCT_MD_MEM_TYPE_CUDA] != NULL) {
@@ -510,6 +959,7 @@ static void init_test_params(ucx_perf_params_t *params)
     params->async_mode      = UCS_ASYNC_THREAD_LOCK_TYPE;
     params->wait_mode       = UCX_PERF_WAIT_MODE_LAST;
     params->max_outstanding = 1;
+    params->send_buffers    = 1;
     params->warmup_iter     = 10000;
     params->am_hdr_size     = 8;
     params->alignment       = ucs_get_page_size();
@@ -524,6 +974,11 @@ static void init_test_params(ucx_perf_params_t *params)
     params->iov_stride      = 0;
     params->ucp.send_datatype = UCP_PERF_DATATYPE_CONTIG;
     params->ucp.recv_datatype = UCP_PERF_DATATYPE_CONTIG;
+    params->ucp.wireup_eps    = 1;
+    params->ucp.tag_depth     = 64;
+    params->ucp.tag_count     = 64;
+    params->ucp.tag_any_source_percent = 0;
+    params->ucp.thread_model  = UCP_PERF_THREAD_MODEL_SHARED_EP;
     strcpy(params->uct.dev_name, TL_RESOURCE_NAME_NONE);
     strcpy(params->uct.tl_name,  TL_RESOURCE_NAME_NONE);
 
@@ -534,6 +989,7 @@ static void init_test_params(ucx_perf_params_t *params)
 
 static ucs_status_t parse_test_params(ucx_perf_params_t *params, char opt, const char *optarg)
 {
+    ucp_perf_thread_model_t thread_model;
     test_type_t *test;
     char *optarg2 = NULL;
 
@@ -634,6 +1090,16 @@ static ucs_status_t parse_test_params(ucx_perf_params_t *params, char opt, const
         params->thread_count = atoi(optarg);
         params->thread_mode = UCS_THREAD_MODE_MULTI;
         return UCS_OK;
+    case 'e':
+        for (thread_model = 0; thread_model < UCP_PERF_THREAD_MODEL_LAST;
+             ++thread_model) {
+            if (!strcmp(optarg, thread_model_names[thread_model])) {
+                params->ucp.thread_model = thread_model;
+                return UCS_OK;
+            }
+        }
+        ucs_error("Invalid option argument for -e");
+        return UCS_ERR_INVALID_PARAM;
     case 'A':
         if (!strcmp(optarg, "thread") || !strcmp(optarg, "thread_spinlock")) {
             params->async_mode = UCS_ASYNC_MODE_THREAD_SPINLOCK;
@@ -657,6 +1123,27 @@ static ucs_status_t parse_test_params(ucx_perf_params_t *params, char opt, const
             return UCS_OK;
         }
         return UCS_ERR_INVALID_PARAM;
+    case 'E':
+        params->ucp.wireup_eps = atoi(optarg);
+        return UCS_OK;
+    case 'Q':
+        params->ucp.tag_depth = atoi(optarg);
+        return UCS_OK;
+    case 'j':
+        params->ucp.tag_count = atoi(optarg);
+        return UCS_OK;
+    case 'y':
+        params->ucp.tag_any_source_percent = atoi(optarg);
+        return UCS_OK;
+    case 'z':
+        params->flags |= UCX_PERF_TEST_FLAG_TAG_RANDOM_ORDER;
+        return UCS_OK;
+    case 'k':
+        params->send_buffers = atoi(optarg);
+        return UCS_OK;
+    case 'R':
+        params->flags |= UCX_PERF_TEST_FLAG_REALLOC_BUFFERS;
+        return UCS_OK;
     case 'm':
         if (!strcmp(optarg, "host")) {
             params->mem_type = UCT_MD_MEM_TYPE_HOST;
@@ -704,7 +1191,9 @@ static ucs_status_t read_batch_file(FILE *batch_file, const char *file_name,
         argv[argc] = NULL;
     } while ((argc == 0) || (argv[0][0] == '#'));
 
-    optind = 1;
+    /* Reinitialize getopt completely, since it could keep a pointer into the
+     * previous line, which was read to the same buffer */
+    optind = 0;
     while ((c = getopt (argc, argv, TEST_PARAMS_ARGS)) != -1) {
         status = parse_test_params(params, c, optarg);
         if (status != UCS_OK) {
@@ -721,6 +1210,7 @@ static ucs_status_t read_batch_file(FILE *batch_file, const char *file_name,
 static ucs_status_t parse_opts(struct perftest_context *ctx, int mpi_initialized,
                                int argc, char **argv)
 {
+    ucx_perf_pattern_t pattern;
     ucs_status_t status;
     int c;
 
@@ -731,14 +1221,38 @@ static ucs_status_t parse_opts(struct perftest_context *ctx, int mpi_initialized
     ctx->num_batch_files        = 0;
     ctx->port                   = 13337;
     ctx->flags                  = 0;
+    ctx->histogram_file         = NULL;
+    ctx->json_file              = NULL;
+    ctx->num_procs              = 0;
+    ctx->row_label              = NULL;
     ctx->mpi                    = mpi_initialized;
 
     optind = 1;
-    while ((c = getopt (argc, argv, "p:b:Nfvc:P:h" TEST_PARAMS_ARGS)) != -1) {
+    while ((c = getopt (argc, argv, "p:b:Nfvg:J:c:l:L:P:h" TEST_PARAMS_ARGS)) != -1) {
         switch (c) {
         case 'p':
             ctx->port = atoi(optarg);
             break;
+        case 'l':
+            ctx->num_procs = atoi(optarg);
+            if (ctx->num_procs < 2) {
+                ucs_error("At least 2 processes are required for -l");
+                return UCS_ERR_INVALID_PARAM;
+            }
+            break;
+        case 'L':
+            for (pattern = 0; pattern < UCX_PERF_PATTERN_LAST; ++pattern) {
+                if (!strcmp(optarg, pattern_names[pattern])) {
+                    break;
+                }
+            }
+            if (pattern == UCX_PERF_PATTERN_LAST) {
+                ucs_error("Invalid option argument for -L");
+                usage(ctx, __basename(argv[0]));
+                return UCS_ERR_INVALID_PARAM;
+            }
+            ctx->params.pattern = pattern;
+            break;
         case 'b':
             if (ctx->num_batch_files < MAX_BATCH_FILES) {
                 ctx->batch_files[ctx->num_batch_files++] = optarg;
@@ -753,6 +1267,12 @@ static ucs_status_t parse_opts(struct perftest_context *ctx, int mpi_initialized
         case 'v':
             ctx->flags |= TEST_FLAG_PRINT_CSV;
             break;
+        case 'g':
+            ctx->histogram_file = optarg;
+            break;
+        case 'J':
+            ctx->json_file = optarg;
+            break;
         case 'c':
             ctx->flags |= TEST_FLAG_SET_AFFINITY;
             ctx->cpu = atoi(optarg);
@@ -779,6 +1299,17 @@ static ucs_status_t parse_opts(struct perftest_context *ctx, int mpi_initialized
         ctx->server_addr   = argv[optind];
     }
 
+    if ((ctx->params.pattern != UCX_PERF_PATTERN_PAIR) && (ctx->num_procs == 0)) {
+        ucs_error("Traffic pattern '%s' requires launching local processes (-l)",
+                  pattern_names[ctx->params.pattern]);
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    if ((ctx->params.pattern == UCX_PERF_PATTERN_PAIR) && (ctx->num_procs % 2)) {
+        ucs_error("Even number of processes is required for pair pattern");
+        return UCS_ERR_INVALID_PARAM;
+    }
+
     return UCS_OK;
 }
 
@@ -854,8 +1385,7 @@ static void sock_rte_report(void *rte_group, const ucx_perf_result_t *result,
                             void *arg, int is_final)
 {
     struct perftest_context *ctx = arg;
-    print_progress(ctx->test_names, ctx->num_batch_files, result, ctx->flags,
-                   is_final);
+    print_progress(ctx, result, is_final);
 }
 
 static ucx_perf_rte_t sock_rte = {
@@ -996,6 +1526,303 @@ static ucs_status_t cleanup_sock_rte(struct perftest_context *ctx)
     return UCS_OK;
 }
 
+static size_t shm_rte_shared_size(unsigned num_procs)
+{
+    return sizeof(shm_rte_shared_t) + (num_procs * sizeof(shm_rte_slot_t));
+}
+
+static void shm_rte_barrier_wait(shm_rte_barrier_t *barrier, unsigned size,
+                                 uint32_t *sense, void (*progress)(void *arg),
+                                 void *arg)
+{
+    *sense = !*sense;
+    if (ucs_atomic_fadd32(&barrier->count, 1) == (size - 1)) {
+        barrier->count = 0;
+        ucs_memory_cpu_store_fence();
+        barrier->sense = *sense;
+        return;
+    }
+
+    while (barrier->sense != *sense) {
+        if (progress != NULL) {
+            progress(arg);
+        }
+        sched_yield();
+    }
+    ucs_memory_cpu_load_fence();
+}
+
+static unsigned shm_rte_group_size(void *rte_group)
+{
+    shm_rte_group_t *group = rte_group;
+    return group->size;
+}
+
+static unsigned shm_rte_group_index(void *rte_group)
+{
+    shm_rte_group_t *group = rte_group;
+    return group->rank - group->first;
+}
+
+static void shm_rte_barrier(void *rte_group, void (*progress)(void *arg),
+                            void *arg)
+{
+#pragma omp master
+  {
+    shm_rte_group_t *group = rte_group;
+
+    shm_rte_barrier_wait(&group->shared->slots[group->first].barrier,
+                         group->size, &group->sense, progress, arg);
+  }
+#pragma omp barrier
+}
+
+static void shm_rte_post_vec(void *rte_group, const struct iovec *iovec,
+                             int iovcnt, void **req)
+{
+    shm_rte_group_t *group = rte_group;
+    shm_rte_slot_t *slot   = &group->shared->slots[group->rank];
+    size_t size;
+    int i;
+
+    /* Wait until the other group members have read the previous message */
+    while ((slot->post_sn > 0) && (slot->readers < (group->size - 1))) {
+        sched_yield();
+    }
+    ucs_memory_cpu_load_fence();
+
+    size = 0;
+    for (i = 0; i < iovcnt; ++i) {
+        ucs_assert_always(size + iovec[i].iov_len <= sizeof(slot->data));
+        memcpy(slot->data + size, iovec[i].iov_base, iovec[i].iov_len);
+        size += iovec[i].iov_len;
+    }
+
+    slot->size    = size;
+    slot->readers = 0;
+    ucs_memory_cpu_store_fence();
+    ++slot->post_sn;
+}
+
+static void shm_rte_recv(void *rte_group, unsigned src, void *buffer,
+                         size_t max, void *req)
+{
+    shm_rte_group_t *group = rte_group;
+    shm_rte_slot_t *slot;
+
+    if (src == shm_rte_group_index(rte_group)) {
+        return;
+    }
+
+    slot = &group->shared->slots[group->first + src];
+    ++group->recv_sn[src];
+    while (slot->post_sn < group->recv_sn[src]) {
+        sched_yield();
+    }
+    ucs_memory_cpu_load_fence();
+
+    ucs_assert_always(slot->size <= max);
+    memcpy(buffer, slot->data, slot->size);
+    ucs_memory_cpu_fence();
+    ucs_atomic_add32(&slot->readers, 1);
+}
+
+static void print_row_label(struct perftest_context *ctx, const char *label)
+{
+    ctx->row_label = label;
+    if (!(ctx->flags & TEST_FLAG_PRINT_CSV)) {
+        printf("| %-88s |\n", label);
+    }
+}
+
+/* All processes run with the same configuration on the same host, so the
+ * endpoint configuration of the printing process stands for all of them */
+static void print_shm_results(struct perftest_context *ctx,
+                              shm_rte_group_t *group, const char *ep_info)
+{
+    ucx_perf_histogram_t *histogram;
+    ucx_perf_result_t total, result;
+    shm_rte_slot_t *slot;
+    unsigned rank, count;
+    char label[64];
+
+    histogram = calloc(1, sizeof(*histogram));
+    if (histogram == NULL) {
+        ucs_error("failed to allocate latency histogram");
+        return;
+    }
+
+    memset(&total, 0, sizeof(total));
+    count = 0;
+    for (rank = 0; rank < ctx->num_procs; ++rank) {
+        /* As with a single pair, the result of a pair is reported by rank 1 */
+        if ((ctx->params.pattern == UCX_PERF_PATTERN_PAIR) && !(rank % 2)) {
+            continue;
+        }
+
+        slot   = &group->shared->slots[rank];
+        result = slot->result;
+        result.ep_info = ep_info;
+        if (result.threads.count > 1) {
+            result.threads.count   = ucs_min(result.threads.count,
+                                             SHM_RTE_MAX_THREADS);
+            result.threads.results = slot->thread_results;
+        }
+
+        if (ctx->params.pattern == UCX_PERF_PATTERN_PAIR) {
+            snprintf(label, sizeof(label), "pair %u", rank / 2);
+        } else if (ctx->params.pattern != UCX_PERF_PATTERN_INCAST) {
+            snprintf(label, sizeof(label), "rank %u", rank);
+        } else if (rank == 0) {
+            snprintf(label, sizeof(label), "receiver %u", rank);
+        } else {
+            snprintf(label, sizeof(label), "sender %u", rank);
+        }
+
+        print_row_label(ctx, label);
+        print_progress(ctx, &result, 1);
+
+        /* Incast receiver sees the sum of the senders' traffic */
+        if ((ctx->params.pattern == UCX_PERF_PATTERN_INCAST) && (rank == 0)) {
+            continue;
+        }
+
+        if (count == 0) {
+            *histogram = slot->histogram;
+        } else {
+            ucx_perf_histogram_merge(histogram, &slot->histogram);
+        }
+
+        total.iters                     += result.iters;
+        total.bytes                     += result.bytes;
+        total.elapsed_time               = ucs_max(total.elapsed_time,
+                                                   result.elapsed_time);
+        total.latency.typical           += result.latency.typical;
+        total.latency.moment_average    += result.latency.moment_average;
+        total.latency.total_average     += result.latency.total_average;
+        total.bandwidth.moment_average  += result.bandwidth.moment_average;
+        total.bandwidth.total_average   += result.bandwidth.total_average;
+        total.msgrate.moment_average    += result.msgrate.moment_average;
+        total.msgrate.total_average     += result.msgrate.total_average;
+        total.wireup.ep_create          += result.wireup.ep_create;
+        total.wireup.first_msg          += result.wireup.first_msg;
+        total.wireup.ep_close           += result.wireup.ep_close;
+        total.wireup.address_size        = ucs_max(total.wireup.address_size,
+                                                   result.wireup.address_size);
+        total.rcache.gets               += result.rcache.gets;
+        total.rcache.regs               += result.rcache.regs;
+        total.rcache.invalidations      += result.rcache.invalidations;
+        total.rcache.hit_ratio          += result.rcache.hit_ratio *
+                                           result.rcache.gets;
+        total.rcache.reg_time           += result.rcache.reg_time *
+                                           result.rcache.regs;
+        ++count;
+    }
+
+    /* Latency is averaged over the ranks, bandwidth and rate are summed */
+    total.latency.typical        /= count;
+    total.latency.moment_average /= count;
+    total.latency.total_average  /= count;
+    total.wireup.ep_create       /= count;
+    total.wireup.first_msg       /= count;
+    total.wireup.ep_close        /= count;
+    if (total.rcache.gets > 0) {
+        total.rcache.hit_ratio   /= total.rcache.gets;
+    }
+    if (total.rcache.regs > 0) {
+        total.rcache.reg_time    /= total.rcache.regs;
+    }
+    ucx_perf_histogram_calc_percentiles(histogram, &total);
+    total.latency_histogram       = histogram;
+    total.ep_info                 = ep_info;
+
+    print_row_label(ctx, "aggregate");
+    print_progress(ctx, &total, 1);
+    free(histogram);
+}
+
+static void shm_rte_report(void *rte_group, const ucx_perf_result_t *result,
+                           void *arg, int is_final)
+{
+    struct perftest_context *ctx = arg;
+    shm_rte_group_t *group       = rte_group;
+    shm_rte_slot_t *slot         = &group->shared->slots[group->rank];
+
+    /* Intermediate results of separate processes are not combined */
+    if (!is_final) {
+        return;
+    }
+
+    slot->result                   = *result;
+    slot->result.latency_histogram = NULL;
+    slot->result.ep_info           = NULL;
+    slot->result.threads.results   = NULL;
+    if (result->threads.results != NULL) {
+        memcpy(slot->thread_results, result->threads.results,
+               ucs_min(result->threads.count, SHM_RTE_MAX_THREADS) *
+               sizeof(*result->threads.results));
+    }
+    slot->histogram                = *result->latency_histogram;
+
+    shm_rte_barrier_wait(&group->shared->barrier, ctx->num_procs,
+                         &group->global_sense, NULL, NULL);
+    if (group->rank == 0) {
+        print_shm_results(ctx, group, result->ep_info);
+    }
+
+    /* Do not let the next test overwrite the results before they are printed */
+    shm_rte_barrier_wait(&group->shared->barrier, ctx->num_procs,
+                         &group->global_sense, NULL, NULL);
+}
+
+static ucx_perf_rte_t shm_rte = {
+    .group_size    = shm_rte_group_size,
+    .group_index   = shm_rte_group_index,
+    .barrier       = shm_rte_barrier,
+    .post_vec      = shm_rte_post_vec,
+    .recv          = shm_rte_recv,
+    .exchange_vec  = (void*)ucs_empty_function,
+    .report        = shm_rte_report,
+};
+
+static ucs_status_t setup_shm_rte(struct perftest_context *ctx,
+                                  shm_rte_shared_t *shared, unsigned rank)
+{
+    shm_rte_group_t *group = &ctx->shm_rte_group;
+
+    group->shared       = shared;
+    group->rank         = rank;
+    group->sense        = 0;
+    group->global_sense = 0;
+    if (ctx->params.pattern == UCX_PERF_PATTERN_PAIR) {
+        group->first    = rank & ~1u;
+        group->size     = 2;
+    } else {
+        group->first    = 0;
+        group->size     = ctx->num_procs;
+    }
+
+    group->recv_sn = calloc(group->size, sizeof(*group->recv_sn));
+    if (group->recv_sn == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    if (rank == 0) {
+        ctx->flags |= TEST_FLAG_PRINT_TEST | TEST_FLAG_PRINT_RESULTS;
+    }
+
+    ctx->params.rte_group         = group;
+    ctx->params.rte               = &shm_rte;
+    ctx->params.report_arg        = ctx;
+    return UCS_OK;
+}
+
+static ucs_status_t cleanup_shm_rte(struct perftest_context *ctx)
+{
+    free(ctx->shm_rte_group.recv_sn);
+    return UCS_OK;
+}
+
 #if HAVE_MPI
 static unsigned mpi_rte_group_size(void *rte_group)
 {
@@ -1127,8 +1954,7 @@ static void mpi_rte_report(void *rte_group, const ucx_perf_result_t *result,
                            void *arg, int is_final)
 {
     struct perftest_context *ctx = arg;
-    print_progress(ctx->test_names, ctx->num_batch_files, result, ctx->flags,
-                   is_final);
+    print_progress(ctx, result, is_final);
 }
 
 static ucx_perf_rte_t mpi_rte = {
@@ -1246,8 +2072,7 @@ static void ext_rte_report(void *rte_group, const ucx_perf_result_t *result,
                            void *arg, int is_final)
 {
     struct perftest_context *ctx = arg;
-    print_progress(ctx->test_names, ctx->num_batch_files, result, ctx->flags,
-                   is_final);
+    print_progress(ctx, result, is_final);
 }
 
 static ucx_perf_rte_t ext_rte = {
@@ -1435,6 +2260,110 @@ static ucs_status_t run_test(struct perftest_context *ctx)
     return status;
 }
 
+static int run_local_rank(struct perftest_context *ctx,
+                          shm_rte_shared_t *shared, unsigned rank)
+{
+    cpu_set_t cpuset;
+    ucs_status_t status;
+    long nr_cpus;
+
+    if (ctx->flags & TEST_FLAG_SET_AFFINITY) {
+        nr_cpus = sysconf(_SC_NPROCESSORS_CONF);
+        CPU_ZERO(&cpuset);
+        CPU_SET((ctx->cpu + rank) % nr_cpus, &cpuset);
+        if (sched_setaffinity(0, sizeof(cpuset), &cpuset)) {
+            ucs_warn("sched_setaffinity() failed: %m");
+        }
+    }
+
+    status = setup_shm_rte(ctx, shared, rank);
+    if (status != UCS_OK) {
+        return -1;
+    }
+
+    status = run_test(ctx);
+    cleanup_shm_rte(ctx);
+    return (status == UCS_OK) ? 0 : -1;
+}
+
+/* Run the test in several processes forked on the local host */
+static ucs_status_t launch_local(struct perftest_context *ctx)
+{
+    shm_rte_shared_t *shared;
+    ucs_status_t status;
+    unsigned rank, num_running;
+    size_t shared_size;
+    pid_t *pids;
+    pid_t pid;
+    int wstatus;
+
+    pids = calloc(ctx->num_procs, sizeof(*pids));
+    if (pids == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    shared_size = shm_rte_shared_size(ctx->num_procs);
+    shared      = mmap(NULL, shared_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        ucs_error("failed to allocate shared memory of %zu bytes: %m",
+                  shared_size);
+        status = UCS_ERR_NO_MEMORY;
+        goto out_free_pids;
+    }
+
+    status = UCS_OK;
+    fflush(stdout);
+    for (num_running = 0; num_running < ctx->num_procs; ++num_running) {
+        pid = fork();
+        if (pid < 0) {
+            ucs_error("fork() failed: %m");
+            status = UCS_ERR_IO_ERROR;
+            break;
+        } else if (pid == 0) {
+            exit(run_local_rank(ctx, shared, num_running));
+        }
+        pids[num_running] = pid;
+    }
+
+    /* A failed process would leave the others waiting for it, so stop them */
+    while (num_running > 0) {
+        if (status != UCS_OK) {
+            for (rank = 0; rank < ctx->num_procs; ++rank) {
+                if (pids[rank] != 0) {
+                    kill(pids[rank], SIGTERM);
+                }
+            }
+        }
+
+        pid = wait(&wstatus);
+        if (pid < 0) {
+            ucs_error("wait() failed: %m");
+            status = UCS_ERR_IO_ERROR;
+            break;
+        }
+
+        for (rank = 0; rank < ctx->num_procs; ++rank) {
+            if (pids[rank] == pid) {
+                pids[rank] = 0;
+                --num_running;
+            }
+        }
+
+        if (!WIFEXITED(wstatus) || (WEXITSTATUS(wstatus) != 0)) {
+            if (status == UCS_OK) {
+                ucs_error("process %d failed", pid);
+            }
+            status = UCS_ERR_IO_ERROR;
+        }
+    }
+
+    munmap(shared, shared_size);
+out_free_pids:
+    free(pids);
+    return status;
+}
+
 int main(int argc, char **argv)
 {
     struct perftest_context ctx;
@@ -1477,6 +2406,12 @@ int main(int argc, char **argv)
         goto out;
     }
 
+    if (ctx.num_procs > 0) {
+        status = launch_local(&ctx);
+        ret    = (status == UCS_OK) ? 0 : -1;
+        goto out;
+    }
+
     /* Create RTE */
     status = (mpi_rte) ? setup_mpi_rte(&ctx) : setup_sock_rte(&ctx);
     if (status != UCS_OK) {
@@ -6,6 +6,7 @@
 
 #include <ucs/profile/profile.h>
 #include <ucs/datastruct/khash.h>
+#include <ucs/sys/math.h>
 
 #include <sys/signal.h>
 #include <sys/fcntl.h>
@@ -14,6 +15,7 @@
 #include <sys/stat.h>
 #include <stdlib.h>
 #include <getopt.h>
+#include <inttypes.h>
 #include <unistd.h>
 #include <string.h>
 #include <stdio.h>
@@ -45,16 +47,24 @@ typedef enum {
 typedef struct options {
     const char                   *filename;
     int                          raw;
+    int                          chrome_trace;
     time_units_t                 time_units;
 } options_t;
 
 
+typedef struct {
+    const ucs_profile_thread_header_t   *header;
+    const ucs_profile_thread_location_t *locations;
+    const ucs_profile_record_t          *records;
+} profile_thread_data_t;
+
+
 typedef struct {
     void                         *mem;
     size_t                       length;
     const ucs_profile_header_t   *header;
     const ucs_profile_location_t *locations;
-    const ucs_profile_record_t   *records;
+    profile_thread_data_t        *threads;
 } profile_data_t;
 
 
@@ -73,7 +83,10 @@ static const char* time_units_str[] = {
 
 static int read_profile_data(const char *file_name, profile_data_t *data)
 {
+    profile_thread_data_t *thread;
     struct stat stat;
+    const void *ptr;
+    unsigned i;
     int ret, fd;
 
     fd = open(file_name, O_RDONLY);
@@ -98,12 +111,58 @@ static int read_profile_data(const char *file_name, profile_data_t *data)
         goto out_close;
     }
 
-    data->header    = data->mem;
+    data->header = data->mem;
+    if (data->header->version != UCS_PROFILE_FILE_VERSION) {
+        fprintf(stderr, "%s: unsupported profile file version %u (expected %u)\n",
+                file_name, data->header->version, UCS_PROFILE_FILE_VERSION);
+        ret = -1;
+        goto out_unmap;
+    }
+
     data->locations = (const void*)(data->header + 1);
-    data->records   = (const void*)(data->locations + data->header->num_locations);
+
+    data->threads = calloc(data->header->num_threads, sizeof(*data->threads));
+    if (data->threads == NULL) {
+        fprintf(stderr, "failed to allocate threads array\n");
+        ret = -1;
+        goto out_unmap;
+    }
+
+    ptr = data->locations + data->header->num_locations;
+    for (i = 0; i < data->header->num_threads; ++i) {
+        thread         = &data->threads[i];
+        thread->header = ptr;
+        ptr            = thread->header + 1;
+
+        thread->locations = ptr;
+        if (data->header->mode & UCS_BIT(UCS_PROFILE_MODE_ACCUM)) {
+            ptr = thread->locations + data->header->num_locations;
+        }
+
+        thread->records = ptr;
+        if (data->header->mode & UCS_BIT(UCS_PROFILE_MODE_LOG)) {
+            ptr = thread->records + thread->header->num_records;
+        } else if (thread->header->num_records != 0) {
+            fprintf(stderr, "%s: thread %d has records without log mode\n",
+                    file_name, thread->header->tid);
+            ret = -1;
+            goto out_free_threads;
+        }
+
+        if (ptr > data->mem + data->length) {
+            fprintf(stderr, "%s: file is truncated\n", file_name);
+            ret = -1;
+            goto out_free_threads;
+        }
+    }
 
     ret = 0;
+    goto out_close;
 
+out_free_threads:
+    free(data->threads);
+out_unmap:
+    munmap(data->mem, data->length);
 out_close:
     close(fd);
 out:
@@ -112,6 +171,7 @@ out:
 
 static void release_profile_data(profile_data_t *data)
 {
+    free(data->threads);
     munmap(data->mem, data->length);
 }
 
@@ -136,11 +196,18 @@ static int compare_locations(const void *l1, const void *l2)
            0;
 }
 
-static void show_profile_data_accum(profile_data_t *data, options_t *opts)
+/*
+ * Show accumulated data of a single thread, or of the whole process if
+ * 'thread' is NULL.
+ */
+static void show_profile_data_accum(profile_data_t *data,
+                                    const profile_thread_data_t *thread,
+                                    options_t *opts)
 {
     uint32_t num_locations = data->header->num_locations;
     ucs_profile_location_t *sorted_locations;
     ucs_profile_location_t *loc;
+    uint32_t i;
 
     sorted_locations = malloc(sizeof(*sorted_locations) * num_locations);
     if (sorted_locations == NULL) {
@@ -149,12 +216,22 @@ static void show_profile_data_accum(profile_data_t *data, options_t *opts)
 
     /* Sort locations */
     memcpy(sorted_locations, data->locations, sizeof(*sorted_locations) * num_locations);
+    if (thread != NULL) {
+        for (i = 0; i < num_locations; ++i) {
+            sorted_locations[i].total_time = thread->locations[i].total_time;
+            sorted_locations[i].count      = thread->locations[i].count;
+        }
+    }
     qsort(sorted_locations, num_locations, sizeof(*sorted_locations), compare_locations);
 
     /* Print locations */
     printf("%30s %13s %13s %10s                FILE     FUNCTION\n",
            "NAME", "AVG", "TOTAL", "COUNT");
     for (loc = sorted_locations; loc < sorted_locations + num_locations; ++loc) {
+        if ((thread != NULL) && (loc->count == 0)) {
+            continue;
+        }
+
         switch (loc->type) {
         case UCS_PROFILE_TYPE_SAMPLE:
             printf("%30s %13s %13s %10ld %18s:%-4d %s()\n",
@@ -190,55 +267,37 @@ static void show_profile_data_accum(profile_data_t *data, options_t *opts)
 
 KHASH_MAP_INIT_INT64(request_ids, int)
 
-static void show_profile_data_log(profile_data_t *data, options_t *opts)
+/*
+ * Find the matching scope-end record for every scope-begin record of a thread.
+ * Returns an array which is indexed by the record number, and the minimal
+ * nesting level, which is the base of the call stack.
+ */
+static const ucs_profile_record_t **
+find_scope_ends(profile_data_t *data, const profile_thread_data_t *thread,
+                int *min_nesting_p)
 {
-    size_t num_recods               = data->header->num_records;
+    size_t num_records = thread->header->num_records;
     const ucs_profile_record_t **stack[UCS_PROFILE_STACK_MAX * 2];
     const ucs_profile_record_t **scope_ends;
     const ucs_profile_location_t *loc;
-    const ucs_profile_record_t *rec, *se, **sep;
+    const ucs_profile_record_t *rec, **sep;
     int nesting, min_nesting;
-    uint64_t prev_time;
-    const char *action;
-    char buf[256];
-    khash_t(request_ids) reqids;
-    int hash_extra_status;
-    khiter_t hash_it;
-    int reqid, reqid_ctr = 1;
 
-#define NAME_COLOR       (opts->raw ? "" : TERM_COLOR_CYAN)
-#define TS_COLOR         (opts->raw ? "" : TERM_COLOR_WHITE)
-#define LOC_COLOR        (opts->raw ? "" : TERM_COLOR_GRAY)
-#define REQ_COLOR        (opts->raw ? "" : TERM_COLOR_YELLOW)
-#define CLEAR_COLOR      (opts->raw ? "" : TERM_COLOR_CLEAR)
-#define RECORD_FMT       "%s%10.3f%s%*s"
-#define RECORD_ARG(_ts)  TS_COLOR, time_to_usec(data, opts, (_ts)), CLEAR_COLOR, \
-                         INDENT * nesting, ""
-#define PRINT_RECORD()   printf("%-*s %s%15s:%-4d %s()%s\n", \
-                                (int)(60 + strlen(NAME_COLOR) + \
-                                      2 * strlen(TS_COLOR) + \
-                                      3 * strlen(CLEAR_COLOR)), \
-                                buf, \
-                                LOC_COLOR, \
-                                basename(loc->file), loc->line, loc->function, \
-                                CLEAR_COLOR)
-
-    scope_ends = calloc(1, sizeof(*scope_ends) * num_recods);
+    scope_ends = calloc(1, sizeof(*scope_ends) * (num_records + 1));
     if (scope_ends == NULL) {
         fprintf(stderr, "Failed to allocate memory\n");
-        return;
+        return NULL;
     }
 
     memset(stack, 0, sizeof(stack));
 
-    /* Find the first record with minimal nesting level, which is the base of call stack */
     nesting         = 0;
     min_nesting     = 0;
-    for (rec = data->records; rec < data->records + num_recods; ++rec) {
+    for (rec = thread->records; rec < thread->records + num_records; ++rec) {
         loc = &data->locations[rec->location];
         switch (loc->type) {
         case UCS_PROFILE_TYPE_SCOPE_BEGIN:
-            stack[nesting + UCS_PROFILE_STACK_MAX] = &scope_ends[rec - data->records];
+            stack[nesting + UCS_PROFILE_STACK_MAX] = &scope_ends[rec - thread->records];
             ++nesting;
             break;
         case UCS_PROFILE_TYPE_SCOPE_END:
@@ -256,8 +315,51 @@ static void show_profile_data_log(profile_data_t *data, options_t *opts)
         }
     }
 
+    *min_nesting_p = min_nesting;
+    return scope_ends;
+}
+
+static void show_profile_data_log(profile_data_t *data,
+                                  const profile_thread_data_t *thread,
+                                  options_t *opts)
+{
+    size_t num_recods               = thread->header->num_records;
+    const ucs_profile_record_t **scope_ends;
+    const ucs_profile_location_t *loc;
+    const ucs_profile_record_t *rec, *se;
+    int nesting, min_nesting;
+    uint64_t prev_time;
+    const char *action;
+    char buf[256];
+    khash_t(request_ids) reqids;
+    int hash_extra_status;
+    khiter_t hash_it;
+    int reqid, reqid_ctr = 1;
+
+#define NAME_COLOR       (opts->raw ? "" : TERM_COLOR_CYAN)
+#define TS_COLOR         (opts->raw ? "" : TERM_COLOR_WHITE)
+#define LOC_COLOR        (opts->raw ? "" : TERM_COLOR_GRAY)
+#define REQ_COLOR        (opts->raw ? "" : TERM_COLOR_YELLOW)
+#define CLEAR_COLOR      (opts->raw ? "" : TERM_COLOR_CLEAR)
+#define RECORD_FMT       "%s%10.3f%s%*s"
+#define RECORD_ARG(_ts)  TS_COLOR, time_to_usec(data, opts, (_ts)), CLEAR_COLOR, \
+                         INDENT * nesting, ""
+#define PRINT_RECORD()   printf("%-*s %s%15s:%-4d %s()%s\n", \
+                                (int)(60 + strlen(NAME_COLOR) + \
+                                      2 * strlen(TS_COLOR) + \
+                                      3 * strlen(CLEAR_COLOR)), \
+                                buf, \
+                                LOC_COLOR, \
+                                basename(loc->file), loc->line, loc->function, \
+                                CLEAR_COLOR)
+
+    scope_ends = find_scope_ends(data, thread, &min_nesting);
+    if (scope_ends == NULL) {
+        return;
+    }
+
     if (num_recods > 0) {
-        prev_time = data->records[0].timestamp;
+        prev_time = thread->records[0].timestamp;
     } else {
         prev_time = 0;
     }
@@ -266,11 +368,11 @@ static void show_profile_data_log(profile_data_t *data, options_t *opts)
 
     /* Display records */
     nesting = -min_nesting;
-    for (rec = data->records; rec < data->records + num_recods; ++rec) {
+    for (rec = thread->records; rec < thread->records + num_recods; ++rec) {
         loc = &data->locations[rec->location];
         switch (loc->type) {
         case UCS_PROFILE_TYPE_SCOPE_BEGIN:
-            se = scope_ends[rec - data->records];
+            se = scope_ends[rec - thread->records];
             if (se != NULL) {
                 snprintf(buf, sizeof(buf), RECORD_FMT"  %s%s%s %s%.3f%s {",
                          RECORD_ARG(rec->timestamp - prev_time),
@@ -352,13 +454,15 @@ static void close_pipes()
     close(output_pipefds[1]);
 }
 
-static int redirect_output(const ucs_profile_header_t *hdr)
+static int redirect_output(profile_data_t *data)
 {
+    const ucs_profile_header_t *hdr = data->header;
     char *less_argv[] = {LESS_COMMAND,
                          "-R" /* show colors */,
                          NULL};;
     struct winsize wsz;
     uint64_t num_lines;
+    unsigned i;
     pid_t pid;
     int ret;
 
@@ -371,9 +475,14 @@ static int redirect_output(const ucs_profile_header_t *hdr)
     num_lines = 6 + /* header */
                 ((hdr->mode & UCS_BIT(UCS_PROFILE_MODE_ACCUM)) ?
                                 (hdr->num_locations + 2) : 0) +
-                ((hdr->mode & UCS_BIT(UCS_PROFILE_MODE_LOG)) ?
-                                (hdr->num_records    + 1) : 0) +
                 1; /* footer */
+    for (i = 0; i < hdr->num_threads; ++i) {
+        num_lines += 2 + /* thread header */
+                     ((hdr->mode & UCS_BIT(UCS_PROFILE_MODE_ACCUM)) ?
+                                     (hdr->num_locations + 2) : 0) +
+                     ((hdr->mode & UCS_BIT(UCS_PROFILE_MODE_LOG)) ?
+                                     (data->threads[i].header->num_records + 1) : 0);
+    }
 
     if (num_lines <= wsz.ws_row) {
         return 0; /* no need to use 'less' */
@@ -425,16 +534,31 @@ static void show_header(profile_data_t *data, options_t *opts)
     printf("   command : %s\n", data->header->cmdline);
     printf("   host    : %s\n", data->header->hostname);
     printf("   pid     : %d\n", data->header->pid);
+    printf("   threads : %u\n", data->header->num_threads);
     printf("   units   : %s\n", time_units_str[opts->time_units]);
     printf("\n");
 }
 
+static void show_thread_header(profile_data_t *data,
+                               const profile_thread_data_t *thread,
+                               options_t *opts)
+{
+    printf("%sthread %d%s: %"PRIu64" records, %.3f %s\n",
+           opts->raw ? "" : TERM_COLOR_MAGENTA, thread->header->tid,
+           opts->raw ? "" : TERM_COLOR_CLEAR, thread->header->num_records,
+           time_to_usec(data, opts, thread->header->end_time -
+                                    thread->header->start_time),
+           time_units_str[opts->time_units]);
+    printf("\n");
+}
+
 static int show_profile_data(profile_data_t *data, options_t *opts)
 {
+    const profile_thread_data_t *thread;
     int ret;
 
     if (!opts->raw) {
-        ret = redirect_output(data->header);
+        ret = redirect_output(data);
         if (ret < 0) {
             return ret;
         }
@@ -443,23 +567,214 @@ static int show_profile_data(profile_data_t *data, options_t *opts)
     show_header(data, opts);
 
     if (data->header->mode & UCS_BIT(UCS_PROFILE_MODE_ACCUM)) {
-        show_profile_data_accum(data, opts);
+        show_profile_data_accum(data, NULL, opts);
         printf("\n");
     }
 
-    if (data->header->mode & UCS_BIT(UCS_PROFILE_MODE_LOG)) {
-        show_profile_data_log(data, opts);
-        printf("\n");
+    for (thread = data->threads;
+         thread < data->threads + data->header->num_threads; ++thread) {
+        show_thread_header(data, thread, opts);
+
+        /* per-thread summary is needed only if there is more than one thread */
+        if ((data->header->mode & UCS_BIT(UCS_PROFILE_MODE_ACCUM)) &&
+            (data->header->num_threads > 1)) {
+            show_profile_data_accum(data, thread, opts);
+            printf("\n");
+        }
+
+        if (data->header->mode & UCS_BIT(UCS_PROFILE_MODE_LOG)) {
+            show_profile_data_log(data, thread, opts);
+            printf("\n");
+        }
     }
 
     return 0;
 }
 
+static void print_json_chars(const char *str)
+{
+    const char *p;
+
+    for (p = str; *p != '\0'; ++p) {
+        if ((*p == '"') || (*p == '\\')) {
+            printf("\\%c", *p);
+        } else if ((unsigned char)*p < 0x20) {
+            printf("\\u%04x", (unsigned char)*p);
+        } else {
+            putchar(*p);
+        }
+    }
+}
+
+static void print_json_string(const char *str)
+{
+    putchar('"');
+    print_json_chars(str);
+    putchar('"');
+}
+
+/* Print the source location of a profile location as event arguments */
+static void print_json_file_args(const ucs_profile_location_t *loc)
+{
+    printf(",\"args\":{\"file\":\"");
+    print_json_chars(loc->file);
+    printf(":%d\"}}", loc->line);
+}
+
+static double chrome_trace_ts(profile_data_t *data, uint64_t time,
+                              uint64_t base_time)
+{
+    /* trace-event timestamps are always in microseconds */
+    return (time - base_time) * 1e6 / data->header->one_second;
+}
+
+static void show_chrome_trace_event(profile_data_t *data,
+                                    const profile_thread_data_t *thread,
+                                    const char *name, const char *phase,
+                                    const ucs_profile_record_t *rec,
+                                    uint64_t base_time, int *first)
+{
+    printf("%s\n{\"name\":", *first ? "" : ",");
+    print_json_string(name);
+    printf(",\"ph\":\"%s\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f",
+           phase, data->header->pid, thread->header->tid,
+           chrome_trace_ts(data, rec->timestamp, base_time));
+    *first = 0;
+}
+
+static void show_chrome_trace_thread(profile_data_t *data,
+                                     const profile_thread_data_t *thread,
+                                     uint64_t base_time, int *first)
+{
+    size_t num_records = thread->header->num_records;
+    const ucs_profile_record_t **scope_ends;
+    const ucs_profile_location_t *loc;
+    const ucs_profile_record_t *rec, *se;
+    khash_t(request_ids) req_names;
+    int hash_extra_status;
+    khiter_t hash_it;
+    int min_nesting;
+
+    scope_ends = find_scope_ends(data, thread, &min_nesting);
+    if (scope_ends == NULL) {
+        return;
+    }
+
+    /* Map request pointer to the location of its allocation, so the end event
+     * would have the same name as the begin event */
+    kh_init_inplace(request_ids, &req_names);
+
+    for (rec = thread->records; rec < thread->records + num_records; ++rec) {
+        loc = &data->locations[rec->location];
+        switch (loc->type) {
+        case UCS_PROFILE_TYPE_SCOPE_BEGIN:
+            se = scope_ends[rec - thread->records];
+            if (se == NULL) {
+                break; /* unfinished scope */
+            }
+            show_chrome_trace_event(data, thread,
+                                    data->locations[se->location].name, "X",
+                                    rec, base_time, first);
+            printf(",\"dur\":%.3f",
+                   chrome_trace_ts(data, se->timestamp, rec->timestamp));
+            print_json_file_args(&data->locations[se->location]);
+            break;
+        case UCS_PROFILE_TYPE_SAMPLE:
+            show_chrome_trace_event(data, thread, loc->name, "i", rec,
+                                    base_time, first);
+            printf(",\"s\":\"t\"");
+            print_json_file_args(loc);
+            break;
+        case UCS_PROFILE_TYPE_REQUEST_NEW:
+            hash_it = kh_put(request_ids, &req_names, rec->param64,
+                             &hash_extra_status);
+            if (hash_it != kh_end(&req_names)) {
+                kh_value(&req_names, hash_it) = rec->location;
+            }
+            show_chrome_trace_event(data, thread, loc->name, "b", rec,
+                                    base_time, first);
+            printf(",\"cat\":\"request\",\"id\":\"0x%"PRIx64"\","
+                   "\"args\":{\"param\":%u}}", rec->param64, rec->param32);
+            break;
+        case UCS_PROFILE_TYPE_REQUEST_EVENT:
+            show_chrome_trace_event(data, thread, loc->name, "n", rec,
+                                    base_time, first);
+            printf(",\"cat\":\"request\",\"id\":\"0x%"PRIx64"\","
+                   "\"args\":{\"param\":%u}}", rec->param64, rec->param32);
+            break;
+        case UCS_PROFILE_TYPE_REQUEST_FREE:
+            hash_it = kh_get(request_ids, &req_names, rec->param64);
+            if (hash_it == kh_end(&req_names)) {
+                break; /* request was allocated before the log was rotated */
+            }
+            show_chrome_trace_event(data, thread,
+                                    data->locations[kh_value(&req_names,
+                                                             hash_it)].name,
+                                    "e", rec, base_time, first);
+            printf(",\"cat\":\"request\",\"id\":\"0x%"PRIx64"\"}",
+                   rec->param64);
+            kh_del(request_ids, &req_names, hash_it);
+            break;
+        default:
+            break;
+        }
+    }
+
+    kh_destroy_inplace(request_ids, &req_names);
+    free(scope_ends);
+}
+
+/*
+ * Show the log in Chrome trace-event format, which can be loaded by
+ * chrome://tracing or https://ui.perfetto.dev
+ */
+static int show_chrome_trace(profile_data_t *data, options_t *opts)
+{
+    const profile_thread_data_t *thread;
+    uint64_t base_time;
+    int first;
+
+    if (!(data->header->mode & UCS_BIT(UCS_PROFILE_MODE_LOG))) {
+        fprintf(stderr, "Trace-event output requires profile in 'log' mode\n");
+        return -1;
+    }
+
+    /* Find the earliest timestamp, to use as time origin */
+    base_time = UINT64_MAX;
+    for (thread = data->threads;
+         thread < data->threads + data->header->num_threads; ++thread) {
+        if (thread->header->num_records > 0) {
+            base_time = ucs_min(base_time, thread->records[0].timestamp);
+        }
+    }
+
+    printf("{\"displayTimeUnit\":\"ns\",\"otherData\":{\"command\":");
+    print_json_string(data->header->cmdline);
+    printf(",\"host\":");
+    print_json_string(data->header->hostname);
+    printf("},\"traceEvents\":[");
+
+    first = 1;
+    for (thread = data->threads;
+         thread < data->threads + data->header->num_threads; ++thread) {
+        printf("%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,"
+               "\"tid\":%u,\"args\":{\"name\":\"thread %d\"}}",
+               first ? "" : ",", data->header->pid, thread->header->tid,
+               thread->header->tid);
+        first = 0;
+        show_chrome_trace_thread(data, thread, base_time, &first);
+    }
+
+    printf("\n]}\n");
+    return 0;
+}
+
 static void usage()
 {
     printf("Usage: ucx_read_profile [options] [profile-file]\n");
     printf("Options are:\n");
     printf("  -r              Show raw output\n");
+    printf("  -j              Show log in Chrome trace-event (JSON) format\n");
     printf("  -t <units>      Select time units to use:\n");
     printf("                     sec  - seconds\n");
     printf("                     msec - milliseconds\n");
@@ -472,14 +787,18 @@ int parse_args(int argc, char **argv, options_t *opts)
 {
     int c;
 
-    opts->raw         = !isatty(fileno(stdout));
-    opts->time_units  = TIME_UNITS_USEC;
+    opts->raw          = !isatty(fileno(stdout));
+    opts->chrome_trace = 0;
+    opts->time_units   = TIME_UNITS_USEC;
 
-    while ( (c = getopt(argc, argv, "hrt:")) != -1 ) {
+    while ( (c = getopt(argc, argv, "hrjt:")) != -1 ) {
         switch (c) {
         case 'r':
             opts->raw = 1;
             break;
+        case 'j':
+            opts->chrome_trace = 1;
+            break;
         case 't':
             if (!strcasecmp(optarg, "sec")) {
                 opts->time_units = TIME_UNITS_SEC;
@@ -527,7 +846,11 @@ int main(int argc, char **argv)
         return -1;
     }
 
-    ret = show_profile_data(&data, &opts);
+    if (opts.chrome_trace) {
+        ret = show_chrome_trace(&data, &opts);
+    } else {
+        ret = show_profile_data(&data, &opts);
+    }
     release_profile_data(&data);
     return ret;
 }
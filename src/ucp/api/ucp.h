@@ -335,7 +335,9 @@ enum ucp_context_attr_field {
 enum ucp_worker_attr_field {
     UCP_WORKER_ATTR_FIELD_THREAD_MODE   = UCS_BIT(0), /**< UCP thread mode */
     UCP_WORKER_ATTR_FIELD_ADDRESS       = UCS_BIT(1), /**< UCP address */
-    UCP_WORKER_ATTR_FIELD_ADDRESS_FLAGS = UCS_BIT(2)  /**< UCP address flags */
+    UCP_WORKER_ATTR_FIELD_ADDRESS_FLAGS = UCS_BIT(2), /**< UCP address flags */
+    UCP_WORKER_ATTR_FIELD_LOCK_WAITS    = UCS_BIT(3)  /**< Contention on the
+                                                           worker lock */
 };
 
 /**
@@ -768,6 +770,19 @@ typedef struct ucp_worker_attr {
      * Size of worker address in bytes.
      */
     size_t                address_length;
+
+    /**
+     * Number of times a thread had to wait for another thread to release the
+     * worker lock, since the worker was created. Always 0 unless the worker
+     * was created with @ref UCS_THREAD_MODE_MULTI.
+     */
+    uint64_t              lock_waits;
+
+    /**
+     * Total time, in seconds, which threads spent waiting for the worker
+     * lock, since the worker was created.
+     */
+    double                lock_wait_time;
 } ucp_worker_attr_t;
 
 
@@ -1000,7 +1015,9 @@ struct ucp_tag_recv_info {
  * @param [in]  filename      If non-NULL, read configuration from the file
  *                            defined by @e filename. If the file does not
  *                            exist, it will be ignored and no error reported
- *                            to the application.
+ *                            to the application. Every line of the file is
+ *                            @e UCX_<NAME>=<value>, and the environment
+ *                            variables take precedence over the file.
  * @param [out] config_p      Pointer to configuration descriptor as defined by
  *                            @ref ucp_config_t "ucp_config_t".
  *
@@ -1408,6 +1425,10 @@ ucs_status_t ucp_worker_get_efd(ucp_worker_h worker, int *fd);
  * notification and may not progress some of the requests as it would when
  * calling @ref ucp_worker_progress (which is not invoked in that duration).
  *
+ * @note If UCX_WAIT_SPIN_TIME is set, the worker is first progressed for up to
+ * that time, adapted to the observed time between events, before going to
+ * sleep. In this case request callbacks may be invoked from this function.
+ *
  * @note UCP @ref ucp_feature "features" have to be triggered
  *   with @ref UCP_FEATURE_WAKEUP to select proper transport
  *
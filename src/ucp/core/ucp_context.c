@@ -188,6 +188,13 @@ static ucs_config_field_t ucp_config_table[] = {
    "transport interfaces.",
    ucs_offsetof(ucp_config_t, ctx.adaptive_progress), UCS_CONFIG_TYPE_BOOL},
 
+  {"WAIT_SPIN_TIME", "0us",
+   "Maximal time to poll the worker in ucp_worker_wait() before arming the\n"
+   "transports and going to sleep. The actual polling time adapts to the time\n"
+   "between events: it grows when events arrive shortly after going to sleep,\n"
+   "and shrinks when they arrive later than this limit. 0 disables polling.",
+   ucs_offsetof(ucp_config_t, ctx.wait_spin_time), UCS_CONFIG_TYPE_TIME},
+
   {"SEG_SIZE", "8192",
    "Size of a segment in the worker preregistered memory pool.",
    ucs_offsetof(ucp_config_t, ctx.seg_size), UCS_CONFIG_TYPE_MEMUNITS},
@@ -240,6 +247,20 @@ static ucs_config_field_t ucp_config_table[] = {
    "of all entities which connect to each other are the same.",
    ucs_offsetof(ucp_config_t, ctx.unified_mode), UCS_CONFIG_TYPE_BOOL},
 
+  {"ADDRESS_CACHE_SIZE", "64",
+   "Maximal number of remote worker addresses to keep unpacked, so creating\n"
+   "more endpoints to the same worker address would not unpack it again.\n"
+   "The most recently used address is always kept.",
+   ucs_offsetof(ucp_config_t, ctx.address_cache_size), UCS_CONFIG_TYPE_UINT},
+
+  {"LAZY_LANES", "n",
+   "Connect the transports of RMA, atomic, and bandwidth lanes to the remote\n"
+   "interface only when the endpoint uses them for the first time, instead of\n"
+   "when it is created. This saves transport resources if most endpoints use\n"
+   "only active messages. Transports which connect to a remote endpoint are\n"
+   "always connected when the endpoint is created.",
+   ucs_offsetof(ucp_config_t, ctx.lazy_lanes), UCS_CONFIG_TYPE_BOOL},
+
   {NULL}
 };
 UCS_CONFIG_REGISTER_TABLE(ucp_config_table, "UCP context", NULL, ucp_config_t)
@@ -278,9 +299,19 @@ ucs_status_t ucp_config_read(const char *env_prefix, const char *filename,
         goto err_free;
     }
 
+    if (filename != NULL) {
+        status = ucs_config_parser_apply_file(config, ucp_config_table,
+                                              env_prefix, filename);
+        if (status != UCS_OK) {
+            goto err_release_opts;
+        }
+    }
+
     *config_p = config;
     return UCS_OK;
 
+err_release_opts:
+    ucs_config_parser_release_opts(config, ucp_config_table);
 err_free:
     ucs_free(config);
 err:
@@ -70,6 +70,8 @@ typedef struct ucp_context_config {
     int                                    use_mt_mutex;
     /** On-demand progress */
     int                                    adaptive_progress;
+    /** Maximal time to poll the worker in ucp_worker_wait() before sleeping */
+    double                                 wait_spin_time;
     /** Eager-am multi-lane support */
     unsigned                               max_eager_lanes;
     /** Rendezvous-get multi-lane support */
@@ -82,6 +84,10 @@ typedef struct ucp_context_config {
     int                                    flush_worker_eps;
     /** Enable optimizations suitable for homogeneous systems */
     int                                    unified_mode;
+    /** Maximal number of unpacked remote worker addresses to keep */
+    unsigned                               address_cache_size;
+    /** Connect lanes other than active message lane on first use */
+    int                                    lazy_lanes;
 } ucp_context_config_t;
 
 
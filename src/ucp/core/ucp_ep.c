@@ -5,14 +5,18 @@
 */
 
 #include "ucp_ep.h"
+#include "ucp_mm.h"
 #include "ucp_worker.h"
 #include "ucp_ep.inl"
 #include "ucp_request.inl"
 
 #include <ucp/wireup/wireup_ep.h>
 #include <ucp/wireup/wireup.h>
+#include <ucp/rma/rma.h>
 #include <ucp/tag/eager.h>
 #include <ucp/tag/offload.h>
+#include <ucp/tag/rndv.h>
+#include <ucp/tag/tag_send.h>
 #include <ucp/stream/stream.h>
 #include <ucp/core/ucp_listener.h>
 #include <ucs/datastruct/queue.h>
@@ -227,7 +231,7 @@ ucs_status_t ucp_worker_create_mem_type_endpoints(ucp_worker_h worker)
             goto err_cleanup_eps;
         }
 
-        status = ucp_address_unpack(address_buffer, &local_address);
+        status = ucp_address_unpack(worker, address_buffer, &local_address);
         if (status != UCS_OK) {
             goto err_free_address_buffer;
         }
@@ -398,7 +402,7 @@ ucs_status_t ucp_ep_create_accept(ucp_worker_h worker,
     params.field_mask = UCP_EP_PARAM_FIELD_ERR_HANDLING_MODE;
     params.err_mode   = client_data->err_mode;
 
-    status = ucp_address_unpack(client_data + 1, &remote_address);
+    status = ucp_address_unpack(worker, client_data + 1, &remote_address);
     if (status != UCS_OK) {
         goto out;
     }
@@ -487,7 +491,7 @@ static ucs_status_t
 ucp_ep_create_api_to_worker_addr(ucp_worker_h worker,
                                  const ucp_ep_params_t *params, ucp_ep_h *ep_p)
 {
-    ucp_unpacked_address_t remote_address;
+    const ucp_unpacked_address_t *remote_address;
     ucp_ep_conn_sn_t conn_sn;
     ucs_status_t status;
     unsigned flags;
@@ -501,7 +505,7 @@ ucp_ep_create_api_to_worker_addr(ucp_worker_h worker,
 
     UCP_CHECK_PARAM_NON_NULL(params->address, status, goto out);
 
-    status = ucp_address_unpack(params->address, &remote_address);
+    status = ucp_address_cache_unpack(worker, params->address, &remote_address);
     if (status != UCS_OK) {
         goto out;
     }
@@ -517,9 +521,9 @@ ucp_ep_create_api_to_worker_addr(ucp_worker_h worker,
      * dst_ep != 0. So, ucp_wireup_request() will not create an unexpected ep
      * in ep_match.
      */
-    conn_sn = ucp_ep_match_get_next_sn(&worker->ep_match_ctx, remote_address.uuid);
-    ep = ucp_ep_match_retrieve_unexp(&worker->ep_match_ctx, remote_address.uuid,
-                                     conn_sn ^ (remote_address.uuid == worker->uuid));
+    conn_sn = ucp_ep_match_get_next_sn(&worker->ep_match_ctx, remote_address->uuid);
+    ep = ucp_ep_match_retrieve_unexp(&worker->ep_match_ctx, remote_address->uuid,
+                                     conn_sn ^ (remote_address->uuid == worker->uuid));
     if (ep != NULL) {
         status = ucp_ep_adjust_params(ep, params);
         if (status != UCS_OK) {
@@ -528,13 +532,13 @@ ucp_ep_create_api_to_worker_addr(ucp_worker_h worker,
 
         ucp_ep_flush_state_reset(ep);
         ucp_stream_ep_activate(ep);
-        goto out_free_address;
+        goto out;
     }
 
-    status = ucp_ep_create_to_worker_addr(worker, params, &remote_address, 0,
+    status = ucp_ep_create_to_worker_addr(worker, params, remote_address, 0,
                                           "from api call", &ep);
     if (status != UCS_OK) {
-        goto out_free_address;
+        goto out;
     }
 
     ep->conn_sn = conn_sn;
@@ -546,12 +550,12 @@ ucp_ep_create_api_to_worker_addr(ucp_worker_h worker,
      * waiting for connection request from the peer endpoint
      */
     flags = UCP_PARAM_VALUE(EP, params, flags, FLAGS, 0);
-    if ((remote_address.uuid == worker->uuid) &&
+    if ((remote_address->uuid == worker->uuid) &&
         !(flags & UCP_EP_PARAMS_FLAGS_NO_LOOPBACK)) {
         ucp_ep_update_dest_ep_ptr(ep, (uintptr_t)ep);
         ucp_ep_flush_state_reset(ep);
     } else {
-        ucp_ep_match_insert_exp(&worker->ep_match_ctx, remote_address.uuid, ep);
+        ucp_ep_match_insert_exp(&worker->ep_match_ctx, remote_address->uuid, ep);
     }
 
     /* if needed, send initial wireup message */
@@ -560,14 +564,12 @@ ucp_ep_create_api_to_worker_addr(ucp_worker_h worker,
         status = ucp_wireup_send_request(ep);
         if (status != UCS_OK) {
             ucp_ep_destroy_internal(ep);
-            goto out_free_address;
+            goto out;
         }
     }
 
     status = UCS_OK;
 
-out_free_address:
-    ucs_free(remote_address.address_list);
 out:
     if (status == UCS_OK) {
         *ep_p = ep;
@@ -1033,8 +1035,10 @@ static void ucp_ep_config_init_attrs(ucp_worker_t *worker, ucp_rsc_index_t rsc_i
         }
     } else {
         config->zcopy_auto_thresh    = 0;
+        /* Empty buffers cannot be registered, so send them with bcopy */
         config->sync_zcopy_thresh[0] = config->zcopy_thresh[0] =
-                ucs_min(context->config.ext.zcopy_thresh, adjust_min_val);
+                ucs_max(ucs_min(context->config.ext.zcopy_thresh,
+                                adjust_min_val), 1);
     }
 
     for (mem_type = 0; mem_type < UCT_MD_MEM_TYPE_LAST; mem_type++) {
@@ -1540,6 +1544,501 @@ void ucp_ep_print_info(ucp_ep_h ep, FILE *stream)
     UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(ep->worker);
 }
 
+/*
+ * Protocol which is selected for an operation of a given length, and its
+ * modeled completion time. The model uses the same latency functions as
+ * ucp_ep_config_calc_rndv_thresh().
+ */
+typedef struct {
+    const char                  *name;
+    ucp_lane_map_t              lane_map;
+    double                      time;     /* Modeled time, seconds */
+} ucp_ep_proto_select_t;
+
+
+static ucp_lane_map_t ucp_ep_proto_lanes_map(const ucp_lane_index_t *lanes)
+{
+    ucp_lane_map_t lane_map = 0;
+    int i;
+
+    for (i = 0; (i < UCP_MAX_LANES) && (lanes[i] != UCP_NULL_LANE); ++i) {
+        lane_map |= UCS_BIT(lanes[i]);
+    }
+    return lane_map;
+}
+
+/* Time to send one control message, such as RTS or ATS, on the AM lane */
+static double ucp_ep_proto_am_msg_time(ucp_ep_h ep)
+{
+    uct_iface_attr_t *iface_attr = ucp_ep_get_iface_attr(ep,
+                                                         ucp_ep_get_am_lane(ep));
+
+    return iface_attr->overhead +
+           ucp_tl_iface_latency(ep->worker->context, iface_attr);
+}
+
+static double ucp_ep_proto_reg_time(ucp_ep_h ep, ucp_lane_index_t lane,
+                                    size_t length)
+{
+    const uct_md_attr_t *md_attr = ucp_ep_md_attr(ep, lane);
+
+    if (!(md_attr->cap.flags & UCT_MD_FLAG_REG)) {
+        return 0;
+    }
+
+    return md_attr->reg_cost.overhead + (md_attr->reg_cost.growth * length);
+}
+
+/*
+ * Time to transfer the data over a set of lanes, in fragments of up to
+ * max_frag bytes. Bandwidth of the lanes is aggregated, and the data copy
+ * bandwidth limits bcopy protocols.
+ */
+static double ucp_ep_proto_transfer_time(ucp_ep_h ep, ucp_lane_map_t lane_map,
+                                         size_t length, size_t max_frag,
+                                         int bcopy)
+{
+    ucp_context_h context = ep->worker->context;
+    double bandwidth      = 0;
+    double overhead       = 0;
+    double latency        = 0;
+    uct_iface_attr_t *iface_attr;
+    ucp_lane_index_t lane;
+    double byte_time;
+    size_t num_frags;
+
+    ucs_for_each_bit(lane, lane_map) {
+        iface_attr = ucp_ep_get_iface_attr(ep, lane);
+        bandwidth += iface_attr->bandwidth;
+        overhead   = ucs_max(overhead, iface_attr->overhead);
+        latency    = ucs_max(latency, ucp_tl_iface_latency(context, iface_attr));
+    }
+
+    byte_time = 1.0 / bandwidth;
+    if (bcopy) {
+        byte_time = ucs_max(byte_time, 1.0 / context->config.ext.bcopy_bw);
+    }
+
+    num_frags = ((max_frag == 0) || (length <= max_frag)) ? 1 :
+                ucs_div_round_up(length, max_frag);
+    return (num_frags * overhead) + (length * byte_time) + latency;
+}
+
+static void ucp_ep_proto_select_set(ucp_ep_proto_select_t *select,
+                                    const char *name, ucp_lane_map_t lane_map,
+                                    double time)
+{
+    select->name     = name;
+    select->lane_map = lane_map;
+    select->time     = time;
+}
+
+/*
+ * Initialize a request to send a contiguous host buffer of the given length,
+ * for selecting its protocol with the helpers of the send operations.
+ */
+static void ucp_ep_proto_req_init(ucp_request_t *req, ucp_ep_h ep,
+                                  ucp_lane_index_t lane, size_t length,
+                                  uint16_t flags)
+{
+    req->flags         = flags;
+    req->send.ep       = ep;
+    req->send.buffer   = NULL;
+    req->send.datatype = ucp_dt_make_contig(1);
+    req->send.mem_type = UCT_MD_MEM_TYPE_HOST;
+    req->send.length   = length;
+    req->send.lane     = lane;
+}
+
+/* Follows ucp_tag_send_start_rndv() and the reply of the receiver to RTS */
+static void ucp_ep_proto_select_rndv(ucp_ep_h ep, const ucp_request_t *req,
+                                     ucp_ep_proto_select_t *select)
+{
+    ucp_ep_config_t *config   = ucp_ep_config(ep);
+    ucp_rndv_mode_t rndv_mode = ep->worker->context->config.ext.rndv_mode;
+    size_t length             = req->send.length;
+    ucp_lane_map_t rma_bw_map = ucp_ep_proto_lanes_map(config->key.rma_bw_lanes);
+    ucp_lane_map_t am_bw_map  = ucp_ep_proto_lanes_map(config->key.am_bw_lanes);
+    double time;
+
+    /* RTS and completion control messages, and registration on both sides */
+    time = (2 * ucp_ep_proto_am_msg_time(ep)) +
+           (2 * ucp_ep_proto_reg_time(ep, req->send.lane, length));
+
+    if (ucp_ep_is_tag_offload_enabled(config)) {
+        time += ucp_ep_proto_transfer_time(ep, UCS_BIT(config->tag.lane),
+                                           length, 0, 0);
+        ucp_ep_proto_select_set(select, "rndv_offload",
+                                UCS_BIT(config->tag.lane), time);
+    } else if ((rma_bw_map != 0) && ucp_rndv_is_get_zcopy(req, rndv_mode)) {
+        /* The receiver fetches the data with get_zcopy */
+        time += ucp_ep_proto_transfer_time(ep, rma_bw_map, length,
+                                           config->tag.rndv.max_get_zcopy, 0);
+        ucp_ep_proto_select_set(select, "rndv_get", rma_bw_map, time);
+    } else if ((rma_bw_map != 0) && (rndv_mode != UCP_RNDV_MODE_GET_ZCOPY)) {
+        /* The receiver replies with RTR, and the sender does put_zcopy */
+        time += ucp_ep_proto_transfer_time(ep, rma_bw_map, length,
+                                           config->tag.rndv.max_put_zcopy, 0) +
+                ucp_ep_proto_am_msg_time(ep);
+        ucp_ep_proto_select_set(select, "rndv_put", rma_bw_map, time);
+    } else {
+        /* The receiver replies with RTR, and the sender sends active messages */
+        time += ucp_ep_proto_transfer_time(ep, am_bw_map, length,
+                                           config->am.max_bcopy, 1) +
+                ucp_ep_proto_am_msg_time(ep);
+        ucp_ep_proto_select_set(select, "rndv_am", am_bw_map, time);
+    }
+}
+
+/* Models the protocol chosen by ucp_request_send_select() */
+static void ucp_ep_proto_select_msg(ucp_ep_h ep, const ucp_request_t *req,
+                                    ucp_request_send_select_t send_select,
+                                    const ucp_ep_msg_config_t *msg_config,
+                                    const ucp_proto_t *proto,
+                                    ucp_ep_proto_select_t *select)
+{
+    ucp_ep_config_t *config  = ucp_ep_config(ep);
+    ucp_lane_index_t lane    = req->send.lane;
+    size_t length            = req->send.length;
+    ucp_lane_map_t am_bw_map = ucp_ep_proto_lanes_map(config->key.am_bw_lanes);
+    double time;
+
+    switch (send_select) {
+    case UCP_REQUEST_SEND_SELECT_SHORT:
+        ucp_ep_proto_select_set(select, "short", UCS_BIT(lane),
+                                ucp_ep_proto_transfer_time(ep, UCS_BIT(lane),
+                                                           length, 0, 1));
+        break;
+    case UCP_REQUEST_SEND_SELECT_BCOPY_SINGLE:
+        ucp_ep_proto_select_set(select, "bcopy", UCS_BIT(lane),
+                                ucp_ep_proto_transfer_time(ep, UCS_BIT(lane),
+                                                           length, 0, 1));
+        break;
+    case UCP_REQUEST_SEND_SELECT_BCOPY_MULTI:
+        time = ucp_ep_proto_transfer_time(ep, am_bw_map, length,
+                                          msg_config->max_bcopy -
+                                          proto->mid_hdr_size, 1);
+        ucp_ep_proto_select_set(select, "bcopy_multi", am_bw_map, time);
+        break;
+    case UCP_REQUEST_SEND_SELECT_ZCOPY_SINGLE:
+        time = ucp_ep_proto_reg_time(ep, lane, length) +
+               ucp_ep_proto_transfer_time(ep, UCS_BIT(lane), length, 0, 0);
+        ucp_ep_proto_select_set(select, "zcopy", UCS_BIT(lane), time);
+        break;
+    case UCP_REQUEST_SEND_SELECT_ZCOPY_MULTI:
+        time = ucp_ep_proto_reg_time(ep, lane, length) +
+               ucp_ep_proto_transfer_time(ep, am_bw_map, length,
+                                          msg_config->max_zcopy -
+                                          proto->mid_hdr_size, 0);
+        ucp_ep_proto_select_set(select, "zcopy_multi", am_bw_map, time);
+        break;
+    default:
+        ucp_ep_proto_select_rndv(ep, req, select);
+        break;
+    }
+}
+
+/* Models the protocol chosen by ucp_rma_basic_select_put/get() */
+static void ucp_ep_proto_select_rma(ucp_ep_h ep, ucp_rkey_h rkey, int is_put,
+                                    size_t length, ucp_ep_proto_select_t *select)
+{
+    ucp_ep_config_t *config = ucp_ep_config(ep);
+    ucp_lane_index_t lane   = rkey->cache.rma_lane;
+    ucp_lane_map_t lane_map = UCS_BIT(lane);
+    ucp_ep_rma_config_t *rma_config;
+    double time;
+
+    if (rkey->cache.rma_proto == &ucp_rma_sw_proto) {
+        /* Data is sent in active messages, and the peer replies */
+        time = ucp_ep_proto_transfer_time(ep, lane_map, length,
+                                          config->am.max_bcopy, 1) +
+               ucp_ep_proto_am_msg_time(ep);
+        ucp_ep_proto_select_set(select, "sw_am", lane_map, time);
+        return;
+    }
+
+    rma_config = &config->rma[lane];
+    if (is_put) {
+        switch (ucp_rma_basic_select_put(config, lane, length)) {
+        case UCP_RMA_BASIC_SELECT_SHORT:
+            time = ucp_ep_proto_transfer_time(ep, lane_map, length,
+                                              rma_config->max_put_short, 1);
+            ucp_ep_proto_select_set(select, "short", lane_map, time);
+            break;
+        case UCP_RMA_BASIC_SELECT_BCOPY:
+            time = ucp_ep_proto_transfer_time(ep, lane_map, length,
+                                              rma_config->max_put_bcopy, 1);
+            ucp_ep_proto_select_set(select, "bcopy", lane_map, time);
+            break;
+        default:
+            time = ucp_ep_proto_reg_time(ep, lane, length) +
+                   ucp_ep_proto_transfer_time(ep, lane_map, length,
+                                              rma_config->max_put_zcopy, 0);
+            ucp_ep_proto_select_set(select, "zcopy", lane_map, time);
+            break;
+        }
+    } else {
+        /* Get requires a round trip */
+        time = ucp_tl_iface_latency(ep->worker->context,
+                                    ucp_ep_get_iface_attr(ep, lane));
+        if (ucp_rma_basic_select_get(config, lane, length) ==
+            UCP_RMA_BASIC_SELECT_BCOPY) {
+            time += ucp_ep_proto_transfer_time(ep, lane_map, length,
+                                               rma_config->max_get_bcopy, 1);
+            ucp_ep_proto_select_set(select, "bcopy", lane_map, time);
+        } else {
+            time += ucp_ep_proto_reg_time(ep, lane, length) +
+                    ucp_ep_proto_transfer_time(ep, lane_map, length,
+                                               rma_config->max_get_zcopy, 0);
+            ucp_ep_proto_select_set(select, "zcopy", lane_map, time);
+        }
+    }
+}
+
+static void ucp_ep_proto_select_amo(ucp_ep_h ep, ucp_rkey_h rkey, int fetch,
+                                    ucp_ep_proto_select_t *select)
+{
+    ucp_lane_index_t lane        = rkey->cache.amo_lane;
+    uct_iface_attr_t *iface_attr = ucp_ep_get_iface_attr(ep, lane);
+    double latency               = ucp_tl_iface_latency(ep->worker->context,
+                                                        iface_attr);
+
+    ucp_ep_proto_select_set(select,
+                            (rkey->cache.amo_proto == &ucp_amo_sw_proto) ?
+                            "sw_am" : "device", UCS_BIT(lane),
+                            iface_attr->overhead + ((fetch ? 2 : 1) * latency));
+}
+
+static void ucp_ep_proto_select_print(FILE *stream, const char *op_name,
+                                      size_t length,
+                                      const ucp_ep_proto_select_t *select)
+{
+    char lanes_str[32];
+    ucp_lane_index_t lane;
+    char *p, *endp;
+
+    p    = lanes_str;
+    endp = lanes_str + sizeof(lanes_str);
+    *p   = '\0';
+    ucs_for_each_bit(lane, select->lane_map) {
+        snprintf(p, endp - p, "%s%d", (p == lanes_str) ? "" : ",", lane);
+        p += strlen(p);
+    }
+
+    fprintf(stream, "# %18s %10zu  %-12s %-8s %12.3f %12.2f\n", op_name, length,
+            select->name, lanes_str, select->time * UCS_USEC_PER_SEC,
+            length / select->time / UCS_MBYTE);
+}
+
+static const char *ucp_ep_proto_thresh_str(size_t thresh, char *buf,
+                                           size_t max)
+{
+    if (thresh == SIZE_MAX) {
+        return "inf";
+    }
+
+    snprintf(buf, max, "%zu", thresh);
+    return buf;
+}
+
+typedef enum {
+    UCP_EP_PROTO_OP_TAG_SEND,
+    UCP_EP_PROTO_OP_TAG_SEND_NBR,
+    UCP_EP_PROTO_OP_TAG_SEND_SYNC,
+    UCP_EP_PROTO_OP_STREAM_SEND,
+    UCP_EP_PROTO_OP_PUT,
+    UCP_EP_PROTO_OP_GET,
+    UCP_EP_PROTO_OP_ATOMIC_POST,
+    UCP_EP_PROTO_OP_ATOMIC_FETCH,
+    UCP_EP_PROTO_OP_LAST
+} ucp_ep_proto_op_t;
+
+
+static const struct {
+    const char                  *name;
+    uint64_t                    feature;
+} ucp_ep_proto_ops[] = {
+    [UCP_EP_PROTO_OP_TAG_SEND]      = {"tag_send",      UCP_FEATURE_TAG},
+    [UCP_EP_PROTO_OP_TAG_SEND_NBR]  = {"tag_send_nbr",  UCP_FEATURE_TAG},
+    [UCP_EP_PROTO_OP_TAG_SEND_SYNC] = {"tag_send_sync", UCP_FEATURE_TAG},
+    [UCP_EP_PROTO_OP_STREAM_SEND]   = {"stream_send",   UCP_FEATURE_STREAM},
+    [UCP_EP_PROTO_OP_PUT]           = {"put",           UCP_FEATURE_RMA},
+    [UCP_EP_PROTO_OP_GET]           = {"get",           UCP_FEATURE_RMA},
+    [UCP_EP_PROTO_OP_ATOMIC_POST]   = {"atomic_post",   UCP_FEATURE_AMO},
+    [UCP_EP_PROTO_OP_ATOMIC_FETCH]  = {"atomic_fetch",  UCP_FEATURE_AMO}
+};
+
+
+static void ucp_ep_proto_select_op(ucp_ep_h ep, ucp_rkey_h rkey,
+                                   ucp_ep_proto_op_t op, size_t length,
+                                   ucp_ep_proto_select_t *select)
+{
+    ucp_ep_config_t *config               = ucp_ep_config(ep);
+    const ucp_ep_msg_config_t *tag_config = &config->tag.eager;
+    ucp_request_send_select_t send_select;
+    ucp_request_t req;
+
+    switch (op) {
+    case UCP_EP_PROTO_OP_TAG_SEND:
+        ucp_ep_proto_req_init(&req, ep, config->tag.lane, length, 0);
+        send_select = ucp_tag_send_select(&req, 1, tag_config,
+                                          config->tag.rndv.rma_thresh,
+                                          config->tag.rndv.am_thresh,
+                                          config->tag.proto, 1);
+        ucp_ep_proto_select_msg(ep, &req, send_select, tag_config,
+                                config->tag.proto, select);
+        break;
+    case UCP_EP_PROTO_OP_TAG_SEND_NBR:
+        ucp_ep_proto_req_init(&req, ep, config->tag.lane, length, 0);
+        send_select = ucp_tag_send_select(&req, 1, tag_config,
+                                          config->tag.rndv_send_nbr.rma_thresh,
+                                          config->tag.rndv_send_nbr.am_thresh,
+                                          config->tag.proto, 0);
+        ucp_ep_proto_select_msg(ep, &req, send_select, tag_config,
+                                config->tag.proto, select);
+        break;
+    case UCP_EP_PROTO_OP_TAG_SEND_SYNC:
+        ucp_ep_proto_req_init(&req, ep, config->tag.lane, length,
+                              UCP_REQUEST_FLAG_SYNC);
+        send_select = ucp_tag_send_select(&req, 1, tag_config,
+                                          config->tag.rndv.rma_thresh,
+                                          config->tag.rndv.am_thresh,
+                                          config->tag.sync_proto, 1);
+        ucp_ep_proto_select_msg(ep, &req, send_select, tag_config,
+                                config->tag.sync_proto, select);
+        /* Synchronous send waits for an acknowledgment from the peer */
+        select->time += ucp_ep_proto_am_msg_time(ep);
+        break;
+    case UCP_EP_PROTO_OP_STREAM_SEND:
+        ucp_ep_proto_req_init(&req, ep, ucp_ep_get_am_lane(ep), length, 0);
+        send_select = ucp_stream_send_select(&req, 1, &config->am,
+                                             config->stream.proto);
+        ucp_ep_proto_select_msg(ep, &req, send_select, &config->am,
+                                config->stream.proto, select);
+        break;
+    case UCP_EP_PROTO_OP_PUT:
+    case UCP_EP_PROTO_OP_GET:
+        ucp_ep_proto_select_rma(ep, rkey, op == UCP_EP_PROTO_OP_PUT, length,
+                                select);
+        break;
+    default:
+        ucp_ep_proto_select_amo(ep, rkey, op == UCP_EP_PROTO_OP_ATOMIC_FETCH,
+                                select);
+        break;
+    }
+}
+
+void ucp_ep_print_proto_select(ucp_ep_h ep, ucp_rkey_h rkey, size_t min_length,
+                               size_t max_length, FILE *stream)
+{
+    ucp_context_h context                 = ep->worker->context;
+    ucp_ep_config_t *config               = ucp_ep_config(ep);
+    const ucp_ep_msg_config_t *tag_config = &config->tag.eager;
+    uint64_t features                     = context->config.features;
+    char buf[4][32];
+    ucp_ep_proto_select_t select;
+    ucp_rma_proto_t *rma_proto;
+    ucp_ep_proto_op_t op;
+    ucp_lane_index_t lane;
+    ucs_status_t status;
+    size_t length;
+
+    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(ep->worker);
+
+    if ((rkey == NULL) ||
+        (UCP_RKEY_RESOLVE(rkey, ep, rma) != UCS_OK)) {
+        features &= ~(UCP_FEATURE_RMA | UCP_FEATURE_AMO);
+    }
+
+    fprintf(stream, "#\n");
+    fprintf(stream, "# UCP protocol selection\n");
+    fprintf(stream, "#\n");
+    fprintf(stream, "# %18s: %s\n", "peer", ucp_ep_peer_name(ep));
+
+    if (features & UCP_FEATURE_TAG) {
+        fprintf(stream, "# %18s: %s, short..%zd zcopy %s.. rndv rma %s.. am %s.., "
+                "nbr rndv rma %s.. am %s..\n", "tag_send",
+                ucp_ep_is_tag_offload_enabled(config) ? "offload" : "am",
+                tag_config->max_short,
+                ucp_ep_proto_thresh_str(tag_config->zcopy_thresh[0], buf[0], 32),
+                ucp_ep_proto_thresh_str(config->tag.rndv.rma_thresh, buf[1], 32),
+                ucp_ep_proto_thresh_str(config->tag.rndv.am_thresh, buf[2], 32),
+                ucp_ep_proto_thresh_str(config->tag.rndv_send_nbr.rma_thresh,
+                                        buf[3], 32),
+                ucp_ep_proto_thresh_str(config->tag.rndv_send_nbr.am_thresh,
+                                        buf[0], 32));
+    }
+
+    if (features & UCP_FEATURE_STREAM) {
+        fprintf(stream, "# %18s: short..%zd zcopy %s..\n", "stream_send",
+                config->am.max_short,
+                ucp_ep_proto_thresh_str(config->am.zcopy_thresh[0], buf[0], 32));
+    }
+
+    if (features & UCP_FEATURE_RMA) {
+        lane      = rkey->cache.rma_lane;
+        rma_proto = rkey->cache.rma_proto;
+        fprintf(stream, "# %18s: %s lane[%d], put short..%s zcopy %s.., "
+                "get zcopy %s..\n", "put/get", rma_proto->name, lane,
+                ucp_ep_proto_thresh_str(ucs_max(config->rma[lane].max_put_short,
+                                                config->bcopy_thresh),
+                                        buf[0], 32),
+                ucp_ep_proto_thresh_str(config->rma[lane].put_zcopy_thresh,
+                                        buf[1], 32),
+                ucp_ep_proto_thresh_str(config->rma[lane].get_zcopy_thresh,
+                                        buf[2], 32));
+    }
+
+    if (features & UCP_FEATURE_AMO) {
+        status = UCP_RKEY_RESOLVE(rkey, ep, amo);
+        if (status != UCS_OK) {
+            features &= ~UCP_FEATURE_AMO;
+        } else {
+            fprintf(stream, "# %18s: %s lane[%d]\n", "atomic",
+                    rkey->cache.amo_proto->name, rkey->cache.amo_lane);
+        }
+    }
+
+    fprintf(stream, "#\n");
+    fprintf(stream, "# %18s %10s  %-12s %-8s %12s %12s\n", "operation",
+            "length", "protocol", "lanes", "time (usec)", "bw (MB/s)");
+
+    for (op = 0; op < UCP_EP_PROTO_OP_LAST; ++op) {
+        if (!(features & ucp_ep_proto_ops[op].feature)) {
+            continue;
+        }
+
+        fprintf(stream, "#\n");
+        if (ucp_ep_proto_ops[op].feature == UCP_FEATURE_AMO) {
+            /* Atomic operations are only 32 or 64 bit */
+            for (length = sizeof(uint32_t); length <= sizeof(uint64_t);
+                 length *= 2) {
+                if (features & ((length == sizeof(uint32_t)) ?
+                                UCP_FEATURE_AMO32 : UCP_FEATURE_AMO64)) {
+                    ucp_ep_proto_select_op(ep, rkey, op, length, &select);
+                    ucp_ep_proto_select_print(stream, ucp_ep_proto_ops[op].name,
+                                              length, &select);
+                }
+            }
+            continue;
+        }
+
+        for (length = min_length; length <= max_length;
+             length = (length == 0) ? 1 : (length * 2)) {
+            ucp_ep_proto_select_op(ep, rkey, op, length, &select);
+            ucp_ep_proto_select_print(stream, ucp_ep_proto_ops[op].name,
+                                      length, &select);
+            if (length > (max_length / 2)) {
+                break; /* avoid overflow */
+            }
+        }
+    }
+
+    fprintf(stream, "#\n");
+
+    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(ep->worker);
+}
+
 size_t ucp_ep_config_get_zcopy_auto_thresh(size_t iovcnt,
                                            const uct_linear_growth_t *reg_cost,
                                            const ucp_context_h context,
@@ -1555,5 +2054,6 @@ size_t ucp_ep_config_get_zcopy_auto_thresh(size_t iovcnt,
         return SIZE_MAX;
     }
 
-    return zcopy_thresh;
+    /* Empty buffers cannot be registered, so send them with bcopy */
+    return ucs_max((size_t)zcopy_thresh, 1);
 }
@@ -346,6 +346,15 @@ void ucp_ep_config_lane_info_str(ucp_context_h context,
                                  ucp_rsc_index_t aux_rsc_index,
                                  char *buf, size_t max);
 
+/**
+ * Print which protocol and lanes are selected for tag, stream, RMA and atomic
+ * operations, for message lengths from min_length to max_length in powers of
+ * 2, with the completion time and bandwidth modeled from the iface attributes.
+ * The rkey is used for RMA and atomics, and may be NULL.
+ */
+void ucp_ep_print_proto_select(ucp_ep_h ep, ucp_rkey_h rkey, size_t min_length,
+                               size_t max_length, FILE *stream);
+
 ucs_status_t ucp_ep_new(ucp_worker_h worker, const char *peer_name,
                         const char *message, ucp_ep_h *ep_p);
 
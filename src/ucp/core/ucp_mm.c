@@ -99,7 +99,14 @@ ucs_status_t ucp_mem_rereg_mds(ucp_context_h context, ucp_md_map_t reg_md_map,
             /* MD supports registration, register new memh on it */
             status = uct_md_mem_reg(context->tl_mds[md_index].md, address,
                                     length, uct_flags, &uct_memh[memh_index]);
-            if (status != UCS_OK) {
+            if (status == UCS_ERR_UNSUPPORTED) {
+                /* MD can register only some memory regions, e.g memfd which
+                 * shares only its own mappings; leave it out of the md_map */
+                ucs_trace("md[%d]=%s cannot register address %p length %zu",
+                          md_index, context->tl_mds[md_index].rsc.md_name,
+                          address, length);
+                continue;
+            } else if (status != UCS_OK) {
                 level = (uct_flags & UCT_MD_MEM_FLAG_HIDE_ERRORS) ?
                         UCS_LOG_LEVEL_DEBUG : UCS_LOG_LEVEL_ERROR;
                 ucs_log(level,
@@ -305,37 +305,32 @@ ucs_status_t ucp_request_test(void *request, ucp_tag_recv_info_t *info)
     return UCS_INPROGRESS;
 }
 
-ucs_status_t
-ucp_request_send_start(ucp_request_t *req, ssize_t max_short,
-                       size_t zcopy_thresh, size_t zcopy_max, size_t dt_count,
-                       const ucp_ep_msg_config_t* msg_config,
-                       const ucp_proto_t *proto)
+ucs_status_t ucp_request_send_start(ucp_request_t *req,
+                                    ucp_request_send_select_t select,
+                                    const ucp_proto_t *proto)
 {
-    size_t       length = req->send.length;
     ucs_status_t status;
-    int          multi;
 
-    if ((ssize_t)length <= max_short) {
-        /* short */
+    switch (select) {
+    case UCP_REQUEST_SEND_SELECT_SHORT:
         req->send.uct.func = proto->contig_short;
         UCS_PROFILE_REQUEST_EVENT(req, "start_contig_short", req->send.length);
         return UCS_OK;
-    } else if (length < zcopy_thresh) {
-        /* bcopy */
+    case UCP_REQUEST_SEND_SELECT_BCOPY_SINGLE:
         ucp_request_send_state_reset(req, NULL, UCP_REQUEST_SEND_PROTO_BCOPY_AM);
-        if (length <= msg_config->max_bcopy - proto->only_hdr_size) {
-            req->send.uct.func   = proto->bcopy_single;
-            UCS_PROFILE_REQUEST_EVENT(req, "start_bcopy_single", req->send.length);
-        } else {
-            req->send.uct.func        = proto->bcopy_multi;
-            req->send.tag.message_id  = req->send.ep->worker->tm.am.message_id++;
-            req->send.tag.am_bw_index = 1;
-            req->send.pending_lane    = UCP_NULL_LANE;
-            UCS_PROFILE_REQUEST_EVENT(req, "start_bcopy_multi", req->send.length);
-        }
+        req->send.uct.func = proto->bcopy_single;
+        UCS_PROFILE_REQUEST_EVENT(req, "start_bcopy_single", req->send.length);
+        return UCS_OK;
+    case UCP_REQUEST_SEND_SELECT_BCOPY_MULTI:
+        ucp_request_send_state_reset(req, NULL, UCP_REQUEST_SEND_PROTO_BCOPY_AM);
+        req->send.uct.func        = proto->bcopy_multi;
+        req->send.tag.message_id  = req->send.ep->worker->tm.am.message_id++;
+        req->send.tag.am_bw_index = 1;
+        req->send.pending_lane    = UCP_NULL_LANE;
+        UCS_PROFILE_REQUEST_EVENT(req, "start_bcopy_multi", req->send.length);
         return UCS_OK;
-    } else if (length < zcopy_max) {
-        /* zcopy */
+    case UCP_REQUEST_SEND_SELECT_ZCOPY_SINGLE:
+    case UCP_REQUEST_SEND_SELECT_ZCOPY_MULTI:
         ucp_request_send_state_reset(req, proto->zcopy_completion,
                                      UCP_REQUEST_SEND_PROTO_ZCOPY_AM);
         status = ucp_request_send_buffer_reg_lane(req, req->send.lane);
@@ -343,20 +338,7 @@ ucp_request_send_start(ucp_request_t *req, ssize_t max_short,
             return status;
         }
 
-        if (ucs_unlikely(length > msg_config->max_zcopy - proto->only_hdr_size)) {
-            multi = 1;
-        } else if (ucs_unlikely(UCP_DT_IS_IOV(req->send.datatype))) {
-            if (dt_count <= msg_config->max_iov) {
-                multi = 0;
-            } else {
-                multi = ucp_dt_iov_count_nonempty(req->send.buffer, dt_count) >
-                        msg_config->max_iov;
-            }
-        } else {
-            multi = 0;
-        }
-
-        if (multi) {
+        if (select == UCP_REQUEST_SEND_SELECT_ZCOPY_MULTI) {
             req->send.uct.func        = proto->zcopy_multi;
             req->send.tag.message_id  = req->send.ep->worker->tm.am.message_id++;
             req->send.tag.am_bw_index = 1;
@@ -367,9 +349,9 @@ ucp_request_send_start(ucp_request_t *req, ssize_t max_short,
             UCS_PROFILE_REQUEST_EVENT(req, "start_zcopy_single", req->send.length);
         }
         return UCS_OK;
+    default:
+        return UCS_ERR_NO_PROGRESS;
     }
-
-    return UCS_ERR_NO_PROGRESS;
 }
 
 void ucp_request_send_state_ff(ucp_request_t *req, ucs_status_t status)
@@ -62,6 +62,19 @@ enum {
 };
 
 
+/**
+ * Protocol selected for a send request by ucp_request_send_select()
+ */
+typedef enum {
+    UCP_REQUEST_SEND_SELECT_SHORT,
+    UCP_REQUEST_SEND_SELECT_BCOPY_SINGLE,
+    UCP_REQUEST_SEND_SELECT_BCOPY_MULTI,
+    UCP_REQUEST_SEND_SELECT_ZCOPY_SINGLE,
+    UCP_REQUEST_SEND_SELECT_ZCOPY_MULTI,
+    UCP_REQUEST_SEND_SELECT_RNDV
+} ucp_request_send_select_t;
+
+
 /**
  * Receive descriptor flags.
  */
@@ -305,10 +318,8 @@ ucs_status_t ucp_request_memory_reg(ucp_context_t *context, ucp_md_map_t md_map,
 void ucp_request_memory_dereg(ucp_context_t *context, ucp_datatype_t datatype,
                               ucp_dt_state_t *state, ucp_request_t *req_dbg);
 
-ucs_status_t ucp_request_send_start(ucp_request_t *req, ssize_t max_short,
-                                    size_t zcopy_thresh, size_t zcopy_max,
-                                    size_t dt_count,
-                                    const ucp_ep_msg_config_t* msg_config,
+ucs_status_t ucp_request_send_start(ucp_request_t *req,
+                                    ucp_request_send_select_t select,
                                     const ucp_proto_t *proto);
 
 /* Fast-forward to data end */
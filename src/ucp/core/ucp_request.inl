@@ -554,4 +554,39 @@ static UCS_F_ALWAYS_INLINE uintptr_t ucp_request_get_dest_ep_ptr(ucp_request_t *
     return ucp_ep_dest_ep_ptr(req->send.ep);
 }
 
+/*
+ * Select the protocol of a send request by its length and the thresholds of
+ * the operation. The selection has no side effects, so it is also used to
+ * explain the protocols of an endpoint. Rendezvous is selected for messages
+ * of zcopy_max bytes and larger.
+ */
+static UCS_F_ALWAYS_INLINE ucp_request_send_select_t
+ucp_request_send_select(const ucp_request_t *req, ssize_t max_short,
+                        size_t zcopy_thresh, size_t zcopy_max, size_t dt_count,
+                        const ucp_ep_msg_config_t* msg_config,
+                        const ucp_proto_t *proto)
+{
+    size_t length = req->send.length;
+
+    if ((ssize_t)length <= max_short) {
+        return UCP_REQUEST_SEND_SELECT_SHORT;
+    } else if (length < zcopy_thresh) {
+        return (length <= msg_config->max_bcopy - proto->only_hdr_size) ?
+               UCP_REQUEST_SEND_SELECT_BCOPY_SINGLE :
+               UCP_REQUEST_SEND_SELECT_BCOPY_MULTI;
+    } else if (length < zcopy_max) {
+        if (ucs_unlikely(length > msg_config->max_zcopy - proto->only_hdr_size)) {
+            return UCP_REQUEST_SEND_SELECT_ZCOPY_MULTI;
+        } else if (ucs_unlikely(UCP_DT_IS_IOV(req->send.datatype)) &&
+                   (dt_count > msg_config->max_iov) &&
+                   (ucp_dt_iov_count_nonempty(req->send.buffer, dt_count) >
+                    msg_config->max_iov)) {
+            return UCP_REQUEST_SEND_SELECT_ZCOPY_MULTI;
+        }
+        return UCP_REQUEST_SEND_SELECT_ZCOPY_SINGLE;
+    }
+
+    return UCP_REQUEST_SEND_SELECT_RNDV;
+}
+
 #endif
@@ -27,6 +27,9 @@
 #define UCP_WORKER_HEADROOM_SIZE \
     (sizeof(ucp_recv_desc_t) + UCP_WORKER_HEADROOM_PRIV_SIZE)
 
+/* Fraction of the maximal polling time to start from, when it grows again */
+#define UCP_WORKER_WAIT_SPIN_MIN_DIV  8
+
 
 #if ENABLE_STATS
 static ucs_stats_class_t ucp_worker_stats_class = {
@@ -333,10 +336,10 @@ static ucs_status_t ucp_worker_wakeup_signal_fd(ucp_worker_h worker)
     do {
         ret = write(worker->eventfd, &dummy, sizeof(dummy));
         if (ret == sizeof(dummy)) {
-            return UCS_OK;
+            break;
         } else if (ret == -1) {
             if (errno == EAGAIN) {
-                return UCS_OK;
+                break;
             } else if (errno != EINTR) {
                 ucs_error("Signaling wakeup failed: %m");
                 return UCS_ERR_IO_ERROR;
@@ -346,6 +349,9 @@ static ucs_status_t ucp_worker_wakeup_signal_fd(ucp_worker_h worker)
         }
     } while (ret == 0);
 
+    /* stop ucp_worker_wait() from polling; set after writing, so the polling
+     * can consume the event */
+    worker->wait.signaled = 1;
     return UCS_OK;
 }
 
@@ -1394,6 +1400,15 @@ ucs_status_t ucp_worker_create(ucp_context_h context,
     worker->uuid              = ucs_generate_uuid((uintptr_t)worker);
     worker->flush_ops_count   = 0;
     worker->inprogress        = 0;
+    worker->cs_wait.count     = 0;
+    worker->cs_wait.time      = 0;
+    worker->wait.max_spin     = ucs_time_from_sec(context->config.ext.wait_spin_time);
+    worker->wait.spin_budget  = worker->wait.max_spin / UCP_WORKER_WAIT_SPIN_MIN_DIV;
+    worker->wait.signaled     = 0;
+    worker->wait.spin_hits    = 0;
+    worker->wait.spin_time    = 0;
+    worker->wait.sleeps       = 0;
+    worker->wait.sleep_time   = 0;
     worker->ep_config_max     = config_count;
     worker->ep_config_count   = 0;
     worker->num_active_ifaces = 0;
@@ -1401,6 +1416,8 @@ ucs_status_t ucp_worker_create(ucp_context_h context,
     ucs_list_head_init(&worker->stream_ready_eps);
     ucs_list_head_init(&worker->all_eps);
     ucp_ep_match_init(&worker->ep_match_ctx);
+    ucp_address_cache_init(&worker->address_cache,
+                           context->config.ext.address_cache_size);
 
     UCS_STATIC_ASSERT(sizeof(ucp_ep_ext_gen_t) <= sizeof(ucp_ep_t));
     if (context->config.features & UCP_FEATURE_STREAM) {
@@ -1482,6 +1499,9 @@ ucs_status_t ucp_worker_create(ucp_context_h context,
         goto err_close_ifaces;
     }
 
+    /* Must be known before packing the worker address */
+    worker->address_profile = ucp_address_profile(worker);
+
     /* create mem type endponts */
     status = ucp_worker_create_mem_type_endpoints(worker);;
     if (status != UCS_OK) {
@@ -1554,6 +1574,7 @@ void ucp_worker_destroy(ucp_worker_h worker)
     ucs_mpool_cleanup(&worker->req_mp, 1);
     uct_worker_destroy(worker->uct);
     ucs_async_context_cleanup(&worker->async);
+    ucp_address_cache_cleanup(&worker->address_cache);
     ucp_ep_match_cleanup(&worker->ep_match_ctx);
     ucs_strided_alloc_cleanup(&worker->ep_alloc);
     UCS_STATS_NODE_FREE(worker->tm_offload_stats);
@@ -1597,6 +1618,13 @@ ucs_status_t ucp_worker_query(ucp_worker_h worker,
                                   (void**)&attr->address);
     }
 
+    if (attr->field_mask & UCP_WORKER_ATTR_FIELD_LOCK_WAITS) {
+        UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
+        attr->lock_waits     = worker->cs_wait.count;
+        attr->lock_wait_time = ucs_time_to_sec(worker->cs_wait.time);
+        UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(worker);
+    }
+
     return status;
 }
 
@@ -1622,6 +1650,17 @@ unsigned ucp_worker_progress(ucp_worker_h worker)
     return count;
 }
 
+/* Slow path of the worker lock: wait for another thread to release it, and
+ * account the waiting time */
+void ucp_worker_thread_cs_wait(ucp_worker_h worker)
+{
+    ucs_time_t start_time = ucs_get_time();
+
+    UCS_ASYNC_BLOCK(&worker->async);
+    ++worker->cs_wait.count;
+    worker->cs_wait.time += ucs_get_time() - start_time;
+}
+
 ssize_t ucp_stream_worker_poll(ucp_worker_h worker,
                                ucp_stream_poll_ep_t *poll_eps,
                                size_t max_eps, unsigned flags)
@@ -1726,9 +1765,74 @@ void ucp_worker_wait_mem(ucp_worker_h worker, void *address)
     ucs_arch_wait_mem(address);
 }
 
+/* Consume the pending signals of the wakeup fd */
+static void ucp_worker_wakeup_drain_fd(ucp_worker_h worker)
+{
+    uint64_t dummy;
+    int ret;
+
+    do {
+        ret = read(worker->eventfd, &dummy, sizeof(dummy));
+    } while ((ret == sizeof(dummy)) || ((ret == -1) && (errno == EINTR)));
+}
+
+/* Progress the worker for up to the current polling budget, and return
+ * nonzero if an event was found. The time when polling ended is returned in
+ * end_time_p. */
+static int ucp_worker_wait_spin(ucp_worker_h worker, ucs_time_t *end_time_p)
+{
+    ucs_time_t start_time = ucs_get_time();
+    ucs_time_t deadline   = start_time + worker->wait.spin_budget;
+    ucs_time_t now;
+    int found;
+
+    do {
+        found = (ucp_worker_progress(worker) != 0) || worker->wait.signaled;
+        now   = ucs_get_time();
+    } while (!found && (now < deadline));
+
+    /* this wait returns because of the signal, so it must not wake up the
+     * next wait or an external poll of the event fd */
+    if (worker->wait.signaled) {
+        worker->wait.signaled = 0;
+        ucp_worker_wakeup_drain_fd(worker);
+        found = 1;
+    }
+
+    worker->wait.spin_time += now - start_time;
+    worker->wait.spin_hits += found;
+    *end_time_p             = now;
+    return found;
+}
+
+/* Adjust the polling budget after sleeping: if the event arrived soon enough
+ * after polling stopped to be caught by polling longer, poll longer next time;
+ * otherwise the polling time was wasted, so poll less */
+static void ucp_worker_wait_adapt(ucp_worker_h worker, ucs_time_t spin_end_time,
+                                  ucs_time_t sleep_time)
+{
+    ucs_time_t min_spin = worker->wait.max_spin / UCP_WORKER_WAIT_SPIN_MIN_DIV;
+    ucs_time_t now      = ucs_get_time();
+
+    ++worker->wait.sleeps;
+    worker->wait.sleep_time += now - sleep_time;
+
+    if ((now - spin_end_time) <= worker->wait.max_spin) {
+        worker->wait.spin_budget = ucs_min(ucs_max(worker->wait.spin_budget * 2,
+                                                   min_spin),
+                                           worker->wait.max_spin);
+    } else {
+        worker->wait.spin_budget /= 2;
+    }
+
+    ucs_trace("worker %p: polling budget %.2f usec", worker,
+              ucs_time_to_usec(worker->wait.spin_budget));
+}
+
 ucs_status_t ucp_worker_wait(ucp_worker_h worker)
 {
     ucp_worker_iface_t *wiface;
+    ucs_time_t spin_end_time, sleep_time;
     struct pollfd *pfd;
     ucs_status_t status;
     nfds_t nfds;
@@ -1741,6 +1845,15 @@ ucs_status_t ucp_worker_wait(ucp_worker_h worker)
 
     UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
 
+    if (worker->wait.max_spin > 0) {
+        if (ucp_worker_wait_spin(worker, &spin_end_time)) {
+            status = UCS_OK;
+            goto out;
+        }
+    } else {
+        spin_end_time = 0;
+    }
+
     status = ucp_worker_arm(worker);
     if (status == UCS_ERR_BUSY) { /* if UCS_ERR_BUSY returned - no poll() must called */
         status = UCS_OK;
@@ -1764,10 +1877,14 @@ ucs_status_t ucp_worker_wait(ucp_worker_h worker)
         nfds         = 1;
     }
 
+    sleep_time = ucs_get_time();
     for (;;) {
         ret = poll(pfd, nfds, -1);
         if (ret >= 0) {
             ucs_assertv(ret == 1, "ret=%d", ret);
+            if (worker->wait.max_spin > 0) {
+                ucp_worker_wait_adapt(worker, spin_end_time, sleep_time);
+            }
             status = UCS_OK;
             goto out;
         } else {
@@ -1852,6 +1969,15 @@ void ucp_worker_print_info(ucp_worker_h worker, FILE *stream)
         fprintf(stream, "\n");
     }
 
+    if (worker->wait.max_spin > 0) {
+        fprintf(stream, "#            wait polling: budget %.2f of %.2f usec, "
+                "%"PRIu64" hits in %.0f usec, %"PRIu64" sleeps in %.0f usec\n",
+                ucs_time_to_usec(worker->wait.spin_budget),
+                ucs_time_to_usec(worker->wait.max_spin),
+                worker->wait.spin_hits, ucs_time_to_usec(worker->wait.spin_time),
+                worker->wait.sleeps, ucs_time_to_usec(worker->wait.sleep_time));
+    }
+
     fprintf(stream, "#\n");
 
     UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(worker);
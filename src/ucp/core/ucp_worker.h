@@ -14,6 +14,7 @@
 
 #include <ucp/proto/proto.h>
 #include <ucp/tag/tag_match.h>
+#include <ucp/wireup/address_cache.h>
 #include <ucp/wireup/ep_match.h>
 #include <ucs/datastruct/mpool.h>
 #include <ucs/datastruct/queue_types.h>
@@ -31,8 +32,9 @@
 
 #define UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(_worker)                 \
     do {                                                                \
-        if ((_worker)->flags & UCP_WORKER_FLAG_MT) {                    \
-            UCS_ASYNC_BLOCK(&(_worker)->async);                         \
+        if (((_worker)->flags & UCP_WORKER_FLAG_MT) &&                  \
+            ucs_unlikely(!ucs_async_try_block(&(_worker)->async))) {    \
+            ucp_worker_thread_cs_wait(_worker);                         \
         }                                                               \
     } while (0)
 
@@ -207,6 +209,9 @@ typedef struct ucp_worker {
     ucs_list_link_t               stream_ready_eps; /* List of EPs with received stream data */
     ucs_list_link_t               all_eps;       /* List of all endpoints */
     ucp_ep_match_ctx_t            ep_match_ctx;  /* Endpoint-to-endpoint matching context */
+    ucp_address_cache_t           address_cache; /* Unpacked remote worker addresses */
+    uint32_t                      address_profile; /* Hash of the resources, see
+                                                      ucp_address_profile() */
     ucp_worker_iface_t            *ifaces;       /* Array of interfaces, one for each resource */
     unsigned                      num_ifaces;    /* Number of elements in ifaces array  */
     unsigned                      num_active_ifaces; /* Number of activated ifaces  */
@@ -220,6 +225,22 @@ typedef struct ucp_worker {
     UCS_STATS_NODE_DECLARE(tm_offload_stats);
 
     ucs_cpu_set_t                 cpu_mask;        /* Save CPU mask for subsequent calls to ucp_worker_listen */
+
+    struct {
+        uint64_t                  count;         /* Lock acquisitions which had to wait */
+        ucs_time_t                time;          /* Total time spent waiting for the lock */
+    } cs_wait;                                   /* Contention on the multi-thread lock */
+
+    struct {
+        ucs_time_t                max_spin;      /* Upper limit of the polling time */
+        ucs_time_t                spin_budget;   /* Current polling time before sleeping */
+        volatile int              signaled;      /* Wakeup fd was signaled while polling */
+        uint64_t                  spin_hits;     /* Waits which ended while polling */
+        ucs_time_t                spin_time;     /* Total time spent polling */
+        uint64_t                  sleeps;        /* Waits which ended in poll() */
+        ucs_time_t                sleep_time;    /* Total time spent in poll() */
+    } wait;                                      /* Hybrid polling in ucp_worker_wait() */
+
     unsigned                      ep_config_max;   /* Maximal number of configurations */
     unsigned                      ep_config_count; /* Current number of configurations */
     ucp_ep_config_t               ep_config[0];    /* Array of transport limits and thresholds */
@@ -238,6 +259,8 @@ typedef struct ucp_worker_err_handle_arg {
 } ucp_worker_err_handle_arg_t;
 
 
+void ucp_worker_thread_cs_wait(ucp_worker_h worker);
+
 unsigned ucp_worker_get_ep_config(ucp_worker_h worker,
                                   const ucp_ep_config_key_t *key);
 
@@ -9,6 +9,7 @@
 #include <ucp/core/ucp_ep.inl>
 #include <ucp/core/ucp_request.h>
 #include <ucp/core/ucp_mm.h>
+#include <ucs/arch/cpu.h>
 #include <ucs/profile/profile.h>
 
 
@@ -104,7 +105,8 @@ size_t ucp_dt_pack(ucp_worker_h worker, ucp_datatype_t datatype,
     case UCP_DATATYPE_CONTIG:
         if ((ucs_likely(UCP_MEM_IS_HOST(mem_type))) ||
             (ucs_likely(UCP_MEM_IS_CUDA_MANAGED(mem_type)))) {
-            UCS_PROFILE_CALL(memcpy, dest, src + state->offset, length);
+            UCS_PROFILE_CALL_VOID(ucs_memcpy_relaxed, dest,
+                                  src + state->offset, length);
         } else {
             ucp_mem_type_pack(worker, dest, src + state->offset, length, mem_type);
         }
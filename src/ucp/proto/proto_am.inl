@@ -4,6 +4,9 @@
  * See file LICENSE for terms.
  */
 
+#ifndef UCP_PROTO_AM_INL_
+#define UCP_PROTO_AM_INL_
+
 #include <ucp/core/ucp_context.h>
 #include <ucp/core/ucp_request.h>
 #include <ucp/core/ucp_request.inl>
@@ -193,12 +196,12 @@ ucs_status_t ucp_do_am_zcopy_single(uct_pending_req_t *self, uint8_t am_id,
     status = uct_ep_am_zcopy(ep->uct_eps[req->send.lane], am_id, (void*)hdr,
                              hdr_size, iov, iovcnt, 0,
                              &req->send.state.uct_comp);
+    ucp_request_send_state_advance(req, &state,
+                                   UCP_REQUEST_SEND_PROTO_ZCOPY_AM,
+                                   status);
     if (status == UCS_OK) {
+        /* Completion callbacks check the offset to detect the last fragment */
         complete(req, UCS_OK);
-    } else {
-        ucp_request_send_state_advance(req, &state,
-                                       UCP_REQUEST_SEND_PROTO_ZCOPY_AM,
-                                       status);
     }
     return UCS_STATUS_IS_ERR(status) ? status : UCS_OK;
 }
@@ -302,14 +305,13 @@ ucs_status_t ucp_do_am_zcopy_multi(uct_pending_req_t *self, uint8_t am_id_first,
 
             if (!flag_iov_mid && (offset + mid_len == req->send.length)) {
                 /* Last stage */
-                if (status == UCS_OK) {
-                    complete(req, UCS_OK);
-                    return UCS_OK;
-                }
                 ucp_request_send_state_advance(req, &state,
                                                UCP_REQUEST_SEND_PROTO_ZCOPY_AM,
                                                status);
-                if (!UCS_STATUS_IS_ERR(status)) {
+                if (status == UCS_OK) {
+                    complete(req, UCS_OK);
+                    return UCS_OK;
+                } else if (!UCS_STATUS_IS_ERR(status)) {
                     return UCS_OK;
                 }
             }
@@ -394,3 +396,5 @@ ucp_proto_get_short_max(const ucp_request_t *req,
             (!UCP_MEM_IS_HOST(req->send.mem_type))) ?
            -1 : msg_config->max_short;
 }
+
+#endif
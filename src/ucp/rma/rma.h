@@ -70,6 +70,16 @@ typedef struct {
 } UCS_S_PACKED ucp_atomic_req_hdr_t;
 
 
+/**
+ * Transport operation used by the basic RMA protocol for a fragment
+ */
+typedef enum {
+    UCP_RMA_BASIC_SELECT_SHORT,
+    UCP_RMA_BASIC_SELECT_BCOPY,
+    UCP_RMA_BASIC_SELECT_ZCOPY
+} ucp_rma_basic_select_t;
+
+
 extern ucp_rma_proto_t ucp_rma_basic_proto;
 extern ucp_rma_proto_t ucp_rma_sw_proto;
 extern ucp_amo_proto_t ucp_amo_basic_proto;
@@ -83,4 +93,29 @@ void ucp_ep_flush_remote_completed(ucp_request_t *req);
 
 void ucp_rma_sw_send_cmpl(ucp_ep_h ep);
 
+
+static UCS_F_ALWAYS_INLINE ucp_rma_basic_select_t
+ucp_rma_basic_select_put(const ucp_ep_config_t *config, ucp_lane_index_t lane,
+                         size_t length)
+{
+    const ucp_ep_rma_config_t *rma_config = &config->rma[lane];
+
+    if ((length <= rma_config->max_put_short) ||
+        (length <= config->bcopy_thresh)) {
+        return UCP_RMA_BASIC_SELECT_SHORT;
+    } else if (ucs_likely(length < rma_config->put_zcopy_thresh)) {
+        return UCP_RMA_BASIC_SELECT_BCOPY;
+    }
+
+    return UCP_RMA_BASIC_SELECT_ZCOPY;
+}
+
+static UCS_F_ALWAYS_INLINE ucp_rma_basic_select_t
+ucp_rma_basic_select_get(const ucp_ep_config_t *config, ucp_lane_index_t lane,
+                         size_t length)
+{
+    return ucs_likely(length < config->rma[lane].get_zcopy_thresh) ?
+           UCP_RMA_BASIC_SELECT_BCOPY : UCP_RMA_BASIC_SELECT_ZCOPY;
+}
+
 #endif
@@ -18,15 +18,16 @@ static ucs_status_t ucp_rma_basic_progress_put(uct_pending_req_t *self)
     ucp_rkey_h rkey                 = req->send.rma.rkey;
     ucp_lane_index_t lane           = req->send.lane;
     ucp_ep_rma_config_t *rma_config = &ucp_ep_config(ep)->rma[lane];
+    ucp_rma_basic_select_t select;
     ucs_status_t status;
     ssize_t packed_len;
 
     ucs_assert(rkey->cache.ep_cfg_index == ep->cfg_index);
     ucs_assert(rkey->cache.rma_lane == lane);
 
-    if ((req->send.length <= rma_config->max_put_short) ||
-        (req->send.length <= ucp_ep_config(ep)->bcopy_thresh))
-    {
+    select = ucp_rma_basic_select_put(ucp_ep_config(ep), lane,
+                                      req->send.length);
+    if (select == UCP_RMA_BASIC_SELECT_SHORT) {
         packed_len = ucs_min(req->send.length, rma_config->max_put_short);
         status = UCS_PROFILE_CALL(uct_ep_put_short,
                                   ep->uct_eps[lane],
@@ -34,7 +35,7 @@ static ucs_status_t ucp_rma_basic_progress_put(uct_pending_req_t *self)
                                   packed_len,
                                   req->send.rma.remote_addr,
                                   rkey->cache.rma_rkey);
-    } else if (ucs_likely(req->send.length < rma_config->put_zcopy_thresh)) {
+    } else if (ucs_likely(select == UCP_RMA_BASIC_SELECT_BCOPY)) {
         ucp_memcpy_pack_context_t pack_ctx;
         pack_ctx.src    = req->send.buffer;
         pack_ctx.length = ucs_min(req->send.length, rma_config->max_put_bcopy);
@@ -82,7 +83,8 @@ static ucs_status_t ucp_rma_basic_progress_get(uct_pending_req_t *self)
     ucs_assert(rkey->cache.ep_cfg_index == ep->cfg_index);
     ucs_assert(rkey->cache.rma_lane == lane);
 
-    if (ucs_likely(req->send.length < rma_config->get_zcopy_thresh)) {
+    if (ucp_rma_basic_select_get(ucp_ep_config(ep), lane, req->send.length) ==
+        UCP_RMA_BASIC_SELECT_BCOPY) {
         frag_length = ucs_min(rma_config->max_get_bcopy, req->send.length);
         status = UCS_PROFILE_CALL(uct_ep_get_bcopy,
                                   ep->uct_eps[lane],
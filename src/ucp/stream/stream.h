@@ -10,6 +10,7 @@
 #include <ucp/core/ucp_ep.h>
 #include <ucp/core/ucp_ep.inl>
 #include <ucp/core/ucp_worker.h>
+#include <ucp/proto/proto_am.inl>
 
 
 typedef struct {
@@ -65,4 +66,21 @@ ucp_stream_worker_dequeue_ep_head(ucp_worker_h worker)
     return ep_ext;
 }
 
+/*
+ * Select the protocol of a stream send request. Stream messages do not use
+ * rendezvous.
+ */
+static UCS_F_ALWAYS_INLINE ucp_request_send_select_t
+ucp_stream_send_select(const ucp_request_t *req, size_t count,
+                       const ucp_ep_msg_config_t* msg_config,
+                       const ucp_proto_t *proto)
+{
+    size_t zcopy_thresh = ucp_proto_get_zcopy_threshold(req, msg_config,
+                                                        count, SIZE_MAX);
+    ssize_t max_short   = ucp_proto_get_short_max(req, msg_config);
+
+    return ucp_request_send_select(req, max_short, zcopy_thresh, SIZE_MAX,
+                                   count, msg_config, proto);
+}
+
 #endif /* UCP_STREAM_H_ */
@@ -47,13 +47,12 @@ ucp_stream_send_req(ucp_request_t *req, size_t count,
                     const ucp_ep_msg_config_t* msg_config,
                     ucp_send_callback_t cb, const ucp_proto_t *proto)
 {
-    size_t zcopy_thresh = ucp_proto_get_zcopy_threshold(req, msg_config,
-                                                        count, SIZE_MAX);
-    ssize_t max_short   = ucp_proto_get_short_max(req, msg_config);
+    ucs_status_t status;
 
-    ucs_status_t status = ucp_request_send_start(req, max_short, zcopy_thresh,
-                                                 SIZE_MAX, count, msg_config,
-                                                 proto);
+    status = ucp_request_send_start(req,
+                                    ucp_stream_send_select(req, count,
+                                                           msg_config, proto),
+                                    proto);
     if (status != UCS_OK) {
         return UCS_STATUS_PTR(status);
     }
@@ -12,13 +12,6 @@
 #include <ucp/proto/proto_am.inl>
 #include <ucs/datastruct/queue.h>
 
-static int ucp_rndv_is_get_zcopy(ucp_request_t *sreq, ucp_rndv_mode_t rndv_mode)
-{
-    return ((rndv_mode == UCP_RNDV_MODE_GET_ZCOPY) ||
-            ((rndv_mode == UCP_RNDV_MODE_AUTO) &&
-             UCP_MEM_IS_HOST(sreq->send.mem_type)));
-}
-
 static int ucp_rndv_is_pipeline_needed(ucp_request_t *sreq) {
     uct_md_attr_t *md_attr;
     unsigned md_index;
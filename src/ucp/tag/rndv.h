@@ -52,9 +52,21 @@ void ucp_rndv_matched(ucp_worker_h worker, ucp_request_t *req,
 
 ucs_status_t ucp_rndv_progress_rma_get_zcopy(uct_pending_req_t *self);
 
+ucs_status_t ucp_proto_progress_rndv_rts(uct_pending_req_t *self);
+
 ucs_status_t ucp_rndv_process_rts(void *arg, void *data, size_t length,
                                   unsigned tl_flags);
 
 size_t ucp_tag_rndv_rts_pack(void *dest, void *arg);
 
+
+/* Whether the receiver is asked to fetch the data with get_zcopy */
+static UCS_F_ALWAYS_INLINE int
+ucp_rndv_is_get_zcopy(const ucp_request_t *sreq, ucp_rndv_mode_t rndv_mode)
+{
+    return ((rndv_mode == UCP_RNDV_MODE_GET_ZCOPY) ||
+            ((rndv_mode == UCP_RNDV_MODE_AUTO) &&
+             UCP_MEM_IS_HOST(sreq->send.mem_type)));
+}
+
 #endif
@@ -7,6 +7,7 @@
 #include "tag_match.h"
 #include "eager.h"
 #include "rndv.h"
+#include "tag_send.h"
 
 #include <ucp/core/ucp_ep.h>
 #include <ucp/core/ucp_worker.h>
@@ -16,31 +17,6 @@
 #include <string.h>
 
 
-static UCS_F_ALWAYS_INLINE size_t
-ucp_tag_get_rndv_threshold(const ucp_request_t *req, size_t count,
-                           size_t max_iov, size_t rndv_rma_thresh,
-                           size_t rndv_am_thresh)
-{
-    switch (req->send.datatype & UCP_DATATYPE_CLASS_MASK) {
-    case UCP_DATATYPE_IOV:
-        if ((count > max_iov) &&
-            ucp_ep_is_tag_offload_enabled(ucp_ep_config(req->send.ep))) {
-            /* Make sure SW RNDV will be used, because tag offload does
-             * not support multi-packet eager protocols. */
-            return 1;
-        }
-        /* Fall through */
-    case UCP_DATATYPE_CONTIG:
-        return ucs_min(rndv_rma_thresh, rndv_am_thresh);
-    case UCP_DATATYPE_GENERIC:
-        return rndv_am_thresh;
-    default:
-        ucs_error("Invalid data type %lx", req->send.datatype);
-    }
-
-    return SIZE_MAX;
-}
-
 static UCS_F_ALWAYS_INLINE ucs_status_ptr_t
 ucp_tag_send_req(ucp_request_t *req, size_t dt_count,
                  const ucp_ep_msg_config_t* msg_config,
@@ -48,33 +24,15 @@ ucp_tag_send_req(ucp_request_t *req, size_t dt_count,
                  ucp_send_callback_t cb, const ucp_proto_t *proto,
                  int enable_zcopy)
 {
-    size_t rndv_thresh  = ucp_tag_get_rndv_threshold(req, dt_count,
-                                                     msg_config->max_iov,
-                                                     rndv_rma_thresh,
-                                                     rndv_am_thresh);
-    ssize_t max_short   = ucp_proto_get_short_max(req, msg_config);
+    ucp_request_send_select_t select;
     ucs_status_t status;
-    size_t zcopy_thresh;
-
-    if (enable_zcopy || ucs_unlikely(!UCP_MEM_IS_HOST(req->send.mem_type))) {
-        zcopy_thresh = ucp_proto_get_zcopy_threshold(req, msg_config, dt_count,
-                                                     rndv_thresh);
-    } else {
-        zcopy_thresh = rndv_thresh;
-    }
-
-    ucs_trace_req("select tag request(%p) progress algorithm datatype=%lx "
-                  "buffer=%p length=%zu max_short=%zd rndv_thresh=%zu "
-                  "zcopy_thresh=%zu zcopy_enabled=%d",
-                  req, req->send.datatype, req->send.buffer, req->send.length,
-                  max_short, rndv_thresh, zcopy_thresh, enable_zcopy);
 
-    status = ucp_request_send_start(req, max_short, zcopy_thresh, rndv_thresh,
-                                    dt_count, msg_config, proto);
+    select = ucp_tag_send_select(req, dt_count, msg_config, rndv_rma_thresh,
+                                 rndv_am_thresh, proto, enable_zcopy);
+    status = ucp_request_send_start(req, select, proto);
     if (ucs_unlikely(status != UCS_OK)) {
         if (status == UCS_ERR_NO_PROGRESS) {
             /* RMA/AM rendezvous */
-            ucs_assert(req->send.length >= rndv_thresh);
             status = ucp_tag_send_start_rndv(req);
             if (status != UCS_OK) {
                 return UCS_STATUS_PTR(status);
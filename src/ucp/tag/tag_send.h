@@ -0,0 +1,74 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2001-2019.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#ifndef UCP_TAG_SEND_H_
+#define UCP_TAG_SEND_H_
+
+#include <ucp/core/ucp_ep.inl>
+#include <ucp/core/ucp_request.inl>
+#include <ucp/proto/proto_am.inl>
+
+
+static UCS_F_ALWAYS_INLINE size_t
+ucp_tag_get_rndv_threshold(const ucp_request_t *req, size_t count,
+                           size_t max_iov, size_t rndv_rma_thresh,
+                           size_t rndv_am_thresh)
+{
+    switch (req->send.datatype & UCP_DATATYPE_CLASS_MASK) {
+    case UCP_DATATYPE_IOV:
+        if ((count > max_iov) &&
+            ucp_ep_is_tag_offload_enabled(ucp_ep_config(req->send.ep))) {
+            /* Make sure SW RNDV will be used, because tag offload does
+             * not support multi-packet eager protocols. */
+            return 1;
+        }
+        /* Fall through */
+    case UCP_DATATYPE_CONTIG:
+        return ucs_min(rndv_rma_thresh, rndv_am_thresh);
+    case UCP_DATATYPE_GENERIC:
+        return rndv_am_thresh;
+    default:
+        ucs_error("Invalid data type %lx", req->send.datatype);
+    }
+
+    return SIZE_MAX;
+}
+
+/*
+ * Select the protocol of a tag send request. Zero-copy is disabled for host
+ * memory when enable_zcopy is 0, as in ucp_tag_send_nbr().
+ */
+static UCS_F_ALWAYS_INLINE ucp_request_send_select_t
+ucp_tag_send_select(const ucp_request_t *req, size_t dt_count,
+                    const ucp_ep_msg_config_t* msg_config,
+                    size_t rndv_rma_thresh, size_t rndv_am_thresh,
+                    const ucp_proto_t *proto, int enable_zcopy)
+{
+    size_t rndv_thresh  = ucp_tag_get_rndv_threshold(req, dt_count,
+                                                     msg_config->max_iov,
+                                                     rndv_rma_thresh,
+                                                     rndv_am_thresh);
+    ssize_t max_short   = ucp_proto_get_short_max(req, msg_config);
+    size_t zcopy_thresh;
+
+    if (enable_zcopy || ucs_unlikely(!UCP_MEM_IS_HOST(req->send.mem_type))) {
+        zcopy_thresh = ucp_proto_get_zcopy_threshold(req, msg_config, dt_count,
+                                                     rndv_thresh);
+    } else {
+        zcopy_thresh = rndv_thresh;
+    }
+
+    ucs_trace_req("select tag request(%p) progress algorithm datatype=%lx "
+                  "buffer=%p length=%zu max_short=%zd rndv_thresh=%zu "
+                  "zcopy_thresh=%zu zcopy_enabled=%d",
+                  req, req->send.datatype, req->send.buffer, req->send.length,
+                  max_short, rndv_thresh, zcopy_thresh, enable_zcopy);
+
+    return ucp_request_send_select(req, max_short, zcopy_thresh, rndv_thresh,
+                                   dt_count, msg_config, proto);
+}
+
+#endif
@@ -9,6 +9,7 @@
 
 #include <ucp/core/ucp_worker.h>
 #include <ucp/core/ucp_ep.inl>
+#include <ucs/algorithm/crc.h>
 #include <ucs/arch/bitops.h>
 #include <ucs/debug/log.h>
 #include <inttypes.h>
@@ -17,10 +18,10 @@
 /*
  * Packed address layout:
  *
- * [ uuid(64bit) | worker_name(string) ]
+ * [ uuid(64bit) | header_flags(8bit) | profile(32bit) | worker_name(string) ]
  * [ device1_md_index | device1_address(var) ]
- *    [ tl1_name_csum(string) | tl1_info | tl1_address(var) ]
- *    [ tl2_name_csum(string) | tl2_info | tl2_address(var) ]
+ *    [ tl1_name_csum(16bit) | tl1_info | tl1_address(var) ]
+ *    [ tl2_name_csum(16bit) | tl2_info | tl2_address(var) ]
  *    ...
  * [ device2_md_index | device2_address(var) ]
  *    ...
@@ -30,6 +31,10 @@
  *     EMPTY.
  *   * If the address list is empty, then it will contain only a single md_index
  *     which equals to UCP_NULL_RESOURCE.
+ *   * The profile is packed only if header_flags has the flag PROFILE, which is
+ *     set in unified mode. In this case, every transport is packed as its
+ *     resource index (8bit) instead of tl_name_csum and tl_info, and the remote
+ *     side takes them from its own resources, which must have the same profile.
  *
  */
 
@@ -45,11 +50,11 @@ typedef struct {
 
 
 typedef struct {
-    float            overhead;
-    float            bandwidth;
-    float            lat_ovh;
+    uint16_t         overhead;       /* Quantized by ucp_address_pack_float() */
+    uint16_t         bandwidth;
+    uint16_t         lat_ovh;
     uint32_t         prio_cap_flags; /* 8 lsb: prio, 22 msb: cap flags, 2 hsb: amo */
-} ucp_address_packed_iface_attr_t;
+} UCS_S_PACKED ucp_address_packed_iface_attr_t;
 
 #define UCT_ADDRESS_FLAG_ATOMIC32     UCS_BIT(30) /* 32bit atomic operations */
 #define UCT_ADDRESS_FLAG_ATOMIC64     UCS_BIT(31) /* 64bit atomic operations */
@@ -67,6 +72,9 @@ typedef struct {
                                         UCP_ADDRESS_FLAG_MD_ALLOC | \
                                         UCP_ADDRESS_FLAG_MD_REG)
 
+#define UCP_ADDRESS_HEADER_FLAG_PROFILE  UCS_BIT(0) /* Transports are packed as
+                                                       resource indexes */
+
 static size_t ucp_address_string_packed_size(const char *s)
 {
     return strlen(s) + 1;
@@ -96,6 +104,36 @@ static const void* ucp_address_unpack_string(const void *src, char *s, size_t ma
     return src + length + 1;
 }
 
+/* Keep the 16 most significant bits of the single-precision value: the sign,
+ * the exponent, and 7 bits of the mantissa, rounded to nearest. It's enough to
+ * compare the performance of transports. */
+static uint16_t ucp_address_pack_float(double value)
+{
+    union {
+        float    f;
+        uint32_t u;
+    } v;
+
+    v.f = value;
+    return (v.u + 0x7fff + ((v.u >> 16) & 1)) >> 16;
+}
+
+static double ucp_address_unpack_float(uint16_t value)
+{
+    union {
+        float    f;
+        uint32_t u;
+    } v;
+
+    v.u = (uint32_t)value << 16;
+    return v.f;
+}
+
+static int ucp_address_is_profile(ucp_worker_h worker)
+{
+    return worker->context->config.ext.unified_mode;
+}
+
 static ucp_address_packed_device_t*
 ucp_address_get_device(const char *name, ucp_address_packed_device_t *devices,
                        ucp_rsc_index_t *num_devices_p)
@@ -157,8 +195,12 @@ ucp_address_gather_devices(ucp_worker_h worker, uint64_t tl_bitmap, int has_ep,
             dev->tl_addrs_size += 1 + iface_attr->ep_addr_len;
         }
 
-        dev->tl_addrs_size += sizeof(uint16_t); /* tl name checksum */
-        dev->tl_addrs_size += sizeof(ucp_address_packed_iface_attr_t); /* iface attr */
+        if (ucp_address_is_profile(worker)) {
+            dev->tl_addrs_size += 1;            /* resource index */
+        } else {
+            dev->tl_addrs_size += sizeof(uint16_t); /* tl name checksum */
+            dev->tl_addrs_size += sizeof(ucp_address_packed_iface_attr_t); /* iface attr */
+        }
         dev->tl_addrs_size += 1;                /* iface address length */
         dev->rsc_index      = i;
         dev->dev_addr_len   = iface_attr->device_addr_len;
@@ -186,8 +228,11 @@ static size_t ucp_address_packed_size(ucp_worker_h worker,
     const ucp_address_packed_device_t *dev;
     size_t size;
 
-    size = sizeof(uint64_t) +
+    size = sizeof(uint64_t) + 1 + /* uuid and header flags */
            ucp_address_string_packed_size(ucp_address_get_worker_name(worker));
+    if (ucp_address_is_profile(worker)) {
+        size += sizeof(uint32_t);
+    }
 
     if (num_devices == 0) {
         size += 1;                      /* NULL md_index */
@@ -247,9 +292,9 @@ static void ucp_address_pack_iface_attr(ucp_address_packed_iface_attr_t *packed,
     cap_flags = iface_attr->cap.flags;
 
     packed->prio_cap_flags = ((uint8_t)iface_attr->priority);
-    packed->overhead       = iface_attr->overhead;
-    packed->bandwidth      = iface_attr->bandwidth;
-    packed->lat_ovh        = iface_attr->latency.overhead;
+    packed->overhead       = ucp_address_pack_float(iface_attr->overhead);
+    packed->bandwidth      = ucp_address_pack_float(iface_attr->bandwidth);
+    packed->lat_ovh        = ucp_address_pack_float(iface_attr->latency.overhead);
 
     /* Keep only the bits defined by UCP_ADDRESS_IFACE_FLAGS, to shrink address. */
     packed_flag = UCS_BIT(8);
@@ -286,9 +331,9 @@ ucp_address_unpack_iface_attr(ucp_address_iface_attr_t *iface_attr,
 
     iface_attr->cap_flags = 0;
     iface_attr->priority  = packed->prio_cap_flags & UCS_MASK(8);
-    iface_attr->overhead  = packed->overhead;
-    iface_attr->bandwidth = packed->bandwidth;
-    iface_attr->lat_ovh   = packed->lat_ovh;
+    iface_attr->overhead  = ucp_address_unpack_float(packed->overhead);
+    iface_attr->bandwidth = ucp_address_unpack_float(packed->bandwidth);
+    iface_attr->lat_ovh   = ucp_address_unpack_float(packed->lat_ovh);
 
     packed_flag = UCS_BIT(8);
     bit         = 1;
@@ -312,6 +357,61 @@ ucp_address_unpack_iface_attr(ucp_address_iface_attr_t *iface_attr,
     }
 }
 
+/* Get the attributes which a remote worker with the same profile packs for the
+ * resource, from the local interface */
+static void ucp_address_profile_iface_attr(ucp_worker_h worker,
+                                           ucp_rsc_index_t rsc_index,
+                                           ucp_address_iface_attr_t *iface_attr)
+{
+    ucp_address_packed_iface_attr_t packed;
+
+    ucp_address_pack_iface_attr(&packed,
+                                ucp_worker_iface_get_attr(worker, rsc_index),
+                                worker->atomic_tls & UCS_BIT(rsc_index));
+    ucp_address_unpack_iface_attr(iface_attr, &packed);
+}
+
+uint32_t ucp_address_profile(ucp_worker_h worker)
+{
+    ucp_context_h context = worker->context;
+    ucp_address_packed_iface_attr_t packed;
+    const uct_tl_resource_desc_t *tl_rsc;
+    const uct_iface_attr_t *iface_attr;
+    ucp_rsc_index_t md_index;
+    ucp_rsc_index_t i;
+    uint64_t md_flags;
+    uint32_t crc;
+
+    /* everything which the address refers to by resource index, except the
+     * atomic transports, which are selected later in the same way */
+    crc = ucs_crc32(0, &context->tl_bitmap, sizeof(context->tl_bitmap));
+    ucs_for_each_bit(i, context->tl_bitmap) {
+        tl_rsc     = &context->tl_rscs[i].tl_rsc;
+        md_index   = context->tl_rscs[i].md_index;
+        md_flags   = context->tl_mds[md_index].attr.cap.flags &
+                     (UCT_MD_FLAG_ALLOC | UCT_MD_FLAG_REG);
+        iface_attr = ucp_worker_iface_get_attr(worker, i);
+
+        ucp_address_pack_iface_attr(&packed, iface_attr, 0);
+
+        crc = ucs_crc32(crc, tl_rsc->tl_name, strlen(tl_rsc->tl_name));
+        crc = ucs_crc32(crc, tl_rsc->dev_name, strlen(tl_rsc->dev_name));
+        crc = ucs_crc32(crc, &md_index, sizeof(md_index));
+        crc = ucs_crc32(crc, &md_flags, sizeof(md_flags));
+        crc = ucs_crc32(crc, &packed, sizeof(packed));
+        crc = ucs_crc32(crc, &iface_attr->cap.flags,
+                        sizeof(iface_attr->cap.flags));
+        crc = ucs_crc32(crc, &iface_attr->device_addr_len,
+                        sizeof(iface_attr->device_addr_len));
+        crc = ucs_crc32(crc, &iface_attr->iface_addr_len,
+                        sizeof(iface_attr->iface_addr_len));
+        crc = ucs_crc32(crc, &iface_attr->ep_addr_len,
+                        sizeof(iface_attr->ep_addr_len));
+    }
+
+    return crc;
+}
+
 static ucs_status_t ucp_address_do_pack(ucp_worker_h worker, ucp_ep_h ep,
                                         void *buffer, size_t size,
                                         uint64_t tl_bitmap, unsigned *order,
@@ -337,6 +437,15 @@ static ucs_status_t ucp_address_do_pack(ucp_worker_h worker, ucp_ep_h ep,
 
     *(uint64_t*)ptr = worker->uuid;
     ptr += sizeof(uint64_t);
+    if (ucp_address_is_profile(worker)) {
+        *(uint8_t*)ptr = UCP_ADDRESS_HEADER_FLAG_PROFILE;
+        ++ptr;
+        *(uint32_t*)ptr = worker->address_profile;
+        ptr += sizeof(uint32_t);
+    } else {
+        *(uint8_t*)ptr = 0;
+        ++ptr;
+    }
     ptr = ucp_address_pack_string(ucp_address_get_worker_name(worker), ptr);
 
     if (num_devices == 0) {
@@ -384,16 +493,22 @@ static ucs_status_t ucp_address_do_pack(ucp_worker_h worker, ucp_ep_h ep,
             wiface     = ucp_worker_iface(worker, i);
             iface_attr = &wiface->attr;
 
-            /* Transport name checksum */
-            *(uint16_t*)ptr = context->tl_rscs[i].tl_name_csum;
-            ptr += sizeof(uint16_t);
-
-            /* Transport information */
-            ucp_address_pack_iface_attr(ptr, iface_attr,
-                                        worker->atomic_tls & UCS_BIT(i));
-            ucp_address_memchek(ptr, sizeof(ucp_address_packed_iface_attr_t),
-                                &context->tl_rscs[dev->rsc_index].tl_rsc);
-            ptr += sizeof(ucp_address_packed_iface_attr_t);
+            if (ucp_address_is_profile(worker)) {
+                /* Resource index, the remote side has the same resources */
+                *(uint8_t*)ptr = i;
+                ++ptr;
+            } else {
+                /* Transport name checksum */
+                *(uint16_t*)ptr = context->tl_rscs[i].tl_name_csum;
+                ptr += sizeof(uint16_t);
+
+                /* Transport information */
+                ucp_address_pack_iface_attr(ptr, iface_attr,
+                                            worker->atomic_tls & UCS_BIT(i));
+                ucp_address_memchek(ptr, sizeof(ucp_address_packed_iface_attr_t),
+                                    &context->tl_rscs[dev->rsc_index].tl_rsc);
+                ptr += sizeof(ucp_address_packed_iface_attr_t);
+            }
 
 
             if (!(iface_attr->cap.flags & UCT_IFACE_FLAG_CONNECT_TO_IFACE) &&
@@ -508,37 +623,41 @@ out:
     return status;
 }
 
-ucs_status_t ucp_address_unpack(const void *buffer,
-                                ucp_unpacked_address_t *unpacked_address)
+static const void *
+ucp_address_unpack_header(const void *buffer, uint64_t *uuid_p,
+                          uint8_t *header_flags_p, uint32_t *profile_p)
 {
-    ucp_address_entry_t *address_list, *address;
-    const uct_device_addr_t *dev_addr;
-    ucp_rsc_index_t dev_index;
-    ucp_rsc_index_t md_index;
-    unsigned address_count;
+    const void *ptr = buffer;
+
+    *uuid_p         = *(uint64_t*)ptr;
+    ptr            += sizeof(uint64_t);
+    *header_flags_p = *(uint8_t*)ptr;
+    ++ptr;
+    if (*header_flags_p & UCP_ADDRESS_HEADER_FLAG_PROFILE) {
+        *profile_p  = *(uint32_t*)ptr;
+        ptr        += sizeof(uint32_t);
+    } else {
+        *profile_p  = 0;
+    }
+    return ptr;
+}
+
+/* Walk the device and transport list which starts at 'ptr', and return the
+ * end of the packed address */
+static const void *ucp_address_skip_devices(const void *ptr,
+                                            uint8_t header_flags,
+                                            unsigned *address_count_p)
+{
+    unsigned address_count = 0;
     int last_dev, last_tl, ep_addr_present;
     int empty_dev;
-    uint64_t md_flags;
     size_t dev_addr_len;
     size_t iface_addr_len;
     size_t ep_addr_len;
-    uint8_t md_byte;
-    const void *ptr;
-    const void *aptr;
 
-    ptr = buffer;
-    unpacked_address->uuid = *(uint64_t*)ptr;
-    ptr += sizeof(uint64_t);
-
-    aptr = ucp_address_unpack_string(ptr, unpacked_address->name,
-                                     sizeof(unpacked_address->name));
-
-    address_count = 0;
-
-    /* Count addresses */
-    ptr = aptr;
     do {
         if (*(uint8_t*)ptr == UCP_NULL_RESOURCE) {
+            ++ptr;
             break;
         }
 
@@ -555,8 +674,12 @@ ucs_status_t ucp_address_unpack(const void *buffer,
 
         last_tl = empty_dev;
         while (!last_tl) {
-            ptr += sizeof(uint16_t);                        /* tl_name_csum */
-            ptr += sizeof(ucp_address_packed_iface_attr_t); /* iface attr */
+            if (header_flags & UCP_ADDRESS_HEADER_FLAG_PROFILE) {
+                ptr += 1;                                   /* rsc_index */
+            } else {
+                ptr += sizeof(uint16_t);                    /* tl_name_csum */
+                ptr += sizeof(ucp_address_packed_iface_attr_t); /* iface attr */
+            }
 
             /* iface and ep address lengths */
             iface_addr_len  = (*(uint8_t*)ptr) & UCP_ADDRESS_FLAG_LEN_MASK;
@@ -575,6 +698,61 @@ ucs_status_t ucp_address_unpack(const void *buffer,
 
     } while (!last_dev);
 
+    *address_count_p = address_count;
+    return ptr;
+}
+
+size_t ucp_address_length(const void *buffer)
+{
+    uint8_t header_flags;
+    unsigned address_count;
+    uint32_t profile;
+    uint64_t uuid;
+    const void *ptr;
+
+    ptr  = ucp_address_unpack_header(buffer, &uuid, &header_flags, &profile);
+    ptr += 1 + *(uint8_t*)ptr; /* worker name */
+    ptr = ucp_address_skip_devices(ptr, header_flags, &address_count);
+    return ptr - buffer;
+}
+
+ucs_status_t ucp_address_unpack(ucp_worker_h worker, const void *buffer,
+                                ucp_unpacked_address_t *unpacked_address)
+{
+    ucp_context_h context = worker->context;
+    ucp_address_entry_t *address_list, *address;
+    const uct_device_addr_t *dev_addr;
+    ucp_rsc_index_t dev_index;
+    ucp_rsc_index_t md_index;
+    ucp_rsc_index_t rsc_index;
+    unsigned address_count;
+    int last_dev, last_tl, ep_addr_present;
+    int empty_dev;
+    uint64_t md_flags;
+    size_t dev_addr_len;
+    size_t iface_addr_len;
+    size_t ep_addr_len;
+    uint8_t header_flags;
+    uint32_t profile;
+    uint8_t md_byte;
+    const void *ptr;
+    const void *aptr;
+
+    ptr = ucp_address_unpack_header(buffer, &unpacked_address->uuid,
+                                    &header_flags, &profile);
+    if ((header_flags & UCP_ADDRESS_HEADER_FLAG_PROFILE) &&
+        (profile != worker->address_profile)) {
+        ucs_error("address of worker 0x%"PRIx64" has profile 0x%08x, which is "
+                  "different from the local profile 0x%08x",
+                  unpacked_address->uuid, profile, worker->address_profile);
+        return UCS_ERR_UNREACHABLE;
+    }
+
+    aptr = ucp_address_unpack_string(ptr, unpacked_address->name,
+                                     sizeof(unpacked_address->name));
+
+    /* Count addresses */
+    ucp_address_skip_devices(aptr, header_flags, &address_count);
 
     /* Allocate address list */
     address_list = ucs_calloc(address_count, sizeof(*address_list),
@@ -612,13 +790,30 @@ ucs_status_t ucp_address_unpack(const void *buffer,
 
         last_tl = empty_dev;
         while (!last_tl) {
-            /* tl name */
-            address->tl_name_csum = *(uint16_t*)ptr;
-            ptr += sizeof(uint16_t);
+            if (header_flags & UCP_ADDRESS_HEADER_FLAG_PROFILE) {
+                /* resource index, same as the local one */
+                rsc_index = *(uint8_t*)ptr;
+                ++ptr;
+                if ((rsc_index >= context->num_tls) ||
+                    !(context->tl_bitmap & UCS_BIT(rsc_index))) {
+                    ucs_error("invalid resource index %d in address of worker "
+                              "0x%"PRIx64, rsc_index, unpacked_address->uuid);
+                    ucs_free(address_list);
+                    return UCS_ERR_INVALID_ADDR;
+                }
+
+                address->tl_name_csum = context->tl_rscs[rsc_index].tl_name_csum;
+                ucp_address_profile_iface_attr(worker, rsc_index,
+                                               &address->iface_attr);
+            } else {
+                /* tl_name_csum */
+                address->tl_name_csum = *(uint16_t*)ptr;
+                ptr += sizeof(uint16_t);
 
-            /* tl_name_csum */
-            ucp_address_unpack_iface_attr(&address->iface_attr, ptr);
-            ptr += sizeof(ucp_address_packed_iface_attr_t);
+                /* iface attr */
+                ucp_address_unpack_iface_attr(&address->iface_attr, ptr);
+                ptr += sizeof(ucp_address_packed_iface_attr_t);
+            }
 
             /* tl address length */
             iface_addr_len  = (*(uint8_t*)ptr) & UCP_ADDRESS_FLAG_LEN_MASK;
@@ -658,4 +853,3 @@ ucs_status_t ucp_address_unpack(const void *buffer,
     unpacked_address->address_list  = address_list;
     return UCS_OK;
 }
-
@@ -101,6 +101,8 @@ ucs_status_t ucp_address_pack(ucp_worker_h worker, ucp_ep_h ep, uint64_t tl_bitm
 /**
  * Unpack a list of addresses.
  *
+ * @param [in]  worker           Worker which unpacks the address. Addresses
+ *                                packed in unified mode refer to its resources.
  * @param [in]  buffer           Buffer with data to unpack.
  * @param [out] unpacked_address Filled with remote address data.
  *
@@ -110,8 +112,26 @@ ucs_status_t ucp_address_pack(ucp_worker_h worker, ucp_ep_h ep, uint64_t tl_bitm
  * @note The address list inside @ref ucp_remote_address_t should be released
  *       by ucs_free().
  */
-ucs_status_t ucp_address_unpack(const void *buffer,
+ucs_status_t ucp_address_unpack(ucp_worker_h worker, const void *buffer,
                                 ucp_unpacked_address_t *unpacked_address);
 
 
+/**
+ * @return Size of a packed address.
+ *
+ * @param [in]  buffer           Packed address.
+ */
+size_t ucp_address_length(const void *buffer);
+
+
+/**
+ * Calculate the profile of the worker resources: a hash of everything which the
+ * address packed in unified mode omits. Workers exchange such addresses only if
+ * their profiles are equal.
+ *
+ * @param [in]  worker           Worker whose interfaces are already created.
+ */
+uint32_t ucp_address_profile(ucp_worker_h worker);
+
+
 #endif
@@ -0,0 +1,126 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#include "address_cache.h"
+#include "address.h"
+
+#include <ucp/core/ucp_worker.h>
+#include <ucs/debug/log.h>
+#include <ucs/debug/memtrack.h>
+#include <inttypes.h>
+
+
+struct ucp_address_cache_entry {
+    ucs_list_link_t          list;     /* Entry in the LRU list */
+    ucp_unpacked_address_t   address;  /* Unpacked address, points to 'buffer' */
+    size_t                   length;   /* Packed address length */
+    uint8_t                  buffer[]; /* Copy of the packed address */
+};
+
+
+__KHASH_IMPL(ucp_address_cache, static UCS_F_MAYBE_UNUSED inline, uint64_t,
+             ucp_address_cache_entry_t*, 1, kh_int64_hash_func,
+             kh_int64_hash_equal);
+
+
+void ucp_address_cache_init(ucp_address_cache_t *cache, unsigned max_count)
+{
+    kh_init_inplace(ucp_address_cache, &cache->hash);
+    ucs_list_head_init(&cache->lru);
+    cache->count     = 0;
+    cache->max_count = ucs_max(max_count, 1);
+}
+
+static void ucp_address_cache_entry_free(ucp_address_cache_entry_t *entry)
+{
+    ucs_free(entry->address.address_list);
+    ucs_free(entry);
+}
+
+static void ucp_address_cache_remove(ucp_address_cache_t *cache,
+                                     ucp_address_cache_entry_t *entry)
+{
+    khiter_t iter;
+
+    iter = kh_get(ucp_address_cache, &cache->hash, entry->address.uuid);
+    ucs_assert(iter != kh_end(&cache->hash));
+    kh_del(ucp_address_cache, &cache->hash, iter);
+    ucs_list_del(&entry->list);
+    --cache->count;
+    ucp_address_cache_entry_free(entry);
+}
+
+void ucp_address_cache_cleanup(ucp_address_cache_t *cache)
+{
+    ucp_address_cache_entry_t *entry, *tmp;
+
+    ucs_list_for_each_safe(entry, tmp, &cache->lru, list) {
+        ucp_address_cache_entry_free(entry);
+    }
+    kh_destroy_inplace(ucp_address_cache, &cache->hash);
+}
+
+ucs_status_t ucp_address_cache_unpack(ucp_worker_h worker, const void *buffer,
+                                      const ucp_unpacked_address_t **address_p)
+{
+    ucp_address_cache_t *cache = &worker->address_cache;
+    ucp_address_cache_entry_t *entry;
+    ucs_status_t status;
+    khiter_t iter;
+    size_t length;
+    uint64_t uuid;
+    int ret;
+
+    uuid   = *(const uint64_t*)buffer;
+    length = ucp_address_length(buffer);
+
+    iter = kh_get(ucp_address_cache, &cache->hash, uuid);
+    if (iter != kh_end(&cache->hash)) {
+        entry = kh_value(&cache->hash, iter);
+        if ((entry->length == length) &&
+            !memcmp(entry->buffer, buffer, length)) {
+            ucs_list_del(&entry->list);
+            ucs_list_add_tail(&cache->lru, &entry->list);
+            *address_p = &entry->address;
+            return UCS_OK;
+        }
+
+        /* The remote worker changed its address, e.g connected more transports */
+        ucp_address_cache_remove(cache, entry);
+    }
+
+    entry = ucs_malloc(sizeof(*entry) + length, "ucp_address_cache_entry");
+    if (entry == NULL) {
+        ucs_error("failed to allocate address cache entry");
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    entry->length = length;
+    memcpy(entry->buffer, buffer, length);
+
+    status = ucp_address_unpack(worker, entry->buffer, &entry->address);
+    if (status != UCS_OK) {
+        ucs_free(entry);
+        return status;
+    }
+
+    if (cache->count >= cache->max_count) {
+        ucp_address_cache_remove(cache, ucs_list_head(&cache->lru,
+                                                      ucp_address_cache_entry_t,
+                                                      list));
+    }
+
+    iter = kh_put(ucp_address_cache, &cache->hash, uuid, &ret);
+    ucs_assert(ret != 0);
+    kh_value(&cache->hash, iter) = entry;
+    ucs_list_add_tail(&cache->lru, &entry->list);
+    ++cache->count;
+
+    ucs_trace("worker %p: cached address of 0x%"PRIx64" length %zu", worker,
+              uuid, length);
+    *address_p = &entry->address;
+    return UCS_OK;
+}
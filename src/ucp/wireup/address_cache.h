@@ -0,0 +1,52 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#ifndef UCP_ADDRESS_CACHE_H_
+#define UCP_ADDRESS_CACHE_H_
+
+#include <ucp/core/ucp_types.h>
+#include <ucs/datastruct/khash.h>
+#include <ucs/datastruct/list.h>
+
+
+typedef struct ucp_address_cache_entry ucp_address_cache_entry_t;
+
+
+__KHASH_TYPE(ucp_address_cache, uint64_t, ucp_address_cache_entry_t*)
+
+
+/*
+ * Cache of unpacked remote worker addresses, indexed by worker UUID, so creating
+ * many endpoints to the same worker would unpack its address only once.
+ */
+typedef struct {
+    khash_t(ucp_address_cache) hash;
+    ucs_list_link_t            lru;       /* Entries, least recently used first */
+    unsigned                   count;     /* Number of entries */
+    unsigned                   max_count; /* Maximal number of entries */
+} ucp_address_cache_t;
+
+
+void ucp_address_cache_init(ucp_address_cache_t *cache, unsigned max_count);
+
+void ucp_address_cache_cleanup(ucp_address_cache_t *cache);
+
+
+/**
+ * Unpack a remote worker address, or return the cached result of unpacking an
+ * identical address.
+ *
+ * @param [in]  worker           Worker which unpacks the address.
+ * @param [in]  buffer           Packed remote worker address.
+ * @param [out] address_p        Filled with the unpacked address, which is
+ *                                valid until the next call on this worker. It
+ *                                does not point into the buffer.
+ */
+ucs_status_t ucp_address_cache_unpack(ucp_worker_h worker, const void *buffer,
+                                      const ucp_unpacked_address_t **address_p);
+
+
+#endif
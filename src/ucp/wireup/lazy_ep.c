@@ -0,0 +1,172 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#include "address.h"
+#include "wireup.h"
+
+#include <ucp/core/ucp_proxy_ep.h>
+#include <ucp/core/ucp_worker.h>
+#include <ucp/core/ucp_ep.inl>
+#include <ucs/debug/log.h>
+#include <ucs/debug/memtrack.h>
+
+
+/**
+ * Lane which is connected to the remote interface only when it's used for the
+ * first time. Until then, it keeps a copy of the remote address instead of a
+ * transport endpoint. The first operation creates the transport endpoint, puts
+ * it on the lane instead of the lazy endpoint, and returns UCS_ERR_NO_RESOURCE,
+ * so the caller would retry the operation on the new endpoint.
+ */
+typedef struct ucp_lazy_ep {
+    ucp_proxy_ep_t            super;      /**< Derive from ucp_proxy_ep_t */
+    ucp_rsc_index_t           rsc_index;  /**< Resource to connect with */
+    uct_device_addr_t         *dev_addr;  /**< Remote device address */
+    uct_iface_addr_t          *iface_addr;/**< Remote interface address */
+} ucp_lazy_ep_t;
+
+
+UCS_CLASS_DECLARE(ucp_lazy_ep_t, ucp_ep_h, ucp_rsc_index_t,
+                  const ucp_address_entry_t*);
+
+static UCS_CLASS_DEFINE_DELETE_FUNC(ucp_lazy_ep_t, uct_ep_t);
+
+
+static ucs_status_t ucp_lazy_ep_connect(uct_ep_h uct_ep)
+{
+    ucp_lazy_ep_t *lazy_ep     = ucs_derived_of(uct_ep, ucp_lazy_ep_t);
+    ucp_ep_h ucp_ep            = lazy_ep->super.ucp_ep;
+    ucp_worker_h worker        = ucp_ep->worker;
+    ucp_worker_iface_t *wiface = ucp_worker_iface(worker, lazy_ep->rsc_index);
+    uct_ep_h next_ep;
+    ucs_status_t status;
+
+    status = uct_ep_create_connected(wiface->iface, lazy_ep->dev_addr,
+                                     lazy_ep->iface_addr, &next_ep);
+    if (status != UCS_OK) {
+        ucs_error("ep %p: failed to connect to %s using "
+                  UCT_TL_RESOURCE_DESC_FMT ": %s", ucp_ep,
+                  ucp_ep_peer_name(ucp_ep),
+                  UCT_TL_RESOURCE_DESC_ARG(&worker->context->tl_rscs[lazy_ep->rsc_index].tl_rsc),
+                  ucs_status_string(status));
+        return status;
+    }
+
+    ucs_debug("ep %p: lazy ep %p connected next_ep %p", ucp_ep, lazy_ep,
+              next_ep);
+
+    ucp_worker_iface_progress_ep(wiface);
+    ucp_proxy_ep_set_uct_ep(&lazy_ep->super, next_ep, 1);
+    ucp_proxy_ep_replace(&lazy_ep->super);
+    return UCS_ERR_NO_RESOURCE;
+}
+
+static ssize_t ucp_lazy_ep_connect_bcopy(uct_ep_h uct_ep)
+{
+    return ucp_lazy_ep_connect(uct_ep);
+}
+
+static ucs_status_ptr_t ucp_lazy_ep_connect_ptr(uct_ep_h uct_ep)
+{
+    return UCS_STATUS_PTR(ucp_lazy_ep_connect(uct_ep));
+}
+
+static ucs_status_t ucp_lazy_ep_pending_add(uct_ep_h uct_ep,
+                                            uct_pending_req_t *req,
+                                            unsigned flags)
+{
+    ucs_status_t status;
+
+    /* The caller would retry the operation on the new endpoint */
+    status = ucp_lazy_ep_connect(uct_ep);
+    return (status == UCS_ERR_NO_RESOURCE) ? UCS_ERR_BUSY : status;
+}
+
+UCS_CLASS_INIT_FUNC(ucp_lazy_ep_t, ucp_ep_h ucp_ep, ucp_rsc_index_t rsc_index,
+                    const ucp_address_entry_t *address)
+{
+    static uct_iface_ops_t ops = {
+        .ep_flush             = (void*)ucs_empty_function_return_success,
+        .ep_fence             = (void*)ucs_empty_function_return_success,
+        .ep_check             = (void*)ucs_empty_function_return_success,
+        .ep_destroy           = UCS_CLASS_DELETE_FUNC_NAME(ucp_lazy_ep_t),
+        .ep_get_address       = (void*)ucs_empty_function_return_unsupported,
+        .ep_connect_to_ep     = (void*)ucs_empty_function_return_unsupported,
+        .ep_pending_add       = ucp_lazy_ep_pending_add,
+        .ep_pending_purge     = (void*)ucs_empty_function,
+        .ep_put_short         = (void*)ucp_lazy_ep_connect,
+        .ep_put_bcopy         = (void*)ucp_lazy_ep_connect_bcopy,
+        .ep_put_zcopy         = (void*)ucp_lazy_ep_connect,
+        .ep_get_short         = (void*)ucp_lazy_ep_connect,
+        .ep_get_bcopy         = (void*)ucp_lazy_ep_connect,
+        .ep_get_zcopy         = (void*)ucp_lazy_ep_connect,
+        .ep_am_short          = (void*)ucp_lazy_ep_connect,
+        .ep_am_bcopy          = (void*)ucp_lazy_ep_connect_bcopy,
+        .ep_am_zcopy          = (void*)ucp_lazy_ep_connect,
+        .ep_tag_eager_short   = (void*)ucp_lazy_ep_connect,
+        .ep_tag_eager_bcopy   = (void*)ucp_lazy_ep_connect_bcopy,
+        .ep_tag_eager_zcopy   = (void*)ucp_lazy_ep_connect,
+        .ep_tag_rndv_zcopy    = (void*)ucp_lazy_ep_connect_ptr,
+        .ep_tag_rndv_cancel   = (void*)ucs_empty_function_return_unsupported,
+        .ep_tag_rndv_request  = (void*)ucp_lazy_ep_connect,
+        .ep_atomic64_post     = (void*)ucp_lazy_ep_connect,
+        .ep_atomic64_fetch    = (void*)ucp_lazy_ep_connect,
+        .ep_atomic_cswap64    = (void*)ucp_lazy_ep_connect,
+        .ep_atomic32_post     = (void*)ucp_lazy_ep_connect,
+        .ep_atomic32_fetch    = (void*)ucp_lazy_ep_connect,
+        .ep_atomic_cswap32    = (void*)ucp_lazy_ep_connect
+    };
+    const uct_iface_attr_t *iface_attr = ucp_worker_iface_get_attr(ucp_ep->worker,
+                                                                   rsc_index);
+    size_t dev_addr_len                = iface_attr->device_addr_len;
+    size_t iface_addr_len              = iface_attr->iface_addr_len;
+
+    UCS_CLASS_CALL_SUPER_INIT(ucp_proxy_ep_t, &ops, ucp_ep, NULL, 0);
+
+    self->rsc_index  = rsc_index;
+    self->dev_addr   = NULL;
+    self->iface_addr = NULL;
+
+    if (address->dev_addr != NULL) {
+        self->dev_addr = ucs_malloc(dev_addr_len, "lazy_ep_dev_addr");
+        if (self->dev_addr == NULL) {
+            return UCS_ERR_NO_MEMORY;
+        }
+        memcpy(self->dev_addr, address->dev_addr, dev_addr_len);
+    }
+
+    if (address->iface_addr != NULL) {
+        self->iface_addr = ucs_malloc(iface_addr_len, "lazy_ep_iface_addr");
+        if (self->iface_addr == NULL) {
+            ucs_free(self->dev_addr);
+            return UCS_ERR_NO_MEMORY;
+        }
+        memcpy(self->iface_addr, address->iface_addr, iface_addr_len);
+    }
+
+    ucs_trace("ep %p: created lazy ep %p to %s using " UCT_TL_RESOURCE_DESC_FMT,
+              ucp_ep, self, ucp_ep_peer_name(ucp_ep),
+              UCT_TL_RESOURCE_DESC_ARG(&ucp_ep->worker->context->tl_rscs[rsc_index].tl_rsc));
+    return UCS_OK;
+}
+
+static UCS_CLASS_CLEANUP_FUNC(ucp_lazy_ep_t)
+{
+    ucs_free(self->iface_addr);
+    ucs_free(self->dev_addr);
+}
+
+UCS_CLASS_DEFINE(ucp_lazy_ep_t, ucp_proxy_ep_t);
+
+UCS_CLASS_DEFINE_NAMED_NEW_FUNC(ucp_lazy_ep_create, ucp_lazy_ep_t, uct_ep_t,
+                                ucp_ep_h, ucp_rsc_index_t,
+                                const ucp_address_entry_t*);
+
+int ucp_lazy_ep_test(uct_ep_h uct_ep)
+{
+    return uct_ep->iface->ops.ep_destroy ==
+                    UCS_CLASS_DELETE_FUNC_NAME(ucp_lazy_ep_t);
+}
@@ -517,7 +517,7 @@ static ucs_status_t ucp_wireup_msg_handler(void *arg, void *data,
 
     UCS_ASYNC_BLOCK(&worker->async);
 
-    status = ucp_address_unpack(msg + 1, &remote_address);
+    status = ucp_address_unpack(worker, msg + 1, &remote_address);
     if (status != UCS_OK) {
         ucs_error("failed to unpack address: %s", ucs_status_string(status));
         goto out;
@@ -573,8 +573,37 @@ static uct_ep_h ucp_wireup_extract_lane(ucp_ep_h ep, ucp_lane_index_t lane)
     }
 }
 
+static int ucp_wireup_is_lane_lazy(ucp_ep_h ep, unsigned ep_init_flags,
+                                   ucp_lane_index_t lane)
+{
+    const ucp_ep_config_key_t *key = &ucp_ep_config(ep)->key;
+    ucp_lane_index_t proxy_lane;
+
+    /* active message and wireup lanes are always used */
+    if (!ep->worker->context->config.ext.lazy_lanes ||
+        (ep_init_flags & UCP_EP_INIT_FLAG_MEM_TYPE) ||
+        (ep->uct_eps[lane] != NULL) || (lane == key->am_lane) ||
+        (lane == key->wireup_lane)) {
+        return 0;
+    }
+
+    /* signaling proxies need the transport endpoint */
+    if (ucp_ep_get_proxy_lane(ep, lane) != UCP_NULL_LANE) {
+        return 0;
+    }
+
+    for (proxy_lane = 0; proxy_lane < ucp_ep_num_lanes(ep); ++proxy_lane) {
+        if (ucp_ep_get_proxy_lane(ep, proxy_lane) == lane) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
 static ucs_status_t ucp_wireup_connect_lane(ucp_ep_h ep,
                                             const ucp_ep_params_t *params,
+                                            unsigned ep_init_flags,
                                             ucp_lane_index_t lane,
                                             unsigned address_count,
                                             const ucp_address_entry_t *address_list,
@@ -596,6 +625,20 @@ static ucs_status_t ucp_wireup_connect_lane(ucp_ep_h ep,
     if ((wiface->attr.cap.flags & UCT_IFACE_FLAG_CONNECT_TO_IFACE) &&
         ((ep->uct_eps[lane] == NULL) || ucp_wireup_ep_test(ep->uct_eps[lane])))
     {
+        if (ucp_wireup_is_lane_lazy(ep, ep_init_flags, lane)) {
+            /* connect to the remote interface on first use */
+            ucs_trace("ep %p: lazy uct_ep[%d] to addr[%d]", ep, lane,
+                      addr_index);
+            status = ucp_lazy_ep_create(ep, rsc_index, &address_list[addr_index],
+                                        &uct_ep);
+            if (status != UCS_OK) {
+                return status;
+            }
+
+            ep->uct_eps[lane] = uct_ep;
+            return UCS_OK;
+        }
+
         if ((proxy_lane == UCP_NULL_LANE) || (proxy_lane == lane)) {
             /* create an endpoint connected to the remote interface */
             ucs_trace("ep %p: connect uct_ep[%d] to addr[%d]", ep, lane,
@@ -793,8 +836,9 @@ ucs_status_t ucp_wireup_init_lanes(ucp_ep_h ep, const ucp_ep_params_t *params,
 
     /* establish connections on all underlying endpoints */
     for (lane = 0; lane < ucp_ep_num_lanes(ep); ++lane) {
-        status = ucp_wireup_connect_lane(ep, params, lane, address_count,
-                                         address_list, addr_indices[lane]);
+        status = ucp_wireup_connect_lane(ep, params, ep_init_flags, lane,
+                                         address_count, address_list,
+                                         addr_indices[lane]);
         if (status != UCS_OK) {
             return status;
         }
@@ -968,7 +1012,7 @@ static void ucp_wireup_msg_dump(ucp_worker_h worker, uct_am_trace_type_t type,
     char *p, *end;
     ucp_rsc_index_t tl;
 
-    status = ucp_address_unpack(msg + 1, &unpacked_address);
+    status = ucp_address_unpack(worker, msg + 1, &unpacked_address);
     if (status != UCS_OK) {
         strncpy(unpacked_address.name, "<malformed address>", UCP_WORKER_NAME_MAX);
         unpacked_address.uuid          = 0;
@@ -115,6 +115,12 @@ ucs_status_t ucp_wireup_select_lanes(ucp_ep_h ep, const ucp_ep_params_t *params,
 ucs_status_t ucp_signaling_ep_create(ucp_ep_h ucp_ep, uct_ep_h uct_ep,
                                      int is_owner, uct_ep_h *signaling_ep);
 
+ucs_status_t ucp_lazy_ep_create(ucp_ep_h ucp_ep, ucp_rsc_index_t rsc_index,
+                                const ucp_address_entry_t *address,
+                                uct_ep_h *lazy_ep_p);
+
+int ucp_lazy_ep_test(uct_ep_h uct_ep);
+
 static inline int ucp_worker_is_tl_p2p(ucp_worker_h worker, ucp_rsc_index_t rsc_index)
 {
     uint64_t flags = ucp_worker_iface_get_attr(worker, rsc_index)->cap.flags;
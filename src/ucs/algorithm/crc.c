@@ -40,3 +40,20 @@ uint16_t ucs_crc16_string(const char *s)
 {
     return ucs_crc16((char*)s, strlen(s));
 }
+
+uint32_t ucs_crc32(uint32_t prev_crc, const void *buffer, size_t size)
+{
+    const uint8_t *p;
+    uint32_t result;
+    int bit;
+
+    result = ~prev_crc;
+    for (p = buffer; p < (const uint8_t*)(buffer + size); ++p) {
+        result ^= *p;
+        for (bit = 0; bit < 8; ++bit) {
+            result = (result >> 1) ^ (0xedb88320 & -(result & 1));
+        }
+    }
+
+    return ~result;
+}
@@ -30,6 +30,19 @@ uint16_t ucs_crc16(const void *buffer, size_t size);
  */
 uint16_t ucs_crc16_string(const char *s);
 
+
+/**
+ * Calculate CRC32 of an arbitrary buffer.
+ *
+ * @param [in]  prev_crc  CRC of the previous data, to calculate the CRC of
+ *                        several buffers. Should be 0 for the first buffer.
+ * @param [in]  buffer    Buffer to compute crc for.
+ * @param [in]  size      Buffer size.
+ *
+ * @return crc32() function of the buffer.
+ */
+uint32_t ucs_crc32(uint32_t prev_crc, const void *buffer, size_t size);
+
 END_C_DECLS
 
 #endif
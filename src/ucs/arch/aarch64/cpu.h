@@ -96,6 +96,8 @@ static inline void ucs_arch_wait_mem(void *address)
                   : "Q"(address));
 }
 
+#define ucs_arch_memcpy_nontemporal ucs_arch_generic_memcpy_nontemporal
+
 #if !HAVE___CLEAR_CACHE
 static inline void ucs_arch_clear_cache(void *start, void *end)
 {
@@ -0,0 +1,14 @@
+/**
+* Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+*
+* See file LICENSE for terms.
+*/
+
+#include "cpu.h"
+
+#include <stdint.h>
+
+
+/* Relaxed copies do not use non-temporal stores until the global options are
+ * parsed */
+size_t ucs_memcpy_nontemporal_thresh = SIZE_MAX;
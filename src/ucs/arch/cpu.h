@@ -13,6 +13,7 @@
 #endif
 
 #include <ucs/sys/compiler_def.h>
+#include <string.h>
 
 
 /* CPU models */
@@ -43,7 +44,8 @@ typedef enum ucs_cpu_flag {
     UCS_CPU_FLAG_SSE41      = UCS_BIT(7),
     UCS_CPU_FLAG_SSE42      = UCS_BIT(8),
     UCS_CPU_FLAG_AVX        = UCS_BIT(9),
-    UCS_CPU_FLAG_AVX2       = UCS_BIT(10)
+    UCS_CPU_FLAG_AVX2       = UCS_BIT(10),
+    UCS_CPU_FLAG_AVX512F    = UCS_BIT(11)
 } ucs_cpu_flag_t;
 
 
@@ -69,6 +71,15 @@ typedef enum ucs_cpu_flag {
 #define UCS_SYS_CACHE_LINE_SIZE    UCS_ARCH_CACHE_LINE_SIZE
 #endif
 
+
+BEGIN_C_DECLS
+
+/* Minimal size of a relaxed copy to use non-temporal stores, set from
+ * UCX_MEMCPY_NONTEMPORAL_THRESH */
+extern size_t ucs_memcpy_nontemporal_thresh;
+
+END_C_DECLS
+
 /**
  * Clear processor data and instruction caches, intended for
  * self-modifying code.
@@ -87,4 +98,40 @@ static inline void ucs_clear_cache(void *start, void *end)
     ucs_arch_clear_cache(start, end);
 #endif
 }
+
+/**
+ * Copy a buffer using non-temporal stores, which write the destination to
+ * memory without allocating it in the cache of the current core. The stores
+ * are fenced before returning, so the copy is ordered with respect to any
+ * following store, such as a completion flag.
+ *
+ * @dst  destination buffer
+ * @src  source buffer
+ * @len  number of bytes to copy
+ */
+static inline void ucs_memcpy_nontemporal(void *dst, const void *src, size_t len)
+{
+    ucs_arch_memcpy_nontemporal(dst, src, len);
+}
+
+/**
+ * Copy a buffer which is not expected to be read again soon by the current
+ * core. Copies which are larger than UCX_MEMCPY_NONTEMPORAL_THRESH use
+ * non-temporal stores to avoid evicting the working set from the cache, and
+ * smaller copies use regular memcpy().
+ *
+ * @dst  destination buffer
+ * @src  source buffer
+ * @len  number of bytes to copy
+ */
+static UCS_F_ALWAYS_INLINE void
+ucs_memcpy_relaxed(void *dst, const void *src, size_t len)
+{
+    if (ucs_likely(len < ucs_memcpy_nontemporal_thresh)) {
+        memcpy(dst, src, len);
+    } else {
+        ucs_arch_memcpy_nontemporal(dst, src, len);
+    }
+}
+
 #endif
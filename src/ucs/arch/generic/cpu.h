@@ -10,6 +10,7 @@
 
 #include <sys/time.h>
 #include <stdint.h>
+#include <string.h>
 
 
 static inline uint64_t ucs_arch_generic_read_hres_clock(void)
@@ -32,4 +33,11 @@ static inline void ucs_arch_generic_wait_mem(void *address)
     /* NOP */
 }
 
+static inline void ucs_arch_generic_memcpy_nontemporal(void *dst,
+                                                       const void *src,
+                                                       size_t len)
+{
+    memcpy(dst, src, len);
+}
+
 #endif
@@ -59,6 +59,7 @@ static inline int ucs_arch_get_cpu_flag()
 double ucs_arch_get_clocks_per_sec();
 
 #define ucs_arch_wait_mem ucs_arch_generic_wait_mem
+#define ucs_arch_memcpy_nontemporal ucs_arch_generic_memcpy_nontemporal
 
 #if !HAVE___CLEAR_CACHE
 static inline void ucs_arch_clear_cache(void *start, void *end)
@@ -11,6 +11,11 @@
 #include <ucs/sys/math.h>
 #include <ucs/sys/sys.h>
 
+#include <emmintrin.h>
+#if HAVE_ATTRIBUTE_TARGET
+#  include <immintrin.h>
+#endif
+
 #define X86_CPUID_GET_MODEL       0x00000001u
 #define X86_CPUID_GET_BASE_VALUE  0x00000000u
 #define X86_CPUID_GET_EXTD_VALUE  0x00000007u
@@ -18,6 +23,12 @@
 #define X86_CPUID_INVARIANT_TSC   0x80000007u
 
 
+typedef void (*ucs_x86_memcpy_func_t)(void *dst, const void *src, size_t len);
+
+static void ucs_x86_memcpy_nt_select(void *dst, const void *src, size_t len);
+
+static ucs_x86_memcpy_func_t ucs_x86_memcpy_nt_func = ucs_x86_memcpy_nt_select;
+
 ucs_ternary_value_t ucs_arch_x86_enable_rdtsc = UCS_TRY;
 
 static UCS_F_NOOPTIMIZE inline void ucs_x86_cpuid(uint32_t level,
@@ -259,6 +270,13 @@ int ucs_arch_get_cpu_flag()
             if ((result & UCS_CPU_FLAG_AVX) && (_ebx & (1 << 5))) {
                 result |= UCS_CPU_FLAG_AVX2;
             }
+            if ((result & UCS_CPU_FLAG_AVX) && (_ebx & (1 << 16))) {
+                /* Check that the OS saves opmask and ZMM registers */
+                ucs_x86_xgetbv(0, _eax, _edx);
+                if ((_eax & 0xe6) == 0xe6) {
+                    result |= UCS_CPU_FLAG_AVX512F;
+                }
+            }
         }
         cpu_flag = result;
     }
@@ -266,4 +284,122 @@ int ucs_arch_get_cpu_flag()
     return cpu_flag;
 }
 
+/*
+ * Copy the unaligned head of the destination with regular stores, and return
+ * the remaining length.
+ */
+static UCS_F_ALWAYS_INLINE size_t
+ucs_x86_memcpy_nt_head(void **dst_p, const void **src_p, size_t len,
+                       size_t align)
+{
+    size_t head = ucs_min(len, -(uintptr_t)*dst_p & (align - 1));
+
+    memcpy(*dst_p, *src_p, head);
+    *dst_p = UCS_PTR_BYTE_OFFSET(*dst_p, head);
+    *src_p = UCS_PTR_BYTE_OFFSET(*src_p, head);
+    return len - head;
+}
+
+static void ucs_x86_memcpy_nt_sse2(void *dst, const void *src, size_t len)
+{
+    const __m128i *s;
+    __m128i *d;
+
+    len = ucs_x86_memcpy_nt_head(&dst, &src, len, sizeof(*d));
+    d   = dst;
+    s   = src;
+
+    for (; len >= 4 * sizeof(*d); len -= 4 * sizeof(*d), d += 4, s += 4) {
+        _mm_stream_si128(d + 0, _mm_loadu_si128(s + 0));
+        _mm_stream_si128(d + 1, _mm_loadu_si128(s + 1));
+        _mm_stream_si128(d + 2, _mm_loadu_si128(s + 2));
+        _mm_stream_si128(d + 3, _mm_loadu_si128(s + 3));
+    }
+    for (; len >= sizeof(*d); len -= sizeof(*d), ++d, ++s) {
+        _mm_stream_si128(d, _mm_loadu_si128(s));
+    }
+
+    memcpy(d, s, len);
+    _mm_sfence();
+}
+
+#if HAVE_ATTRIBUTE_TARGET
+__attribute__((target("avx2")))
+static void ucs_x86_memcpy_nt_avx2(void *dst, const void *src, size_t len)
+{
+    const __m256i *s;
+    __m256i *d;
+
+    len = ucs_x86_memcpy_nt_head(&dst, &src, len, sizeof(*d));
+    d   = dst;
+    s   = src;
+
+    for (; len >= 4 * sizeof(*d); len -= 4 * sizeof(*d), d += 4, s += 4) {
+        _mm256_stream_si256(d + 0, _mm256_loadu_si256(s + 0));
+        _mm256_stream_si256(d + 1, _mm256_loadu_si256(s + 1));
+        _mm256_stream_si256(d + 2, _mm256_loadu_si256(s + 2));
+        _mm256_stream_si256(d + 3, _mm256_loadu_si256(s + 3));
+    }
+    for (; len >= sizeof(*d); len -= sizeof(*d), ++d, ++s) {
+        _mm256_stream_si256(d, _mm256_loadu_si256(s));
+    }
+
+    memcpy(d, s, len);
+    _mm_sfence();
+}
+
+__attribute__((target("avx512f")))
+static void ucs_x86_memcpy_nt_avx512(void *dst, const void *src, size_t len)
+{
+    const __m512i *s;
+    __m512i *d;
+
+    len = ucs_x86_memcpy_nt_head(&dst, &src, len, sizeof(*d));
+    d   = dst;
+    s   = src;
+
+    for (; len >= 4 * sizeof(*d); len -= 4 * sizeof(*d), d += 4, s += 4) {
+        _mm512_stream_si512(d + 0, _mm512_loadu_si512(s + 0));
+        _mm512_stream_si512(d + 1, _mm512_loadu_si512(s + 1));
+        _mm512_stream_si512(d + 2, _mm512_loadu_si512(s + 2));
+        _mm512_stream_si512(d + 3, _mm512_loadu_si512(s + 3));
+    }
+    for (; len >= sizeof(*d); len -= sizeof(*d), ++d, ++s) {
+        _mm512_stream_si512(d, _mm512_loadu_si512(s));
+    }
+
+    memcpy(d, s, len);
+    _mm_sfence();
+}
+#endif
+
+/*
+ * Initial value of the copy function pointer: select the best implementation
+ * for the current CPU on first use.
+ */
+static void ucs_x86_memcpy_nt_select(void *dst, const void *src, size_t len)
+{
+    int UCS_V_UNUSED cpu_flag = ucs_arch_get_cpu_flag();
+    ucs_x86_memcpy_func_t func;
+
+#if HAVE_ATTRIBUTE_TARGET
+    if (cpu_flag & UCS_CPU_FLAG_AVX512F) {
+        func = ucs_x86_memcpy_nt_avx512;
+    } else if (cpu_flag & UCS_CPU_FLAG_AVX2) {
+        func = ucs_x86_memcpy_nt_avx2;
+    } else
+#endif
+    {
+        func = ucs_x86_memcpy_nt_sse2;
+    }
+
+    ucs_x86_memcpy_nt_func = func;
+    func(dst, src, len);
+}
+
+void ucs_arch_memcpy_nontemporal(void *dst, const void *src, size_t len)
+{
+    ucs_x86_memcpy_nt_func(dst, src, len);
+}
+
 #endif
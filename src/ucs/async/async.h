@@ -106,6 +106,25 @@ static inline int ucs_async_check_miss(ucs_async_context_t *async)
     } while(0)
 
 
+/**
+ * Try to block the async handler without waiting.
+ *
+ * @param async Event context to block events for.
+ * @return Nonzero if the context was blocked, 0 if it is held by another thread.
+ */
+static inline int ucs_async_try_block(ucs_async_context_t *async)
+{
+    if (async->mode == UCS_ASYNC_MODE_THREAD_SPINLOCK) {
+        return ucs_spin_trylock(&async->thread.spinlock);
+    } else if (async->mode == UCS_ASYNC_MODE_THREAD_MUTEX) {
+        return pthread_mutex_trylock(&async->thread.mutex) == 0;
+    }
+
+    UCS_ASYNC_BLOCK(async);
+    return 1;
+}
+
+
 /**
  * Unblock asynchronous event delivery, and invoke pending callbacks.
  *
@@ -13,12 +13,14 @@
 #include "pipe.h"
 
 #include <ucs/arch/atomic.h>
+#include <ucs/config/global_opts.h>
 #include <ucs/sys/checker.h>
 #include <ucs/sys/sys.h>
 
 
 #define UCS_ASYNC_EPOLL_MAX_EVENTS      16
 #define UCS_ASYNC_EPOLL_MIN_TIMEOUT_MS  2.0
+#define UCS_ASYNC_MAX_THREADS           64
 
 
 typedef struct ucs_async_thread {
@@ -31,17 +33,23 @@ typedef struct ucs_async_thread {
 } ucs_async_thread_t;
 
 
-typedef struct ucs_async_thread_global_context {
+typedef struct ucs_async_thread_slot {
     ucs_async_thread_t *thread;
     unsigned           use_count;
-    pthread_mutex_t    lock;
+} ucs_async_thread_slot_t;
+
+
+typedef struct ucs_async_thread_global_context {
+    ucs_async_thread_slot_t slots[UCS_ASYNC_MAX_THREADS];
+    volatile uint32_t       next_index;  /* For round robin assignment */
+    pthread_mutex_t         lock;
 } ucs_async_thread_global_context_t;
 
 
 static ucs_async_thread_global_context_t ucs_async_thread_global_context = {
-    .thread    = NULL,
-    .use_count = 0,
-    .lock      = PTHREAD_MUTEX_INITIALIZER
+    .slots      = {{ NULL, 0 }},
+    .next_index = 0,
+    .lock       = PTHREAD_MUTEX_INITIALIZER
 };
 
 
@@ -133,24 +141,109 @@ static void *ucs_async_thread_func(void *arg)
     return NULL;
 }
 
-static ucs_status_t ucs_async_thread_start(ucs_async_thread_t **thread_p)
+static unsigned ucs_async_thread_num_threads()
+{
+    return ucs_min(ucs_max(ucs_global_opts.async_threads, 1),
+                   UCS_ASYNC_MAX_THREADS);
+}
+
+/*
+ * Parse the CPU set of progress thread 'index' from the configuration.
+ * Returns 0 if the thread should not be bound.
+ */
+static int ucs_async_thread_get_cpuset(unsigned index, cpu_set_t *cpuset)
+{
+    const ucs_config_names_array_t *cpus = &ucs_global_opts.async_thread_cpus;
+    unsigned first, last, cpu;
+    const char *str;
+    char dummy;
+
+    if (cpus->count == 0) {
+        return 0;
+    }
+
+    str = cpus->names[index % cpus->count];
+    if (sscanf(str, "%u-%u%c", &first, &last, &dummy) != 2) {
+        if (sscanf(str, "%u%c", &first, &dummy) != 1) {
+            ucs_warn("invalid async thread CPU set '%s'", str);
+            return 0;
+        }
+        last = first;
+    }
+
+    CPU_ZERO(cpuset);
+    for (cpu = first; (cpu <= last) && (cpu < CPU_SETSIZE); ++cpu) {
+        CPU_SET(cpu, cpuset);
+    }
+    return CPU_COUNT(cpuset) > 0;
+}
+
+static unsigned ucs_async_thread_select_index()
+{
+    unsigned num_threads = ucs_async_thread_num_threads();
+    cpu_set_t cpuset;
+    unsigned index;
+    int cpu;
+
+    if (num_threads == 1) {
+        return 0;
+    }
+
+    if (ucs_global_opts.async_thread_assign == UCS_ASYNC_THREAD_ASSIGN_AFFINITY) {
+        cpu = sched_getcpu();
+        if (cpu >= 0) {
+            if (ucs_global_opts.async_thread_cpus.count == 0) {
+                return cpu % num_threads;
+            }
+
+            for (index = 0; index < num_threads; ++index) {
+                if (ucs_async_thread_get_cpuset(index, &cpuset) &&
+                    CPU_ISSET(cpu, &cpuset)) {
+                    return index;
+                }
+            }
+        }
+    }
+
+    return ucs_atomic_fadd32(&ucs_async_thread_global_context.next_index, 1) %
+           num_threads;
+}
+
+static unsigned ucs_async_thread_index(ucs_async_context_t *async)
+{
+    /* Handlers without async context are processed by the first thread */
+    return (async == NULL) ? 0 : async->thread.index;
+}
+
+static ucs_async_thread_t *ucs_async_thread_get(ucs_async_context_t *async)
 {
+    return ucs_async_thread_global_context.slots[ucs_async_thread_index(async)].thread;
+}
+
+static ucs_status_t ucs_async_thread_start(ucs_async_context_t *async,
+                                           ucs_async_thread_t **thread_p)
+{
+    unsigned index = ucs_async_thread_index(async);
+    ucs_async_thread_slot_t *slot;
     ucs_async_thread_t *thread;
     struct epoll_event event;
+    cpu_set_t cpuset;
+    pthread_attr_t attr;
     ucs_status_t status;
     int wakeup_rfd;
     int ret;
 
-    ucs_trace_func("");
+    ucs_trace_func("index=%u", index);
 
     pthread_mutex_lock(&ucs_async_thread_global_context.lock);
-    if (ucs_async_thread_global_context.use_count++ > 0) {
+    slot = &ucs_async_thread_global_context.slots[index];
+    if (slot->use_count++ > 0) {
         /* Thread already started */
         status = UCS_OK;
         goto out_unlock;
     }
 
-    ucs_assert_always(ucs_async_thread_global_context.thread == NULL);
+    ucs_assert_always(slot->thread == NULL);
 
     thread = ucs_malloc(sizeof(*thread), "async_thread_context");
     if (thread == NULL) {
@@ -192,14 +285,20 @@ static ucs_status_t ucs_async_thread_start(ucs_async_thread_t **thread_p)
         goto err_close_epfd;
     }
 
-    ret = pthread_create(&thread->thread_id, NULL, ucs_async_thread_func, thread);
+    pthread_attr_init(&attr);
+    if (ucs_async_thread_get_cpuset(index, &cpuset)) {
+        pthread_attr_setaffinity_np(&attr, sizeof(cpuset), &cpuset);
+    }
+
+    ret = pthread_create(&thread->thread_id, &attr, ucs_async_thread_func, thread);
+    pthread_attr_destroy(&attr);
     if (ret != 0) {
         ucs_error("pthread_create() returned %d: %m", ret);
         status = UCS_ERR_IO_ERROR;
         goto err_close_epfd;
     }
 
-    ucs_async_thread_global_context.thread = thread;
+    slot->thread = thread;
     status = UCS_OK;
     goto out_unlock;
 
@@ -212,27 +311,32 @@ err_timerq_cleanup:
 err_free:
     ucs_free(thread);
 err:
-    --ucs_async_thread_global_context.use_count;
+    --slot->use_count;
+    pthread_mutex_unlock(&ucs_async_thread_global_context.lock);
+    return status;
+
 out_unlock:
-    ucs_assert_always(ucs_async_thread_global_context.thread != NULL);
-    *thread_p = ucs_async_thread_global_context.thread;
+    ucs_assert_always(slot->thread != NULL);
+    *thread_p = slot->thread;
     pthread_mutex_unlock(&ucs_async_thread_global_context.lock);
     return status;
 }
 
-static void ucs_async_thread_stop()
+static void ucs_async_thread_stop(ucs_async_context_t *async)
 {
+    ucs_async_thread_slot_t *slot;
     ucs_async_thread_t *thread = NULL;
 
     ucs_trace_func("");
 
     pthread_mutex_lock(&ucs_async_thread_global_context.lock);
-    if (--ucs_async_thread_global_context.use_count == 0) {
-        thread = ucs_async_thread_global_context.thread;
+    slot = &ucs_async_thread_global_context.slots[ucs_async_thread_index(async)];
+    if (--slot->use_count == 0) {
+        thread = slot->thread;
         ucs_async_thread_hold(thread);
         thread->stop = 1;
         ucs_async_pipe_push(&thread->wakeup);
-        ucs_async_thread_global_context.thread = NULL;
+        slot->thread = NULL;
     }
     pthread_mutex_unlock(&ucs_async_thread_global_context.lock);
 
@@ -248,6 +352,7 @@ static void ucs_async_thread_stop()
 
 static ucs_status_t ucs_async_thread_spinlock_init(ucs_async_context_t *async)
 {
+    async->thread.index = ucs_async_thread_select_index();
     return ucs_spinlock_init(&async->thread.spinlock);
 }
 
@@ -271,6 +376,8 @@ static ucs_status_t ucs_async_thread_mutex_init(ucs_async_context_t *async)
     pthread_mutexattr_t attr;
     int                 ret;
 
+    async->thread.index = ucs_async_thread_select_index();
+
     pthread_mutexattr_init(&attr);
     pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
     ret = pthread_mutex_init(&async->thread.mutex, &attr);
@@ -299,7 +406,7 @@ static ucs_status_t ucs_async_thread_add_event_fd(ucs_async_context_t *async,
     ucs_status_t status;
     int ret;
 
-    status = ucs_async_thread_start(&thread);
+    status = ucs_async_thread_start(async, &thread);
     if (status != UCS_OK) {
         goto err;
     }
@@ -319,7 +426,7 @@ static ucs_status_t ucs_async_thread_add_event_fd(ucs_async_context_t *async,
     return UCS_OK;
 
 err_removed:
-    ucs_async_thread_stop();
+    ucs_async_thread_stop(async);
 err:
     return status;
 }
@@ -327,7 +434,7 @@ err:
 static ucs_status_t ucs_async_thread_remove_event_fd(ucs_async_context_t *async,
                                                      int event_fd)
 {
-    ucs_async_thread_t *thread = ucs_async_thread_global_context.thread;
+    ucs_async_thread_t *thread = ucs_async_thread_get(async);
     int ret;
 
     ret = epoll_ctl(thread->epfd, EPOLL_CTL_DEL, event_fd, NULL);
@@ -337,14 +444,14 @@ static ucs_status_t ucs_async_thread_remove_event_fd(ucs_async_context_t *async,
         return UCS_ERR_INVALID_PARAM;
     }
 
-    ucs_async_thread_stop();
+    ucs_async_thread_stop(async);
     return UCS_OK;
 }
 
 static ucs_status_t ucs_async_thread_modify_event_fd(ucs_async_context_t *async,
                                                      int event_fd, int events)
 {
-    ucs_async_thread_t *thread = ucs_async_thread_global_context.thread;
+    ucs_async_thread_t *thread = ucs_async_thread_get(async);
     struct epoll_event event;
     int ret;
 
@@ -383,7 +490,7 @@ static ucs_status_t ucs_async_thread_add_timer(ucs_async_context_t *async,
         goto err;
     }
 
-    status = ucs_async_thread_start(&thread);
+    status = ucs_async_thread_start(async, &thread);
     if (status != UCS_OK) {
         goto err;
     }
@@ -397,7 +504,7 @@ static ucs_status_t ucs_async_thread_add_timer(ucs_async_context_t *async,
     return UCS_OK;
 
 err_stop:
-    ucs_async_thread_stop();
+    ucs_async_thread_stop(async);
 err:
     return status;
 }
@@ -405,18 +512,24 @@ err:
 static ucs_status_t ucs_async_thread_remove_timer(ucs_async_context_t *async,
                                                   int timer_id)
 {
-    ucs_async_thread_t *thread = ucs_async_thread_global_context.thread;
+    ucs_async_thread_t *thread = ucs_async_thread_get(async);
     ucs_timerq_remove(&thread->timerq, timer_id);
     ucs_async_pipe_push(&thread->wakeup);
-    ucs_async_thread_stop();
+    ucs_async_thread_stop(async);
     return UCS_OK;
 }
 
 static void ucs_async_signal_global_cleanup()
 {
-    if (ucs_async_thread_global_context.thread != NULL) {
-        ucs_info("async thread still running (use count %d)",
-                 ucs_async_thread_global_context.use_count);
+    ucs_async_thread_slot_t *slot;
+    unsigned index;
+
+    for (index = 0; index < UCS_ASYNC_MAX_THREADS; ++index) {
+        slot = &ucs_async_thread_global_context.slots[index];
+        if (slot->thread != NULL) {
+            ucs_info("async thread %u still running (use count %d)", index,
+                     slot->use_count);
+        }
     }
 }
 
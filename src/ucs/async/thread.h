@@ -16,6 +16,7 @@ typedef struct ucs_async_thread_context {
         ucs_spinlock_t      spinlock;
         pthread_mutex_t     mutex;
     };
+    unsigned                index;  /* Index of the progress thread */
 } ucs_async_thread_context_t;
 
 #endif
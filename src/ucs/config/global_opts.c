@@ -6,11 +6,13 @@
 
 #include "global_opts.h"
 
+#include <ucs/arch/cpu.h>
 #include <ucs/config/parser.h>
 #include <ucs/profile/profile.h>
 #include <ucs/debug/assert.h>
 #include <ucs/debug/log.h>
 #include <ucs/sys/compiler.h>
+#include <ucs/sys/sys.h>
 #include <sys/signal.h>
 
 
@@ -20,6 +22,8 @@ ucs_global_opts_t ucs_global_opts = {
     .log_file              = "",
     .log_buffer_size       = 1024,
     .log_data_size         = 0,
+    .log_async             = 0,
+    .log_async_buffer_size = 1024 * 1024,
     .mpool_fifo            = 0,
     .handle_errors         = UCS_BIT(UCS_HANDLE_ERROR_BACKTRACE),
     .error_signals         = { NULL, 0 },
@@ -31,16 +35,22 @@ ucs_global_opts_t ucs_global_opts = {
     .warn_unused_env_vars  = 1,
     .async_max_events      = 64,
     .async_signo           = SIGALRM,
+    .async_threads         = 1,
+    .async_thread_cpus     = { NULL, 0 },
+    .async_thread_assign   = UCS_ASYNC_THREAD_ASSIGN_ROUND_ROBIN,
     .stats_dest            = "",
     .tuning_path           = "",
     .memtrack_dest         = "",
+    .memtrack_sample       = 1,
     .stats_trigger         = "exit",
     .profile_mode          = 0,
     .profile_file          = "",
     .stats_filter          = { NULL, 0 },
     .stats_format          = UCS_STATS_FULL,
     .rcache_check_pfn      = 0,
-    .module_dir            = UCX_MODULE_DIR /* defined in Makefile.am */
+    .rcache_counters       = 0,
+    .module_dir            = UCX_MODULE_DIR, /* defined in Makefile.am */
+    .memcpy_nontemporal_thresh = UCS_CONFIG_MEMUNITS_INF
 };
 
 static const char *ucs_handle_error_modes[] = {
@@ -50,6 +60,12 @@ static const char *ucs_handle_error_modes[] = {
     [UCS_HANDLE_ERROR_LAST]      = NULL
 };
 
+static const char *ucs_async_thread_assign_names[] = {
+    [UCS_ASYNC_THREAD_ASSIGN_ROUND_ROBIN] = "round_robin",
+    [UCS_ASYNC_THREAD_ASSIGN_AFFINITY]    = "affinity",
+    [UCS_ASYNC_THREAD_ASSIGN_LAST]        = NULL
+};
+
 
 static UCS_CONFIG_DEFINE_ARRAY(signo,
                                sizeof(int),
@@ -82,6 +98,19 @@ static ucs_config_field_t ucs_global_opts_table[] = {
   "Enable output of ucs_print(). This option is intended for use by the library developers.\n",
   ucs_offsetof(ucs_global_opts_t, log_print_enable), UCS_CONFIG_TYPE_BOOL},
 
+ {"LOG_ASYNC", "n",
+  "Write log messages as compact binary records (format string, timestamp and\n"
+  "raw arguments) to per-thread buffers, and format them to the log file on a\n"
+  "background thread. This keeps the cost of enabled log messages low on the\n"
+  "calling thread. Errors and warnings are still printed synchronously.\n"
+  "If a buffer is full, new messages are dropped and the number of dropped\n"
+  "messages is reported.",
+  ucs_offsetof(ucs_global_opts_t, log_async), UCS_CONFIG_TYPE_BOOL},
+
+ {"LOG_ASYNC_BUFFER", "1m",
+  "Size of the per-thread buffer for asynchronous log records.",
+  ucs_offsetof(ucs_global_opts_t, log_async_buffer_size), UCS_CONFIG_TYPE_MEMUNITS},
+
 #if ENABLE_DEBUG_DATA
  {"MPOOL_FIFO", "n",
   "Enable FIFO behavior for memory pool, instead of LIFO. Useful for\n"
@@ -137,6 +166,27 @@ static ucs_config_field_t ucs_global_opts_table[] = {
   "Signal number used for async signaling.",
   ucs_offsetof(ucs_global_opts_t, async_signo), UCS_CONFIG_TYPE_SIGNO},
 
+ {"ASYNC_THREADS", "1",
+  "Number of progress threads which handle events and timers of async contexts\n"
+  "in thread mode.",
+  ucs_offsetof(ucs_global_opts_t, async_threads), UCS_CONFIG_TYPE_UINT},
+
+ {"ASYNC_THREAD_CPUS", "",
+  "Comma-separated list of CPU sets to bind the async progress threads to.\n"
+  "Each CPU set is a single CPU number or a range <first>-<last>, and progress\n"
+  "thread i is bound to CPU set (i modulo the number of sets). If the list is\n"
+  "empty, the threads are not bound.",
+  ucs_offsetof(ucs_global_opts_t, async_thread_cpus), UCS_CONFIG_TYPE_STRING_ARRAY},
+
+ {"ASYNC_THREAD_ASSIGN", "round_robin",
+  "How to assign async contexts to progress threads:\n"
+  " round_robin - assign the threads in a cyclic order.\n"
+  " affinity    - assign the thread whose CPU set contains the CPU of the thread\n"
+  "               which creates the context. Without CPU sets, the thread is\n"
+  "               selected by the CPU number.",
+  ucs_offsetof(ucs_global_opts_t, async_thread_assign),
+  UCS_CONFIG_TYPE_ENUM(ucs_async_thread_assign_names)},
+
 #if ENABLE_STATS
  {"STATS_DEST", "",
   "Destination to send statistics to. If the value is empty, statistics are\n"
@@ -183,6 +233,13 @@ static ucs_config_field_t ucs_global_opts_table[] = {
   "  stdout            - print to standard output.\n"
   "  stderr            - print to standard error.\n",
   ucs_offsetof(ucs_global_opts_t, memtrack_dest), UCS_CONFIG_TYPE_STRING},
+
+ {"MEMTRACK_SAMPLE", "1",
+  "Track only one of every N memory allocations, and record the call stack of\n"
+  "the tracked allocations. The report then estimates the allocated memory of\n"
+  "the largest call sites. The value 1 means tracking all allocations without\n"
+  "call stacks.",
+  ucs_offsetof(ucs_global_opts_t, memtrack_sample), UCS_CONFIG_TYPE_UINT},
 #endif
 
   {"PROFILE_MODE", "",
@@ -206,16 +263,39 @@ static ucs_config_field_t ucs_global_opts_table[] = {
    "memory region was not changed since the time the region was registered.\n",
    ucs_offsetof(ucs_global_opts_t, rcache_check_pfn), UCS_CONFIG_TYPE_BOOL},
 
+  {"RCACHE_COUNTERS", "n",
+   "Collect process-wide registration cache counters of lookups, hits,\n"
+   "registrations, registration time and invalidations. The counters are\n"
+   "shared by all threads, so this adds overhead to every lookup.",
+   ucs_offsetof(ucs_global_opts_t, rcache_counters), UCS_CONFIG_TYPE_BOOL},
+
   {"MODULE_DIR", UCX_MODULE_DIR,
    "Directory to search for loadable modules",
    ucs_offsetof(ucs_global_opts_t, module_dir), UCS_CONFIG_TYPE_STRING},
 
+  {"MEMCPY_NONTEMPORAL_THRESH", "auto",
+   "Minimal size of a bulk memory copy, such as packing a large message to a\n"
+   "shared memory buffer, which uses non-temporal stores that bypass the cache.\n"
+   "\"auto\" uses 3/4 of the last-level cache size.",
+   ucs_offsetof(ucs_global_opts_t, memcpy_nontemporal_thresh),
+   UCS_CONFIG_TYPE_MEMUNITS},
+
   {NULL}
 };
 UCS_CONFIG_REGISTER_TABLE(ucs_global_opts_table, "UCS global", NULL,
                           ucs_global_opts_t)
 
 
+/* Apply the options which are used by the architecture-specific code */
+static void ucs_global_opts_update_arch()
+{
+    if (ucs_global_opts.memcpy_nontemporal_thresh == UCS_CONFIG_MEMUNITS_AUTO) {
+        ucs_memcpy_nontemporal_thresh = ucs_get_llc_size() * 3 / 4;
+    } else {
+        ucs_memcpy_nontemporal_thresh = ucs_global_opts.memcpy_nontemporal_thresh;
+    }
+}
+
 void ucs_global_opts_init()
 {
     ucs_status_t status;
@@ -225,12 +305,22 @@ void ucs_global_opts_init()
     if (status != UCS_OK) {
         ucs_fatal("failed to parse global configuration - aborting");
     }
+
+    ucs_global_opts_update_arch();
 }
 
 ucs_status_t ucs_global_opts_set_value(const char *name, const char *value)
 {
-    return ucs_config_parser_set_value(&ucs_global_opts, ucs_global_opts_table,
-                                       name, value);
+    ucs_status_t status;
+
+    status = ucs_config_parser_set_value(&ucs_global_opts, ucs_global_opts_table,
+                                         name, value);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    ucs_global_opts_update_arch();
+    return UCS_OK;
 }
 
 ucs_status_t ucs_global_opts_get_value(const char *name, char *value, size_t max)
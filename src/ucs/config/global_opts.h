@@ -39,6 +39,13 @@ typedef struct {
     /* Enable ucs_print() output */
     int                      log_print_enable;
 
+    /* Record log messages to per-thread buffers and format them on a
+     * background thread */
+    int                      log_async;
+
+    /* Size of per-thread buffer for asynchronous log records */
+    size_t                   log_async_buffer_size;
+
     /* Enable FIFO behavior for memory pool, instead of LIFO. Useful for
      * debugging because object pointers are not recycled. */
     int                      mpool_fifo;
@@ -87,10 +94,22 @@ typedef struct {
     /* Signal number used by async handler (for signal mode) */
     unsigned                 async_signo;
 
+    /* Number of async progress threads */
+    unsigned                 async_threads;
+
+    /* CPU sets of async progress threads */
+    ucs_config_names_array_t async_thread_cpus;
+
+    /* How to assign async contexts to progress threads */
+    ucs_async_thread_assign_t async_thread_assign;
+
     /* Destination for detailed memory tracking results: none / stdout / stderr
      */
     char                     *memtrack_dest;
 
+    /* Track one of every N allocations, with call stacks */
+    unsigned                 memtrack_sample;
+
     /* Profiling mode */
     unsigned                 profile_mode;
 
@@ -109,8 +128,15 @@ typedef struct {
     /* registration cache checks if physical page is not moved */
     int                      rcache_check_pfn;
 
+    /* Collect process-wide registration cache counters */
+    int                      rcache_counters;
+
     /* directory for loadable modules */
     char                     *module_dir;
+
+    /* Minimal size of a relaxed memory copy to use non-temporal stores, or
+     * "auto". The resolved value is in ucs_memcpy_nontemporal_thresh. */
+    size_t                   memcpy_nontemporal_thresh;
 } ucs_global_opts_t;
 
 
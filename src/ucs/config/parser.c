@@ -1020,6 +1020,111 @@ ucs_status_t ucs_config_parser_set_value(void *opts, ucs_config_field_t *fields,
     return ucs_config_parser_set_value_internal(opts, fields, name, value, NULL, 1);
 }
 
+/* Check if a variable from a configuration file is overridden by the
+ * environment */
+static int ucs_config_parser_is_env_set(const char *env_prefix,
+                                        const char *name)
+{
+    char buf[256];
+
+    snprintf(buf, sizeof(buf), "%s%s", UCS_CONFIG_PREFIX, name);
+    if (getenv(buf) != NULL) {
+        return 1;
+    }
+
+    if ((env_prefix != NULL) && (strlen(env_prefix) > 0)) {
+        snprintf(buf, sizeof(buf), "%s%s_%s", UCS_CONFIG_PREFIX, env_prefix,
+                 name);
+        if (getenv(buf) != NULL) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+ucs_status_t ucs_config_parser_apply_file(void *opts, ucs_config_field_t *fields,
+                                          const char *env_prefix,
+                                          const char *filename)
+{
+    size_t prefix_len = strlen(UCS_CONFIG_PREFIX);
+    char line[1024], env_name_prefix[128];
+    char *name, *value, *p;
+    ucs_status_t status;
+    unsigned line_num;
+    FILE *file;
+
+    file = fopen(filename, "r");
+    if (file == NULL) {
+        ucs_debug("failed to open configuration file '%s': %m", filename);
+        return UCS_OK;
+    }
+
+    env_name_prefix[0] = '\0';
+    if ((env_prefix != NULL) && (strlen(env_prefix) > 0)) {
+        snprintf(env_name_prefix, sizeof(env_name_prefix), "%s_", env_prefix);
+    }
+
+    status   = UCS_OK;
+    line_num = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        ++line_num;
+
+        /* Lines have the same syntax as shell variable assignments:
+         * [export ]UCX_<NAME>=<value>, with optional quotes and comments */
+        name = ucs_strtrim(line);
+        if ((*name == '\0') || (*name == '#')) {
+            continue;
+        }
+
+        if (!strncmp(name, "export ", 7)) {
+            name = ucs_strtrim(name + 7);
+        }
+
+        p = strchr(name, '=');
+        if ((p == NULL) || strncmp(name, UCS_CONFIG_PREFIX, prefix_len)) {
+            ucs_error("%s:%u: expected "UCS_CONFIG_PREFIX"<NAME>=<value>",
+                      filename, line_num);
+            status = UCS_ERR_INVALID_PARAM;
+            break;
+        }
+
+        *p    = '\0';
+        name  = ucs_strtrim(name + prefix_len);
+        value = ucs_strtrim(p + 1);
+        if ((value[0] == '"') || (value[0] == '\'')) {
+            p = strrchr(value + 1, value[0]);
+            if (p != NULL) {
+                *p = '\0';
+                ++value;
+            }
+        }
+
+        if (!strncmp(name, env_name_prefix, strlen(env_name_prefix))) {
+            name += strlen(env_name_prefix);
+        }
+
+        if (ucs_config_parser_is_env_set(env_prefix, name)) {
+            ucs_debug("%s:%u: "UCS_CONFIG_PREFIX"%s is overridden by the "
+                      "environment", filename, line_num, name);
+            continue;
+        }
+
+        status = ucs_config_parser_set_value(opts, fields, name, value);
+        if (status == UCS_ERR_NO_ELEM) {
+            /* The variable belongs to another component */
+            status = UCS_OK;
+        } else if (status != UCS_OK) {
+            ucs_error("%s:%u: invalid value '%s' for "UCS_CONFIG_PREFIX"%s",
+                      filename, line_num, value, name);
+            break;
+        }
+    }
+
+    fclose(file);
+    return status;
+}
+
 ucs_status_t ucs_config_parser_get_value(void *opts, ucs_config_field_t *fields,
                                          const char *name, char *value,
                                          size_t max)
@@ -345,6 +345,23 @@ ucs_status_t ucs_config_parser_get_value(void *opts, ucs_config_field_t *fields,
 ucs_status_t ucs_config_parser_set_value(void *opts, ucs_config_field_t *fields,
                                          const char *name, const char *value);
 
+/**
+ * Modify existing opts structure with the settings from a configuration file.
+ * Every line of the file is "UCX_<NAME>=<value>", and empty lines and lines
+ * which start with '#' are ignored. Variables which are set in the environment,
+ * or which are not defined by 'fields', are skipped. A missing file is not an
+ * error.
+ *
+ * @param opts       User-defined options structure.
+ * @param fields     Array of fields which define how to parse.
+ * @param env_prefix Prefix of environment variables, as in
+ *                   @ref ucs_config_parser_fill_opts.
+ * @param filename   Configuration file to read.
+ */
+ucs_status_t ucs_config_parser_apply_file(void *opts, ucs_config_field_t *fields,
+                                          const char *env_prefix,
+                                          const char *filename);
+
 /**
  * Check all UCX_ environment variables have been used so far by the
  * configuration parser, issue a warning if not. Called just before program exit.
@@ -69,6 +69,17 @@ typedef enum {
 } ucs_handle_error_t;
 
 
+/**
+ * Policy of assigning async contexts to async progress threads
+ */
+typedef enum {
+    UCS_ASYNC_THREAD_ASSIGN_ROUND_ROBIN, /* Assign threads in a cyclic order */
+    UCS_ASYNC_THREAD_ASSIGN_AFFINITY,    /* Assign the thread by the CPU of
+                                            the thread creating the context */
+    UCS_ASYNC_THREAD_ASSIGN_LAST
+} ucs_async_thread_assign_t;
+
+
 /**
  * Configuration printing flags
  */
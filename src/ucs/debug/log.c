@@ -5,6 +5,7 @@
 */
 
 #include "log.h"
+#include "log_async.h"
 
 #include <ucs/debug/debug.h>
 #include <ucs/sys/compiler.h>
@@ -44,7 +45,7 @@ static pthread_spinlock_t threads_lock = 0;
 static pthread_t threads[128]          = {0};
 
 
-static int ucs_log_get_thread_num(void)
+int ucs_log_get_thread_num(void)
 {
     pthread_t self = pthread_self();
     unsigned i;
@@ -77,6 +78,17 @@ unlock_and_return_i:
     return i;
 }
 
+void ucs_log_write_message(const struct timeval *tv, int thread_num,
+                           const char *short_file, unsigned line,
+                           ucs_log_level_t level, const char *message)
+{
+    fprintf(ucs_log_file,
+            "[%lu.%06lu] [%s:%-5d:%d] %16s:%-4u %-4s %-5s %s\n",
+            tv->tv_sec, tv->tv_usec, ucs_log_hostname, ucs_log_pid,
+            thread_num, short_file, line, "UCX",
+            ucs_log_level_names[level], message);
+}
+
 void ucs_log_flush()
 {
     if (ucs_log_file != NULL) {
@@ -119,11 +131,8 @@ ucs_log_default_handler(const char *file, unsigned line, const char *function,
                  short_file, line, "UCX", ucs_log_level_names[level], buf);
         VALGRIND_PRINTF("%s", valg_buf);
     } else if (ucs_log_initialized) {
-        fprintf(ucs_log_file,
-                "[%lu.%06lu] [%s:%-5d:%d] %16s:%-4u %-4s %-5s %s\n",
-                tv.tv_sec, tv.tv_usec, ucs_log_hostname, ucs_log_pid,
-                ucs_log_get_thread_num(), short_file, line, "UCX",
-                ucs_log_level_names[level], buf);
+        ucs_log_write_message(&tv, ucs_log_get_thread_num(), short_file, line,
+                              level, buf);
     } else {
         fprintf(stdout,
                 "[%lu.%06lu] %16s:%-4u %-4s %-5s %s\n",
@@ -328,10 +337,18 @@ void ucs_log_init()
          ucs_open_output_stream(ucs_global_opts.log_file, UCS_LOG_LEVEL_FATAL,
                                 &ucs_log_file, &ucs_log_file_close, &next_token);
     }
+
+    if (ucs_global_opts.log_async && !RUNNING_ON_VALGRIND &&
+        (ucs_log_async_init() == UCS_OK)) {
+        /* Called before the default handler, which is used for messages
+         * that should not be deferred */
+        ucs_log_push_handler(ucs_log_async_handler);
+    }
 }
 
 void ucs_log_cleanup()
 {
+    ucs_log_async_cleanup();
     ucs_log_flush();
     if (ucs_log_file_close) {
         fclose(ucs_log_file);
@@ -14,6 +14,7 @@
 
 #include <ucs/sys/compiler_def.h>
 #include <ucs/config/global_opts.h>
+#include <sys/time.h>
 #include <stdarg.h>
 #include <stdint.h>
 
@@ -109,6 +110,27 @@ void ucs_log_dispatch(const char *file, unsigned line, const char *function,
     UCS_F_PRINTF(5, 6);
 
 
+/**
+ * Get the index of the calling thread, as shown in log messages.
+ */
+int ucs_log_get_thread_num(void);
+
+
+/**
+ * Write a formatted message to the log file, in the default log format.
+ *
+ * @param tv          Message timestamp.
+ * @param thread_num  Index of the thread which created the message.
+ * @param short_file  Source file name, without directory.
+ * @param line        Source line number.
+ * @param level       Log level of the message.
+ * @param message     Formatted message text.
+ */
+void ucs_log_write_message(const struct timeval *tv, int thread_num,
+                           const char *short_file, unsigned line,
+                           ucs_log_level_t level, const char *message);
+
+
 /**
  * Flush logging output.
  */
@@ -0,0 +1,828 @@
+/**
+* Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+*
+* See file LICENSE for terms.
+*/
+
+#include "log_async.h"
+
+#include <ucs/arch/cpu.h>
+#include <ucs/config/parser.h>
+#include <ucs/datastruct/list.h>
+#include <ucs/sys/compiler.h>
+#include <ucs/sys/math.h>
+#include <ucs/sys/sys.h>
+#include <ucs/time/time.h>
+#include <pthread.h>
+#include <errno.h>
+
+
+#define UCS_LOG_ASYNC_MAX_ARGS         16
+#define UCS_LOG_ASYNC_FMT_CACHE_SIZE   64     /* Must be a power of 2 */
+#define UCS_LOG_ASYNC_FLUSH_INTERVAL   10000  /* Microseconds */
+#define UCS_LOG_ASYNC_MAX_SPEC         64
+#define UCS_LOG_ASYNC_PRECISION_NONE   -1
+#define UCS_LOG_ASYNC_PRECISION_ARG    -2     /* Given by the previous argument */
+#define UCS_LOG_ASYNC_NULL_STRING      UINT64_MAX
+
+
+typedef enum {
+    UCS_LOG_ASYNC_ARG_INT,
+    UCS_LOG_ASYNC_ARG_LONG,
+    UCS_LOG_ASYNC_ARG_DOUBLE,
+    UCS_LOG_ASYNC_ARG_PTR,
+    UCS_LOG_ASYNC_ARG_STRING
+} ucs_log_async_arg_type_t;
+
+
+/**
+ * Single conversion specification in a format string
+ */
+typedef struct {
+    const char               *start;      /**< Points to the '%' character */
+    const char               *end;        /**< Points after the conversion character */
+    char                     conversion;  /**< Conversion character */
+    int                      num_stars;   /**< Number of '*' in width/precision */
+    int                      precision;   /**< Literal precision, or one of
+                                               UCS_LOG_ASYNC_PRECISION_xx */
+    int                      is_long;     /**< Has l/ll/j/z/t/q length modifier */
+    int                      is_ldouble;  /**< Has L length modifier */
+} ucs_log_async_spec_t;
+
+
+/**
+ * Argument types of a format string
+ */
+typedef struct {
+    const char               *format;     /**< Format string */
+    int                      num_args;    /**< Number of arguments, or -1 if
+                                               the format is not supported */
+    uint8_t                  types[UCS_LOG_ASYNC_MAX_ARGS];
+    int                      precision[UCS_LOG_ASYNC_MAX_ARGS];
+} ucs_log_async_format_t;
+
+
+/**
+ * Log record header, followed by 64-bit argument values and then by the
+ * contents of string arguments. For a string argument, the value is its length.
+ */
+typedef struct {
+    uint32_t                 size;        /**< Total record size, must be first */
+    uint8_t                  level;       /**< Log level, or UCS_LOG_LEVEL_LAST
+                                               for padding at the end of the ring */
+    uint8_t                  num_args;    /**< Number of arguments */
+    uint16_t                 reserved;
+    uint32_t                 line;        /**< Source line number */
+    int32_t                  err;         /**< Value of errno, for "%m" */
+    ucs_time_t               timestamp;   /**< Time of the log call */
+    const char               *file;       /**< Source file name */
+    const char               *format;     /**< Format string */
+    uint64_t                 args[0];     /**< Raw arguments */
+} ucs_log_async_record_t;
+
+
+/**
+ * Per-thread ring of log records. Written only by the owner thread, and read
+ * only by the thread which holds the global lock.
+ */
+typedef struct {
+    volatile uint64_t        head;        /**< Producer position */
+    uint64_t                 dropped;     /**< Number of dropped records */
+    volatile int             orphaned;    /**< Set when the owner thread exits */
+    int                      thread_num;  /**< Thread index, as shown in log */
+    ucs_log_async_format_t   fmt_cache[UCS_LOG_ASYNC_FMT_CACHE_SIZE];
+
+    /* Consumer fields, on a separate cache line */
+    volatile uint64_t        tail UCS_V_ALIGNED(UCS_SYS_CACHE_LINE_SIZE);
+    uint64_t                 reported;    /**< Number of reported dropped records */
+    size_t                   size;        /**< Buffer size, power of 2 */
+    char                     *buffer;     /**< Records buffer */
+    ucs_list_link_t          list;        /**< Entry in the global list */
+} ucs_log_async_ring_t;
+
+
+static struct {
+    pthread_mutex_t          lock;        /**< Protects the list and draining */
+    ucs_list_link_t          rings;       /**< List of all per-thread rings */
+    pthread_t                thread;      /**< Logging thread */
+    pthread_key_t            key;         /**< Detects exit of writer threads */
+    volatile int             stop;        /**< Whether the thread should exit */
+    int                      initialized;
+    int                      atfork;      /**< Whether fork handlers are set */
+    unsigned                 generation;  /**< Invalidates thread-local pointers */
+    ucs_time_t               base_time;   /**< Time at initialization */
+    struct timeval           base_tv;     /**< Wall-clock time at initialization */
+} ucs_log_async_ctx = {
+    .lock        = PTHREAD_MUTEX_INITIALIZER,
+    .rings       = UCS_LIST_INITIALIZER(&ucs_log_async_ctx.rings,
+                                        &ucs_log_async_ctx.rings),
+    .stop        = 0,
+    .initialized = 0,
+    .atfork      = 0,
+    .generation  = 1
+};
+
+
+static __thread struct {
+    ucs_log_async_ring_t     *ring;
+    unsigned                 generation;
+} ucs_log_async_thread_local = {NULL, 0};
+
+
+/*
+ * Find the next conversion specification in a format string.
+ * Returns NULL if there are no more specifications.
+ */
+static const char *
+ucs_log_async_next_spec(const char *p, ucs_log_async_spec_t *spec)
+{
+    p = strchr(p, '%');
+    if (p == NULL) {
+        return NULL;
+    }
+
+    spec->start      = p++;
+    spec->num_stars  = 0;
+    spec->precision  = UCS_LOG_ASYNC_PRECISION_NONE;
+    spec->is_long    = 0;
+    spec->is_ldouble = 0;
+
+    /* flags */
+    p += strspn(p, "-+ #0'");
+
+    /* width */
+    if (*p == '*') {
+        ++spec->num_stars;
+        ++p;
+    } else {
+        p += strspn(p, "0123456789");
+    }
+
+    /* precision */
+    if (*p == '.') {
+        ++p;
+        if (*p == '*') {
+            ++spec->num_stars;
+            spec->precision = UCS_LOG_ASYNC_PRECISION_ARG;
+            ++p;
+        } else {
+            spec->precision = 0;
+            while ((*p >= '0') && (*p <= '9')) {
+                spec->precision = (spec->precision * 10) + (*p - '0');
+                ++p;
+            }
+        }
+    }
+
+    /* length modifier */
+    while ((*p != '\0') && (strchr("hlLqjzt", *p) != NULL)) {
+        if (*p == 'L') {
+            spec->is_ldouble = 1;
+        } else if (*p != 'h') {
+            spec->is_long    = 1;
+        }
+        ++p;
+    }
+
+    spec->conversion = *p;
+    spec->end        = (*p == '\0') ? p : (p + 1);
+    return spec->start;
+}
+
+static int ucs_log_async_add_arg(ucs_log_async_format_t *fmt,
+                                 ucs_log_async_arg_type_t type, int precision)
+{
+    if (fmt->num_args >= UCS_LOG_ASYNC_MAX_ARGS) {
+        return 0;
+    }
+
+    fmt->types[fmt->num_args]     = type;
+    fmt->precision[fmt->num_args] = precision;
+    ++fmt->num_args;
+    return 1;
+}
+
+static void ucs_log_async_parse_format(const char *format,
+                                       ucs_log_async_format_t *fmt)
+{
+    ucs_log_async_spec_t spec;
+    const char *p;
+    int i, ok;
+
+    fmt->format   = format;
+    fmt->num_args = 0;
+
+    for (p = format; ucs_log_async_next_spec(p, &spec) != NULL; p = spec.end) {
+        for (i = 0; i < spec.num_stars; ++i) {
+            if (!ucs_log_async_add_arg(fmt, UCS_LOG_ASYNC_ARG_INT,
+                                       UCS_LOG_ASYNC_PRECISION_NONE)) {
+                goto unsupported;
+            }
+        }
+
+        switch (spec.conversion) {
+        case '%':
+        case 'm':
+            ok = 1;
+            break;
+        case 'd':
+        case 'i':
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'c':
+            ok = ucs_log_async_add_arg(fmt, (spec.is_long || spec.is_ldouble) ?
+                                       UCS_LOG_ASYNC_ARG_LONG :
+                                       UCS_LOG_ASYNC_ARG_INT,
+                                       UCS_LOG_ASYNC_PRECISION_NONE);
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            ok = !spec.is_ldouble &&
+                 ucs_log_async_add_arg(fmt, UCS_LOG_ASYNC_ARG_DOUBLE,
+                                       UCS_LOG_ASYNC_PRECISION_NONE);
+            break;
+        case 's':
+            ok = !spec.is_long &&
+                 ucs_log_async_add_arg(fmt, UCS_LOG_ASYNC_ARG_STRING,
+                                       spec.precision);
+            break;
+        case 'p':
+            ok = ucs_log_async_add_arg(fmt, UCS_LOG_ASYNC_ARG_PTR,
+                                       UCS_LOG_ASYNC_PRECISION_NONE);
+            break;
+        default:
+            /* %n, wide strings and unknown conversions */
+            ok = 0;
+            break;
+        }
+
+        if (!ok) {
+            goto unsupported;
+        }
+    }
+
+    return;
+
+unsupported:
+    fmt->num_args = -1;
+}
+
+/* Runs with the global lock held */
+static int ucs_log_async_format_record(const ucs_log_async_record_t *rec,
+                                       char *buf, size_t max)
+{
+    const char *strings = (const char*)&rec->args[rec->num_args];
+    char spec_str[UCS_LOG_ASYNC_MAX_SPEC];
+    ucs_log_async_spec_t spec;
+    char *str, *bufp, *endp, *s;
+    const char *p, *q;
+    uint64_t value;
+    int arg, i;
+    double d;
+
+    bufp = buf;
+    endp = buf + max;
+    arg  = 0;
+
+#define UCS_LOG_ASYNC_PRINT(_fmt, ...) \
+    bufp += snprintf(bufp, endp - bufp, _fmt, ## __VA_ARGS__); \
+    if (bufp >= endp) { \
+        goto out; \
+    }
+
+    for (p = rec->format; ucs_log_async_next_spec(p, &spec) != NULL;
+         p = spec.end) {
+        /* literal text before the specification */
+        UCS_LOG_ASYNC_PRINT("%.*s", (int)(spec.start - p), p);
+
+        if (spec.conversion == '%') {
+            UCS_LOG_ASYNC_PRINT("%%");
+            continue;
+        }
+
+        /* copy the specification, replacing '*' by the argument values */
+        s = spec_str;
+        for (q = spec.start; q < spec.end; ++q) {
+            if (s >= spec_str + sizeof(spec_str) - 16) {
+                return -1;
+            } else if (*q == '*') {
+                if (arg >= rec->num_args) {
+                    return -1;
+                }
+                s += sprintf(s, "%d", (int)rec->args[arg++]);
+            } else {
+                *(s++) = *q;
+            }
+        }
+        *s = '\0';
+
+        if (spec.conversion == 'm') {
+            errno = rec->err;
+            UCS_LOG_ASYNC_PRINT(spec_str, 0);
+            continue;
+        }
+
+        if (arg >= rec->num_args) {
+            return -1;
+        }
+
+        value = rec->args[arg++];
+        switch (spec.conversion) {
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            memcpy(&d, &value, sizeof(d));
+            UCS_LOG_ASYNC_PRINT(spec_str, d);
+            break;
+        case 's':
+            if (value == UCS_LOG_ASYNC_NULL_STRING) {
+                UCS_LOG_ASYNC_PRINT(spec_str, (char*)NULL);
+                break;
+            }
+            str = ucs_alloca(value + 1);
+            memcpy(str, strings, value);
+            str[value] = '\0';
+            strings   += value;
+            UCS_LOG_ASYNC_PRINT(spec_str, str);
+            break;
+        case 'p':
+            UCS_LOG_ASYNC_PRINT(spec_str, (void*)(uintptr_t)value);
+            break;
+        default:
+            if (spec.is_long || spec.is_ldouble) {
+                /* 'L' with an integer conversion means 'long long' */
+                for (i = 0; spec_str[i] != '\0'; ++i) {
+                    if (spec_str[i] == 'L') {
+                        spec_str[i] = 'q';
+                    }
+                }
+                UCS_LOG_ASYNC_PRINT(spec_str, (long long)value);
+            } else {
+                UCS_LOG_ASYNC_PRINT(spec_str, (int)value);
+            }
+            break;
+        }
+    }
+
+    /* literal text after the last specification */
+    UCS_LOG_ASYNC_PRINT("%s", p);
+
+#undef UCS_LOG_ASYNC_PRINT
+
+out:
+    return 0;
+}
+
+/* Runs with the global lock held */
+static void ucs_log_async_write_record(const ucs_log_async_ring_t *ring,
+                                       const ucs_log_async_record_t *rec)
+{
+    size_t buffer_size = ucs_config_memunits_get(ucs_global_opts.log_buffer_size,
+                                                 256, 2048);
+    const char *short_file;
+    double usec;
+    struct timeval tv;
+    char *buf;
+
+    buf              = ucs_alloca(buffer_size + 1);
+    buf[buffer_size] = '\0';
+    if (ucs_log_async_format_record(rec, buf, buffer_size) < 0) {
+        snprintf(buf, buffer_size, "<malformed log record, format '%s'>",
+                 rec->format);
+    }
+
+    usec       = ucs_time_to_usec(rec->timestamp - ucs_log_async_ctx.base_time);
+    tv.tv_sec  = ucs_log_async_ctx.base_tv.tv_sec +
+                 (time_t)(usec / UCS_USEC_PER_SEC);
+    tv.tv_usec = ucs_log_async_ctx.base_tv.tv_usec +
+                 ((uint64_t)usec % UCS_USEC_PER_SEC);
+    if (tv.tv_usec >= UCS_USEC_PER_SEC) {
+        tv.tv_usec -= UCS_USEC_PER_SEC;
+        ++tv.tv_sec;
+    }
+
+    short_file = strrchr(rec->file, '/');
+    short_file = (short_file == NULL) ? rec->file : short_file + 1;
+    ucs_log_write_message(&tv, ring->thread_num, short_file, rec->line,
+                          (ucs_log_level_t)rec->level, buf);
+}
+
+/* Runs with the global lock held, returns the number of written records */
+static unsigned ucs_log_async_ring_drain(ucs_log_async_ring_t *ring)
+{
+    const ucs_log_async_record_t *rec;
+    struct timeval tv;
+    unsigned count;
+    uint64_t head, tail, dropped;
+    char buf[64];
+
+    head = ring->head;
+    ucs_memory_cpu_load_fence();
+
+    count = 0;
+    for (tail = ring->tail; tail != head; tail += rec->size) {
+        rec = (const void*)(ring->buffer + (tail & (ring->size - 1)));
+        if (rec->level != UCS_LOG_LEVEL_LAST) {
+            ucs_log_async_write_record(ring, rec);
+            ++count;
+        }
+    }
+
+    ucs_memory_cpu_fence();
+    ring->tail = tail;
+
+    dropped = ring->dropped;
+    if (dropped != ring->reported) {
+        snprintf(buf, sizeof(buf), "%"PRIu64" log messages were dropped",
+                 dropped - ring->reported);
+        gettimeofday(&tv, NULL);
+        ucs_log_write_message(&tv, ring->thread_num, "log_async.c", __LINE__,
+                              UCS_LOG_LEVEL_WARN, buf);
+        ring->reported = dropped;
+        ++count;
+    }
+
+    return count;
+}
+
+static void ucs_log_async_ring_free(ucs_log_async_ring_t *ring)
+{
+    ucs_list_del(&ring->list);
+    free(ring->buffer);
+    free(ring);
+}
+
+void ucs_log_async_flush()
+{
+    ucs_log_async_ring_t *ring, *tmp;
+    unsigned count;
+    int orphaned;
+
+    pthread_mutex_lock(&ucs_log_async_ctx.lock);
+    count = 0;
+    ucs_list_for_each_safe(ring, tmp, &ucs_log_async_ctx.rings, list) {
+        /* An orphaned ring gets no more records, so it's released once the
+         * records written before the owner thread exited are drained */
+        orphaned = ring->orphaned;
+        ucs_memory_cpu_load_fence();
+        count += ucs_log_async_ring_drain(ring);
+        if (orphaned) {
+            ucs_log_async_ring_free(ring);
+        }
+    }
+    if (count > 0) {
+        ucs_log_flush();
+    }
+    pthread_mutex_unlock(&ucs_log_async_ctx.lock);
+}
+
+static void *ucs_log_async_thread_func(void *arg)
+{
+    while (!ucs_log_async_ctx.stop) {
+        usleep(UCS_LOG_ASYNC_FLUSH_INTERVAL);
+        ucs_log_async_flush();
+    }
+    return NULL;
+}
+
+static ucs_log_async_ring_t *ucs_log_async_ring_create()
+{
+    ucs_log_async_ring_t *ring;
+    size_t size;
+    int ret;
+
+    /* Use libc directly, since memory tracking could generate log messages */
+    ret = posix_memalign((void**)&ring, UCS_SYS_CACHE_LINE_SIZE, sizeof(*ring));
+    if (ret != 0) {
+        return NULL;
+    }
+
+    size = ucs_roundup_pow2(ucs_max(ucs_global_opts.log_async_buffer_size,
+                                    UCS_SYS_CACHE_LINE_SIZE));
+    ring->buffer = malloc(size);
+    if (ring->buffer == NULL) {
+        free(ring);
+        return NULL;
+    }
+
+    memset(ring->fmt_cache, 0, sizeof(ring->fmt_cache));
+    ring->head       = 0;
+    ring->tail       = 0;
+    ring->dropped    = 0;
+    ring->reported   = 0;
+    ring->size       = size;
+    ring->thread_num = ucs_log_get_thread_num();
+
+    ring->orphaned   = 0;
+
+    pthread_mutex_lock(&ucs_log_async_ctx.lock);
+    ucs_list_add_tail(&ucs_log_async_ctx.rings, &ring->list);
+    pthread_mutex_unlock(&ucs_log_async_ctx.lock);
+
+    pthread_setspecific(ucs_log_async_ctx.key, ring);
+    return ring;
+}
+
+/* Called when a thread which has a ring exits */
+static void ucs_log_async_thread_exit(void *arg)
+{
+    ucs_log_async_ring_t *ring = arg;
+
+    /* Messages from later thread-local destructors are printed synchronously */
+    ucs_log_async_thread_local.ring       = NULL;
+    ucs_log_async_thread_local.generation = ucs_log_async_ctx.generation;
+
+    ucs_memory_cpu_store_fence();
+    ring->orphaned = 1;
+}
+
+static UCS_F_ALWAYS_INLINE ucs_log_async_ring_t *ucs_log_async_ring_get()
+{
+    if (ucs_likely(ucs_log_async_thread_local.generation ==
+                   ucs_log_async_ctx.generation)) {
+        return ucs_log_async_thread_local.ring;
+    }
+
+    ucs_log_async_thread_local.ring       = ucs_log_async_ring_create();
+    ucs_log_async_thread_local.generation = ucs_log_async_ctx.generation;
+    return ucs_log_async_thread_local.ring;
+}
+
+static UCS_F_ALWAYS_INLINE const ucs_log_async_format_t *
+ucs_log_async_format_get(ucs_log_async_ring_t *ring, const char *format)
+{
+    ucs_log_async_format_t *fmt;
+
+    fmt = &ring->fmt_cache[((uintptr_t)format / sizeof(void*)) &
+                           (UCS_LOG_ASYNC_FMT_CACHE_SIZE - 1)];
+    if (ucs_unlikely(fmt->format != format)) {
+        ucs_log_async_parse_format(format, fmt);
+    }
+    return fmt;
+}
+
+/*
+ * Reserve space for a record of the given size. If the record does not fit
+ * before the end of the buffer, a padding record is added and the record is
+ * placed at the beginning of the buffer.
+ */
+static UCS_F_ALWAYS_INLINE ucs_log_async_record_t *
+ucs_log_async_ring_reserve(ucs_log_async_ring_t *ring, size_t size,
+                           uint64_t *head_p)
+{
+    uint64_t head = ring->head;
+    ucs_log_async_record_t *pad;
+    size_t offset, contig;
+
+    offset = head & (ring->size - 1);
+    contig = ring->size - offset;
+    if ((head + size + ((contig < size) ? contig : 0) - ring->tail) > ring->size) {
+        return NULL;
+    }
+
+    if (contig < size) {
+        pad        = (void*)(ring->buffer + offset);
+        pad->size  = contig;
+        pad->level = UCS_LOG_LEVEL_LAST;
+        head      += contig;
+        offset     = 0;
+    }
+
+    *head_p = head + size;
+    return (void*)(ring->buffer + offset);
+}
+
+ucs_log_func_rc_t
+ucs_log_async_handler(const char *file, unsigned line, const char *function,
+                      ucs_log_level_t level, const char *format, va_list ap)
+{
+    const ucs_log_async_format_t *fmt;
+    const char *strings[UCS_LOG_ASYNC_MAX_ARGS];
+    uint64_t args[UCS_LOG_ASYNC_MAX_ARGS];
+    ucs_log_async_record_t *rec;
+    ucs_log_async_ring_t *ring;
+    size_t size, max_length;
+    int err = errno;
+    uint64_t head;
+    char *strp;
+    double d;
+    int i;
+
+    if (!ucs_log_is_enabled(level) || !ucs_log_async_ctx.initialized) {
+        return UCS_LOG_FUNC_RC_CONTINUE;
+    }
+
+    /* Errors and warnings are printed immediately, after the pending records */
+    if ((level <= UCS_LOG_LEVEL_WARN) ||
+        (level <= ucs_global_opts.log_level_trigger)) {
+        goto out_sync;
+    }
+
+    ring = ucs_log_async_ring_get();
+    if (ucs_unlikely(ring == NULL)) {
+        goto out_sync;
+    }
+
+    fmt = ucs_log_async_format_get(ring, format);
+    if (ucs_unlikely(fmt->num_args < 0)) {
+        goto out_sync;
+    }
+
+    /* Read the arguments, and calculate the record size */
+    size = sizeof(*rec) + (sizeof(uint64_t) * fmt->num_args);
+    for (i = 0; i < fmt->num_args; ++i) {
+        switch (fmt->types[i]) {
+        case UCS_LOG_ASYNC_ARG_INT:
+            args[i] = (int64_t)va_arg(ap, int);
+            break;
+        case UCS_LOG_ASYNC_ARG_LONG:
+            args[i] = va_arg(ap, long long);
+            break;
+        case UCS_LOG_ASYNC_ARG_DOUBLE:
+            d = va_arg(ap, double);
+            memcpy(&args[i], &d, sizeof(args[i]));
+            break;
+        case UCS_LOG_ASYNC_ARG_PTR:
+            args[i] = (uintptr_t)va_arg(ap, void*);
+            break;
+        case UCS_LOG_ASYNC_ARG_STRING:
+            strings[i] = va_arg(ap, const char*);
+            if (strings[i] == NULL) {
+                args[i] = UCS_LOG_ASYNC_NULL_STRING;
+                break;
+            }
+
+            if (fmt->precision[i] >= 0) {
+                max_length = fmt->precision[i];
+            } else if ((fmt->precision[i] == UCS_LOG_ASYNC_PRECISION_ARG) &&
+                       ((int)args[i - 1] >= 0)) {
+                max_length = (int)args[i - 1];
+            } else {
+                max_length = ucs_global_opts.log_buffer_size;
+            }
+
+            args[i] = strnlen(strings[i], max_length);
+            size   += args[i];
+            break;
+        }
+    }
+
+    size = ucs_align_up_pow2(size, sizeof(uint64_t));
+    if (ucs_unlikely(size > (ring->size / 2))) {
+        goto out_sync;
+    }
+
+    rec = ucs_log_async_ring_reserve(ring, size, &head);
+    if (ucs_unlikely(rec == NULL)) {
+        ++ring->dropped;
+        return UCS_LOG_FUNC_RC_STOP;
+    }
+
+    rec->size      = size;
+    rec->level     = level;
+    rec->num_args  = fmt->num_args;
+    rec->line      = line;
+    rec->err       = err;
+    rec->timestamp = ucs_get_time();
+    rec->file      = file;
+    rec->format    = format;
+    memcpy(rec->args, args, sizeof(uint64_t) * fmt->num_args);
+
+    strp = (char*)&rec->args[fmt->num_args];
+    for (i = 0; i < fmt->num_args; ++i) {
+        if ((fmt->types[i] == UCS_LOG_ASYNC_ARG_STRING) &&
+            (args[i] != UCS_LOG_ASYNC_NULL_STRING)) {
+            memcpy(strp, strings[i], args[i]);
+            strp += args[i];
+        }
+    }
+
+    ucs_memory_cpu_store_fence();
+    ring->head = head;
+    return UCS_LOG_FUNC_RC_STOP;
+
+out_sync:
+    ucs_log_async_flush();
+    errno = err;
+    return UCS_LOG_FUNC_RC_CONTINUE;
+}
+
+static void ucs_log_async_atfork_prepare()
+{
+    pthread_mutex_lock(&ucs_log_async_ctx.lock);
+}
+
+static void ucs_log_async_atfork_parent()
+{
+    pthread_mutex_unlock(&ucs_log_async_ctx.lock);
+}
+
+/*
+ * The child process has only the forking thread, and no logging thread. The
+ * pending records are printed by the parent, so they are dropped here, and a
+ * new logging thread is started. If it fails, the child logs synchronously.
+ */
+static void ucs_log_async_atfork_child()
+{
+    ucs_log_async_ring_t *ring, *tmp;
+    int ret;
+
+    pthread_mutex_init(&ucs_log_async_ctx.lock, NULL);
+    if (!ucs_log_async_ctx.initialized) {
+        return;
+    }
+
+    ucs_list_for_each_safe(ring, tmp, &ucs_log_async_ctx.rings, list) {
+        ucs_log_async_ring_free(ring);
+    }
+    pthread_setspecific(ucs_log_async_ctx.key, NULL);
+    ++ucs_log_async_ctx.generation;
+
+    ucs_log_async_ctx.stop = 0;
+    ret = pthread_create(&ucs_log_async_ctx.thread, NULL,
+                         ucs_log_async_thread_func, NULL);
+    if (ret != 0) {
+        pthread_key_delete(ucs_log_async_ctx.key);
+        ucs_log_async_ctx.initialized = 0;
+    }
+}
+
+ucs_status_t ucs_log_async_init()
+{
+    int ret;
+
+    if (ucs_log_async_ctx.initialized) {
+        return UCS_OK;
+    }
+
+    if (!ucs_log_async_ctx.atfork) {
+        ret = pthread_atfork(ucs_log_async_atfork_prepare,
+                             ucs_log_async_atfork_parent,
+                             ucs_log_async_atfork_child);
+        if (ret != 0) {
+            ucs_warn("failed to register asynchronous logging fork handlers: %s",
+                     strerror(ret));
+            return UCS_ERR_IO_ERROR;
+        }
+        ucs_log_async_ctx.atfork = 1;
+    }
+
+    ret = pthread_key_create(&ucs_log_async_ctx.key, ucs_log_async_thread_exit);
+    if (ret != 0) {
+        ucs_warn("failed to create asynchronous logging thread key: %s",
+                 strerror(ret));
+        return UCS_ERR_IO_ERROR;
+    }
+
+    ucs_log_async_ctx.base_time = ucs_get_time();
+    gettimeofday(&ucs_log_async_ctx.base_tv, NULL);
+    ucs_log_async_ctx.stop      = 0;
+
+    ret = pthread_create(&ucs_log_async_ctx.thread, NULL,
+                         ucs_log_async_thread_func, NULL);
+    if (ret != 0) {
+        ucs_warn("failed to create asynchronous logging thread: %s",
+                 strerror(ret));
+        pthread_key_delete(ucs_log_async_ctx.key);
+        return UCS_ERR_IO_ERROR;
+    }
+
+    ucs_log_async_ctx.initialized = 1;
+    return UCS_OK;
+}
+
+void ucs_log_async_cleanup()
+{
+    ucs_log_async_ring_t *ring, *tmp;
+
+    if (!ucs_log_async_ctx.initialized) {
+        return;
+    }
+
+    ucs_log_async_ctx.stop = 1;
+    pthread_join(ucs_log_async_ctx.thread, NULL);
+    ucs_log_async_flush();
+
+    pthread_mutex_lock(&ucs_log_async_ctx.lock);
+    ucs_list_for_each_safe(ring, tmp, &ucs_log_async_ctx.rings, list) {
+        ucs_log_async_ring_free(ring);
+    }
+    pthread_setspecific(ucs_log_async_ctx.key, NULL);
+    pthread_key_delete(ucs_log_async_ctx.key);
+    ++ucs_log_async_ctx.generation;
+    ucs_log_async_ctx.initialized = 0;
+    pthread_mutex_unlock(&ucs_log_async_ctx.lock);
+}
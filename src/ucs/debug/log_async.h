@@ -0,0 +1,58 @@
+/**
+* Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+*
+* See file LICENSE for terms.
+*/
+
+#ifndef UCS_LOG_ASYNC_H_
+#define UCS_LOG_ASYNC_H_
+
+#include "log.h"
+
+#include <ucs/type/status.h>
+
+
+BEGIN_C_DECLS
+
+/*
+ * Asynchronous logging backend.
+ *
+ * Every thread writes log messages as compact binary records (timestamp,
+ * format string pointer and raw arguments) to its own lock-free ring buffer.
+ * A background thread drains the rings, formats the records to text and writes
+ * them to the log file. The ring of an exited thread is released after it is
+ * drained. A forked child process drops the pending records of the parent and
+ * starts its own logging thread.
+ */
+
+
+/**
+ * Start the asynchronous logging thread.
+ */
+ucs_status_t ucs_log_async_init();
+
+
+/**
+ * Stop the asynchronous logging thread, write all pending records and release
+ * the per-thread buffers.
+ */
+void ucs_log_async_cleanup();
+
+
+/**
+ * Format and write all pending records to the log file.
+ */
+void ucs_log_async_flush();
+
+
+/**
+ * Log handler which defers formatting of the message to the logging thread.
+ * Messages which cannot be deferred are passed to the next handler.
+ */
+ucs_log_func_rc_t
+ucs_log_async_handler(const char *file, unsigned line, const char *function,
+                      ucs_log_level_t level, const char *format, va_list ap);
+
+END_C_DECLS
+
+#endif
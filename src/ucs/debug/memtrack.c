@@ -6,44 +6,85 @@
 
 #include "memtrack.h"
 
+#include <ucs/arch/atomic.h>
+#include <ucs/arch/cpu.h>
+#include <ucs/config/global_opts.h>
 #include <ucs/datastruct/khash.h>
 #include <ucs/debug/log.h>
 #include <ucs/stats/stats.h>
 #include <ucs/sys/sys.h>
+#include <execinfo.h>
 #include <malloc.h>
+#include <pthread.h>
 #include <stdio.h>
 
 
 #if ENABLE_MEMTRACK
 
 #define UCS_MEMTRACK_FORMAT_STRING    ("%22s: size: %9lu / %9lu\tcount: %9u / %9u\n")
-
+#define UCS_MEMTRACK_NUM_SHARDS       64  /* Must be a power of 2 */
+#define UCS_MEMTRACK_ENTRY_CACHE_SIZE 64  /* Must be a power of 2 */
+#define UCS_MEMTRACK_BACKTRACE_DEPTH  8
+#define UCS_MEMTRACK_BACKTRACE_SKIP   2   /* Skip memtrack functions */
+#define UCS_MEMTRACK_MAX_CALLSITES    20  /* Maximal number of reported call sites */
+#define UCS_MEMTRACK_SHARD_HASH_MULT  0x9e3779b97f4a7c15ul
+
+
+/* Call site of sampled allocations */
+typedef struct ucs_memtrack_callsite {
+    volatile uint64_t       size;   /* Currently allocated sampled size */
+    volatile uint32_t       count;  /* Number of currently allocated sampled blocks */
+    int                     num_frames;
+    void                    *frames[UCS_MEMTRACK_BACKTRACE_DEPTH];
+} ucs_memtrack_callsite_t;
 
 typedef struct ucs_memtrack_ptr {
-    size_t                  size;   /* Length of allocated buffer */
-    ucs_memtrack_entry_t    *entry; /* Entry which tracks this allocation */
+    size_t                  size;     /* Length of allocated buffer */
+    ucs_memtrack_entry_t    *entry;   /* Entry which tracks this allocation */
+    ucs_memtrack_callsite_t *callsite;/* Call site, if the allocation was sampled */
 } ucs_memtrack_ptr_t;
 
 KHASH_MAP_INIT_INT64(ucs_memtrack_ptr_hash, ucs_memtrack_ptr_t)
 KHASH_MAP_INIT_STR(ucs_memtrack_entry_hash, ucs_memtrack_entry_t*);
+KHASH_MAP_INIT_INT64(ucs_memtrack_callsite_hash, ucs_memtrack_callsite_t*);
 
-typedef struct ucs_memtrack_context {
-    int                              enabled;
-    pthread_mutex_t                  lock;
-    ucs_memtrack_entry_t             total;
+/* Part of the pointers hash, selected by the pointer value */
+typedef struct ucs_memtrack_shard {
+    pthread_spinlock_t               lock;
     khash_t(ucs_memtrack_ptr_hash)   ptrs;
-    khash_t(ucs_memtrack_entry_hash) entries;
+} UCS_V_ALIGNED(UCS_SYS_CACHE_LINE_SIZE) ucs_memtrack_shard_t;
+
+typedef struct ucs_memtrack_context {
+    int                                 enabled;
+    unsigned                            sample_interval;
+    unsigned                            generation; /* Invalidates thread caches */
+    pthread_mutex_t                     lock;       /* Protects entries and call sites */
+    ucs_memtrack_entry_t                total;
+    khash_t(ucs_memtrack_entry_hash)    entries;
+    khash_t(ucs_memtrack_callsite_hash) callsites;
+    ucs_memtrack_shard_t                shards[UCS_MEMTRACK_NUM_SHARDS];
     UCS_STATS_NODE_DECLARE(stats);
 } ucs_memtrack_context_t;
 
 
 /* Global context for tracking allocated memory */
 static ucs_memtrack_context_t ucs_memtrack_context = {
-    .enabled = 0,
-    .lock    = PTHREAD_MUTEX_INITIALIZER,
-    .total   = {0}
+    .enabled    = 0,
+    .generation = 1,
+    .lock       = PTHREAD_MUTEX_INITIALIZER,
+    .total      = {0}
 };
 
+/* Per-thread state, to avoid taking the global lock for every allocation */
+static __thread struct {
+    unsigned                generation;
+    unsigned                sample_countdown;
+    struct {
+        const char           *name;
+        ucs_memtrack_entry_t *entry;
+    } entry_cache[UCS_MEMTRACK_ENTRY_CACHE_SIZE];
+} ucs_memtrack_thread_ctx = {0};
+
 #if ENABLE_STATS
 static ucs_stats_class_t ucs_memtrack_stats_class = {
     .name = "memtrack",
@@ -63,7 +104,8 @@ static void ucs_memtrack_entry_reset(ucs_memtrack_entry_t *entry)
     entry->peak_count = 0;
 }
 
-static ucs_memtrack_entry_t* ucs_memtrack_entry_get(const char* name)
+/* Must be called with the global lock held */
+static ucs_memtrack_entry_t* ucs_memtrack_entry_get_locked(const char* name)
 {
     ucs_memtrack_entry_t *entry;
     khiter_t iter;
@@ -90,21 +132,148 @@ static ucs_memtrack_entry_t* ucs_memtrack_entry_get(const char* name)
     return entry;
 }
 
+/*
+ * Allocation names are usually string literals, so the entry is looked up in a
+ * per-thread cache by the name pointer, and the global hash is used only on a
+ * cache miss.
+ */
+static ucs_memtrack_entry_t* ucs_memtrack_entry_get(const char* name)
+{
+    ucs_memtrack_entry_t *entry;
+    unsigned index;
+
+    if (ucs_memtrack_thread_ctx.generation != ucs_memtrack_context.generation) {
+        memset(ucs_memtrack_thread_ctx.entry_cache, 0,
+               sizeof(ucs_memtrack_thread_ctx.entry_cache));
+        ucs_memtrack_thread_ctx.sample_countdown = 0;
+        ucs_memtrack_thread_ctx.generation       = ucs_memtrack_context.generation;
+    }
+
+    index = ((uintptr_t)name / sizeof(void*)) & (UCS_MEMTRACK_ENTRY_CACHE_SIZE - 1);
+    if (ucs_memtrack_thread_ctx.entry_cache[index].name == name) {
+        return ucs_memtrack_thread_ctx.entry_cache[index].entry;
+    }
+
+    pthread_mutex_lock(&ucs_memtrack_context.lock);
+    entry = ucs_memtrack_entry_get_locked(name);
+    pthread_mutex_unlock(&ucs_memtrack_context.lock);
+
+    if (entry != NULL) {
+        ucs_memtrack_thread_ctx.entry_cache[index].name  = name;
+        ucs_memtrack_thread_ctx.entry_cache[index].entry = entry;
+    }
+    return entry;
+}
+
 static void ucs_memtrack_entry_update(ucs_memtrack_entry_t *entry, ssize_t size)
 {
     int count = (size < 0) ? -1 : 1;
+    uint64_t new_size, peak_size;
+    uint32_t new_count, peak_count;
+
+    new_size  = ucs_atomic_fadd64((volatile uint64_t*)&entry->size, size) + size;
+    new_count = ucs_atomic_fadd32((volatile uint32_t*)&entry->count, count) + count;
+    ucs_assert((ssize_t)new_size  >= 0);
+    ucs_assert((int)new_count     >= 0);
+
+    /* update peak values, which are only increased */
+    peak_size = entry->peak_size;
+    while ((new_size > peak_size) &&
+           (ucs_atomic_cswap64((volatile uint64_t*)&entry->peak_size, peak_size,
+                               new_size) != peak_size)) {
+        peak_size = entry->peak_size;
+    }
 
-    ucs_assert((int)entry->count    >= -count);
-    ucs_assert((ssize_t)entry->size >= -size);
-    entry->count      += count;
-    entry->size       += size;
-    entry->peak_count  = ucs_max(entry->peak_count, entry->count);
-    entry->peak_size   = ucs_max(entry->peak_size,  entry->size);
+    peak_count = entry->peak_count;
+    while ((new_count > peak_count) &&
+           (ucs_atomic_cswap32((volatile uint32_t*)&entry->peak_count,
+                               peak_count, new_count) != peak_count)) {
+        peak_count = entry->peak_count;
+    }
+}
+
+static UCS_F_ALWAYS_INLINE ucs_memtrack_shard_t* ucs_memtrack_shard_get(void *ptr)
+{
+    uint64_t key = (uintptr_t)ptr;
+
+    /* Mix the bits, since allocations are aligned */
+    key ^= key >> 17;
+    key *= UCS_MEMTRACK_SHARD_HASH_MULT;
+    return &ucs_memtrack_context.shards[(key >> 32) &
+                                        (UCS_MEMTRACK_NUM_SHARDS - 1)];
+}
+
+/*
+ * Find or create the call site of the current allocation.
+ */
+static ucs_memtrack_callsite_t *ucs_memtrack_callsite_get()
+{
+    void *frames[UCS_MEMTRACK_BACKTRACE_DEPTH + UCS_MEMTRACK_BACKTRACE_SKIP];
+    ucs_memtrack_callsite_t *callsite;
+    uint64_t hash;
+    khiter_t iter;
+    int i, num_frames, ret;
+
+    num_frames = backtrace(frames, ucs_static_array_size(frames));
+    if (num_frames <= UCS_MEMTRACK_BACKTRACE_SKIP) {
+        return NULL;
+    }
+
+    num_frames -= UCS_MEMTRACK_BACKTRACE_SKIP;
+    hash        = num_frames;
+    for (i = 0; i < num_frames; ++i) {
+        hash = (hash * UCS_MEMTRACK_SHARD_HASH_MULT) ^
+               (uintptr_t)frames[i + UCS_MEMTRACK_BACKTRACE_SKIP];
+    }
+
+    pthread_mutex_lock(&ucs_memtrack_context.lock);
+
+    iter = kh_put(ucs_memtrack_callsite_hash, &ucs_memtrack_context.callsites,
+                  hash, &ret);
+    if (ret == -1) {
+        callsite = NULL;
+    } else if (ret == 0) {
+        callsite = kh_val(&ucs_memtrack_context.callsites, iter);
+    } else {
+        callsite = malloc(sizeof(*callsite));
+        if (callsite == NULL) {
+            kh_del(ucs_memtrack_callsite_hash, &ucs_memtrack_context.callsites,
+                   iter);
+        } else {
+            callsite->size       = 0;
+            callsite->count      = 0;
+            callsite->num_frames = num_frames;
+            memcpy(callsite->frames, frames + UCS_MEMTRACK_BACKTRACE_SKIP,
+                   sizeof(*frames) * num_frames);
+            kh_val(&ucs_memtrack_context.callsites, iter) = callsite;
+        }
+    }
+
+    pthread_mutex_unlock(&ucs_memtrack_context.lock);
+    return callsite;
+}
+
+/* Returns nonzero if the current allocation should be tracked */
+static UCS_F_ALWAYS_INLINE int ucs_memtrack_sample()
+{
+    if (ucs_memtrack_context.sample_interval <= 1) {
+        return 1;
+    }
+
+    if (ucs_memtrack_thread_ctx.sample_countdown > 1) {
+        --ucs_memtrack_thread_ctx.sample_countdown;
+        return 0;
+    }
+
+    ucs_memtrack_thread_ctx.sample_countdown = ucs_memtrack_context.sample_interval;
+    return 1;
 }
 
 void ucs_memtrack_allocated(void *ptr, size_t size, const char *name)
 {
+    ucs_memtrack_callsite_t *callsite;
     ucs_memtrack_entry_t *entry;
+    ucs_memtrack_shard_t *shard;
     khiter_t iter;
     int ret;
 
@@ -112,19 +281,30 @@ void ucs_memtrack_allocated(void *ptr, size_t size, const char *name)
         return;
     }
 
-    pthread_mutex_lock(&ucs_memtrack_context.lock);
-
     entry = ucs_memtrack_entry_get(name);
-    if (entry == NULL) {
-        goto out_unlock;
+    if ((entry == NULL) || !ucs_memtrack_sample()) {
+        return;
+    }
+
+    if (ucs_memtrack_context.sample_interval > 1) {
+        callsite = ucs_memtrack_callsite_get();
+        if (callsite != NULL) {
+            ucs_atomic_add64(&callsite->size, size);
+            ucs_atomic_add32(&callsite->count, 1);
+        }
+    } else {
+        callsite = NULL;
     }
 
     /* Add pointer to hash */
-    iter = kh_put(ucs_memtrack_ptr_hash, &ucs_memtrack_context.ptrs,
-                  (uintptr_t)ptr, &ret);
+    shard = ucs_memtrack_shard_get(ptr);
+    pthread_spin_lock(&shard->lock);
+    iter = kh_put(ucs_memtrack_ptr_hash, &shard->ptrs, (uintptr_t)ptr, &ret);
     ucs_assertv(ret == 1 || ret == 2, "ret=%d", ret);
-    kh_value(&ucs_memtrack_context.ptrs, iter).entry = entry;
-    kh_value(&ucs_memtrack_context.ptrs, iter).size  = size;
+    kh_value(&shard->ptrs, iter).entry    = entry;
+    kh_value(&shard->ptrs, iter).size     = size;
+    kh_value(&shard->ptrs, iter).callsite = callsite;
+    pthread_spin_unlock(&shard->lock);
 
     /* update specific and global entries */
     ucs_memtrack_entry_update(entry, size);
@@ -132,14 +312,13 @@ void ucs_memtrack_allocated(void *ptr, size_t size, const char *name)
 
     UCS_STATS_UPDATE_COUNTER(ucs_memtrack_context.stats, UCS_MEMTRACK_STAT_ALLOCATION_COUNT, 1);
     UCS_STATS_UPDATE_COUNTER(ucs_memtrack_context.stats, UCS_MEMTRACK_STAT_ALLOCATION_SIZE, size);
-
-out_unlock:
-    pthread_mutex_unlock(&ucs_memtrack_context.lock);
 }
 
 void ucs_memtrack_releasing(void* ptr)
 {
+    ucs_memtrack_callsite_t *callsite;
     ucs_memtrack_entry_t *entry;
+    ucs_memtrack_shard_t *shard;
     khiter_t iter;
     size_t size;
 
@@ -147,25 +326,33 @@ void ucs_memtrack_releasing(void* ptr)
         return;
     }
 
-    pthread_mutex_lock(&ucs_memtrack_context.lock);
+    shard = ucs_memtrack_shard_get(ptr);
+    pthread_spin_lock(&shard->lock);
 
-    iter = kh_get(ucs_memtrack_ptr_hash, &ucs_memtrack_context.ptrs, (uintptr_t)ptr);
-    if (iter == kh_end(&ucs_memtrack_context.ptrs)) {
-        ucs_debug("address %p not found in memtrack ptr hash", ptr);
-        goto out_unlock;
+    iter = kh_get(ucs_memtrack_ptr_hash, &shard->ptrs, (uintptr_t)ptr);
+    if (iter == kh_end(&shard->ptrs)) {
+        pthread_spin_unlock(&shard->lock);
+        if (ucs_memtrack_context.sample_interval <= 1) {
+            ucs_debug("address %p not found in memtrack ptr hash", ptr);
+        }
+        return;
     }
 
-    /* remote pointer from hash */
-    entry = kh_val(&ucs_memtrack_context.ptrs, iter).entry;
-    size  = kh_val(&ucs_memtrack_context.ptrs, iter).size;
-    kh_del(ucs_memtrack_ptr_hash, &ucs_memtrack_context.ptrs, iter);
+    /* remove pointer from hash */
+    entry    = kh_val(&shard->ptrs, iter).entry;
+    size     = kh_val(&shard->ptrs, iter).size;
+    callsite = kh_val(&shard->ptrs, iter).callsite;
+    kh_del(ucs_memtrack_ptr_hash, &shard->ptrs, iter);
+
+    pthread_spin_unlock(&shard->lock);
 
     /* update counts */
     ucs_memtrack_entry_update(entry, -size);
     ucs_memtrack_entry_update(&ucs_memtrack_context.total, -size);
-
-out_unlock:
-    pthread_mutex_unlock(&ucs_memtrack_context.lock);
+    if (callsite != NULL) {
+        ucs_atomic_add64(&callsite->size, -size);
+        ucs_atomic_add32(&callsite->count, -1);
+    }
 }
 
 void *ucs_malloc(size_t size, const char *name)
@@ -232,9 +419,7 @@ void ucs_memtrack_total(ucs_memtrack_entry_t* total)
         return;
     }
 
-    pthread_mutex_lock(&ucs_memtrack_context.lock);
     *total = ucs_memtrack_context.total;
-    pthread_mutex_unlock(&ucs_memtrack_context.lock);
 }
 
 static int ucs_memtrack_cmp_entries(const void *ptr1, const void *ptr2)
@@ -245,6 +430,61 @@ static int ucs_memtrack_cmp_entries(const void *ptr1, const void *ptr2)
     return (int)((ssize_t)(*e2)->peak_size - (ssize_t)(*e1)->peak_size);
 }
 
+static int ucs_memtrack_cmp_callsites(const void *ptr1, const void *ptr2)
+{
+    ucs_memtrack_callsite_t * const *c1 = ptr1;
+    ucs_memtrack_callsite_t * const *c2 = ptr2;
+
+    return ((*c2)->size > (*c1)->size) ? 1 :
+           ((*c2)->size < (*c1)->size) ? -1 :
+           0;
+}
+
+/* Must be called with the global lock held */
+static void ucs_memtrack_dump_callsites(FILE* output_stream)
+{
+    ucs_memtrack_callsite_t *callsite, **all_callsites;
+    unsigned num_callsites, i;
+    char **symbols;
+    int j;
+
+    all_callsites = malloc(sizeof(*all_callsites) *
+                           kh_size(&ucs_memtrack_context.callsites));
+    if (all_callsites == NULL) {
+        return;
+    }
+
+    num_callsites = 0;
+    kh_foreach_value(&ucs_memtrack_context.callsites, callsite, {
+        if (callsite->count > 0) {
+            all_callsites[num_callsites++] = callsite;
+        }
+    });
+
+    /* sort call sites according to currently allocated size */
+    qsort(all_callsites, num_callsites, sizeof(*all_callsites),
+          ucs_memtrack_cmp_callsites);
+
+    fprintf(output_stream, "\nlargest call sites of allocated memory, "
+            "estimated from sampling 1 of %u allocations:\n",
+            ucs_memtrack_context.sample_interval);
+    for (i = 0; i < ucs_min(num_callsites, UCS_MEMTRACK_MAX_CALLSITES); ++i) {
+        callsite = all_callsites[i];
+        fprintf(output_stream, "#%-2u size: ~%lu count: ~%lu\n", i,
+                (unsigned long)callsite->size * ucs_memtrack_context.sample_interval,
+                (unsigned long)callsite->count * ucs_memtrack_context.sample_interval);
+
+        symbols = backtrace_symbols(callsite->frames, callsite->num_frames);
+        for (j = 0; j < callsite->num_frames; ++j) {
+            fprintf(output_stream, "    %s\n",
+                    (symbols != NULL) ? symbols[j] : "?");
+        }
+        free(symbols);
+    }
+
+    free(all_callsites);
+}
+
 static void ucs_memtrack_dump_internal(FILE* output_stream)
 {
     ucs_memtrack_entry_t *entry, **all_entries;
@@ -267,6 +507,10 @@ static void ucs_memtrack_dump_internal(FILE* output_stream)
     qsort(all_entries, num_entries, sizeof(*all_entries), ucs_memtrack_cmp_entries);
 
     /* print title */
+    if (ucs_memtrack_context.sample_interval > 1) {
+        fprintf(output_stream, "sampled 1 of %u allocations\n",
+                ucs_memtrack_context.sample_interval);
+    }
     fprintf(output_stream, "%31s current / peak  %16s current / peak\n", "", "");
     fprintf(output_stream, UCS_MEMTRACK_FORMAT_STRING, "TOTAL",
             ucs_memtrack_context.total.size, ucs_memtrack_context.total.peak_size,
@@ -278,6 +522,10 @@ static void ucs_memtrack_dump_internal(FILE* output_stream)
         fprintf(output_stream, UCS_MEMTRACK_FORMAT_STRING, entry->name,
                 entry->size, entry->peak_size, entry->count, entry->peak_count);
     }
+
+    if (ucs_memtrack_context.sample_interval > 1) {
+        ucs_memtrack_dump_callsites(output_stream);
+    }
 }
 
 void ucs_memtrack_dump(FILE* output_stream)
@@ -310,6 +558,7 @@ static void ucs_memtrack_generate_report()
 void ucs_memtrack_init()
 {
     ucs_status_t status;
+    int i;
 
     ucs_assert(ucs_memtrack_context.enabled == 0);
 
@@ -319,10 +568,15 @@ void ucs_memtrack_init()
         return;
     }
 
-    // TODO use ucs_memtrack_entry_reset
     ucs_memtrack_entry_reset(&ucs_memtrack_context.total);
-    kh_init_inplace(ucs_memtrack_ptr_hash, &ucs_memtrack_context.ptrs);
     kh_init_inplace(ucs_memtrack_entry_hash, &ucs_memtrack_context.entries);
+    kh_init_inplace(ucs_memtrack_callsite_hash, &ucs_memtrack_context.callsites);
+    for (i = 0; i < UCS_MEMTRACK_NUM_SHARDS; ++i) {
+        pthread_spin_init(&ucs_memtrack_context.shards[i].lock, 0);
+        kh_init_inplace(ucs_memtrack_ptr_hash,
+                        &ucs_memtrack_context.shards[i].ptrs);
+    }
+    ucs_memtrack_context.sample_interval = ucs_max(ucs_global_opts.memtrack_sample, 1);
 
     status = UCS_STATS_NODE_ALLOC(&ucs_memtrack_context.stats,
                                   &ucs_memtrack_stats_class,
@@ -337,7 +591,9 @@ void ucs_memtrack_init()
 
 void ucs_memtrack_cleanup()
 {
+    ucs_memtrack_callsite_t *callsite;
     ucs_memtrack_entry_t *entry;
+    int i;
 
     if (!ucs_memtrack_context.enabled) {
         return;
@@ -356,9 +612,21 @@ void ucs_memtrack_cleanup()
          free(entry);
     });
 
+    kh_foreach_value(&ucs_memtrack_context.callsites, callsite, {
+         free(callsite);
+    });
+
     /* destroy hash tables */
     kh_destroy_inplace(ucs_memtrack_entry_hash, &ucs_memtrack_context.entries);
-    kh_destroy_inplace(ucs_memtrack_ptr_hash, &ucs_memtrack_context.ptrs);
+    kh_destroy_inplace(ucs_memtrack_callsite_hash, &ucs_memtrack_context.callsites);
+    for (i = 0; i < UCS_MEMTRACK_NUM_SHARDS; ++i) {
+        kh_destroy_inplace(ucs_memtrack_ptr_hash,
+                           &ucs_memtrack_context.shards[i].ptrs);
+        pthread_spin_destroy(&ucs_memtrack_context.shards[i].lock);
+    }
+
+    /* invalidate per-thread entry caches */
+    ++ucs_memtrack_context.generation;
 
     pthread_mutex_unlock(&ucs_memtrack_context.lock);
 }
@@ -14,6 +14,7 @@
 #include <ucs/stats/stats.h>
 #include <ucs/sys/math.h>
 #include <ucs/sys/sys.h>
+#include <ucs/time/time.h>
 #include <ucm/api/ucm.h>
 
 #include "rcache.h"
@@ -47,6 +48,18 @@ typedef struct ucs_rcache_inv_entry {
 } ucs_rcache_inv_entry_t;
 
 
+/* Process-wide counters, collected regardless of ENABLE_STATS when enabled
+ * by the configuration */
+static ucs_rcache_counters_t ucs_rcache_global_counters = {0};
+
+#define ucs_rcache_counter_add(_name, _value) \
+    do { \
+        if (ucs_unlikely(ucs_global_opts.rcache_counters)) { \
+            ucs_atomic_add64(&ucs_rcache_global_counters._name, (_value)); \
+        } \
+    } while (0)
+
+
 #if ENABLE_STATS
 static ucs_stats_class_t ucs_rcache_stats_class = {
     .name = "rcache",
@@ -270,6 +283,7 @@ static void ucs_rcache_invalidate_range(ucs_rcache_t *rcache, ucs_pgt_addr_t sta
         /* all regions on the list are in the page table */
         ucs_rcache_region_invalidate(rcache, region, 1, 0);
         UCS_STATS_UPDATE_COUNTER(rcache->stats, UCS_RCACHE_UNMAP_INVALIDATES, 1);
+        ucs_rcache_counter_add(invalidations, 1);
     }
 }
 
@@ -461,6 +475,7 @@ ucs_rcache_create_region(ucs_rcache_t *rcache, void *address, size_t length,
 {
     ucs_rcache_region_t *region;
     ucs_pgt_addr_t start, end;
+    ucs_time_t reg_start_time;
     ucs_status_t status;
     int merged;
 
@@ -488,6 +503,7 @@ retry:
         ucs_rcache_region_validate_pfn(rcache, region);
         status = region->status;
         UCS_STATS_UPDATE_COUNTER(rcache->stats, UCS_RCACHE_HITS_SLOW, 1);
+        ucs_rcache_counter_add(hits, 1);
         goto out_set_region;
     } else if (status != UCS_OK) {
         /* Could not create a region because there are overlapping regions which
@@ -524,10 +540,13 @@ retry:
     region->prot     = prot;
     region->flags    = UCS_RCACHE_REGION_FLAG_PGTABLE;
     region->refcount = 1;
+    reg_start_time   = ucs_global_opts.rcache_counters ? ucs_get_time() : 0;
     region->status = status =
         UCS_PROFILE_NAMED_CALL("mem_reg", rcache->params.ops->mem_reg,
                                rcache->params.context, rcache, arg, region,
                                merged ? UCS_RCACHE_MEM_REG_HIDE_ERRORS : 0);
+    ucs_rcache_counter_add(regs, 1);
+    ucs_rcache_counter_add(reg_time, ucs_get_time() - reg_start_time);
     if (status != UCS_OK) {
         if (merged) {
             /* failure may be due to merge, because memory of the merged
@@ -585,6 +604,7 @@ ucs_status_t ucs_rcache_get(ucs_rcache_t *rcache, void *address, size_t length,
 
     pthread_rwlock_rdlock(&rcache->lock);
     UCS_STATS_UPDATE_COUNTER(rcache->stats, UCS_RCACHE_GETS, 1);
+    ucs_rcache_counter_add(gets, 1);
     if (ucs_queue_is_empty(&rcache->inv_q)) {
         pgt_region = UCS_PROFILE_CALL(ucs_pgtable_lookup, &rcache->pgtable,
                                       start);
@@ -597,6 +617,7 @@ ucs_status_t ucs_rcache_get(ucs_rcache_t *rcache, void *address, size_t length,
                 ucs_rcache_region_validate_pfn(rcache, region);
                 *region_p = region;
                 UCS_STATS_UPDATE_COUNTER(rcache->stats, UCS_RCACHE_HITS_FAST, 1);
+                ucs_rcache_counter_add(hits, 1);
                 pthread_rwlock_unlock(&rcache->lock);
                 return UCS_OK;
             }
@@ -613,6 +634,11 @@ ucs_status_t ucs_rcache_get(ucs_rcache_t *rcache, void *address, size_t length,
                             prot, arg, region_p);
 }
 
+void ucs_rcache_get_counters(ucs_rcache_counters_t *counters)
+{
+    *counters = ucs_rcache_global_counters;
+}
+
 void ucs_rcache_region_put(ucs_rcache_t *rcache, ucs_rcache_region_t *region)
 {
     ucs_rcache_region_put_internal(rcache, region, 1, 0);
@@ -116,6 +116,21 @@ struct ucs_rcache_params {
 };
 
 
+/*
+ * Registration cache counters, accumulated over all caches in the process.
+ * Collected only if UCX_RCACHE_COUNTERS is enabled.
+ */
+typedef struct ucs_rcache_counters {
+    uint64_t               gets;          /**< Number of region lookups */
+    uint64_t               hits;          /**< Lookups which found a registered region */
+    uint64_t               regs;          /**< Number of memory registrations */
+    uint64_t               reg_time;      /**< Total time spent in memory
+                                               registration, in ucs_time_t units */
+    uint64_t               invalidations; /**< Regions invalidated because their
+                                               memory was unmapped */
+} ucs_rcache_counters_t;
+
+
 struct ucs_rcache_region {
     ucs_pgt_region_t       super;    /**< Base class - page table region */
     ucs_list_link_t        list;     /**< List element */
@@ -189,4 +204,12 @@ void ucs_rcache_region_hold(ucs_rcache_t *rcache, ucs_rcache_region_t *region);
 void ucs_rcache_region_put(ucs_rcache_t *rcache, ucs_rcache_region_t *region);
 
 
+/**
+ * Get a snapshot of the process-wide registration cache counters.
+ *
+ * @param [out] counters    Filled with current counter values.
+ */
+void ucs_rcache_get_counters(ucs_rcache_counters_t *counters);
+
+
 #endif
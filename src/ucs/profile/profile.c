@@ -6,7 +6,9 @@
 
 #include "profile.h"
 
+#include <ucs/datastruct/list.h>
 #include <ucs/debug/log.h>
+#include <ucs/sys/math.h>
 #include <ucs/sys/string.h>
 #include <ucs/sys/sys.h>
 #include <ucs/time/time.h>
@@ -14,26 +16,42 @@
 
 
 /**
- * Profiling global context
+ * Per-thread profiling context
  */
-typedef struct ucs_profile_global_context {
-
-    ucs_profile_location_t   *locations;    /**< Array of all locations */
-    unsigned                 num_locations; /**< Number of valid locations */
-    unsigned                 max_locations; /**< Size of locations array */
-    pthread_mutex_t          mutex;         /**< Protects updating the locations array */
+typedef struct ucs_profile_thread_context {
+    int                           tid;          /**< System thread id */
+    ucs_time_t                    start_time;   /**< Thread context creation time */
+    ucs_list_link_t               list;         /**< Entry in the global threads list */
 
     struct {
-        ucs_profile_record_t *start, *end;  /**< Circular log buffer */
-        ucs_profile_record_t *current;      /**< Current log pointer */
-        int                  wraparound;    /**< Whether log was rotated */
+        ucs_profile_record_t      *start, *end; /**< Circular log buffer */
+        ucs_profile_record_t      *current;     /**< Current log pointer */
+        int                       wraparound;   /**< Whether log was rotated */
     } log;
 
     struct {
-        int                  stack_top;     /**< Index of stack top */
-        ucs_time_t           stack[UCS_PROFILE_STACK_MAX]; /**< Timestamps for each nested scope */
+        unsigned                  num_locations; /**< Size of locations array */
+        ucs_profile_thread_location_t *locations; /**< Per-location counters */
+        int                       stack_top;    /**< Index of stack top */
+        ucs_time_t                stack[UCS_PROFILE_STACK_MAX]; /**< Timestamps for each nested scope */
     } accum;
 
+} ucs_profile_thread_context_t;
+
+
+/**
+ * Profiling global context
+ */
+typedef struct ucs_profile_global_context {
+
+    ucs_profile_location_t   *locations;    /**< Array of all locations */
+    unsigned                 num_locations; /**< Number of valid locations */
+    unsigned                 max_locations; /**< Size of locations array */
+    pthread_mutex_t          mutex;         /**< Protects updating the locations
+                                                 array and the threads list */
+    ucs_list_link_t          thread_list;   /**< List of all thread contexts */
+    unsigned                 generation;    /**< Incremented on every cleanup, to
+                                                 invalidate thread-local pointers */
 } ucs_profile_global_context_t;
 
 
@@ -45,16 +63,20 @@ const char *ucs_profile_mode_names[] = {
 
 ucs_profile_global_context_t ucs_profile_ctx = {
     .locations       = NULL,
-    .log.start       = NULL,
-    .log.end         = NULL,
-    .log.current     = NULL,
-    .log.wraparound  = 0,
-    .accum.stack_top = -1,
     .num_locations   = 0,
     .max_locations   = 0,
-    .mutex           = PTHREAD_MUTEX_INITIALIZER
+    .mutex           = PTHREAD_MUTEX_INITIALIZER,
+    .thread_list     = UCS_LIST_INITIALIZER(&ucs_profile_ctx.thread_list,
+                                            &ucs_profile_ctx.thread_list),
+    .generation      = 1
 };
 
+/* Thread-local profiling state, allocated on the first record of the thread */
+static __thread struct {
+    ucs_profile_thread_context_t *ctx;
+    unsigned                     generation;
+} ucs_profile_thread_local = {NULL, 0};
+
 static void ucs_profile_file_write_data(int fd, void *data, size_t size)
 {
     ssize_t written = write(fd, data, size);
@@ -72,8 +94,70 @@ static void ucs_profile_file_write_records(int fd, ucs_profile_record_t *begin,
     ucs_profile_file_write_data(fd, begin, (void*)end - (void*)begin);
 }
 
+/* Must be called with ucs_profile_ctx.mutex held */
+static void ucs_profile_file_write_thread(int fd,
+                                          ucs_profile_thread_context_t *thread_ctx)
+{
+    ucs_profile_thread_location_t empty_location = {0};
+    ucs_profile_thread_header_t thread_header;
+    unsigned i;
+
+    thread_header.tid         = thread_ctx->tid;
+    thread_header.start_time  = thread_ctx->start_time;
+    thread_header.end_time    = ucs_get_time();
+    thread_header.num_records = thread_ctx->log.wraparound ?
+                    (thread_ctx->log.end     - thread_ctx->log.start) :
+                    (thread_ctx->log.current - thread_ctx->log.start);
+    ucs_profile_file_write_data(fd, &thread_header, sizeof(thread_header));
+
+    /* write per-thread location counters; the thread may have not yet seen
+     * locations which were added by other threads */
+    if (ucs_global_opts.profile_mode & UCS_BIT(UCS_PROFILE_MODE_ACCUM)) {
+        ucs_profile_file_write_data(fd, thread_ctx->accum.locations,
+                                    sizeof(*thread_ctx->accum.locations) *
+                                    ucs_min(thread_ctx->accum.num_locations,
+                                            ucs_profile_ctx.num_locations));
+        for (i = thread_ctx->accum.num_locations;
+             i < ucs_profile_ctx.num_locations; ++i) {
+            ucs_profile_file_write_data(fd, &empty_location,
+                                        sizeof(empty_location));
+        }
+    }
+
+    /* write records */
+    if (ucs_global_opts.profile_mode & UCS_BIT(UCS_PROFILE_MODE_LOG)) {
+        if (thread_ctx->log.wraparound > 0) {
+            ucs_profile_file_write_records(fd, thread_ctx->log.current,
+                                           thread_ctx->log.end);
+        }
+        ucs_profile_file_write_records(fd, thread_ctx->log.start,
+                                       thread_ctx->log.current);
+    }
+}
+
+/* Must be called with ucs_profile_ctx.mutex held */
+static void ucs_profile_sum_locations()
+{
+    ucs_profile_thread_context_t *thread_ctx;
+    ucs_profile_location_t *loc;
+    unsigned i;
+
+    for (i = 0; i < ucs_profile_ctx.num_locations; ++i) {
+        loc             = &ucs_profile_ctx.locations[i];
+        loc->total_time = 0;
+        loc->count      = 0;
+        ucs_list_for_each(thread_ctx, &ucs_profile_ctx.thread_list, list) {
+            if (i < thread_ctx->accum.num_locations) {
+                loc->total_time += thread_ctx->accum.locations[i].total_time;
+                loc->count      += thread_ctx->accum.locations[i].count;
+            }
+        }
+    }
+}
+
 static void ucs_profile_write()
 {
+    ucs_profile_thread_context_t *thread_ctx;
     ucs_profile_header_t header;
     char fullpath[1024] = {0};
     char filename[1024] = {0};
@@ -93,31 +177,32 @@ static void ucs_profile_write()
         return;
     }
 
+    pthread_mutex_lock(&ucs_profile_ctx.mutex);
+
     /* write header */
     memset(&header, 0, sizeof(header));
     ucs_read_file(header.cmdline, sizeof(header.cmdline), 1, "/proc/self/cmdline");
     strncpy(header.hostname, ucs_get_host_name(), sizeof(header.hostname) - 1);
-    header.pid = getpid();
-    header.mode = ucs_global_opts.profile_mode;
+    header.version       = UCS_PROFILE_FILE_VERSION;
+    header.pid           = getpid();
+    header.mode          = ucs_global_opts.profile_mode;
     header.num_locations = ucs_profile_ctx.num_locations;
-    header.num_records   = ucs_profile_ctx.log.wraparound ?
-                    (ucs_profile_ctx.log.end     - ucs_profile_ctx.log.start) :
-                    (ucs_profile_ctx.log.current - ucs_profile_ctx.log.start);
+    header.num_threads   = ucs_list_length(&ucs_profile_ctx.thread_list);
     header.one_second    = ucs_time_from_sec(1.0);
     ucs_profile_file_write_data(fd, &header, sizeof(header));
 
     /* write locations */
+    ucs_profile_sum_locations();
     ucs_profile_file_write_data(fd, ucs_profile_ctx.locations,
                                 sizeof(*ucs_profile_ctx.locations) *
                                 ucs_profile_ctx.num_locations);
 
-    /* write records */
-    if (ucs_profile_ctx.log.wraparound > 0) {
-        ucs_profile_file_write_records(fd, ucs_profile_ctx.log.current,
-                                       ucs_profile_ctx.log.end);
+    /* write threads */
+    ucs_list_for_each(thread_ctx, &ucs_profile_ctx.thread_list, list) {
+        ucs_profile_file_write_thread(fd, thread_ctx);
     }
-    ucs_profile_file_write_records(fd, ucs_profile_ctx.log.start,
-                                   ucs_profile_ctx.log.current);
+
+    pthread_mutex_unlock(&ucs_profile_ctx.mutex);
 
     close(fd);
 }
@@ -208,14 +293,109 @@ out_unlock:
     pthread_mutex_unlock(&ucs_profile_ctx.mutex);
 }
 
+static ucs_profile_thread_context_t *ucs_profile_thread_context_create()
+{
+    ucs_profile_thread_context_t *thread_ctx;
+    size_t num_records;
+
+    thread_ctx = ucs_calloc(1, sizeof(*thread_ctx), "profile_thread_ctx");
+    if (thread_ctx == NULL) {
+        ucs_warn("failed to allocate profiling thread context");
+        return NULL;
+    }
+
+    thread_ctx->tid             = ucs_get_tid();
+    thread_ctx->start_time      = ucs_get_time();
+    thread_ctx->accum.stack_top = -1;
+
+    if (ucs_global_opts.profile_mode & UCS_BIT(UCS_PROFILE_MODE_LOG)) {
+        num_records = ucs_global_opts.profile_log_size /
+                      sizeof(ucs_profile_record_t);
+        thread_ctx->log.start = ucs_calloc(num_records,
+                                           sizeof(ucs_profile_record_t),
+                                           "profile_thread_log");
+        if (thread_ctx->log.start == NULL) {
+            ucs_warn("failed to allocate profiling log for thread %d",
+                     thread_ctx->tid);
+            ucs_free(thread_ctx);
+            return NULL;
+        }
+
+        thread_ctx->log.end     = thread_ctx->log.start + num_records;
+        thread_ctx->log.current = thread_ctx->log.start;
+    }
+
+    pthread_mutex_lock(&ucs_profile_ctx.mutex);
+    ucs_list_add_tail(&ucs_profile_ctx.thread_list, &thread_ctx->list);
+    pthread_mutex_unlock(&ucs_profile_ctx.mutex);
+
+    ucs_debug("created profiling context for thread %d", thread_ctx->tid);
+    return thread_ctx;
+}
+
+static void ucs_profile_thread_context_destroy(ucs_profile_thread_context_t *thread_ctx)
+{
+    ucs_list_del(&thread_ctx->list);
+    ucs_free(thread_ctx->accum.locations);
+    ucs_free(thread_ctx->log.start);
+    ucs_free(thread_ctx);
+}
+
+static UCS_F_ALWAYS_INLINE ucs_profile_thread_context_t *
+ucs_profile_thread_context_get()
+{
+    if (ucs_likely(ucs_profile_thread_local.generation ==
+                   ucs_profile_ctx.generation)) {
+        return ucs_profile_thread_local.ctx;
+    }
+
+    /* First record of this thread since profiling was initialized */
+    ucs_profile_thread_local.ctx        = ucs_profile_thread_context_create();
+    ucs_profile_thread_local.generation = ucs_profile_ctx.generation;
+    return ucs_profile_thread_local.ctx;
+}
+
+/*
+ * Get the accumulated counters of a location for the current thread, and
+ * expand the array if the location was added after the last access.
+ */
+static UCS_F_ALWAYS_INLINE ucs_profile_thread_location_t *
+ucs_profile_thread_location_get(ucs_profile_thread_context_t *thread_ctx,
+                                int loc_id)
+{
+    ucs_profile_thread_location_t *locations;
+    unsigned num_locations;
+
+    if (ucs_unlikely(loc_id > thread_ctx->accum.num_locations)) {
+        pthread_mutex_lock(&ucs_profile_ctx.mutex);
+        num_locations = ucs_profile_ctx.max_locations;
+        locations     = ucs_realloc(thread_ctx->accum.locations,
+                                    sizeof(*locations) * num_locations,
+                                    "profile_thread_locations");
+        if (locations != NULL) {
+            memset(locations + thread_ctx->accum.num_locations, 0,
+                   sizeof(*locations) *
+                   (num_locations - thread_ctx->accum.num_locations));
+            thread_ctx->accum.locations     = locations;
+            thread_ctx->accum.num_locations = num_locations;
+        }
+        pthread_mutex_unlock(&ucs_profile_ctx.mutex);
+
+        if (locations == NULL) {
+            return NULL;
+        }
+    }
+
+    return &thread_ctx->accum.locations[loc_id - 1];
+}
+
 void ucs_profile_record(ucs_profile_type_t type, const char *name,
                         uint32_t param32, uint64_t param64, const char *file,
                         int line, const char *function, volatile int *loc_id_p)
 {
-    extern ucs_profile_global_context_t ucs_profile_ctx;
-    ucs_profile_global_context_t *ctx = &ucs_profile_ctx;
-    ucs_profile_record_t   *rec;
-    ucs_profile_location_t *loc;
+    ucs_profile_thread_context_t  *thread_ctx;
+    ucs_profile_thread_location_t *loc;
+    ucs_profile_record_t          *rec;
     ucs_time_t current_time;
     int loc_id;
 
@@ -231,16 +411,26 @@ void ucs_profile_record(ucs_profile_type_t type, const char *name,
     ucs_assert(*loc_id_p                    != 0);
     ucs_assert(ucs_global_opts.profile_mode != 0);
 
+    thread_ctx = ucs_profile_thread_context_get();
+    if (ucs_unlikely(thread_ctx == NULL)) {
+        return;
+    }
+
     current_time = ucs_get_time();
     if (ucs_global_opts.profile_mode & UCS_BIT(UCS_PROFILE_MODE_ACCUM)) {
-        loc = &ctx->locations[loc_id - 1];
+        loc = ucs_profile_thread_location_get(thread_ctx, loc_id);
+        if (ucs_unlikely(loc == NULL)) {
+            return;
+        }
+
         switch (type) {
         case UCS_PROFILE_TYPE_SCOPE_BEGIN:
-            ctx->accum.stack[++ctx->accum.stack_top] = current_time;
+            thread_ctx->accum.stack[++thread_ctx->accum.stack_top] = current_time;
             break;
         case UCS_PROFILE_TYPE_SCOPE_END:
-            loc->total_time += current_time - ctx->accum.stack[ctx->accum.stack_top];
-            --ctx->accum.stack_top;
+            loc->total_time += current_time -
+                               thread_ctx->accum.stack[thread_ctx->accum.stack_top];
+            --thread_ctx->accum.stack_top;
             break;
         default:
             break;
@@ -249,14 +439,14 @@ void ucs_profile_record(ucs_profile_type_t type, const char *name,
     }
 
     if (ucs_global_opts.profile_mode & UCS_BIT(UCS_PROFILE_MODE_LOG)) {
-        rec              = ctx->log.current;
+        rec              = thread_ctx->log.current;
         rec->timestamp   = current_time;
         rec->param64     = param64;
         rec->param32     = param32;
         rec->location    = loc_id - 1;
-        if (++ctx->log.current >= ctx->log.end) {
-            ctx->log.current    = ctx->log.start;
-            ctx->log.wraparound = 1;
+        if (++thread_ctx->log.current >= thread_ctx->log.end) {
+            thread_ctx->log.current    = thread_ctx->log.start;
+            thread_ctx->log.wraparound = 1;
         }
     }
 }
@@ -264,8 +454,6 @@ void ucs_profile_record(ucs_profile_type_t type, const char *name,
 
 void ucs_profile_global_init()
 {
-    size_t num_records;
-
     if (!ucs_global_opts.profile_mode) {
         goto off;
     }
@@ -275,22 +463,10 @@ void ucs_profile_global_init()
         goto disable;
     }
 
-    if (ucs_global_opts.profile_mode & UCS_BIT(UCS_PROFILE_MODE_LOG)) {
-        num_records = ucs_global_opts.profile_log_size / sizeof(ucs_profile_record_t);
-        ucs_profile_ctx.log.start = ucs_calloc(num_records,
-                                               sizeof(ucs_profile_record_t),
-                                               "profile_log");
-        if (ucs_profile_ctx.log.start == NULL) {
-            ucs_warn("failed to allocate profiling log");
-            goto disable;
-        }
-
-        ucs_profile_ctx.log.end     = ucs_profile_ctx.log.start + num_records;
-        ucs_profile_ctx.log.current = ucs_profile_ctx.log.start;
-    }
-
-    if (ucs_global_opts.profile_mode & UCS_BIT(UCS_PROFILE_MODE_ACCUM)) {
-        ucs_profile_ctx.accum.stack_top = -1;
+    if ((ucs_global_opts.profile_mode & UCS_BIT(UCS_PROFILE_MODE_LOG)) &&
+        (ucs_global_opts.profile_log_size < sizeof(ucs_profile_record_t))) {
+        ucs_warn("profiling log size is too small, profiling is disabled");
+        goto disable;
     }
 
     ucs_info("profiling is enabled");
@@ -306,7 +482,6 @@ static void ucs_profile_reset_locations()
 {
     ucs_profile_location_t *loc;
 
-    pthread_mutex_lock(&ucs_profile_ctx.mutex);
     for (loc = ucs_profile_ctx.locations;
          loc < ucs_profile_ctx.locations + ucs_profile_ctx.num_locations;
          ++loc)
@@ -318,36 +493,36 @@ static void ucs_profile_reset_locations()
     ucs_profile_ctx.max_locations = 0;
     ucs_free(ucs_profile_ctx.locations);
     ucs_profile_ctx.locations = NULL;
-    pthread_mutex_unlock(&ucs_profile_ctx.mutex);
 }
 
 void ucs_profile_global_cleanup()
 {
+    ucs_profile_thread_context_t *thread_ctx, *tmp;
+
     ucs_profile_write();
-    ucs_free(ucs_profile_ctx.log.start);
-    ucs_profile_ctx.log.start      = NULL;
-    ucs_profile_ctx.log.end        = NULL;
-    ucs_profile_ctx.log.current    = NULL;
-    ucs_profile_ctx.log.wraparound = 0;
+
+    pthread_mutex_lock(&ucs_profile_ctx.mutex);
+    ucs_list_for_each_safe(thread_ctx, tmp, &ucs_profile_ctx.thread_list, list) {
+        ucs_profile_thread_context_destroy(thread_ctx);
+    }
+    ++ucs_profile_ctx.generation;
     ucs_profile_reset_locations();
+    pthread_mutex_unlock(&ucs_profile_ctx.mutex);
 }
 
 void ucs_profile_dump()
 {
-    ucs_profile_location_t *loc;
+    ucs_profile_thread_context_t *thread_ctx;
 
     ucs_profile_write();
 
-    for (loc = ucs_profile_ctx.locations;
-         loc < ucs_profile_ctx.locations + ucs_profile_ctx.num_locations;
-         ++loc)
-    {
-        loc->count      = 0;
-        loc->total_time = 0;
-    }
-
-    if (ucs_global_opts.profile_mode & UCS_BIT(UCS_PROFILE_MODE_LOG)) {
-        ucs_profile_ctx.log.wraparound = 0;
-        ucs_profile_ctx.log.current    = ucs_profile_ctx.log.start;
+    pthread_mutex_lock(&ucs_profile_ctx.mutex);
+    ucs_list_for_each(thread_ctx, &ucs_profile_ctx.thread_list, list) {
+        memset(thread_ctx->accum.locations, 0,
+               sizeof(*thread_ctx->accum.locations) *
+               thread_ctx->accum.num_locations);
+        thread_ctx->log.wraparound = 0;
+        thread_ctx->log.current    = thread_ctx->log.start;
     }
+    pthread_mutex_unlock(&ucs_profile_ctx.mutex);
 }
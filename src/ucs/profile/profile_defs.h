@@ -14,7 +14,8 @@
 
 BEGIN_C_DECLS
 
-#define UCS_PROFILE_STACK_MAX 64
+#define UCS_PROFILE_STACK_MAX      64
+#define UCS_PROFILE_FILE_VERSION   2u
 
 
 /**
@@ -43,18 +44,47 @@ typedef enum {
 
 /**
  * Profile output file header
+ *
+ * The file layout is:
+ *  - ucs_profile_header_t
+ *  - ucs_profile_location_t[num_locations], with totals of all threads
+ *  - for each one of num_threads threads:
+ *     - ucs_profile_thread_header_t
+ *     - ucs_profile_thread_location_t[num_locations], if accum mode is enabled
+ *     - ucs_profile_record_t[num_records], if log mode is enabled
  */
 typedef struct ucs_profile_header {
+    uint32_t                 version;       /**< File format version */
     char                     cmdline[1024]; /**< Command line */
     char                     hostname[40];  /**< Host name */
     uint32_t                 pid;           /**< Process ID */
     uint32_t                 mode;          /**< Profiling mode */
     uint32_t                 num_locations; /**< Number of locations in the file */
-    uint64_t                 num_records;   /**< Number of records in the file */
+    uint32_t                 num_threads;   /**< Number of threads in the file */
     uint64_t                 one_second;    /**< How much time is one second on the sampled machine */
 } UCS_S_PACKED ucs_profile_header_t;
 
 
+/**
+ * Profile output file per-thread header
+ */
+typedef struct ucs_profile_thread_header {
+    uint32_t                 tid;           /**< System thread id */
+    uint64_t                 start_time;    /**< Time of the first event of the thread */
+    uint64_t                 end_time;      /**< Time the data was written */
+    uint64_t                 num_records;   /**< Number of records of the thread */
+} UCS_S_PACKED ucs_profile_thread_header_t;
+
+
+/**
+ * Profile output file per-thread location counters
+ */
+typedef struct ucs_profile_thread_location {
+    uint64_t                 total_time;    /**< Total interval from previous location */
+    size_t                   count;         /**< Number of times we've hit this location */
+} UCS_S_PACKED ucs_profile_thread_location_t;
+
+
 /**
  * Profile output file sample record
  */
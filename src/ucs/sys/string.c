@@ -13,6 +13,7 @@
 #include "sys.h"
 
 #include <string.h>
+#include <ctype.h>
 #include <stdio.h>
 #include <time.h>
 
@@ -163,4 +164,22 @@ char* ucs_strncpy_safe(char *dst, const char *src, size_t len)
     return dst;
 }
 
+char* ucs_strtrim(char *str)
+{
+    char *start, *end;
+
+    start = str;
+    while (isspace((unsigned char)*start)) {
+        ++start;
+    }
+
+    end = start + strlen(start);
+    while ((end > start) && isspace((unsigned char)*(end - 1))) {
+        --end;
+    }
+    *end = '\0';
+
+    return start;
+}
+
 
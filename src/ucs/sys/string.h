@@ -98,6 +98,15 @@ const char* ucs_sockaddr_str(const struct sockaddr *sock_addr, char *ip_str, siz
  */
 char* ucs_strncpy_safe(char *dst, const char *src, size_t len);
 
+/**
+ * Remove leading and trailing whitespace from a string, in place.
+ *
+ * @param str String to trim
+ *
+ * @return address of the first non-whitespace character in str
+ */
+char* ucs_strtrim(char *str);
+
 END_C_DECLS
 
 #endif
@@ -33,6 +33,7 @@
 
 /* Default huge page size is 2 MBytes */
 #define UCS_DEFAULT_MEM_FREE       640000
+#define UCS_DEFAULT_LLC_SIZE       (8 * UCS_MBYTE)
 #define UCS_PROCESS_MAPS_FILE      "/proc/self/maps"
 
 
@@ -478,6 +479,29 @@ size_t ucs_get_phys_mem_size()
     return phys_mem_size;
 }
 
+size_t ucs_get_llc_size()
+{
+    static size_t llc_size = 0;
+    long cache_size        = -1;
+
+    if (llc_size == 0) {
+#if defined(_SC_LEVEL3_CACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE)
+        cache_size = ucs_sysconf(_SC_LEVEL3_CACHE_SIZE);
+        if (cache_size <= 0) {
+            cache_size = ucs_sysconf(_SC_LEVEL2_CACHE_SIZE);
+        }
+#endif
+        if (cache_size <= 0) {
+            llc_size = UCS_DEFAULT_LLC_SIZE;
+            ucs_debug("cannot determine last-level cache size, using default: %zu",
+                      llc_size);
+        } else {
+            llc_size = cache_size;
+        }
+    }
+    return llc_size;
+}
+
 #define UCS_SYS_THP_ENABLED_FILE "/sys/kernel/mm/transparent_hugepage/enabled"
 int ucs_is_thp_enabled()
 {
@@ -181,6 +181,13 @@ size_t ucs_get_memfree_size();
 size_t ucs_get_phys_mem_size();
 
 
+/**
+ * @return Size of the last-level CPU cache, or a default value if it cannot be
+ *         detected.
+ */
+size_t ucs_get_llc_size();
+
+
 /**
  * Allocate shared memory using SystemV API.
  *
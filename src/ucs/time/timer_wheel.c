@@ -6,12 +6,33 @@
 
 #include <ucs/time/timer_wheel.h>
 
+#include <ucs/arch/bitops.h>
 #include <ucs/debug/assert.h>
 #include <ucs/debug/log.h>
 #include <ucs/debug/memtrack.h>
 #include <ucs/sys/math.h>
 
 
+#define UCS_TWHEEL_MAX_TICKS \
+    (UCS_BIT(UCS_TWHEEL_LEVEL_BITS * UCS_TWHEEL_NUM_LEVELS) - 1)
+
+
+static inline unsigned ucs_twheel_level_shift(unsigned level)
+{
+    return level * UCS_TWHEEL_LEVEL_BITS;
+}
+
+static inline unsigned ucs_twheel_level_index(uint64_t tick, unsigned level)
+{
+    return (tick >> ucs_twheel_level_shift(level)) & (UCS_TWHEEL_LEVEL_SLOTS - 1);
+}
+
+static inline ucs_list_link_t *ucs_twheel_slot(ucs_twheel_t *t, unsigned level,
+                                               unsigned index)
+{
+    return &t->wheel[level * UCS_TWHEEL_LEVEL_SLOTS + index];
+}
+
 ucs_status_t ucs_twheel_init(ucs_twheel_t *twheel, ucs_time_t resolution,
                              ucs_time_t current_time)
 {
@@ -19,15 +40,23 @@ ucs_status_t ucs_twheel_init(ucs_twheel_t *twheel, ucs_time_t resolution,
 
     twheel->res         = ucs_roundup_pow2(resolution);
     twheel->res_order   = (unsigned) ucs_log2(twheel->res);
-    twheel->num_slots   = 1024;
+    twheel->num_slots   = UCS_TWHEEL_LEVEL_SLOTS;
     twheel->current     = 0;
     twheel->now         = current_time;
-    twheel->wheel       = ucs_malloc(sizeof(*twheel->wheel) * twheel->num_slots,
+    twheel->wheel       = ucs_malloc(sizeof(*twheel->wheel) *
+                                     UCS_TWHEEL_LEVEL_SLOTS * UCS_TWHEEL_NUM_LEVELS,
                                      "twheel");
+    if (twheel->wheel == NULL) {
+        ucs_error("failed to allocate timer wheel");
+        return UCS_ERR_NO_MEMORY;
+    }
 
-    for (i = 0; i < twheel->num_slots; i++) {
+    for (i = 0; i < UCS_TWHEEL_LEVEL_SLOTS * UCS_TWHEEL_NUM_LEVELS; i++) {
         ucs_list_head_init(&twheel->wheel[i]);
     }
+    for (i = 0; i < UCS_TWHEEL_NUM_LEVELS; i++) {
+        twheel->slot_map[i] = 0;
+    }
 
     ucs_debug("high res timer created log=%d resolution=%lf usec wanted: %lf usec",
               twheel->res_order, ucs_time_to_usec(twheel->res), ucs_time_to_usec(resolution));
@@ -46,50 +75,150 @@ ucs_status_t ucs_wtimer_init(ucs_wtimer_t *t, ucs_twheel_callback_t cb)
     return UCS_OK;
 }
 
+/*
+ * Put the timer on the lowest level whose range covers its expiration time.
+ * The slot is selected by the bits of the expiration tick, so it is reached
+ * exactly when the lower levels wrap around at that tick.
+ */
+static void ucs_twheel_insert(ucs_twheel_t *t, ucs_wtimer_t *timer)
+{
+    uint64_t delta = timer->expires - t->current;
+    unsigned level, index;
+
+    if ((int64_t)delta < 0) {
+        /* Expired while cascading, run in the current tick */
+        timer->expires = t->current;
+        delta          = 0;
+    }
+
+    level = 0;
+    while ((level < UCS_TWHEEL_NUM_LEVELS - 1) &&
+           (delta >= UCS_BIT(ucs_twheel_level_shift(level + 1)))) {
+        ++level;
+    }
+
+    index = ucs_twheel_level_index(timer->expires, level);
+    ucs_list_add_tail(ucs_twheel_slot(t, level, index), &timer->list);
+    t->slot_map[level] |= UCS_BIT(index);
+}
+
 void __ucs_wtimer_add(ucs_twheel_t *t, ucs_wtimer_t *timer, ucs_time_t delta)
 {
-    uint64_t slot;
+    uint64_t ticks;
 
     timer->is_active = 1;
-    slot = delta>>t->res_order;
-    if (ucs_unlikely(slot == 0)) {
+    ticks = delta>>t->res_order;
+    if (ucs_unlikely(ticks == 0)) {
         /* nothing really wrong with adding timer to the current slot. However
          * we want to guard against the case we spend to much time in hi res
          * timer processing */
         ucs_fatal("Timer resolution is too low. Min resolution %lf usec, wanted %lf usec",
                 ucs_time_to_usec(t->res), ucs_time_to_usec(delta));
     }
-    ucs_assert(slot > 0);
+    ucs_assert(ticks > 0);
+
+    if (ucs_unlikely(ticks > UCS_TWHEEL_MAX_TICKS)) {
+        ticks = UCS_TWHEEL_MAX_TICKS;
+    }
+
+    timer->expires = t->current + ticks;
+    ucs_twheel_insert(t, timer);
+}
 
-    if (ucs_unlikely(slot >= t->num_slots)) {
-        slot = t->num_slots - 1;
+/* Move the timers of a slot to the lower levels */
+static void ucs_twheel_cascade(ucs_twheel_t *t, unsigned level, unsigned index)
+{
+    ucs_list_link_t *slot = ucs_twheel_slot(t, level, index);
+    ucs_list_link_t timers;
+    ucs_wtimer_t *timer;
+
+    t->slot_map[level] &= ~UCS_BIT(index);
+    if (ucs_list_is_empty(slot)) {
+        return;
     }
 
-    slot = (t->current + slot) % t->num_slots;
-    ucs_assert(slot != t->current);
+    ucs_list_head_init(&timers);
+    ucs_list_splice_tail(&timers, slot);
+    ucs_list_head_init(slot);
 
-    ucs_list_add_tail(&t->wheel[slot], &timer->list);
+    while (!ucs_list_is_empty(&timers)) {
+        timer = ucs_list_extract_head(&timers, ucs_wtimer_t, list);
+        ucs_twheel_insert(t, timer);
+    }
 }
 
-void __ucs_twheel_sweep(ucs_twheel_t *t, ucs_time_t current_time)
+/* Process the current tick: cascade the upper levels and dispatch timers */
+static void ucs_twheel_process_tick(ucs_twheel_t *t)
 {
+    unsigned level, index;
+    ucs_list_link_t *slot;
     ucs_wtimer_t *timer;
-    uint64_t slot;
 
-    slot   = (current_time - t->now) >> t->res_order;
-    t->now = current_time;
+    for (level = 1; level < UCS_TWHEEL_NUM_LEVELS; ++level) {
+        if (ucs_twheel_level_index(t->current, level - 1) != 0) {
+            break;
+        }
+        ucs_twheel_cascade(t, level, ucs_twheel_level_index(t->current, level));
+    }
 
-    if (ucs_unlikely(slot >= t->num_slots)) {
-        slot = t->num_slots - 1;
+    index = ucs_twheel_level_index(t->current, 0);
+    slot  = ucs_twheel_slot(t, 0, index);
+    while (!ucs_list_is_empty(slot)) {
+        timer = ucs_list_extract_head(slot, ucs_wtimer_t, list);
+        timer->is_active = 0;
+        timer->cb(timer);
     }
+    t->slot_map[0] &= ~UCS_BIT(index);
+}
+
+/*
+ * Find the next tick after the current one which has to be processed: a
+ * level-0 slot which may have timers, or a tick when an upper level slot which
+ * may have timers is cascaded. Returns UINT64_MAX if the wheel is empty.
+ */
+static uint64_t ucs_twheel_next_tick(ucs_twheel_t *t)
+{
+    unsigned level, shift, index;
+    uint64_t mask, base;
 
-    slot = (t->current + slot) % t->num_slots;
+    for (level = 0; level < UCS_TWHEEL_NUM_LEVELS; ++level) {
+        if (t->slot_map[level] == 0) {
+            continue;
+        }
 
-    for (; t->current != slot; t->current = (t->current+1) % t->num_slots) {
-        while (!ucs_list_is_empty(&t->wheel[t->current])) {
-            timer = ucs_list_extract_head(&t->wheel[t->current], ucs_wtimer_t, list);
-            timer->is_active = 0;
-            timer->cb(timer);
+        shift = ucs_twheel_level_shift(level);
+        index = ucs_twheel_level_index(t->current, level);
+        base  = (t->current >> (shift + UCS_TWHEEL_LEVEL_BITS)) <<
+                UCS_TWHEEL_LEVEL_BITS;
+        mask  = t->slot_map[level] & (-2ull << index);
+        if (mask != 0) {
+            /* Next slot in the current revolution of this level */
+            return (base + ucs_ffs64(mask)) << shift;
         }
+
+        /* Slots of the next revolution; stop when this level wraps around */
+        return (base + UCS_TWHEEL_LEVEL_SLOTS) << shift;
     }
+
+    return UINT64_MAX;
+}
+
+void __ucs_twheel_sweep(ucs_twheel_t *t, ucs_time_t current_time)
+{
+    uint64_t target, next;
+
+    target = t->current + ((current_time - t->now) >> t->res_order);
+    t->now = current_time;
+
+    for (;;) {
+        next = ucs_twheel_next_tick(t);
+        if (next > target) {
+            break;
+        }
+
+        t->current = next;
+        ucs_twheel_process_tick(t);
+    }
+
+    t->current = target;
 }
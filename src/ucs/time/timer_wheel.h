@@ -12,6 +12,13 @@
 #include <ucs/debug/log.h>
 
 
+/* Number of slots in every level of the wheel, as a power of 2 */
+#define UCS_TWHEEL_LEVEL_BITS   6
+#define UCS_TWHEEL_LEVEL_SLOTS  UCS_BIT(UCS_TWHEEL_LEVEL_BITS)
+/* Number of levels; the wheel range is UCS_TWHEEL_LEVEL_SLOTS^UCS_TWHEEL_NUM_LEVELS */
+#define UCS_TWHEEL_NUM_LEVELS   4
+
+
 /* Forward declarations */
 typedef struct ucs_wtimer       ucs_wtimer_t;
 typedef struct ucs_timer_wheel  ucs_twheel_t;
@@ -29,17 +36,26 @@ typedef void (*ucs_twheel_callback_t)(ucs_wtimer_t *self);
 struct ucs_wtimer {
     ucs_twheel_callback_t  cb;         /* User callback */
     ucs_list_link_t        list;       /* Link in the list of timers */
+    uint64_t               expires;    /* Tick of expiration */
     int                    is_active;
 };
 
 
+/**
+ * Hierarchical timer wheel. Level 0 holds the timers which expire in the next
+ * UCS_TWHEEL_LEVEL_SLOTS ticks, and every next level has slots which are
+ * UCS_TWHEEL_LEVEL_SLOTS times longer. Timers are moved to lower levels only
+ * when the wheel reaches their slot.
+ */
 struct ucs_timer_wheel {
     ucs_time_t             res;
     ucs_time_t             now;        /* when wheel was last updated */
-    uint64_t               current;
-    ucs_list_link_t        *wheel;
+    uint64_t               current;    /* Current tick */
+    ucs_list_link_t        *wheel;     /* Slots of all levels */
+    uint64_t               slot_map[UCS_TWHEEL_NUM_LEVELS]; /* Slots which may
+                                                               have timers */
     unsigned               res_order;
-    unsigned               num_slots;
+    unsigned               num_slots;  /* Number of slots in each level */
 };
 
 
@@ -47,7 +63,8 @@ struct ucs_timer_wheel {
  * Initialize the timer queue.
  *
  * @param twheel        Timer queue to initialize.
- * @param resolution    Timer resolution. Timer wheel range is from now to now + UCS_TWHEEL_NSLOTS * res
+ * @param resolution    Timer resolution. Timer wheel range is from now to
+ *                      now + UCS_TWHEEL_LEVEL_SLOTS^UCS_TWHEEL_NUM_LEVELS * res
  * @param current_time  Current time to initialize the timer with.
  */
 ucs_status_t ucs_twheel_init(ucs_twheel_t *twheel, ucs_time_t resolution,
@@ -77,6 +94,7 @@ ucs_status_t ucs_wtimer_init(ucs_wtimer_t *t, ucs_twheel_callback_t cb);
  * @param current_time  Current time to dispatch the timers for.
  *
  * @note Timers which expired between calls to this function will also be dispatched.
+ *       Empty slots are skipped, so the cost does not depend on the time passed.
  * @note There is no guarantee on the order of dispatching.
  */
 void __ucs_twheel_sweep(ucs_twheel_t *t, ucs_time_t current_time);
@@ -103,6 +121,7 @@ static inline ucs_time_t ucs_twheel_get_time(ucs_twheel_t *t)
  * @param delta      Invocation time
  *
  * NOTE: adding timer already in queue will do nothing
+ * NOTE: delta is limited by the wheel range
  */
 void __ucs_wtimer_add(ucs_twheel_t *t, ucs_wtimer_t *timer, ucs_time_t delta);
 static inline ucs_status_t ucs_wtimer_add(ucs_twheel_t *t, ucs_wtimer_t *timer,
@@ -119,7 +138,7 @@ static inline ucs_status_t ucs_wtimer_add(ucs_twheel_t *t, ucs_wtimer_t *timer,
 
 
 /**
- * Remove a timer.
+ * Remove a timer. This is O(1), the slot of the timer is released lazily.
  *
  * @param timer      timer to remove.
  */
@@ -214,6 +214,13 @@ typedef struct uct_iface_ops {
                                        const uct_device_addr_t *dev_addr,
                                        const uct_iface_addr_t *iface_addr);
 
+    /* interface - broadcast active message */
+
+    ssize_t      (*iface_am_bcast_bcopy)(uct_iface_h iface, uct_ep_h *eps,
+                                         unsigned num_eps, uint8_t id,
+                                         uct_pack_callback_t pack_cb, void *arg,
+                                         unsigned flags);
+
 } uct_iface_ops_t;
 
 
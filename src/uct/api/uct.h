@@ -181,6 +181,8 @@ typedef enum uct_atomic_op {
 #define UCT_IFACE_FLAG_AM_SHORT       UCS_BIT(0)  /**< Short active message */
 #define UCT_IFACE_FLAG_AM_BCOPY       UCS_BIT(1)  /**< Buffered active message */
 #define UCT_IFACE_FLAG_AM_ZCOPY       UCS_BIT(2)  /**< Zero-copy active message */
+#define UCT_IFACE_FLAG_AM_BCAST_BCOPY UCS_BIT(11) /**< Buffered active message to
+                                                       several endpoints */
 
 #define UCT_IFACE_FLAG_PENDING        UCS_BIT(3)  /**< Pending operations */
 
@@ -1936,6 +1938,39 @@ UCT_INLINE_API ucs_status_t uct_ep_am_zcopy(uct_ep_h ep, uint8_t id,
                                       flags, comp);
 }
 
+
+/**
+ * @ingroup UCT_AM
+ * @brief Send the same buffered active message to several endpoints.
+ *
+ * The message is packed once by @a pack_cb, and delivered to every endpoint in
+ * @a eps. The transport may share a single copy of the data between all the
+ * receivers, so the receive callback is invoked without
+ * @ref UCT_CB_PARAM_FLAG_DESC, and must not return @ref UCS_INPROGRESS.
+ * Requires @ref UCT_IFACE_FLAG_AM_BCAST_BCOPY, and the message size is limited
+ * by @ref uct_iface_attr::cap::am::max_bcopy.
+ *
+ * @param [in] iface    Interface which all the endpoints were created on.
+ * @param [in] eps      Array of destination endpoints.
+ * @param [in] num_eps  Number of endpoints in @a eps.
+ * @param [in] id       Active message id. Must be in range 0..UCT_AM_ID_MAX-1.
+ * @param [in] pack_cb  Callback which packs the message data.
+ * @param [in] arg      Argument for @a pack_cb.
+ * @param [in] flags    Active message flags, see @ref uct_msg_flags.
+ *
+ * @return Size of the packed data, or UCS_ERR_NO_RESOURCE if the message could
+ *         not be sent to one of the endpoints. In that case it is not sent to
+ *         any of them, and the operation may be retried after progress.
+ */
+UCT_INLINE_API ssize_t uct_iface_am_bcast_bcopy(uct_iface_h iface, uct_ep_h *eps,
+                                                unsigned num_eps, uint8_t id,
+                                                uct_pack_callback_t pack_cb,
+                                                void *arg, unsigned flags)
+{
+    return iface->ops.iface_am_bcast_bcopy(iface, eps, num_eps, id, pack_cb,
+                                           arg, flags);
+}
+
 /**
  * @ingroup UCT_AMO
  * @brief
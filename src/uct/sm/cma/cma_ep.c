@@ -12,6 +12,7 @@
 
 #include "cma_ep.h"
 #include <uct/sm/base/sm_iface.h>
+#include <ucs/arch/atomic.h>
 #include <ucs/debug/log.h>
 
 
@@ -41,85 +42,151 @@ UCS_CLASS_DEFINE_DELETE_FUNC(uct_cma_ep_t, uct_ep_t);
      ucs_trace_data(_fmt " to %"PRIx64"(%+ld)", ## __VA_ARGS__, (_remote_addr), \
                     (_rkey))
 
-static UCS_F_ALWAYS_INLINE
-ucs_status_t uct_cma_ep_common_zcopy(uct_ep_h tl_ep,
-                                     const uct_iov_t *iov,
-                                     size_t iovcnt,
-                                     uint64_t remote_addr,
-                                     uct_completion_t *comp,
-                                     ssize_t (*fn_p)(pid_t,
-                                                     const struct iovec *,
-                                                     unsigned long,
-                                                     const struct iovec *,
-                                                     unsigned long,
-                                                     unsigned long),
-                                     char *fn_name)
+/*
+ * Copy 'length' bytes from 'offset' in the local iov to or from the same
+ * offset at the remote address.
+ */
+static ucs_status_t uct_cma_ep_tx(pid_t remote_pid, uct_cma_ep_tx_func_t fn,
+                                  const char *fn_name, const struct iovec *iov,
+                                  size_t iovcnt, uint64_t remote_addr,
+                                  size_t offset, size_t length)
 {
-    ssize_t ret;
-    ssize_t delivered = 0;
-    size_t iov_it;
-    size_t iov_it_length;
-    size_t iov_slice_length;
-    size_t iov_slice_delivered;
-    size_t local_iov_it;
-    size_t length = 0;
     struct iovec local_iov[UCT_SM_MAX_IOV];
     struct iovec remote_iov;
-    uct_cma_ep_t *ep = ucs_derived_of(tl_ep, uct_cma_ep_t);
-
-    do {
-        iov_it_length = 0;
-        local_iov_it = 0;
-        for (iov_it = 0; iov_it < ucs_min(UCT_SM_MAX_IOV, iovcnt); ++iov_it) {
-            iov_slice_delivered = 0;
-
-            /* Get length of the particular iov element */
-            iov_slice_length = uct_iov_get_length(iov + iov_it);
+    size_t local_iovcnt, iov_it, iov_offset, remaining;
+    ssize_t ret;
 
-            /* Skip the iov element if no data */
-            if (!iov_slice_length) {
+    while (length > 0) {
+        /* Local iov elements which cover [offset, offset + length) */
+        local_iovcnt = 0;
+        iov_offset   = offset;
+        remaining    = length;
+        for (iov_it = 0; (iov_it < iovcnt) && (remaining > 0); ++iov_it) {
+            if (iov_offset >= iov[iov_it].iov_len) {
+                iov_offset -= iov[iov_it].iov_len;
                 continue;
             }
-            iov_it_length += iov_slice_length;
-
-            if (iov_it_length <= delivered) {
-                continue; /* Skip the iov element if transferred already */
-            } else {
-                /* Let's assume the iov element buffer can be delivered partially */
-                if ((iov_it_length - delivered) < iov_slice_length) {
-                    iov_slice_delivered = iov_slice_length - (iov_it_length - delivered);
-                }
-            }
 
-            local_iov[local_iov_it].iov_base = (void *)((char *)iov[iov_it].buffer +
-                                                        iov_slice_delivered);
-            local_iov[local_iov_it].iov_len  = iov_slice_length - iov_slice_delivered;
-            ++local_iov_it;
-        }
-        if (!delivered) {
-            length = iov_it_length; /* Keep total length of the iov buffers */
+            local_iov[local_iovcnt].iov_base = UCS_PTR_BYTE_OFFSET(
+                                                   iov[iov_it].iov_base,
+                                                   iov_offset);
+            local_iov[local_iovcnt].iov_len  = ucs_min(iov[iov_it].iov_len -
+                                                       iov_offset, remaining);
+            remaining  -= local_iov[local_iovcnt].iov_len;
+            iov_offset  = 0;
+            ++local_iovcnt;
         }
 
-        if(!length) {
-            return UCS_OK; /* Nothing to deliver */
-        }
+        remote_iov.iov_base = (void*)(remote_addr + offset);
+        remote_iov.iov_len  = length;
 
-        remote_iov.iov_base = (void *)(remote_addr + delivered);
-        remote_iov.iov_len  = length - delivered;
-
-        ret = fn_p(ep->remote_pid, local_iov, local_iov_it, &remote_iov, 1, 0);
+        ret = fn(remote_pid, local_iov, local_iovcnt, &remote_iov, 1, 0);
         if (ret < 0) {
             ucs_error("%s delivered %zu instead of %zu, error message %s",
-                      fn_name, delivered, length, strerror(errno));
+                      fn_name, offset, offset + length, strerror(errno));
             return UCS_ERR_IO_ERROR;
         }
 
-        delivered += ret;
-    } while (delivered < length);
+        offset += ret;
+        length -= ret;
+    }
 
     return UCS_OK;
 }
 
+void uct_cma_ep_op_copy_chunk(uct_cma_ep_op_t *op, size_t offset, size_t length)
+{
+    ucs_status_t status;
+
+    status = uct_cma_ep_tx(op->remote_pid, op->fn, op->fn_name, op->iov,
+                           op->iovcnt, op->remote_addr, offset, length);
+    if (status != UCS_OK) {
+        op->status = status;
+    }
+
+    /* The operation may be released once the last chunk is accounted */
+    ucs_atomic_add64(&op->completed, length);
+}
+
+ucs_status_t uct_cma_ep_post_op(uct_cma_iface_t *iface, pid_t remote_pid,
+                                uct_cma_ep_tx_func_t fn, const char *fn_name,
+                                const struct iovec *iov, size_t iovcnt,
+                                uint64_t remote_addr, size_t length,
+                                uct_completion_t *comp)
+{
+    uct_cma_ep_op_t *op;
+
+    op = ucs_malloc(sizeof(*op) + (iovcnt * sizeof(*iov)), "cma_op");
+    if (op == NULL) {
+        ucs_error("failed to allocate cma operation");
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    op->remote_pid  = remote_pid;
+    op->fn          = fn;
+    op->fn_name     = fn_name;
+    op->remote_addr = remote_addr;
+    op->length      = length;
+    op->posted      = 0;
+    op->completed   = 0;
+    op->status      = UCS_OK;
+    op->comp        = comp;
+    op->fence       = iface->fence;
+    op->iovcnt      = iovcnt;
+    if (iovcnt > 0) {
+        memcpy(op->iov, iov, iovcnt * sizeof(*iov));
+    }
+
+    iface->fence = 0;
+
+    uct_cma_iface_lock(iface);
+    ucs_queue_push(&iface->ops, &op->queue);
+    if ((iface->helpers.count > 0) && (length > 0)) {
+        pthread_cond_broadcast(&iface->helpers.cond);
+    }
+    uct_cma_iface_unlock(iface);
+    return UCS_INPROGRESS;
+}
+
+static UCS_F_ALWAYS_INLINE
+ucs_status_t uct_cma_ep_common_zcopy(uct_ep_h tl_ep,
+                                     const uct_iov_t *iov,
+                                     size_t iovcnt,
+                                     uint64_t remote_addr,
+                                     uct_completion_t *comp,
+                                     uct_cma_ep_tx_func_t fn,
+                                     const char *fn_name)
+{
+    uct_cma_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_cma_iface_t);
+    uct_cma_ep_t *ep       = ucs_derived_of(tl_ep, uct_cma_ep_t);
+    struct iovec local_iov[UCT_SM_MAX_IOV];
+    size_t local_iovcnt    = 0;
+    size_t length          = 0;
+    size_t iov_it;
+
+    for (iov_it = 0; iov_it < ucs_min(UCT_SM_MAX_IOV, iovcnt); ++iov_it) {
+        /* Skip the iov element if no data */
+        if (uct_iov_get_length(iov + iov_it) == 0) {
+            continue;
+        }
+
+        local_iov[local_iovcnt].iov_base = iov[iov_it].buffer;
+        local_iov[local_iovcnt].iov_len  = uct_iov_get_length(iov + iov_it);
+        length                          += local_iov[local_iovcnt].iov_len;
+        ++local_iovcnt;
+    }
+
+    /* Small operations are copied right away, unless they would overtake
+     * outstanding ones */
+    if ((length <= iface->chunk_size) && ucs_queue_is_empty(&iface->ops)) {
+        return uct_cma_ep_tx(ep->remote_pid, fn, fn_name, local_iov,
+                             local_iovcnt, remote_addr, 0, length);
+    }
+
+    return uct_cma_ep_post_op(iface, ep->remote_pid, fn, fn_name, local_iov,
+                              local_iovcnt, remote_addr, length, comp);
+}
+
 ucs_status_t uct_cma_ep_put_zcopy(uct_ep_h tl_ep, const uct_iov_t *iov, size_t iovcnt,
                                   uint64_t remote_addr, uct_rkey_t rkey,
                                   uct_completion_t *comp)
@@ -161,3 +228,35 @@ ucs_status_t uct_cma_ep_get_zcopy(uct_ep_h tl_ep, const uct_iov_t *iov, size_t i
                        uct_iov_total_length(iov, iovcnt));
     return ret;
 }
+
+ucs_status_t uct_cma_ep_flush(uct_ep_h tl_ep, unsigned flags,
+                              uct_completion_t *comp)
+{
+    uct_cma_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_cma_iface_t);
+    ucs_status_t status;
+
+    /* Outstanding operations are executed by the helper thread, and cannot be
+     * canceled */
+    if (ucs_unlikely(flags & UCT_FLUSH_FLAG_CANCEL)) {
+        return UCS_ERR_UNSUPPORTED;
+    }
+
+    /* Operations are completed in order, so waiting for all outstanding
+     * operations of the iface flushes the endpoint as well */
+    status = uct_cma_iface_flush_ops(iface, comp);
+    if (status == UCS_OK) {
+        UCT_TL_EP_STAT_FLUSH(ucs_derived_of(tl_ep, uct_base_ep_t));
+    } else if (status == UCS_INPROGRESS) {
+        UCT_TL_EP_STAT_FLUSH_WAIT(ucs_derived_of(tl_ep, uct_base_ep_t));
+    }
+    return status;
+}
+
+ucs_status_t uct_cma_ep_fence(uct_ep_h tl_ep, unsigned flags)
+{
+    uct_cma_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_cma_iface_t);
+
+    uct_cma_iface_fence_ops(iface);
+    UCT_TL_EP_STAT_FENCE(ucs_derived_of(tl_ep, uct_base_ep_t));
+    return UCS_OK;
+}
@@ -11,12 +11,43 @@
 
 #include <uct/base/uct_log.h>
 
+#include <sys/uio.h>
+
+
+typedef ssize_t (*uct_cma_ep_tx_func_t)(pid_t, const struct iovec*,
+                                        unsigned long, const struct iovec*,
+                                        unsigned long, unsigned long);
+
 
 typedef struct uct_cma_ep {
     uct_base_ep_t super;
     pid_t         remote_pid;
 } uct_cma_ep_t;
 
+
+/*
+ * Operation larger than the chunk size. It is copied chunk by chunk, from the
+ * iface progress or by the helper threads, and completed when all chunks are
+ * done. An operation with zero length is a flush marker.
+ */
+typedef struct uct_cma_ep_op {
+    ucs_queue_elem_t      queue;        /* Element in iface operations queue */
+    pid_t                 remote_pid;   /* Remote process */
+    uct_cma_ep_tx_func_t  fn;           /* process_vm_readv or process_vm_writev */
+    const char            *fn_name;     /* Name of 'fn', for error messages */
+    uint64_t              remote_addr;  /* Remote address */
+    size_t                length;       /* Total length of the operation */
+    size_t                posted;       /* Length taken for copying */
+    volatile uint64_t     completed;    /* Length copied */
+    volatile ucs_status_t status;       /* Error from any of the chunks */
+    uct_completion_t      *comp;        /* User completion */
+    int                   fence;        /* Do not start before the previous
+                                           operations are completed */
+    size_t                iovcnt;       /* Number of local iov elements */
+    struct iovec          iov[0];       /* Local iov */
+} uct_cma_ep_op_t;
+
+
 UCS_CLASS_DECLARE_NEW_FUNC(uct_cma_ep_t, uct_ep_t, uct_iface_t*,
                            const uct_device_addr_t *, const uct_iface_addr_t *);
 UCS_CLASS_DECLARE_DELETE_FUNC(uct_cma_ep_t, uct_ep_t);
@@ -26,4 +57,14 @@ ucs_status_t uct_cma_ep_put_zcopy(uct_ep_h tl_ep, const uct_iov_t *iov, size_t i
 ucs_status_t uct_cma_ep_get_zcopy(uct_ep_h tl_ep, const uct_iov_t *iov, size_t iovcnt,
                                   uint64_t remote_addr, uct_rkey_t rkey,
                                   uct_completion_t *comp);
+ucs_status_t uct_cma_ep_flush(uct_ep_h tl_ep, unsigned flags,
+                              uct_completion_t *comp);
+ucs_status_t uct_cma_ep_fence(uct_ep_h tl_ep, unsigned flags);
+ucs_status_t uct_cma_ep_post_op(uct_cma_iface_t *iface, pid_t remote_pid,
+                                uct_cma_ep_tx_func_t fn, const char *fn_name,
+                                const struct iovec *iov, size_t iovcnt,
+                                uint64_t remote_addr, size_t length,
+                                uct_completion_t *comp);
+void uct_cma_ep_op_copy_chunk(uct_cma_ep_op_t *op, size_t offset,
+                              size_t length);
 #endif
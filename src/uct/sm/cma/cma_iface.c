@@ -10,6 +10,7 @@
 
 #include <uct/base/uct_md.h>
 #include <uct/sm/base/sm_iface.h>
+#include <ucs/arch/cpu.h>
 #include <ucs/sys/string.h>
 
 
@@ -19,6 +20,19 @@ static ucs_config_field_t uct_cma_iface_config_table[] = {
     {"", "ALLOC=huge,thp,mmap,heap", NULL,
     ucs_offsetof(uct_cma_iface_config_t, super),
     UCS_CONFIG_TYPE_TABLE(uct_iface_config_table)},
+
+    {"CHUNK_SIZE", "1m",
+     "Operations larger than this size return immediately, and are copied in\n"
+     "chunks of this size from the progress function or by the helper threads.\n"
+     "\"inf\" copies all operations to completion before returning.",
+     ucs_offsetof(uct_cma_iface_config_t, chunk_size), UCS_CONFIG_TYPE_MEMUNITS},
+
+    {"NUM_THREADS", "0",
+     "Number of helper threads which copy the chunks of large operations, to\n"
+     "use the memory bandwidth of several cores. If 0, the chunks are copied\n"
+     "one at a time from the progress function.",
+     ucs_offsetof(uct_cma_iface_config_t, num_threads), UCS_CONFIG_TYPE_UINT},
+
     {NULL}
 };
 
@@ -66,6 +80,202 @@ static ucs_status_t uct_cma_iface_query(uct_iface_h tl_iface,
     return UCS_OK;
 }
 
+/*
+ * Take the next chunk to copy, from the first operation which has data left.
+ * A fenced operation, and everything after it, waits until all the previous
+ * operations are completed. Must be called with the iface lock held.
+ */
+static uct_cma_ep_op_t *uct_cma_iface_get_chunk(uct_cma_iface_t *iface,
+                                                size_t *offset_p,
+                                                size_t *length_p)
+{
+    int prev_completed = 1;
+    uct_cma_ep_op_t *op;
+
+    ucs_queue_for_each(op, &iface->ops, queue) {
+        if (op->fence && !prev_completed) {
+            return NULL;
+        }
+
+        prev_completed = prev_completed && (op->completed >= op->length);
+        if (op->posted < op->length) {
+            *offset_p   = op->posted;
+            *length_p   = ucs_min(iface->chunk_size, op->length - op->posted);
+            op->posted += *length_p;
+            return op;
+        }
+    }
+
+    return NULL;
+}
+
+static unsigned uct_cma_iface_progress(uct_iface_h tl_iface)
+{
+    uct_cma_iface_t *iface = ucs_derived_of(tl_iface, uct_cma_iface_t);
+    ucs_queue_head_t completed;
+    uct_cma_ep_op_t *op;
+    size_t offset, length;
+    unsigned count;
+
+    /* Only the progress thread adds and removes operations */
+    if (ucs_likely(ucs_queue_is_empty(&iface->ops))) {
+        return 0;
+    }
+
+    if (iface->helpers.count == 0) {
+        op = uct_cma_iface_get_chunk(iface, &offset, &length);
+        if (op != NULL) {
+            uct_cma_ep_op_copy_chunk(op, offset, length);
+        }
+    }
+
+    /* Release completed operations in order, and call their completions
+     * outside of the lock */
+    ucs_queue_head_init(&completed);
+    uct_cma_iface_lock(iface);
+    while (!ucs_queue_is_empty(&iface->ops)) {
+        op = ucs_queue_head_elem_non_empty(&iface->ops, uct_cma_ep_op_t, queue);
+        if (op->completed < op->length) {
+            break;
+        }
+
+        ucs_queue_pull_non_empty(&iface->ops);
+        ucs_queue_push(&completed, &op->queue);
+    }
+    uct_cma_iface_unlock(iface);
+
+    count = 0;
+    ucs_queue_for_each_extract(op, &completed, queue, 1) {
+        if (op->comp != NULL) {
+            uct_invoke_completion(op->comp, op->status);
+        }
+        ucs_free(op);
+        ++count;
+    }
+
+    return count;
+}
+
+ucs_status_t uct_cma_iface_flush_ops(uct_cma_iface_t *iface,
+                                     uct_completion_t *comp)
+{
+    if (ucs_queue_is_empty(&iface->ops)) {
+        return UCS_OK;
+    }
+
+    if (comp != NULL) {
+        /* Empty operation which completes after all the previous ones */
+        return uct_cma_ep_post_op(iface, 0, NULL, NULL, NULL, 0, 0, 0, comp);
+    }
+
+    return UCS_INPROGRESS;
+}
+
+void uct_cma_iface_fence_ops(uct_cma_iface_t *iface)
+{
+    /* Operations are posted in order, so only a chunked operation which is
+     * still outstanding can be overtaken */
+    iface->fence = !ucs_queue_is_empty(&iface->ops);
+    ucs_memory_cpu_fence();
+}
+
+static ucs_status_t uct_cma_iface_fence(uct_iface_h tl_iface, unsigned flags)
+{
+    uct_cma_iface_t *iface = ucs_derived_of(tl_iface, uct_cma_iface_t);
+
+    uct_cma_iface_fence_ops(iface);
+    UCT_TL_IFACE_STAT_FENCE(&iface->super);
+    return UCS_OK;
+}
+
+static ucs_status_t uct_cma_iface_flush(uct_iface_h tl_iface, unsigned flags,
+                                        uct_completion_t *comp)
+{
+    uct_cma_iface_t *iface = ucs_derived_of(tl_iface, uct_cma_iface_t);
+    ucs_status_t status;
+
+    status = uct_cma_iface_flush_ops(iface, comp);
+    if (status == UCS_OK) {
+        UCT_TL_IFACE_STAT_FLUSH(&iface->super);
+    } else if (status == UCS_INPROGRESS) {
+        UCT_TL_IFACE_STAT_FLUSH_WAIT(&iface->super);
+    }
+    return status;
+}
+
+static void *uct_cma_iface_helper_thread(void *arg)
+{
+    uct_cma_iface_t *iface = arg;
+    uct_cma_ep_op_t *op;
+    size_t offset, length;
+
+    pthread_mutex_lock(&iface->helpers.lock);
+    while (!iface->helpers.stop) {
+        op = uct_cma_iface_get_chunk(iface, &offset, &length);
+        if (op == NULL) {
+            pthread_cond_wait(&iface->helpers.cond, &iface->helpers.lock);
+            continue;
+        }
+
+        pthread_mutex_unlock(&iface->helpers.lock);
+        uct_cma_ep_op_copy_chunk(op, offset, length);
+        pthread_mutex_lock(&iface->helpers.lock);
+    }
+    pthread_mutex_unlock(&iface->helpers.lock);
+
+    return NULL;
+}
+
+static void uct_cma_iface_stop_helpers(uct_cma_iface_t *iface,
+                                       unsigned num_threads)
+{
+    unsigned i;
+
+    pthread_mutex_lock(&iface->helpers.lock);
+    iface->helpers.stop = 1;
+    pthread_cond_broadcast(&iface->helpers.cond);
+    pthread_mutex_unlock(&iface->helpers.lock);
+
+    for (i = 0; i < num_threads; ++i) {
+        pthread_join(iface->helpers.threads[i], NULL);
+    }
+}
+
+static ucs_status_t uct_cma_iface_start_helpers(uct_cma_iface_t *iface,
+                                                unsigned num_threads)
+{
+    unsigned i;
+    int ret;
+
+    iface->helpers.stop    = 0;
+    iface->helpers.threads = ucs_calloc(num_threads,
+                                        sizeof(*iface->helpers.threads),
+                                        "cma_helper_threads");
+    if (iface->helpers.threads == NULL) {
+        ucs_error("failed to allocate %u cma helper threads", num_threads);
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    pthread_mutex_init(&iface->helpers.lock, NULL);
+    pthread_cond_init(&iface->helpers.cond, NULL);
+
+    for (i = 0; i < num_threads; ++i) {
+        ret = pthread_create(&iface->helpers.threads[i], NULL,
+                             uct_cma_iface_helper_thread, iface);
+        if (ret != 0) {
+            ucs_error("failed to create cma helper thread: %s", strerror(ret));
+            uct_cma_iface_stop_helpers(iface, i);
+            pthread_cond_destroy(&iface->helpers.cond);
+            pthread_mutex_destroy(&iface->helpers.lock);
+            ucs_free(iface->helpers.threads);
+            return UCS_ERR_IO_ERROR;
+        }
+    }
+
+    iface->helpers.count = num_threads;
+    return UCS_OK;
+}
+
 static UCS_CLASS_DECLARE_DELETE_FUNC(uct_cma_iface_t, uct_iface_t);
 
 static uct_iface_ops_t uct_cma_iface_ops = {
@@ -73,15 +283,15 @@ static uct_iface_ops_t uct_cma_iface_ops = {
     .ep_get_zcopy             = uct_cma_ep_get_zcopy,
     .ep_pending_add           = ucs_empty_function_return_busy,
     .ep_pending_purge         = ucs_empty_function,
-    .ep_flush                 = uct_base_ep_flush,
-    .ep_fence                 = uct_sm_ep_fence,
+    .ep_flush                 = uct_cma_ep_flush,
+    .ep_fence                 = uct_cma_ep_fence,
     .ep_create_connected      = UCS_CLASS_NEW_FUNC_NAME(uct_cma_ep_t),
     .ep_destroy               = UCS_CLASS_DELETE_FUNC_NAME(uct_cma_ep_t),
-    .iface_flush              = uct_base_iface_flush,
-    .iface_fence              = uct_sm_iface_fence,
-    .iface_progress_enable    = ucs_empty_function,
-    .iface_progress_disable   = ucs_empty_function,
-    .iface_progress           = ucs_empty_function_return_zero,
+    .iface_flush              = uct_cma_iface_flush,
+    .iface_fence              = uct_cma_iface_fence,
+    .iface_progress_enable    = uct_base_iface_progress_enable,
+    .iface_progress_disable   = uct_base_iface_progress_disable,
+    .iface_progress           = uct_cma_iface_progress,
     .iface_close              = UCS_CLASS_DELETE_FUNC_NAME(uct_cma_iface_t),
     .iface_query              = uct_cma_iface_query,
     .iface_get_address        = uct_cma_iface_get_address,
@@ -93,6 +303,10 @@ static UCS_CLASS_INIT_FUNC(uct_cma_iface_t, uct_md_h md, uct_worker_h worker,
                            const uct_iface_params_t *params,
                            const uct_iface_config_t *tl_config)
 {
+    const uct_cma_iface_config_t *config = ucs_derived_of(tl_config,
+                                                          uct_cma_iface_config_t);
+    ucs_status_t status;
+
     ucs_assert(params->open_mode & UCT_IFACE_OPEN_MODE_DEVICE);
 
     UCS_CLASS_CALL_SUPER_INIT(uct_base_iface_t, &uct_cma_iface_ops, md, worker,
@@ -100,11 +314,45 @@ static UCS_CLASS_INIT_FUNC(uct_cma_iface_t, uct_md_h md, uct_worker_h worker,
                               UCS_STATS_ARG(UCT_CMA_TL_NAME));
     uct_sm_get_max_iov(); /* to initialize ucs_get_max_iov static variable */
 
+    if (config->chunk_size == 0) {
+        ucs_error("invalid cma chunk size: %zu", config->chunk_size);
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    self->chunk_size    = config->chunk_size;
+    self->fence         = 0;
+    self->helpers.count = 0;
+    ucs_queue_head_init(&self->ops);
+
+    if (config->num_threads > 0) {
+        status = uct_cma_iface_start_helpers(self, config->num_threads);
+        if (status != UCS_OK) {
+            return status;
+        }
+    }
+
     return UCS_OK;
 }
 
 static UCS_CLASS_CLEANUP_FUNC(uct_cma_iface_t)
 {
+    uct_cma_ep_op_t *op;
+
+    uct_base_iface_progress_disable(&self->super.super,
+                                    UCT_PROGRESS_SEND | UCT_PROGRESS_RECV);
+
+    if (self->helpers.count > 0) {
+        uct_cma_iface_stop_helpers(self, self->helpers.count);
+        pthread_cond_destroy(&self->helpers.cond);
+        pthread_mutex_destroy(&self->helpers.lock);
+        ucs_free(self->helpers.threads);
+        self->helpers.count = 0;
+    }
+
+    ucs_queue_for_each_extract(op, &self->ops, queue, 1) {
+        ucs_debug("cma iface %p: releasing outstanding operation %p", self, op);
+        ucs_free(op);
+    }
 }
 
 UCS_CLASS_DEFINE(uct_cma_iface_t, uct_base_iface_t);
@@ -141,6 +389,6 @@ UCT_TL_COMPONENT_DEFINE(uct_cma_tl,
                         uct_cma_query_tl_resources,
                         uct_cma_iface_t,
                         UCT_CMA_TL_NAME,
-                        "",
+                        "CMA_",
                         uct_cma_iface_config_table,
                         uct_cma_iface_config_t);
@@ -8,20 +8,57 @@
 #define UCT_CMA_IFACE_H
 
 #include <uct/base/uct_iface.h>
+#include <ucs/datastruct/queue.h>
+
+#include <pthread.h>
 
 #define UCT_CMA_TL_NAME "cma"
 
 
 typedef struct uct_cma_iface_config {
     uct_iface_config_t      super;
+    size_t                  chunk_size;   /* Size of asynchronous copy chunk */
+    unsigned                num_threads;  /* Number of helper copy threads */
 } uct_cma_iface_config_t;
 
 
 typedef struct uct_cma_iface {
     uct_base_iface_t        super;
+    size_t                  chunk_size;   /* Larger operations are asynchronous */
+    ucs_queue_head_t        ops;          /* Outstanding operations, in order */
+    int                     fence;        /* Next operation is fenced */
+    struct {
+        pthread_t           *threads;     /* Helper copy threads */
+        unsigned            count;        /* Number of helper threads */
+        pthread_mutex_t     lock;         /* Protects 'ops' if there are threads */
+        pthread_cond_t      cond;         /* Signaled when new chunks are posted */
+        int                 stop;         /* Helper threads should exit */
+    } helpers;
 } uct_cma_iface_t;
 
 
 extern uct_tl_component_t uct_cma_tl;
 
+
+ucs_status_t uct_cma_iface_flush_ops(uct_cma_iface_t *iface,
+                                     uct_completion_t *comp);
+
+void uct_cma_iface_fence_ops(uct_cma_iface_t *iface);
+
+
+static UCS_F_ALWAYS_INLINE void uct_cma_iface_lock(uct_cma_iface_t *iface)
+{
+    if (iface->helpers.count > 0) {
+        pthread_mutex_lock(&iface->helpers.lock);
+    }
+}
+
+
+static UCS_F_ALWAYS_INLINE void uct_cma_iface_unlock(uct_cma_iface_t *iface)
+{
+    if (iface->helpers.count > 0) {
+        pthread_mutex_unlock(&iface->helpers.lock);
+    }
+}
+
 #endif
@@ -16,6 +16,8 @@ typedef struct uct_mm_ep                uct_mm_ep_t;
 typedef struct uct_mm_iface             uct_mm_iface_t;
 typedef struct uct_mm_fifo_ctl          uct_mm_fifo_ctl_t;
 typedef struct uct_mm_fifo_element      uct_mm_fifo_element_t;
+typedef struct uct_mm_fifo_desc         uct_mm_fifo_desc_t;
+typedef struct uct_mm_fifo_bcast        uct_mm_fifo_bcast_t;
 typedef struct uct_mm_recv_desc         uct_mm_recv_desc_t;
 typedef struct uct_mm_remote_seg        uct_mm_remote_seg_t;
 
@@ -24,6 +26,9 @@ typedef struct uct_mm_remote_seg        uct_mm_remote_seg_t;
 enum {
     UCT_MM_FIFO_ELEM_FLAG_OWNER  = UCS_BIT(0), /* new/old info */
     UCT_MM_FIFO_ELEM_FLAG_INLINE = UCS_BIT(1), /* if inline or not */
+    UCT_MM_FIFO_ELEM_FLAG_BCAST  = UCS_BIT(2), /* refers to a broadcast
+                                                  descriptor of the sender */
+    UCT_MM_FIFO_ELEM_FLAG_NOP    = UCS_BIT(3), /* no message, skip it */
 };
 
 enum {
@@ -33,11 +38,11 @@ enum {
 
 #define UCT_MM_IFACE_GET_FIFO_ELEM(_iface, _fifo , _index) \
           (uct_mm_fifo_element_t*) ((char*)(_fifo) + ((_index) * \
-          (_iface)->config.fifo_elem_size));
+          (_iface)->config.fifo_elem_size))
 
-#define UCT_MM_IFACE_GET_DESC_START(_iface, _fifo_elem_p) \
-          (uct_mm_recv_desc_t *) ((_fifo_elem_p)->desc_chunk_base_addr +  \
-          (_fifo_elem_p)->desc_offset - (_iface)->rx_headroom) - 1;
+#define UCT_MM_IFACE_GET_DESC_START(_iface, _fifo_desc_p) \
+          (uct_mm_recv_desc_t *) ((_fifo_desc_p)->desc_chunk_base_addr +  \
+          (_fifo_desc_p)->desc_offset - (_iface)->rx_headroom) - 1
 
 
 /* Check if the resources on the remote peer are available for sending to it.
@@ -90,6 +90,7 @@ static UCS_CLASS_INIT_FUNC(uct_mm_ep_t, uct_iface_t *tl_iface,
     /* set the ep->fifo ptr to point to the beginning of the fifo elements at
      * the remote peer */
     uct_mm_set_fifo_elems_ptr(self->mapped_desc.address, &self->fifo);
+    self->fifo_descs = uct_mm_get_fifo_descs(iface, self->fifo);
 
     /* Initiate the hash which will keep the base_adresses of remote memory
      * chunks that hold the descriptors for bcopy. */
@@ -106,20 +107,8 @@ static UCS_CLASS_CLEANUP_FUNC(uct_mm_ep_t)
 {
     uct_mm_iface_t *iface = ucs_derived_of(self->super.super.iface, uct_mm_iface_t);
     ucs_status_t status;
-    uct_mm_remote_seg_t *remote_seg;
-    struct sglib_hashed_uct_mm_remote_seg_t_iterator iter;
 
-    for (remote_seg = sglib_hashed_uct_mm_remote_seg_t_it_init(&iter, self->remote_segments_hash);
-         remote_seg != NULL; remote_seg = sglib_hashed_uct_mm_remote_seg_t_it_next(&iter)) {
-            sglib_hashed_uct_mm_remote_seg_t_delete(self->remote_segments_hash, remote_seg);
-            /* detach the remote proceess's descriptors segment */
-            status = uct_mm_md_mapper_ops(iface->super.md)->detach(remote_seg);
-            if (status != UCS_OK) {
-                ucs_warn("Unable to detach shared memory segment of descriptors: %s",
-                         ucs_status_string(status));
-            }
-            ucs_free(remote_seg);
-    }
+    uct_mm_detach_remote_segs(iface, self->remote_segments_hash);
 
     /* detach the remote proceess's shared memory segment (remote recv FIFO) */
     status = uct_mm_md_mapper_ops(iface->super.md)->detach(&self->mapped_desc);
@@ -135,16 +124,18 @@ UCS_CLASS_DEFINE_NEW_FUNC(uct_mm_ep_t, uct_ep_t, uct_iface_t*,
                           const uct_device_addr_t *, const uct_iface_addr_t *);
 UCS_CLASS_DEFINE_DELETE_FUNC(uct_mm_ep_t, uct_ep_t);
 
-void *uct_mm_ep_attach_remote_seg(uct_mm_ep_t *ep, uct_mm_iface_t *iface, uct_mm_fifo_element_t *elem)
+void *uct_mm_attach_remote_seg(uct_mm_iface_t *iface,
+                               uct_mm_remote_seg_t **segments_hash,
+                               const uct_mm_fifo_desc_t *fifo_desc)
 {
     uct_mm_remote_seg_t *remote_seg, search;
     ucs_status_t status;
 
     /* take the mmid of the chunk that the desc belongs to, (the desc that the fifo_elem
-     * is 'assigned' to), and check if the ep has already attached to it.
+     * is 'assigned' to), and check if we have already attached to it.
      */
-    search.mmid = elem->desc_mmid;
-    remote_seg = sglib_hashed_uct_mm_remote_seg_t_find_member(ep->remote_segments_hash, &search);
+    search.mmid = fifo_desc->desc_mmid;
+    remote_seg = sglib_hashed_uct_mm_remote_seg_t_find_member(segments_hash, &search);
     if (remote_seg == NULL) {
         /* not in the hash. attach to the memory the mmid refers to. the attach call
          * will return the base address of the mmid's chunk -
@@ -154,30 +145,51 @@ void *uct_mm_ep_attach_remote_seg(uct_mm_ep_t *ep, uct_mm_iface_t *iface, uct_mm
             ucs_fatal("Failed to allocated memory for a remote segment identifier. %m");
         }
 
-        status = uct_mm_md_mapper_ops(iface->super.md)->attach(elem->desc_mmid,
-                                                               elem->desc_mpool_size,
-                                                               elem->desc_chunk_base_addr,
+        status = uct_mm_md_mapper_ops(iface->super.md)->attach(fifo_desc->desc_mmid,
+                                                               fifo_desc->desc_mpool_size,
+                                                               fifo_desc->desc_chunk_base_addr,
                                                                &remote_seg->address,
                                                                &remote_seg->cookie,
                                                                iface->path);
         if (status != UCS_OK) {
             ucs_fatal("Failed to attach to remote mmid:%zu. %s ",
-                      elem->desc_mmid, ucs_status_string(status));
+                      fifo_desc->desc_mmid, ucs_status_string(status));
         }
 
-        remote_seg->mmid   = elem->desc_mmid;
-        remote_seg->length = elem->desc_mpool_size;
+        remote_seg->mmid   = fifo_desc->desc_mmid;
+        remote_seg->length = fifo_desc->desc_mpool_size;
 
-        /* put the base address into the ep's hash table */
-        sglib_hashed_uct_mm_remote_seg_t_add(ep->remote_segments_hash, remote_seg);
+        /* put the base address into the hash table */
+        sglib_hashed_uct_mm_remote_seg_t_add(segments_hash, remote_seg);
     }
 
     return remote_seg->address;
 
 }
 
+void uct_mm_detach_remote_segs(uct_mm_iface_t *iface,
+                               uct_mm_remote_seg_t **segments_hash)
+{
+    ucs_status_t status;
+    uct_mm_remote_seg_t *remote_seg;
+    struct sglib_hashed_uct_mm_remote_seg_t_iterator iter;
+
+    for (remote_seg = sglib_hashed_uct_mm_remote_seg_t_it_init(&iter, segments_hash);
+         remote_seg != NULL; remote_seg = sglib_hashed_uct_mm_remote_seg_t_it_next(&iter)) {
+            sglib_hashed_uct_mm_remote_seg_t_delete(segments_hash, remote_seg);
+            /* detach the remote proceess's descriptors segment */
+            status = uct_mm_md_mapper_ops(iface->super.md)->detach(remote_seg);
+            if (status != UCS_OK) {
+                ucs_warn("Unable to detach shared memory segment of descriptors: %s",
+                         ucs_status_string(status));
+            }
+            ucs_free(remote_seg);
+    }
+}
+
 static inline ucs_status_t uct_mm_ep_get_remote_elem(uct_mm_ep_t *ep, uint64_t head,
-                                                     uct_mm_fifo_element_t **elem)
+                                                     uct_mm_fifo_element_t **elem,
+                                                     uct_mm_fifo_desc_t **fifo_desc)
 {
     uct_mm_iface_t *iface = ucs_derived_of(ep->super.super.iface, uct_mm_iface_t);
     uint64_t elem_index;       /* the fifo elem's index in the fifo. */
@@ -185,7 +197,8 @@ static inline ucs_status_t uct_mm_ep_get_remote_elem(uct_mm_ep_t *ep, uint64_t h
     uint64_t returned_val;
 
     elem_index = ep->fifo_ctl->head & iface->fifo_mask;
-    *elem = UCT_MM_IFACE_GET_FIFO_ELEM(iface, ep->fifo, elem_index);
+    *elem      = UCT_MM_IFACE_GET_FIFO_ELEM(iface, ep->fifo, elem_index);
+    *fifo_desc = &ep->fifo_descs[elem_index];
 
     /* try to get ownership of the head element */
     returned_val = ucs_atomic_cswap64(&ep->fifo_ctl->head, head, head+1);
@@ -202,24 +215,14 @@ static inline void uct_mm_ep_update_cached_tail(uct_mm_ep_t *ep)
     ep->cached_tail = ep->fifo_ctl->tail;
 }
 
-/* A common mm active message sending function.
- * The first parameter indicates the origin of the call.
- * is_short = 1 - perform AM short sending
- * is_short = 0 - perform AM bcopy sending
- */
-static UCS_F_ALWAYS_INLINE ssize_t
-uct_mm_ep_am_common_send(unsigned is_short, uct_mm_ep_t *ep, uct_mm_iface_t *iface,
-                         uint8_t am_id, size_t length, uint64_t header,
-                         const void *payload, uct_pack_callback_t pack_cb, void *arg,
-                         unsigned flags)
+/* Reserve the element at the head of the remote FIFO for writing */
+static UCS_F_ALWAYS_INLINE ucs_status_t
+uct_mm_ep_reserve_elem(uct_mm_ep_t *ep, uct_mm_iface_t *iface, uint64_t *head_p,
+                       uct_mm_fifo_element_t **elem, uct_mm_fifo_desc_t **fifo_desc)
 {
-    uct_mm_fifo_element_t *elem;
     ucs_status_t status;
-    void *base_address;
     uint64_t head;
 
-    UCT_CHECK_AM_ID(am_id);
-
 retry:
     head = ep->fifo_ctl->head;
     /* check if there is room in the remote process's receive FIFO to write */
@@ -239,20 +242,65 @@ retry:
         }
     }
 
-    status = uct_mm_ep_get_remote_elem(ep, head, &elem);
+    status = uct_mm_ep_get_remote_elem(ep, head, elem, fifo_desc);
     if (status != UCS_OK) {
         ucs_assert(status == UCS_ERR_NO_RESOURCE);
         ucs_trace_poll("couldn't get an available FIFO element. retrying");
         goto retry;
     }
 
+    *head_p = head;
+    return UCS_OK;
+}
+
+/* Pass the ownership of a written element to the receiver */
+static UCS_F_ALWAYS_INLINE void
+uct_mm_ep_release_elem(uct_mm_iface_t *iface, uct_mm_fifo_element_t *elem,
+                       uint64_t head)
+{
+    /* change the owner bit to indicate that the writing is complete.
+     * the owner bit flips after every FIFO wraparound */
+    if (head & iface->config.fifo_size) {
+        elem->flags |= UCT_MM_FIFO_ELEM_FLAG_OWNER;
+    } else {
+        elem->flags &= ~UCT_MM_FIFO_ELEM_FLAG_OWNER;
+    }
+}
+
+/* A common mm active message sending function.
+ * The first parameter indicates the origin of the call.
+ * is_short = 1 - perform AM short sending
+ * is_short = 0 - perform AM bcopy sending
+ */
+static UCS_F_ALWAYS_INLINE ssize_t
+uct_mm_ep_am_common_send(unsigned is_short, uct_mm_ep_t *ep, uct_mm_iface_t *iface,
+                         uint8_t am_id, size_t length, uint64_t header,
+                         const void *payload, uct_pack_callback_t pack_cb, void *arg,
+                         unsigned flags)
+{
+    uct_mm_fifo_element_t *elem;
+    uct_mm_fifo_desc_t *fifo_desc;
+    ucs_status_t status;
+    void *base_address;
+    uint64_t head;
+
+    UCT_CHECK_AM_ID(am_id);
+
+    status = uct_mm_ep_reserve_elem(ep, iface, &head, &elem, &fifo_desc);
+    if (status != UCS_OK) {
+        return status;
+    }
+
     if (is_short) {
         /* AM_SHORT */
         /* write to the remote FIFO */
-        *(uint64_t*) (elem + 1) = header;
+        /* the inline data follows the 4-byte element header, so the AM header
+         * is not 8-byte aligned */
+        memcpy(elem + 1, &header, sizeof(header));
         memcpy((void*) (elem + 1) + sizeof(header), payload, length);
 
-        elem->flags |= UCT_MM_FIFO_ELEM_FLAG_INLINE;
+        elem->flags  = (elem->flags & UCT_MM_FIFO_ELEM_FLAG_OWNER) |
+                       UCT_MM_FIFO_ELEM_FLAG_INLINE;
         elem->length = length + sizeof(header);
 
         uct_iface_trace_am(&iface->super, UCT_AM_TRACE_TYPE_SEND, am_id,
@@ -262,14 +310,16 @@ retry:
         /* AM_BCOPY */
         /* write to the remote descriptor */
         /* get the base_address: local ptr to remote memory chunk after attaching to it */
-        base_address = uct_mm_ep_attach_remote_seg(ep, iface, elem);
-        length = pack_cb(base_address + elem->desc_offset, arg);
+        base_address = uct_mm_attach_remote_seg(iface, ep->remote_segments_hash,
+                                                fifo_desc);
+        length = pack_cb(base_address + fifo_desc->desc_offset, arg);
 
-        elem->flags &= ~UCT_MM_FIFO_ELEM_FLAG_INLINE;
+        elem->flags &= UCT_MM_FIFO_ELEM_FLAG_OWNER;
         elem->length = length;
 
         uct_iface_trace_am(&iface->super, UCT_AM_TRACE_TYPE_SEND, am_id,
-                           base_address + elem->desc_offset, length, "TX: AM_BCOPY");
+                           base_address + fifo_desc->desc_offset, length,
+                           "TX: AM_BCOPY");
 
         UCT_TL_EP_STAT_OP(&ep->super, AM, BCOPY, length);
     }
@@ -280,13 +330,7 @@ retry:
      * 'writing is complete' flag which the reader checks */
     ucs_memory_cpu_store_fence();
 
-    /* change the owner bit to indicate that the writing is complete.
-     * the owner bit flips after every FIFO wraparound */
-    if (head & iface->config.fifo_size) {
-        elem->flags |= UCT_MM_FIFO_ELEM_FLAG_OWNER;
-    } else {
-        elem->flags &= ~UCT_MM_FIFO_ELEM_FLAG_OWNER;
-    }
+    uct_mm_ep_release_elem(iface, elem, head);
 
     if (ucs_unlikely(flags & UCT_SEND_FLAG_SIGNALED)) {
         uct_mm_ep_signal_remote(ep);
@@ -323,6 +367,102 @@ ssize_t uct_mm_ep_am_bcopy(uct_ep_h tl_ep, uint8_t id, uct_pack_callback_t pack_
                                     pack_cb, arg, flags);
 }
 
+ssize_t uct_mm_iface_am_bcast_bcopy(uct_iface_h tl_iface, uct_ep_h *tl_eps,
+                                    unsigned num_eps, uint8_t id,
+                                    uct_pack_callback_t pack_cb, void *arg,
+                                    unsigned flags)
+{
+    uct_mm_iface_t *iface = ucs_derived_of(tl_iface, uct_mm_iface_t);
+    uct_mm_fifo_element_t **elems;
+    uct_mm_fifo_desc_t *fifo_desc;
+    uct_mm_fifo_bcast_t bcast;
+    uct_mm_recv_desc_t *desc;
+    unsigned i, num_reserved;
+    ucs_status_t status;
+    uint64_t *heads;
+    uct_mm_ep_t *ep;
+    size_t length;
+    void *data;
+
+    UCT_CHECK_AM_ID(id);
+    ucs_assert(iface->config.fifo_elem_size >=
+               sizeof(uct_mm_fifo_element_t) + sizeof(bcast));
+
+    /* reuse the descriptors which all the receivers are done with */
+    uct_mm_iface_release_bcast_descs(iface);
+
+    desc = ucs_mpool_get(&iface->recv_desc_mp);
+    if (desc == NULL) {
+        return UCS_ERR_NO_RESOURCE;
+    }
+
+    elems = ucs_alloca(num_eps * sizeof(*elems));
+    heads = ucs_alloca(num_eps * sizeof(*heads));
+
+    /* reserve an element in the FIFO of every receiver, so the message is
+     * either sent to all of them, or to none */
+    for (num_reserved = 0; num_reserved < num_eps; ++num_reserved) {
+        ep     = ucs_derived_of(tl_eps[num_reserved], uct_mm_ep_t);
+        status = uct_mm_ep_reserve_elem(ep, iface, &heads[num_reserved],
+                                        &elems[num_reserved], &fifo_desc);
+        if (status != UCS_OK) {
+            goto err_release;
+        }
+    }
+
+    /* the data is written once, to a descriptor of the sender, and every FIFO
+     * element refers to it */
+    data   = UCS_PTR_BYTE_OFFSET(desc + 1, iface->rx_headroom);
+    length = pack_cb(data, arg);
+    ucs_assert(length <= iface->config.seg_size);
+
+    desc->bcast_refcount            = num_eps;
+    bcast.desc.desc_mmid            = desc->key;
+    bcast.desc.desc_mpool_size      = desc->mpool_length;
+    bcast.desc.desc_chunk_base_addr = desc->base_address;
+    bcast.desc.desc_offset          = (ptrdiff_t)(data - desc->base_address);
+    bcast.refcount_offset           = (ptrdiff_t)((void*)&desc->bcast_refcount -
+                                                  desc->base_address);
+
+    uct_iface_trace_am(&iface->super, UCT_AM_TRACE_TYPE_SEND, id, data, length,
+                       "TX: AM_BCAST");
+
+    for (i = 0; i < num_eps; ++i) {
+        memcpy(elems[i] + 1, &bcast, sizeof(bcast));
+        elems[i]->flags  = (elems[i]->flags & UCT_MM_FIFO_ELEM_FLAG_OWNER) |
+                           UCT_MM_FIFO_ELEM_FLAG_BCAST;
+        elems[i]->length = length;
+        elems[i]->am_id  = id;
+        UCT_TL_EP_STAT_OP(ucs_derived_of(tl_eps[i], uct_base_ep_t), AM, BCOPY,
+                          length);
+    }
+
+    ucs_memory_cpu_store_fence();
+
+    for (i = 0; i < num_eps; ++i) {
+        uct_mm_ep_release_elem(iface, elems[i], heads[i]);
+        if (ucs_unlikely(flags & UCT_SEND_FLAG_SIGNALED)) {
+            uct_mm_ep_signal_remote(ucs_derived_of(tl_eps[i], uct_mm_ep_t));
+        }
+    }
+
+    ucs_queue_push(&iface->bcast_descs, &desc->bcast_queue);
+    return length;
+
+err_release:
+    /* the receivers skip the elements which were already reserved */
+    for (i = 0; i < num_reserved; ++i) {
+        elems[i]->flags = (elems[i]->flags & UCT_MM_FIFO_ELEM_FLAG_OWNER) |
+                          UCT_MM_FIFO_ELEM_FLAG_NOP;
+    }
+    ucs_memory_cpu_store_fence();
+    for (i = 0; i < num_reserved; ++i) {
+        uct_mm_ep_release_elem(iface, elems[i], heads[i]);
+    }
+    ucs_mpool_put(desc);
+    return status;
+}
+
 static inline int uct_mm_ep_has_tx_resources(uct_mm_ep_t *ep)
 {
     uct_mm_iface_t *iface = ucs_derived_of(ep->super.super.iface, uct_mm_iface_t);
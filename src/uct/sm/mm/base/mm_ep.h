@@ -20,6 +20,7 @@ struct uct_mm_ep {
     /* Remote peer */
     uct_mm_fifo_ctl_t    *fifo_ctl;   /* pointer to the destination's ctl struct in the receive fifo */
     void                 *fifo;       /* fifo elements (destination's receive fifo) */
+    uct_mm_fifo_desc_t   *fifo_descs; /* bcopy descriptors of the fifo elements */
 
     uint64_t             cached_tail; /* the sender's own copy of the remote FIFO's tail.
                                          it is not always updated with the actual remote tail value */
@@ -49,6 +50,18 @@ ucs_status_t uct_mm_ep_am_short(uct_ep_h tl_ep, uint8_t id, uint64_t header,
 ssize_t uct_mm_ep_am_bcopy(uct_ep_h tl_ep, uint8_t id, uct_pack_callback_t pack_cb,
                            void *arg, unsigned flags);
 
+ssize_t uct_mm_iface_am_bcast_bcopy(uct_iface_h tl_iface, uct_ep_h *tl_eps,
+                                    unsigned num_eps, uint8_t id,
+                                    uct_pack_callback_t pack_cb, void *arg,
+                                    unsigned flags);
+
+void *uct_mm_attach_remote_seg(uct_mm_iface_t *iface,
+                               uct_mm_remote_seg_t **segments_hash,
+                               const uct_mm_fifo_desc_t *fifo_desc);
+
+void uct_mm_detach_remote_segs(uct_mm_iface_t *iface,
+                               uct_mm_remote_seg_t **segments_hash);
+
 ucs_status_t uct_mm_ep_flush(uct_ep_h tl_ep, unsigned flags,
                              uct_completion_t *comp);
 
@@ -35,6 +35,10 @@ static ucs_config_field_t uct_mm_iface_config_table[] = {
      "This value refers to the percentage of the FIFO size. (must be >= 0 and < 1)",
      ucs_offsetof(uct_mm_iface_config_t, release_fifo_factor), UCS_CONFIG_TYPE_DOUBLE},
 
+    {"FIFO_PREFETCH", "2",
+     "Number of receive FIFO elements to prefetch ahead of the one being processed.",
+     ucs_offsetof(uct_mm_iface_config_t, fifo_prefetch), UCS_CONFIG_TYPE_UINT},
+
     UCT_IFACE_MPOOL_CONFIG_FIELDS("RX_", -1, 512, "receive",
                                   ucs_offsetof(uct_mm_iface_config_t, mp), ""),
 
@@ -126,6 +130,10 @@ static ucs_status_t uct_mm_iface_query(uct_iface_h tl_iface,
                                           UCT_IFACE_FLAG_EVENT_SEND_COMP     |
                                           UCT_IFACE_FLAG_EVENT_RECV_SIG      |
                                           UCT_IFACE_FLAG_CONNECT_TO_IFACE;
+    if (iface->config.fifo_elem_size >= (sizeof(uct_mm_fifo_element_t) +
+                                         sizeof(uct_mm_fifo_bcast_t))) {
+        iface_attr->cap.flags          |= UCT_IFACE_FLAG_AM_BCAST_BCOPY;
+    }
 
     iface_attr->cap.atomic32.op_flags   =
     iface_attr->cap.atomic64.op_flags   = UCS_BIT(UCT_ATOMIC_OP_ADD)         |
@@ -159,7 +167,7 @@ static inline void uct_mm_progress_fifo_tail(uct_mm_iface_t *iface)
 }
 
 ucs_status_t uct_mm_assign_desc_to_fifo_elem(uct_mm_iface_t *iface,
-                                             uct_mm_fifo_element_t *fifo_elem_p,
+                                             uct_mm_fifo_desc_t *fifo_desc_p,
                                              unsigned need_new_desc)
 {
     uct_mm_recv_desc_t *desc;
@@ -171,20 +179,58 @@ ucs_status_t uct_mm_assign_desc_to_fifo_elem(uct_mm_iface_t *iface,
                                  return UCS_ERR_NO_RESOURCE);
     }
 
-    fifo_elem_p->desc_mmid   = desc->key;
-    fifo_elem_p->desc_offset = iface->rx_headroom +
+    fifo_desc_p->desc_mmid   = desc->key;
+    fifo_desc_p->desc_offset = iface->rx_headroom +
                                (ptrdiff_t) ((void*) (desc + 1) - desc->base_address);
-    fifo_elem_p->desc_chunk_base_addr = desc->base_address;
-    fifo_elem_p->desc_mpool_size      = desc->mpool_length;
+    fifo_desc_p->desc_chunk_base_addr = desc->base_address;
+    fifo_desc_p->desc_mpool_size      = desc->mpool_length;
 
     return UCS_OK;
 }
 
-static inline ucs_status_t uct_mm_iface_process_recv(uct_mm_iface_t *iface,
-                                                     uct_mm_fifo_element_t* elem)
+/* Read a message from a descriptor of the sender, which is shared with the
+ * other receivers of the broadcast, so it can't be kept by the callback */
+static ucs_status_t uct_mm_iface_process_bcast(uct_mm_iface_t *iface,
+                                               uct_mm_fifo_element_t *elem)
 {
+    uct_mm_fifo_bcast_t bcast;
+    uct_mm_fifo_desc_t fifo_desc;
     ucs_status_t status;
-    void         *data;
+    void *base_address;
+    void *data;
+
+    if (elem->flags & UCT_MM_FIFO_ELEM_FLAG_NOP) {
+        return UCS_OK;
+    }
+
+    /* the element contents are not aligned, and neither is the descriptor
+     * inside the packed structure */
+    memcpy(&bcast, elem + 1, sizeof(bcast));
+    memcpy(&fifo_desc, &bcast.desc, sizeof(fifo_desc));
+    base_address = uct_mm_attach_remote_seg(iface, iface->bcast_segments_hash,
+                                            &fifo_desc);
+    data         = base_address + fifo_desc.desc_offset;
+    VALGRIND_MAKE_MEM_DEFINED(data, elem->length);
+
+    uct_iface_trace_am(&iface->super, UCT_AM_TRACE_TYPE_RECV, elem->am_id,
+                       data, elem->length, "RX: AM_BCAST");
+
+    status = uct_iface_invoke_am(&iface->super, elem->am_id, data,
+                                 elem->length, 0);
+    ucs_assert(status == UCS_OK);
+
+    /* let the sender reuse the descriptor after the last receiver */
+    ucs_atomic_add32(base_address + bcast.refcount_offset, (uint32_t)-1);
+    return status;
+}
+
+static inline ucs_status_t uct_mm_iface_process_recv(uct_mm_iface_t *iface,
+                                                     uct_mm_fifo_element_t* elem,
+                                                     uint64_t elem_index)
+{
+    uct_mm_fifo_desc_t *fifo_desc;
+    ucs_status_t       status;
+    void               *data;
 
     if (ucs_likely(elem->flags & UCT_MM_FIFO_ELEM_FLAG_INLINE)) {
         /* read short (inline) messages from the FIFO elements */
@@ -192,12 +238,14 @@ static inline ucs_status_t uct_mm_iface_process_recv(uct_mm_iface_t *iface,
                            elem + 1, elem->length, "RX: AM_SHORT");
         status = uct_mm_iface_invoke_am(iface, elem->am_id, elem + 1,
                                         elem->length, 0);
+    } else if (ucs_unlikely(elem->flags & (UCT_MM_FIFO_ELEM_FLAG_BCAST |
+                                           UCT_MM_FIFO_ELEM_FLAG_NOP))) {
+        status = uct_mm_iface_process_bcast(iface, elem);
     } else {
         /* read bcopy messages from the receive descriptors */
-        VALGRIND_MAKE_MEM_DEFINED(elem->desc_chunk_base_addr + elem->desc_offset,
-                                  elem->length);
-
-        data = elem->desc_chunk_base_addr + elem->desc_offset;
+        fifo_desc = &iface->recv_fifo_descs[elem_index];
+        data      = fifo_desc->desc_chunk_base_addr + fifo_desc->desc_offset;
+        VALGRIND_MAKE_MEM_DEFINED(data, elem->length);
 
         uct_iface_trace_am(&iface->super, UCT_AM_TRACE_TYPE_RECV, elem->am_id,
                            data, elem->length, "RX: AM_BCOPY");
@@ -206,12 +254,25 @@ static inline ucs_status_t uct_mm_iface_process_recv(uct_mm_iface_t *iface,
                                         UCT_CB_PARAM_FLAG_DESC);
         if (status != UCS_OK) {
             /* assign a new receive descriptor to this FIFO element.*/
-            uct_mm_assign_desc_to_fifo_elem(iface, elem, 0);
+            uct_mm_assign_desc_to_fifo_elem(iface, fifo_desc, 0);
         }
     }
     return status;
 }
 
+static inline void uct_mm_iface_prefetch_fifo(uct_mm_iface_t *iface,
+                                              uint64_t read_index)
+{
+    unsigned i;
+
+    /* bring the next elements to the cache while the current one is being
+     * processed, since the senders usually fill them in order */
+    for (i = 1; i <= iface->config.fifo_prefetch; ++i) {
+        ucs_prefetch(UCT_MM_IFACE_GET_FIFO_ELEM(iface, iface->recv_fifo_elements,
+                                                (read_index + i) & iface->fifo_mask));
+    }
+}
+
 static inline unsigned uct_mm_iface_poll_fifo(uct_mm_iface_t *iface)
 {
     uint64_t read_index_loc, read_index;
@@ -236,7 +297,10 @@ static inline unsigned uct_mm_iface_poll_fifo(uct_mm_iface_t *iface)
         ucs_memory_cpu_load_fence();
         ucs_assert(iface->read_index <= iface->recv_fifo_ctl->head);
 
-        status = uct_mm_iface_process_recv(iface, read_index_elem);
+        uct_mm_iface_prefetch_fifo(iface, read_index);
+
+        status = uct_mm_iface_process_recv(iface, read_index_elem,
+                                           read_index_loc);
         if (status != UCS_OK) {
             /* the last_recv_desc is in use. get a new descriptor for it */
             UCT_TL_IFACE_GET_RX_DESC(&iface->super, &iface->recv_desc_mp,
@@ -254,11 +318,27 @@ static inline unsigned uct_mm_iface_poll_fifo(uct_mm_iface_t *iface)
     }
 }
 
+void uct_mm_iface_release_bcast_descs(uct_mm_iface_t *iface)
+{
+    uct_mm_recv_desc_t *desc;
+
+    /* the receivers usually read the broadcast messages in the order they were
+     * sent, so stop at the first descriptor which is still in use */
+    ucs_queue_for_each_extract(desc, &iface->bcast_descs, bcast_queue,
+                               desc->bcast_refcount == 0) {
+        ucs_mpool_put(desc);
+    }
+}
+
 unsigned uct_mm_iface_progress(void *arg)
 {
     uct_mm_iface_t *iface = arg;
     unsigned count;
 
+    if (ucs_unlikely(!ucs_queue_is_empty(&iface->bcast_descs))) {
+        uct_mm_iface_release_bcast_descs(iface);
+    }
+
     /* progress receive */
     count = uct_mm_iface_poll_fifo(iface);
 
@@ -330,7 +410,8 @@ static uct_iface_ops_t uct_mm_iface_ops = {
     .iface_query              = uct_mm_iface_query,
     .iface_get_device_address = uct_sm_iface_get_device_address,
     .iface_get_address        = uct_mm_iface_get_address,
-    .iface_is_reachable       = uct_sm_iface_is_reachable
+    .iface_is_reachable       = uct_sm_iface_is_reachable,
+    .iface_am_bcast_bcopy     = uct_mm_iface_am_bcast_bcopy
 };
 
 void uct_mm_iface_recv_desc_init(uct_iface_h tl_iface, void *obj, uct_mem_h memh)
@@ -347,13 +428,11 @@ void uct_mm_iface_recv_desc_init(uct_iface_h tl_iface, void *obj, uct_mem_h memh
 
 static void uct_mm_iface_free_rx_descs(uct_mm_iface_t *iface, unsigned num_elems)
 {
-    uct_mm_fifo_element_t* fifo_elem_p;
     uct_mm_recv_desc_t *desc;
     unsigned i;
 
     for (i = 0; i < num_elems; i++) {
-        fifo_elem_p = UCT_MM_IFACE_GET_FIFO_ELEM(iface, iface->recv_fifo_elements, i);
-        desc = UCT_MM_IFACE_GET_DESC_START(iface, fifo_elem_p);
+        desc = UCT_MM_IFACE_GET_DESC_START(iface, &iface->recv_fifo_descs[i]);
         ucs_mpool_put(desc);
     }
 }
@@ -379,6 +458,7 @@ ucs_status_t uct_mm_allocate_fifo_mem(uct_mm_iface_t *iface,
 
     ctl = uct_mm_set_fifo_ctl(iface->shared_mem);
     uct_mm_set_fifo_elems_ptr(iface->shared_mem, &iface->recv_fifo_elements);
+    iface->recv_fifo_descs = uct_mm_get_fifo_descs(iface, iface->recv_fifo_elements);
 
     /* Make sure head and tail are cache-aligned, and not on same cacheline, to
      * avoid false-sharing.
@@ -495,6 +575,8 @@ static UCS_CLASS_INIT_FUNC(uct_mm_iface_t, uct_md_h md, uct_worker_h worker,
     self->config.fifo_size         = mm_config->fifo_size;
     self->config.fifo_elem_size    = mm_config->super.max_short;
     self->config.seg_size          = mm_config->super.max_bcopy;
+    self->config.fifo_prefetch     = ucs_min(mm_config->fifo_prefetch,
+                                             mm_config->fifo_size - 1);
     self->fifo_release_factor_mask = UCS_MASK(ucs_ilog2(ucs_max((int)
                                      (mm_config->fifo_size * mm_config->release_fifo_factor),
                                      1)));
@@ -553,7 +635,7 @@ static UCS_CLASS_INIT_FUNC(uct_mm_iface_t, uct_md_h md, uct_worker_h worker,
         fifo_elem_p = UCT_MM_IFACE_GET_FIFO_ELEM(self, self->recv_fifo_elements, i);
         fifo_elem_p->flags = UCT_MM_FIFO_ELEM_FLAG_OWNER;
 
-        status = uct_mm_assign_desc_to_fifo_elem(self, fifo_elem_p, 1);
+        status = uct_mm_assign_desc_to_fifo_elem(self, &self->recv_fifo_descs[i], 1);
         if (status != UCS_OK) {
             ucs_error("Failed to allocate a descriptor for MM");
             goto destroy_descs;
@@ -561,6 +643,8 @@ static UCS_CLASS_INIT_FUNC(uct_mm_iface_t, uct_md_h md, uct_worker_h worker,
     }
 
     ucs_arbiter_init(&self->arbiter);
+    ucs_queue_head_init(&self->bcast_descs);
+    sglib_hashed_uct_mm_remote_seg_t_init(self->bcast_segments_hash);
 
     ucs_debug("Created an MM iface. FIFO mm id: %zu", self->fifo_mm_id);
     return UCS_OK;
@@ -581,6 +665,7 @@ err:
 
 static UCS_CLASS_CLEANUP_FUNC(uct_mm_iface_t)
 {
+    uct_mm_recv_desc_t *desc;
     ucs_status_t status;
     size_t size_to_free;
 
@@ -591,6 +676,12 @@ static UCS_CLASS_CLEANUP_FUNC(uct_mm_iface_t)
      * to their mpool */
     uct_mm_iface_free_rx_descs(self, self->config.fifo_size);
 
+    /* broadcast descriptors which were not consumed by all receivers */
+    ucs_queue_for_each_extract(desc, &self->bcast_descs, bcast_queue, 1) {
+        ucs_mpool_put(desc);
+    }
+    uct_mm_detach_remote_segs(self, self->bcast_segments_hash);
+
     ucs_mpool_put(self->last_recv_desc);
     ucs_mpool_cleanup(&self->recv_desc_mp, 1);
     close(self->signal_fd);
@@ -620,6 +711,20 @@ static ucs_status_t uct_mm_query_tl_resources(uct_md_h md,
                                               unsigned *num_resources_p)
 {
     uct_tl_resource_desc_t *resource;
+    uct_md_attr_t md_attr;
+    ucs_status_t status;
+
+    /* The interface allocates its FIFO and receive buffers from the MD */
+    status = uct_md_query(md, &md_attr);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    if (!(md_attr.cap.flags & UCT_MD_FLAG_ALLOC)) {
+        *num_resources_p = 0;
+        *resource_p      = NULL;
+        return UCS_OK;
+    }
 
     resource = ucs_calloc(1, sizeof(uct_tl_resource_desc_t), "resource desc");
     if (NULL == resource) {
@@ -24,10 +24,15 @@
 #define UCT_MM_TL_NAME "mm"
 #define UCT_MM_FIFO_CTL_SIZE_ALIGNED  ucs_align_up(sizeof(uct_mm_fifo_ctl_t),UCS_SYS_CACHE_LINE_SIZE)
 
+#define UCT_MM_FIFO_ELEMS_SIZE(iface) ucs_align_up((iface)->config.fifo_size *      \
+                                                   (iface)->config.fifo_elem_size, \
+                                                   UCS_SYS_CACHE_LINE_SIZE)
+
 #define UCT_MM_GET_FIFO_SIZE(iface)  (UCS_SYS_CACHE_LINE_SIZE - 1 +  \
                                       UCT_MM_FIFO_CTL_SIZE_ALIGNED + \
-                                     ((iface)->config.fifo_size *    \
-                                     (iface)->config.fifo_elem_size))
+                                      UCT_MM_FIFO_ELEMS_SIZE(iface) + \
+                                      ((iface)->config.fifo_size *    \
+                                       sizeof(uct_mm_fifo_desc_t)))
 
 
 typedef struct uct_mm_iface_config {
@@ -36,6 +41,8 @@ typedef struct uct_mm_iface_config {
     double                   release_fifo_factor;
     ucs_ternary_value_t      hugetlb_mode;         /* Enable using huge pages for */
                                                    /* shared memory buffers */
+    unsigned                 fifo_prefetch;        /* Number of FIFO elements to */
+                                                   /* prefetch ahead of the reader */
     uct_iface_mpool_config_t mp;
 } uct_mm_iface_config_t;
 
@@ -68,6 +75,8 @@ struct uct_mm_iface {
                                               /* shared_mem starts */
     void                    *recv_fifo_elements; /* pointer to the first fifo element */
                                                  /* in the receive fifo */
+    uct_mm_fifo_desc_t      *recv_fifo_descs;    /* bcopy descriptors of the fifo */
+                                                 /* elements, after the elements */
     uint64_t                read_index;          /* actual reading location */
 
     uint8_t                 fifo_shift;          /* = log2(fifo_size) */
@@ -76,6 +85,11 @@ struct uct_mm_iface {
 
     ucs_mpool_t             recv_desc_mp;
     uct_mm_recv_desc_t      *last_recv_desc;    /* next receive descriptor to use */
+    ucs_queue_head_t        bcast_descs;        /* sent broadcast descriptors, which
+                                                   may still be read by the peers */
+
+    /* memory chunks of the peers, which broadcast messages were received from */
+    uct_mm_remote_seg_t     *bcast_segments_hash[UCT_MM_BASE_ADDRESS_HASH_SIZE];
 
     int                     signal_fd;        /* Unix socket for receiving remote signal */
 
@@ -88,6 +102,7 @@ struct uct_mm_iface {
         unsigned fifo_size;
         unsigned fifo_elem_size;
         unsigned seg_size;                    /* size of the receive descriptor (for payload)*/
+        unsigned fifo_prefetch;               /* how many elements to prefetch */
     } config;
 };
 
@@ -96,8 +111,14 @@ struct uct_mm_fifo_element {
     uint8_t         flags;
     uint8_t         am_id;          /* active message id */
     uint16_t        length;         /* length of actual data */
+    /* the data follows here (in case of inline messaging) */
+} UCS_S_PACKED;
 
-    /* bcopy parameters */
+
+/* bcopy parameters of a FIFO element, which are kept in a separate array after
+ * the FIFO elements, so that inline messages start right after the element
+ * header. Only read when the element does not have the INLINE flag. */
+struct uct_mm_fifo_desc {
     size_t          desc_mpool_size;
     uct_mm_id_t     desc_mmid;      /* the mmid of the the memory chunk that
                                      * the desc (that this fifo_elem points to)
@@ -105,7 +126,15 @@ struct uct_mm_fifo_element {
     size_t          desc_offset;    /* the offset of the desc (its data location for bcopy)
                                      * within the memory chunk it belongs to */
     void            *desc_chunk_base_addr;
-    /* the data follows here (in case of inline messaging) */
+};
+
+
+/* Contents of a FIFO element with the BCAST flag, which refers to a descriptor
+ * of the sender, shared by all the receivers of the message */
+struct uct_mm_fifo_bcast {
+    uct_mm_fifo_desc_t  desc;            /* location of the data */
+    size_t              refcount_offset; /* offset of the reference count in
+                                            the memory chunk of the desc */
 } UCS_S_PACKED;
 
 
@@ -113,6 +142,9 @@ struct uct_mm_recv_desc {
     uct_mm_id_t         key;
     void                *base_address;
     size_t              mpool_length;
+    volatile uint32_t   bcast_refcount; /* receivers which did not read the
+                                           broadcast message yet */
+    ucs_queue_elem_t    bcast_queue;    /* in the sent broadcast queue */
     uct_recv_desc_t     recv;   /* has to be in the end */
 };
 
@@ -160,7 +192,20 @@ static inline void uct_mm_set_fifo_elems_ptr(void *mem_region, void **fifo_elems
    *fifo_elems = (void*) fifo_ctl + UCT_MM_FIFO_CTL_SIZE_ALIGNED;
 }
 
+/**
+ * Get the bcopy descriptors array of a FIFO.
+ *
+ * @param [in] iface       the iface which defines the FIFO geometry.
+ * @param [in] fifo_elems  pointer to the first FIFO element.
+ */
+static inline uct_mm_fifo_desc_t *
+uct_mm_get_fifo_descs(uct_mm_iface_t *iface, void *fifo_elems)
+{
+    return (uct_mm_fifo_desc_t*)((char*)fifo_elems + UCT_MM_FIFO_ELEMS_SIZE(iface));
+}
+
 void uct_mm_iface_release_desc(uct_recv_desc_t *self, void *desc);
+void uct_mm_iface_release_bcast_descs(uct_mm_iface_t *iface);
 ucs_status_t uct_mm_flush();
 
 unsigned uct_mm_iface_progress(void *arg);
@@ -134,6 +134,10 @@ ucs_status_t uct_mm_md_query(uct_md_h md, uct_md_attr_t *md_attr)
     md_attr->rkey_packed_size = sizeof(uct_mm_packed_rkey_t) +
                                 uct_mm_md_mapper_ops(md)->get_path_size(md);
     memset(&md_attr->local_cpus, 0xff, sizeof(md_attr->local_cpus));
+
+    if (uct_mm_md_mapper_ops(md)->md_query != NULL) {
+        uct_mm_md_mapper_ops(md)->md_query(md, md_attr);
+    }
     return UCS_OK;
 }
 
@@ -218,6 +222,10 @@ static void uct_mm_md_close(uct_md_h md)
 {
     uct_mm_md_t *mm_md = ucs_derived_of(md, uct_mm_md_t);
 
+    if (uct_mm_md_mapper_ops(md)->md_close != NULL) {
+        uct_mm_md_mapper_ops(md)->md_close(md);
+    }
+
     ucs_config_parser_release_opts(mm_md->config, md->component->md_config_table);
     ucs_free(mm_md->config);
     ucs_free(mm_md);
@@ -266,9 +274,18 @@ ucs_status_t uct_mm_md_open(const char *md_name, const uct_md_config_t *md_confi
     mm_md->super.ops = &uct_mm_md_ops;
     mm_md->super.component = mdc;
 
+    if (uct_mm_mdc_mapper_ops(mdc)->md_open != NULL) {
+        status = uct_mm_mdc_mapper_ops(mdc)->md_open(&mm_md->super);
+        if (status != UCS_OK) {
+            goto err_release_opts;
+        }
+    }
+
     *md_p = &mm_md->super;
     return UCS_OK;
 
+err_release_opts:
+    ucs_config_parser_release_opts(mm_md->config, mdc->md_config_table);
 err_free_mm_md_config:
     ucs_free(mm_md->config);
 err_free_mm_md:
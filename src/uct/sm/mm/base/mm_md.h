@@ -43,6 +43,14 @@ typedef struct uct_mm_mapper_ops {
 
     uint8_t      (*get_priority)();
 
+    /* Optional, called when an MD of this mapper is opened or closed */
+    ucs_status_t (*md_open)(uct_md_h md);
+
+    void         (*md_close)(uct_md_h md);
+
+    /* Optional, updates the MD attributes after the generic query */
+    void         (*md_query)(uct_md_h md, uct_md_attr_t *md_attr);
+
     ucs_status_t (*reg)(void *address, size_t size, 
                         uct_mm_id_t *mmid_p);
 
@@ -0,0 +1,1228 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+ * See file LICENSE for terms.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <uct/sm/mm/base/mm_md.h>
+#include <uct/sm/mm/base/mm_iface.h>
+#include <ucm/api/ucm.h>
+#include <ucs/debug/memtrack.h>
+#include <ucs/debug/log.h>
+#include <ucs/sys/sys.h>
+#include <linux/falloc.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+
+
+/*
+ * All memory of the process which is shared by this mapper is backed by a
+ * single sparse memfd file, and every page is mapped at the file offset which
+ * equals its virtual address. So a peer which has the file descriptor can map
+ * any registered address range without additional translation, and a range
+ * which spans several adjacent arenas is still contiguous in the file.
+ *
+ * Peers open the file through /proc/<pid>/fd, which requires ptrace read
+ * access to the owner process: the same user, or CAP_SYS_PTRACE in the user
+ * namespace of the owner, and the owner must be dumpable. Since peers are not
+ * guaranteed to have it, the mapper is disabled unless configured.
+ */
+#define UCT_MEMFD_FILE_SIZE         UCS_BIT(57)  /* Covers 5-level paging */
+#define UCT_MEMFD_MAX_ARENAS        4096
+#define UCT_MEMFD_SEQ_BITS          22
+#define UCT_MEMFD_FD_BITS           20   /* Default limit of open files */
+#define UCT_MEMFD_FD_SHIFT          UCT_MEMFD_SEQ_BITS
+#define UCT_MEMFD_PID_SHIFT         (UCT_MEMFD_SEQ_BITS + UCT_MEMFD_FD_BITS)
+#define UCT_MEMFD_MMAP_PROT         (PROT_READ | PROT_WRITE)
+#define UCT_MEMFD_HOOK_PRIORITY     1000
+#define UCT_MEMFD_MAPS_BUFFER_SIZE  (256 * UCS_KBYTE)
+#define UCT_MEMFD_HOOK_MAP_FLAGS    (MAP_PRIVATE | MAP_SHARED | MAP_ANONYMOUS | \
+                                     MAP_STACK | MAP_GROWSDOWN | MAP_HUGETLB)
+
+#ifndef MFD_CLOEXEC
+#  define MFD_CLOEXEC               0x0001U
+#endif
+
+
+typedef struct uct_memfd_md_config {
+    uct_mm_md_config_t      super;
+    int                     enable;
+    int                     hook_mmap;
+} uct_memfd_md_config_t;
+
+
+/*
+ * Address range which is mapped from the memfd file
+ */
+typedef struct uct_memfd_arena {
+    uintptr_t               start;
+    uintptr_t               end;
+    int                     is_private;  /* Replaces a private mapping */
+} uct_memfd_arena_t;
+
+
+typedef void (*uct_memfd_mapping_cb_t)(uintptr_t start, uintptr_t end,
+                                       int prot, void *arg);
+
+
+/*
+ * Part of an arena, and the protection of its mapping
+ */
+typedef struct uct_memfd_range {
+    uintptr_t               start;
+    uintptr_t               end;
+    int                     prot;
+} uct_memfd_range_t;
+
+
+/*
+ * Parts of the arenas in [start, end) to replace by private pages. The array
+ * is allocated by ucm_orig_mmap(), so it's not tracked by the hooks.
+ */
+typedef struct uct_memfd_ranges {
+    uintptr_t               start;
+    uintptr_t               end;
+    int                     private_only; /* Only arenas of private mappings */
+    uct_memfd_range_t       *ranges;
+    size_t                  count;
+    size_t                  capacity;
+    ucs_status_t            status;
+} uct_memfd_ranges_t;
+
+
+static ucs_config_field_t uct_memfd_md_config_table[] = {
+  {"MM_", "", NULL,
+   ucs_offsetof(uct_memfd_md_config_t, super), UCS_CONFIG_TYPE_TABLE(uct_mm_md_config_table)},
+
+  {"ENABLE", "n",
+   "Enable the memfd shared memory mapper. Peers open the shared file through\n"
+   "/proc/<pid>/fd, which requires ptrace read access to this process and the\n"
+   "same pid namespace.",
+   ucs_offsetof(uct_memfd_md_config_t, enable), UCS_CONFIG_TYPE_BOOL},
+
+  {"HOOK_MMAP", "n",
+   "Back anonymous memory mappings which are created by the process, such as\n"
+   "large malloc() buffers, with a shared memory file, so they can be registered\n"
+   "and accessed by peers with load/store operations. A child process gets a\n"
+   "private copy of such memory, which fork() copies eagerly instead of on write.\n"
+   "A mapping which mremap() moves to another address becomes private. Only\n"
+   "memory backed by the shared file, or allocated by this memory domain, can\n"
+   "be registered.",
+   ucs_offsetof(uct_memfd_md_config_t, hook_mmap), UCS_CONFIG_TYPE_BOOL},
+
+  {NULL}
+};
+
+
+static struct {
+    pthread_mutex_t         lock;
+    pthread_mutex_t         hook_lock;   /* Not taken by the hooks, since UCM
+                                            may call them while installing.
+                                            Taken before 'lock'. */
+    int                     fd;          /* Shared file, or -1 if not created */
+    volatile unsigned       hook_refcount;
+    int                     hook_installed;
+    int                     atfork_registered;
+    int                     fork_pipe[2]; /* Parent waits for the child to copy
+                                             the private arenas */
+    uct_memfd_ranges_t      fork_ranges; /* Private arenas to copy in the child */
+    volatile unsigned       num_arenas;
+    uct_memfd_arena_t       arenas[UCT_MEMFD_MAX_ARENAS];
+    uint32_t                seq;
+} uct_memfd_global = {
+    .lock              = PTHREAD_MUTEX_INITIALIZER,
+    .hook_lock         = PTHREAD_MUTEX_INITIALIZER,
+    .fd                = -1,
+    .hook_refcount     = 0,
+    .hook_installed    = 0,
+    .atfork_registered = 0,
+    .fork_pipe         = {-1, -1},
+    .num_arenas        = 0,
+    .seq               = 0
+};
+
+/* State passed from the pre-event hook to the post-event hook */
+static __thread struct {
+    int                     reserved;    /* mmap() address was reserved by us */
+    int                     remapped;    /* mremap() of an arena */
+} uct_memfd_hook_state;
+
+
+static void uct_memfd_lock()
+{
+    pthread_mutex_lock(&uct_memfd_global.lock);
+}
+
+static void uct_memfd_unlock()
+{
+    pthread_mutex_unlock(&uct_memfd_global.lock);
+}
+
+/*
+ * The identifier contains the process and the file descriptor to open the file,
+ * and a sequence number, because the mm transport expects a unique identifier
+ * for every segment. Must be called with the lock held.
+ */
+static uct_mm_id_t uct_memfd_mmid(int fd)
+{
+    return ((uct_mm_id_t)getpid() << UCT_MEMFD_PID_SHIFT) |
+           ((uct_mm_id_t)fd << UCT_MEMFD_FD_SHIFT) |
+           (uct_memfd_global.seq++ & UCS_MASK(UCT_MEMFD_SEQ_BITS));
+}
+
+/* Release the file pages of a range, so next reads return zeros */
+static void uct_memfd_punch(uintptr_t start, uintptr_t end)
+{
+    int ret;
+
+    if (start >= end) {
+        return;
+    }
+
+    ret = fallocate(uct_memfd_global.fd,
+                    FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, start,
+                    end - start);
+    if (ret < 0) {
+        ucs_warn("failed to release memfd range 0x%lx..0x%lx: %m", start, end);
+    }
+}
+
+/*
+ * Call a function for every shared mapping of the process. The mappings are
+ * read to a buffer first, since the function may change them, and the buffer
+ * is allocated by ucm_orig_mmap(), so it's not tracked by the hooks.
+ */
+static ucs_status_t uct_memfd_foreach_shared_mapping(uct_memfd_mapping_cb_t cb,
+                                                     void *arg)
+{
+    size_t buffer_size = UCT_MEMFD_MAPS_BUFFER_SIZE;
+    unsigned long start, end;
+    char *buffer, *line, *next;
+    size_t offset;
+    ssize_t nread;
+    char perms[5];
+    int fd, prot;
+
+    for (;;) {
+        fd = open("/proc/self/maps", O_RDONLY);
+        if (fd < 0) {
+            ucs_warn("failed to open /proc/self/maps: %m");
+            return UCS_ERR_IO_ERROR;
+        }
+
+        buffer = ucm_orig_mmap(NULL, buffer_size, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (buffer == MAP_FAILED) {
+            ucs_warn("failed to allocate %zu bytes for /proc/self/maps: %m",
+                     buffer_size);
+            close(fd);
+            return UCS_ERR_NO_MEMORY;
+        }
+
+        offset = 0;
+        do {
+            nread = read(fd, buffer + offset, buffer_size - 1 - offset);
+            if (nread > 0) {
+                offset += nread;
+            }
+        } while (((nread > 0) || ((nread < 0) && (errno == EINTR))) &&
+                 (offset < buffer_size - 1));
+
+        if (nread < 0) {
+            ucs_warn("failed to read /proc/self/maps: %m");
+            ucm_orig_munmap(buffer, buffer_size);
+            close(fd);
+            return UCS_ERR_IO_ERROR;
+        }
+
+        close(fd);
+        if (nread == 0) {
+            break;
+        }
+
+        /* The buffer is full, retry with a larger one */
+        ucm_orig_munmap(buffer, buffer_size);
+        buffer_size *= 2;
+    }
+
+    buffer[offset] = '\0';
+    for (line = buffer; *line != '\0'; line = next) {
+        next = strchr(line, '\n');
+        if (next == NULL) {
+            next = line + strlen(line);
+        } else {
+            *(next++) = '\0';
+        }
+
+        if ((sscanf(line, "%lx-%lx %4s", &start, &end, perms) != 3) ||
+            (perms[3] != 's')) {
+            continue;
+        }
+
+        prot = ((perms[0] == 'r') ? PROT_READ  : 0) |
+               ((perms[1] == 'w') ? PROT_WRITE : 0) |
+               ((perms[2] == 'x') ? PROT_EXEC  : 0);
+        cb(start, end, prot, arg);
+    }
+
+    ucm_orig_munmap(buffer, buffer_size);
+    return UCS_OK;
+}
+
+static void uct_memfd_ranges_add(uct_memfd_ranges_t *ranges, uintptr_t start,
+                                 uintptr_t end, int prot)
+{
+    uct_memfd_range_t *buffer, *range;
+    size_t capacity;
+
+    if (ranges->count == ranges->capacity) {
+        capacity = ucs_max(ranges->capacity * 2,
+                           ucs_get_page_size() / sizeof(*buffer));
+        buffer   = ucm_orig_mmap(NULL, capacity * sizeof(*buffer),
+                                 PROT_READ | PROT_WRITE,
+                                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (buffer == MAP_FAILED) {
+            ucs_warn("failed to allocate %zu memfd ranges: %m", capacity);
+            ranges->status = UCS_ERR_NO_MEMORY;
+            return;
+        }
+
+        if (ranges->capacity > 0) {
+            memcpy(buffer, ranges->ranges, ranges->count * sizeof(*buffer));
+            ucm_orig_munmap(ranges->ranges,
+                            ranges->capacity * sizeof(*buffer));
+        }
+
+        ranges->ranges   = buffer;
+        ranges->capacity = capacity;
+    }
+
+    range        = &ranges->ranges[ranges->count++];
+    range->start = start;
+    range->end   = end;
+    range->prot  = prot;
+}
+
+static void uct_memfd_ranges_collect_cb(uintptr_t start, uintptr_t end,
+                                        int prot, void *arg)
+{
+    uct_memfd_ranges_t *ranges = arg;
+    uintptr_t ovl_start, ovl_end;
+    uct_memfd_arena_t *arena;
+
+    start = ucs_max(start, ranges->start);
+    end   = ucs_min(end, ranges->end);
+
+    for (arena = uct_memfd_global.arenas;
+         arena < uct_memfd_global.arenas + uct_memfd_global.num_arenas;
+         ++arena) {
+        ovl_start = ucs_max(arena->start, start);
+        ovl_end   = ucs_min(arena->end, end);
+        if ((ovl_start >= ovl_end) ||
+            (ranges->private_only && !arena->is_private)) {
+            continue;
+        }
+
+        uct_memfd_ranges_add(ranges, ovl_start, ovl_end, prot);
+    }
+}
+
+/*
+ * Collect the parts of the arenas in a range, with the protection of their
+ * mappings. Must be called with the lock held.
+ */
+static void uct_memfd_ranges_collect(uct_memfd_ranges_t *ranges,
+                                     uintptr_t start, uintptr_t end,
+                                     int private_only)
+{
+    ucs_status_t status;
+
+    ranges->start        = start;
+    ranges->end          = end;
+    ranges->private_only = private_only;
+    ranges->ranges       = NULL;
+    ranges->count        = 0;
+    ranges->capacity     = 0;
+    ranges->status       = UCS_OK;
+
+    status = uct_memfd_foreach_shared_mapping(uct_memfd_ranges_collect_cb,
+                                              ranges);
+    if (status != UCS_OK) {
+        ranges->status = status;
+    }
+}
+
+/* Async-signal-safe */
+static void uct_memfd_ranges_release(uct_memfd_ranges_t *ranges)
+{
+    if (ranges->capacity > 0) {
+        ucm_orig_munmap(ranges->ranges,
+                        ranges->capacity * sizeof(*ranges->ranges));
+    }
+
+    ranges->ranges   = NULL;
+    ranges->count    = 0;
+    ranges->capacity = 0;
+}
+
+/*
+ * Replace the shared pages of a range by private pages with the same contents
+ * and protection. Only the data extents of the file are read, so holes are not
+ * populated. Async-signal-safe, so it's also used in the child after fork(),
+ * and errors are reported by the caller.
+ */
+static ucs_status_t uct_memfd_privatize_range(const uct_memfd_range_t *range)
+{
+    int fd         = uct_memfd_global.fd;
+    size_t length  = range->end - range->start;
+    off_t data, hole, data_end;
+    ssize_t nread;
+    void *copy;
+
+    copy = ucm_orig_mmap(NULL, length, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (copy == MAP_FAILED) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    data_end = range->end;
+    for (data = range->start; data < data_end; data = hole) {
+        data = lseek(fd, data, SEEK_DATA);
+        if ((data < 0) && (errno == ENXIO)) {
+            break;
+        } else if (data < 0) {
+            goto err_unmap;
+        } else if (data >= data_end) {
+            break;
+        }
+
+        hole = lseek(fd, data, SEEK_HOLE);
+        if (hole < 0) {
+            goto err_unmap;
+        }
+
+        hole = ucs_min(hole, data_end);
+        while (data < hole) {
+            nread = pread(fd, UCS_PTR_BYTE_OFFSET(copy, data - range->start),
+                          hole - data, data);
+            if ((nread < 0) && (errno == EINTR)) {
+                continue;
+            } else if (nread <= 0) {
+                goto err_unmap;
+            }
+            data += nread;
+        }
+    }
+
+    if (mprotect(copy, length, range->prot) < 0) {
+        goto err_unmap;
+    }
+
+    /* Not mremap(), which may be hooked by UCM and lose the new address */
+    if (syscall(__NR_mremap, copy, length, length,
+                MREMAP_MAYMOVE | MREMAP_FIXED, range->start) == -1) {
+        goto err_unmap;
+    }
+
+    return UCS_OK;
+
+err_unmap:
+    ucm_orig_munmap(copy, length);
+    return UCS_ERR_IO_ERROR;
+}
+
+/* Async-signal-safe */
+static ucs_status_t uct_memfd_ranges_privatize(const uct_memfd_ranges_t *ranges)
+{
+    ucs_status_t status = ranges->status;
+    size_t i;
+
+    for (i = 0; i < ranges->count; ++i) {
+        if (uct_memfd_privatize_range(&ranges->ranges[i]) != UCS_OK) {
+            status = UCS_ERR_IO_ERROR;
+        }
+    }
+
+    return status;
+}
+
+/*
+ * Replace the pages of the arenas in a range by private pages, after which
+ * they may be mapped at other addresses without changing the semantics of
+ * private memory. Must be called with the lock held.
+ */
+static ucs_status_t uct_memfd_privatize(uintptr_t start, uintptr_t end)
+{
+    uct_memfd_ranges_t ranges;
+    ucs_status_t status;
+
+    uct_memfd_ranges_collect(&ranges, start, end, 0);
+    status = uct_memfd_ranges_privatize(&ranges);
+    if (status != UCS_OK) {
+        ucs_warn("failed to replace memfd range 0x%lx..0x%lx by private pages",
+                 start, end);
+    }
+
+    uct_memfd_ranges_release(&ranges);
+    return status;
+}
+
+/*
+ * The child may call only async-signal-safe functions, so the private arenas
+ * which it copies, and the protection of their mappings, are collected here.
+ * The locks are held until fork() returns, so the arenas do not change.
+ */
+static void uct_memfd_atfork_prepare()
+{
+    unsigned i;
+
+    pthread_mutex_lock(&uct_memfd_global.hook_lock);
+    uct_memfd_lock();
+
+    uct_memfd_global.fork_pipe[0] = -1;
+    uct_memfd_global.fork_pipe[1] = -1;
+    for (i = 0; i < uct_memfd_global.num_arenas; ++i) {
+        if (uct_memfd_global.arenas[i].is_private) {
+            uct_memfd_ranges_collect(&uct_memfd_global.fork_ranges, 0,
+                                     UINTPTR_MAX, 1);
+            if (uct_memfd_global.fork_ranges.status != UCS_OK) {
+                ucs_warn("child process may share private memory with the "
+                         "parent");
+            }
+
+            if (pipe2(uct_memfd_global.fork_pipe, O_CLOEXEC) < 0) {
+                ucs_warn("failed to create a pipe for fork(): %m");
+                uct_memfd_global.fork_pipe[0] = -1;
+                uct_memfd_global.fork_pipe[1] = -1;
+            }
+            break;
+        }
+    }
+}
+
+static void uct_memfd_atfork_parent()
+{
+    int saved_errno = errno;
+    char dummy;
+
+    /* Wait until the child copies the private arenas, and keep the lock
+     * meanwhile so their pages are not released by the hooks */
+    if (uct_memfd_global.fork_pipe[0] >= 0) {
+        close(uct_memfd_global.fork_pipe[1]);
+        while ((read(uct_memfd_global.fork_pipe[0], &dummy, 1) < 0) &&
+               (errno == EINTR));
+        close(uct_memfd_global.fork_pipe[0]);
+    }
+
+    uct_memfd_ranges_release(&uct_memfd_global.fork_ranges);
+    uct_memfd_unlock();
+    pthread_mutex_unlock(&uct_memfd_global.hook_lock);
+    errno = saved_errno;
+}
+
+static void uct_memfd_atfork_child()
+{
+    int saved_errno = errno;
+
+    /* The private arenas get private pages, as private mappings do. The other
+     * arenas remain shared with the parent, and the child creates a new file
+     * for its own arenas, so it never releases pages of the parent. A failure
+     * cannot be reported here, since logging is not async-signal-safe. */
+    if (uct_memfd_global.fd >= 0) {
+        uct_memfd_ranges_privatize(&uct_memfd_global.fork_ranges);
+        close(uct_memfd_global.fd);
+    }
+
+    /* Closing the write end of the pipe releases the parent */
+    if (uct_memfd_global.fork_pipe[0] >= 0) {
+        close(uct_memfd_global.fork_pipe[0]);
+        close(uct_memfd_global.fork_pipe[1]);
+    }
+
+    uct_memfd_ranges_release(&uct_memfd_global.fork_ranges);
+    uct_memfd_global.fd         = -1;
+    uct_memfd_global.num_arenas = 0;
+    uct_memfd_unlock();
+    pthread_mutex_unlock(&uct_memfd_global.hook_lock);
+    errno = saved_errno;
+}
+
+/* Must be called with the lock held */
+static int uct_memfd_get_fd()
+{
+    int fd = -1;
+
+    if (uct_memfd_global.fd >= 0) {
+        return uct_memfd_global.fd;
+    }
+
+#ifdef __NR_memfd_create
+    fd = syscall(__NR_memfd_create, "ucx_memfd", MFD_CLOEXEC);
+#endif
+    if (fd < 0) {
+        ucs_debug("memfd_create() failed: %m");
+        return -1;
+    }
+
+    if (fd >= UCS_BIT(UCT_MEMFD_FD_BITS)) {
+        ucs_debug("memfd file descriptor %d is too large", fd);
+        close(fd);
+        return -1;
+    }
+
+    if (ftruncate(fd, UCT_MEMFD_FILE_SIZE) < 0) {
+        ucs_debug("ftruncate(memfd) failed: %m");
+        close(fd);
+        return -1;
+    }
+
+    if (!uct_memfd_global.atfork_registered) {
+        pthread_atfork(uct_memfd_atfork_prepare, uct_memfd_atfork_parent,
+                       uct_memfd_atfork_child);
+        uct_memfd_global.atfork_registered = 1;
+    }
+
+    uct_memfd_global.fd = fd;
+    return fd;
+}
+
+/*
+ * Start tracking a new arena, and make sure its pages are zero.
+ * Must be called with the lock held.
+ */
+static ucs_status_t uct_memfd_arena_add(uintptr_t start, uintptr_t end,
+                                        int is_private)
+{
+    uct_memfd_arena_t *arena;
+
+    if ((uct_memfd_global.num_arenas == UCT_MEMFD_MAX_ARENAS) ||
+        (end > UCT_MEMFD_FILE_SIZE) || (uct_memfd_get_fd() < 0)) {
+        return UCS_ERR_NO_RESOURCE;
+    }
+
+    /* The file could still hold pages of a mapping which was removed without
+     * notifying us */
+    uct_memfd_punch(start, end);
+
+    arena             = &uct_memfd_global.arenas[uct_memfd_global.num_arenas++];
+    arena->start      = start;
+    arena->end        = end;
+    arena->is_private = is_private;
+    return UCS_OK;
+}
+
+/*
+ * Stop tracking a range which is unmapped, and release its pages.
+ * Must be called with the lock held.
+ */
+static void uct_memfd_arena_remove(uintptr_t start, uintptr_t end)
+{
+    uct_memfd_arena_t *arena;
+    uintptr_t ovl_start, ovl_end;
+    unsigned i;
+
+    for (i = 0; i < uct_memfd_global.num_arenas; ) {
+        arena     = &uct_memfd_global.arenas[i];
+        ovl_start = ucs_max(arena->start, start);
+        ovl_end   = ucs_min(arena->end, end);
+        if (ovl_start >= ovl_end) {
+            ++i;
+            continue;
+        }
+
+        uct_memfd_punch(ovl_start, ovl_end);
+
+        if ((ovl_start == arena->start) && (ovl_end == arena->end)) {
+            *arena = uct_memfd_global.arenas[--uct_memfd_global.num_arenas];
+            continue;
+        } else if (ovl_start == arena->start) {
+            arena->start = ovl_end;
+        } else if ((ovl_end == arena->end) ||
+                   (uct_memfd_global.num_arenas == UCT_MEMFD_MAX_ARENAS)) {
+            /* If there is no room to split the arena, stop tracking its tail;
+             * it will be released when the address is mapped again */
+            arena->end = ovl_start;
+        } else {
+            uct_memfd_global.arenas[uct_memfd_global.num_arenas]       = *arena;
+            uct_memfd_global.arenas[uct_memfd_global.num_arenas].start = ovl_end;
+            ++uct_memfd_global.num_arenas;
+            arena->end = ovl_start;
+        }
+        ++i;
+    }
+}
+
+/* Must be called with the lock held */
+static uct_memfd_arena_t *uct_memfd_arena_find(uintptr_t address)
+{
+    uct_memfd_arena_t *arena;
+
+    for (arena = uct_memfd_global.arenas;
+         arena < uct_memfd_global.arenas + uct_memfd_global.num_arenas;
+         ++arena) {
+        if ((address >= arena->start) && (address < arena->end)) {
+            return arena;
+        }
+    }
+    return NULL;
+}
+
+/* Check if a range is covered by arenas. Must be called with the lock held */
+static int uct_memfd_arena_covers(uintptr_t start, uintptr_t end)
+{
+    uct_memfd_arena_t *arena;
+
+    while (start < end) {
+        arena = uct_memfd_arena_find(start);
+        if (arena == NULL) {
+            return 0;
+        }
+        start = arena->end;
+    }
+    return 1;
+}
+
+/* Must be called with the lock held */
+static int uct_memfd_arena_overlaps(uintptr_t start, uintptr_t end)
+{
+    uct_memfd_arena_t *arena;
+
+    for (arena = uct_memfd_global.arenas;
+         arena < uct_memfd_global.arenas + uct_memfd_global.num_arenas;
+         ++arena) {
+        if ((arena->start < end) && (start < arena->end)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void uct_memfd_hook_mmap(ucm_event_t *event)
+{
+    size_t length = ucs_align_up_pow2(event->mmap.size, ucs_get_page_size());
+    ucs_status_t status;
+    void *address;
+    int fd;
+
+    uct_memfd_hook_state.reserved = 0;
+    if ((event->mmap.result != MAP_FAILED) ||
+        (uct_memfd_global.hook_refcount == 0) ||
+        ((event->mmap.flags & UCT_MEMFD_HOOK_MAP_FLAGS) !=
+         (MAP_PRIVATE | MAP_ANONYMOUS)) ||
+        !(event->mmap.prot & PROT_WRITE) || (length == 0)) {
+        return;
+    }
+
+    if (event->mmap.flags & MAP_FIXED) {
+        address = event->mmap.address;
+    } else {
+        address = ucm_orig_mmap(event->mmap.address, length, PROT_NONE,
+                                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                                -1, 0);
+        if (address == MAP_FAILED) {
+            return;
+        }
+    }
+
+    uct_memfd_lock();
+    status = uct_memfd_arena_add((uintptr_t)address, (uintptr_t)address + length,
+                                 1);
+    fd     = uct_memfd_global.fd;
+    uct_memfd_unlock();
+
+    if (status != UCS_OK) {
+        if (!(event->mmap.flags & MAP_FIXED)) {
+            ucm_orig_munmap(address, length);
+        }
+        return;
+    }
+
+    uct_memfd_hook_state.reserved = !(event->mmap.flags & MAP_FIXED);
+    event->mmap.address = address;
+    event->mmap.flags   = (event->mmap.flags & ~(MAP_PRIVATE | MAP_ANONYMOUS)) |
+                          MAP_SHARED | MAP_FIXED;
+    event->mmap.fd      = fd;
+    event->mmap.offset  = (uintptr_t)address;
+}
+
+static void uct_memfd_hook_mremap(ucm_event_t *event)
+{
+    uintptr_t start   = (uintptr_t)event->mremap.address;
+    uintptr_t old_end = start + ucs_align_up_pow2(event->mremap.old_size,
+                                                  ucs_get_page_size());
+    uintptr_t new_end = start + ucs_align_up_pow2(event->mremap.new_size,
+                                                  ucs_get_page_size());
+    void *result;
+
+    uct_memfd_hook_state.remapped = 0;
+    if ((event->mremap.result != MAP_FAILED) ||
+        (uct_memfd_global.num_arenas == 0)) {
+        return;
+    }
+
+    uct_memfd_lock();
+    if (!uct_memfd_arena_overlaps(start, old_end)) {
+        goto out;
+    }
+
+    /* Try to resize in place, so the file offset of the pages remains equal to
+     * their address. The added pages must be zero, unless they belong to
+     * another arena, in which case the range cannot grow in place anyway. */
+    if (!(event->mremap.flags & MREMAP_FIXED) &&
+        ((new_end <= old_end) || !uct_memfd_arena_overlaps(old_end, new_end))) {
+        uct_memfd_punch(old_end, new_end);
+        result = ucm_orig_mremap(event->mremap.address, event->mremap.old_size,
+                                 event->mremap.new_size,
+                                 event->mremap.flags & ~MREMAP_MAYMOVE);
+        if (result != MAP_FAILED) {
+            event->mremap.result          = result;
+            uct_memfd_hook_state.remapped = 1;
+            goto out;
+        }
+    }
+
+    if (!(event->mremap.flags & (MREMAP_MAYMOVE | MREMAP_FIXED))) {
+        goto out;
+    }
+
+    /* The pages would move to addresses which differ from their file offset,
+     * so replace them by private pages and let mremap() move those. If this
+     * fails, the range is not moved, and mremap() fails as it would without
+     * free address space. */
+    if (uct_memfd_privatize(start, old_end) == UCS_OK) {
+        uct_memfd_arena_remove(start, old_end);
+    } else {
+        event->mremap.flags &= ~(MREMAP_MAYMOVE | MREMAP_FIXED);
+    }
+
+out:
+    uct_memfd_unlock();
+}
+
+static void uct_memfd_hook_madvise(ucm_event_t *event)
+{
+    uintptr_t start = (uintptr_t)event->madvise.addr;
+    uintptr_t end   = start + event->madvise.length;
+    uct_memfd_arena_t *arena;
+
+    if ((event->madvise.result != -1) || (uct_memfd_global.num_arenas == 0)) {
+        return;
+    }
+
+    /* Shared pages keep their contents after these, unlike private pages */
+    if ((event->madvise.advice != MADV_DONTNEED)
+#ifdef MADV_FREE
+        && (event->madvise.advice != MADV_FREE)
+#endif
+       ) {
+        return;
+    }
+
+    uct_memfd_lock();
+    for (arena = uct_memfd_global.arenas;
+         arena < uct_memfd_global.arenas + uct_memfd_global.num_arenas;
+         ++arena) {
+        uct_memfd_punch(ucs_max(arena->start, start), ucs_min(arena->end, end));
+    }
+    uct_memfd_unlock();
+}
+
+static void uct_memfd_pre_event(ucm_event_type_t event_type, ucm_event_t *event,
+                                void *arg)
+{
+    switch (event_type) {
+    case UCM_EVENT_MMAP:
+        uct_memfd_hook_mmap(event);
+        break;
+    case UCM_EVENT_MREMAP:
+        uct_memfd_hook_mremap(event);
+        break;
+    case UCM_EVENT_MADVISE:
+        uct_memfd_hook_madvise(event);
+        break;
+    default:
+        break;
+    }
+}
+
+static void uct_memfd_post_event(ucm_event_type_t event_type, ucm_event_t *event,
+                                 void *arg)
+{
+    size_t page_size = ucs_get_page_size();
+    uintptr_t start, old_end, new_end;
+    uct_memfd_arena_t *arena;
+
+    switch (event_type) {
+    case UCM_EVENT_MMAP:
+        if ((event->mmap.result != MAP_FAILED) ||
+            (event->mmap.fd != uct_memfd_global.fd) ||
+            (event->mmap.offset != (uintptr_t)event->mmap.address)) {
+            break;
+        }
+
+        start = (uintptr_t)event->mmap.address;
+        uct_memfd_lock();
+        uct_memfd_arena_remove(start,
+                               start + ucs_align_up_pow2(event->mmap.size,
+                                                         page_size));
+        uct_memfd_unlock();
+        if (uct_memfd_hook_state.reserved) {
+            ucm_orig_munmap(event->mmap.address, event->mmap.size);
+        }
+        break;
+    case UCM_EVENT_MUNMAP:
+        if ((event->munmap.result != 0) || (uct_memfd_global.num_arenas == 0)) {
+            break;
+        }
+
+        start = (uintptr_t)event->munmap.address;
+        uct_memfd_lock();
+        uct_memfd_arena_remove(start,
+                               start + ucs_align_up_pow2(event->munmap.size,
+                                                         page_size));
+        uct_memfd_unlock();
+        break;
+    case UCM_EVENT_MREMAP:
+        if ((event->mremap.result == MAP_FAILED) ||
+            !uct_memfd_hook_state.remapped) {
+            break;
+        }
+
+        start   = (uintptr_t)event->mremap.address;
+        old_end = start + ucs_align_up_pow2(event->mremap.old_size, page_size);
+        new_end = start + ucs_align_up_pow2(event->mremap.new_size, page_size);
+        uct_memfd_lock();
+        if (new_end < old_end) {
+            uct_memfd_arena_remove(new_end, old_end);
+        } else if (new_end > old_end) {
+            arena = uct_memfd_arena_find(old_end - 1);
+            if ((arena != NULL) && (arena->end == old_end)) {
+                arena->end = new_end;
+            }
+        }
+        uct_memfd_unlock();
+        break;
+    default:
+        break;
+    }
+}
+
+static ucs_status_t uct_memfd_hook_enable()
+{
+    ucs_status_t status;
+
+    pthread_mutex_lock(&uct_memfd_global.hook_lock);
+    if (!uct_memfd_global.hook_installed) {
+        /* The hooks remain installed to track existing arenas even when no
+         * memory domain uses them */
+        status = ucm_set_event_handler(UCM_EVENT_MMAP | UCM_EVENT_MREMAP |
+                                       UCM_EVENT_MADVISE,
+                                       -UCT_MEMFD_HOOK_PRIORITY,
+                                       uct_memfd_pre_event, NULL);
+        if (status != UCS_OK) {
+            goto out;
+        }
+
+        status = ucm_set_event_handler(UCM_EVENT_MMAP | UCM_EVENT_MUNMAP |
+                                       UCM_EVENT_MREMAP,
+                                       UCT_MEMFD_HOOK_PRIORITY,
+                                       uct_memfd_post_event, NULL);
+        if (status != UCS_OK) {
+            ucm_unset_event_handler(UCM_EVENT_MMAP | UCM_EVENT_MREMAP |
+                                    UCM_EVENT_MADVISE, uct_memfd_pre_event,
+                                    NULL);
+            goto out;
+        }
+
+        uct_memfd_global.hook_installed = 1;
+    }
+
+    ++uct_memfd_global.hook_refcount;
+    status = UCS_OK;
+out:
+    pthread_mutex_unlock(&uct_memfd_global.hook_lock);
+    return status;
+}
+
+static void uct_memfd_hook_disable()
+{
+    pthread_mutex_lock(&uct_memfd_global.hook_lock);
+    ucs_assert(uct_memfd_global.hook_refcount > 0);
+    --uct_memfd_global.hook_refcount;
+    pthread_mutex_unlock(&uct_memfd_global.hook_lock);
+}
+
+static uct_memfd_md_config_t *uct_memfd_md_config(uct_md_h md)
+{
+    return ucs_derived_of(ucs_derived_of(md, uct_mm_md_t)->config,
+                          uct_memfd_md_config_t);
+}
+
+static ucs_status_t uct_memfd_query()
+{
+#ifdef __NR_memfd_create
+    static int supported = -1;
+    long ret;
+
+    /* Check the kernel support without creating the file, which is created
+     * only when the first arena is added: invalid flags fail with EINVAL, while
+     * a kernel without memfd_create() fails with ENOSYS */
+    if (supported < 0) {
+        ret = syscall(__NR_memfd_create, "ucx_memfd", UINT_MAX);
+        if (ret >= 0) {
+            close(ret);
+        }
+        supported = (ret >= 0) || (errno == EINVAL);
+    }
+
+    return supported ? UCS_OK : UCS_ERR_UNSUPPORTED;
+#else
+    return UCS_ERR_UNSUPPORTED;
+#endif
+}
+
+static size_t uct_memfd_get_path_size(uct_md_h md)
+{
+    return 0;
+}
+
+static uint8_t uct_memfd_get_priority()
+{
+    return 0;
+}
+
+static int uct_memfd_md_hook_mmap(uct_md_h md)
+{
+    uct_memfd_md_config_t *config = uct_memfd_md_config(md);
+
+    return config->enable && config->hook_mmap;
+}
+
+static ucs_status_t uct_memfd_md_open(uct_md_h md)
+{
+    if (!uct_memfd_md_hook_mmap(md)) {
+        return UCS_OK;
+    }
+
+    return uct_memfd_hook_enable();
+}
+
+static void uct_memfd_md_close(uct_md_h md)
+{
+    if (uct_memfd_md_hook_mmap(md)) {
+        uct_memfd_hook_disable();
+    }
+}
+
+static void uct_memfd_md_query(uct_md_h md, uct_md_attr_t *md_attr)
+{
+    /* When disabled, the MD does not allocate the shared file, so the mm
+     * transport does not use it */
+    if (!uct_memfd_md_config(md)->enable) {
+        md_attr->cap.flags &= ~(UCT_MD_FLAG_ALLOC | UCT_MD_FLAG_REG |
+                                UCT_MD_FLAG_RKEY_PTR);
+    } else if (!uct_memfd_md_config(md)->hook_mmap) {
+        /* Without the hook, only memory allocated by the MD is shareable */
+        md_attr->cap.flags &= ~UCT_MD_FLAG_REG;
+    }
+}
+
+static ucs_status_t uct_memfd_reg(void *address, size_t size,
+                                  uct_mm_id_t *mmid_p)
+{
+    uintptr_t start = ucs_align_down_pow2((uintptr_t)address,
+                                          ucs_get_page_size());
+    uintptr_t end   = ucs_align_up_pow2((uintptr_t)address + size,
+                                        ucs_get_page_size());
+    int covered;
+
+    uct_memfd_lock();
+    covered = uct_memfd_arena_covers(start, end);
+    if (covered) {
+        *mmid_p = uct_memfd_mmid(uct_memfd_global.fd);
+    }
+    uct_memfd_unlock();
+
+    if (!covered) {
+        ucs_debug("memfd cannot register %p..%p: not a shared memory mapping",
+                  (void*)start, (void*)end);
+        return UCS_ERR_UNSUPPORTED;
+    }
+
+    ucs_trace("memfd registered %p..%p", (void*)start, (void*)end);
+    return UCS_OK;
+}
+
+static ucs_status_t uct_memfd_dereg(uct_mm_id_t mmid)
+{
+    /* The pages are released when the memory is unmapped */
+    return UCS_OK;
+}
+
+static ucs_status_t uct_memfd_alloc(uct_md_h md, size_t *length_p,
+                                    ucs_ternary_value_t hugetlb,
+                                    unsigned md_map_flags, const char *alloc_name,
+                                    void **address_p, uct_mm_id_t *mmid_p,
+                                    const char **path_p)
+{
+    ucs_status_t status;
+    size_t length;
+    void *address;
+    int fd;
+
+    if (0 == *length_p) {
+        ucs_error("Unexpected length %zu", *length_p);
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    length = ucs_align_up_pow2(*length_p, ucs_get_page_size());
+
+    if (md_map_flags & UCT_MD_MEM_FLAG_FIXED) {
+        address = *address_p;
+    } else {
+        /* Reserve the address, since the file offset is determined by it */
+        address = mmap(NULL, length, PROT_NONE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (address == MAP_FAILED) {
+            ucs_error("failed to reserve %zu bytes for %s: %m", length,
+                      alloc_name);
+            return UCS_ERR_NO_MEMORY;
+        }
+    }
+
+    uct_memfd_lock();
+    status = uct_memfd_arena_add((uintptr_t)address, (uintptr_t)address + length,
+                                 0);
+    fd     = uct_memfd_global.fd;
+    if (status == UCS_OK) {
+        *mmid_p = uct_memfd_mmid(fd);
+    }
+    uct_memfd_unlock();
+    if (status != UCS_OK) {
+        ucs_error("failed to add memfd arena for %s", alloc_name);
+        goto err_unmap;
+    }
+
+    if (ucs_mmap(address, length, UCT_MEMFD_MMAP_PROT, MAP_SHARED | MAP_FIXED,
+                 fd, (uintptr_t)address,
+                 alloc_name) == MAP_FAILED) {
+        ucs_error("failed to map memfd at %p length %zu for %s: %m", address,
+                  length, alloc_name);
+        status = UCS_ERR_NO_MEMORY;
+        goto err_remove;
+    }
+
+    ucs_trace("memfd allocated address %p length %zu for %s", address, length,
+              alloc_name);
+    *address_p = address;
+    *length_p  = length;
+    return UCS_OK;
+
+err_remove:
+    uct_memfd_lock();
+    uct_memfd_arena_remove((uintptr_t)address, (uintptr_t)address + length);
+    uct_memfd_unlock();
+err_unmap:
+    if (!(md_map_flags & UCT_MD_MEM_FLAG_FIXED)) {
+        munmap(address, length);
+    }
+    return status;
+}
+
+static ucs_status_t uct_memfd_free(void *address, uct_mm_id_t mmid,
+                                   size_t length, const char *path)
+{
+    /* The hook releases the pages as well when it is installed */
+    uct_memfd_lock();
+    uct_memfd_arena_remove((uintptr_t)address, (uintptr_t)address + length);
+    uct_memfd_unlock();
+
+    if (ucs_munmap(address, length) != 0) {
+        ucs_error("munmap(address=%p, length=%zu) failed: %m", address, length);
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    return UCS_OK;
+}
+
+static ucs_status_t uct_memfd_attach(uct_mm_id_t mmid, size_t length,
+                                     void *remote_address, void **local_address,
+                                     uint64_t *cookie, const char *path)
+{
+    size_t offset = (uintptr_t)remote_address & (ucs_get_page_size() - 1);
+    char file_name[NAME_MAX];
+    size_t map_length;
+    void *ptr;
+    int fd;
+
+    snprintf(file_name, sizeof(file_name), "/proc/%d/fd/%d",
+             (int)(mmid >> UCT_MEMFD_PID_SHIFT),
+             (int)((mmid >> UCT_MEMFD_FD_SHIFT) & UCS_MASK(UCT_MEMFD_FD_BITS)));
+    /* The attach is synchronous, so the file is opened through procfs rather
+     * than received from the owner over the signal socket of the interface,
+     * which would require the owner to progress */
+    fd = open(file_name, O_RDWR);
+    if (fd < 0) {
+        ucs_error("failed to open %s: %m%s", file_name,
+                  ((errno == EACCES) || (errno == EPERM)) ?
+                  " (requires ptrace read access to the owner process)" : "");
+        return UCS_ERR_SHMEM_SEGMENT;
+    }
+
+    map_length = ucs_align_up_pow2(length + offset, ucs_get_page_size());
+    ptr        = ucs_mmap(NULL, map_length, UCT_MEMFD_MMAP_PROT, MAP_SHARED, fd,
+                          (uintptr_t)remote_address - offset,
+                          "memfd attach");
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        ucs_error("failed to map %s at offset %p length %zu: %m", file_name,
+                  remote_address, length);
+        return UCS_ERR_SHMEM_SEGMENT;
+    }
+
+    ucs_trace("memfd attached %s %p..%p at %p", file_name, remote_address,
+              remote_address + length, ptr + offset);
+    *local_address = ptr + offset;
+    *cookie        = 0;
+    return UCS_OK;
+}
+
+static ucs_status_t uct_memfd_detach(uct_mm_remote_seg_t *mm_desc)
+{
+    size_t offset = (uintptr_t)mm_desc->address & (ucs_get_page_size() - 1);
+    void *address = mm_desc->address - offset;
+
+    if (ucs_munmap(address,
+                   ucs_align_up_pow2(mm_desc->length + offset,
+                                     ucs_get_page_size())) != 0) {
+        ucs_warn("unable to unmap memfd segment at %p: %m", address);
+        return UCS_ERR_IO_ERROR;
+    }
+
+    return UCS_OK;
+}
+
+static uct_mm_mapper_ops_t uct_memfd_mapper_ops = {
+   .query         = uct_memfd_query,
+   .get_path_size = uct_memfd_get_path_size,
+   .get_priority  = uct_memfd_get_priority,
+   .md_open       = uct_memfd_md_open,
+   .md_close      = uct_memfd_md_close,
+   .md_query      = uct_memfd_md_query,
+   .reg           = uct_memfd_reg,
+   .dereg         = uct_memfd_dereg,
+   .alloc         = uct_memfd_alloc,
+   .attach        = uct_memfd_attach,
+   .detach        = uct_memfd_detach,
+   .free          = uct_memfd_free
+};
+
+UCT_MM_COMPONENT_DEFINE(uct_memfd_md, "memfd", &uct_memfd_mapper_ops, uct_memfd, "MEMFD_")
+UCT_MD_REGISTER_TL(&uct_memfd_md, &uct_mm_tl);
@@ -6,6 +6,7 @@
 #include "self.h"
 
 #include <uct/sm/base/sm_ep.h>
+#include <uct/sm/base/sm_iface.h>
 #include <ucs/type/class.h>
 #include <ucs/sys/string.h>
 #include <ucs/arch/cpu.h>
@@ -44,9 +45,12 @@ static ucs_status_t uct_self_iface_query(uct_iface_h tl_iface, uct_iface_attr_t
     attr->cap.flags              = UCT_IFACE_FLAG_CONNECT_TO_IFACE |
                                    UCT_IFACE_FLAG_AM_SHORT         |
                                    UCT_IFACE_FLAG_AM_BCOPY         |
+                                   UCT_IFACE_FLAG_AM_ZCOPY         |
                                    UCT_IFACE_FLAG_PUT_SHORT        |
                                    UCT_IFACE_FLAG_PUT_BCOPY        |
+                                   UCT_IFACE_FLAG_PUT_ZCOPY        |
                                    UCT_IFACE_FLAG_GET_BCOPY        |
+                                   UCT_IFACE_FLAG_GET_ZCOPY        |
                                    UCT_IFACE_FLAG_ATOMIC_CPU       |
                                    UCT_IFACE_FLAG_PENDING          |
                                    UCT_IFACE_FLAG_CB_SYNC          |
@@ -68,26 +72,26 @@ static ucs_status_t uct_self_iface_query(uct_iface_h tl_iface, uct_iface_attr_t
     attr->cap.put.max_short       = UINT_MAX;
     attr->cap.put.max_bcopy       = SIZE_MAX;
     attr->cap.put.min_zcopy       = 0;
-    attr->cap.put.max_zcopy       = 0;
+    attr->cap.put.max_zcopy       = SIZE_MAX;
     attr->cap.put.opt_zcopy_align = 1;
     attr->cap.put.align_mtu       = attr->cap.put.opt_zcopy_align;
-    attr->cap.put.max_iov         = 1;
+    attr->cap.put.max_iov         = uct_sm_get_max_iov();
 
     attr->cap.get.max_bcopy       = SIZE_MAX;
     attr->cap.get.min_zcopy       = 0;
-    attr->cap.get.max_zcopy       = 0;
+    attr->cap.get.max_zcopy       = SIZE_MAX;
     attr->cap.get.opt_zcopy_align = 1;
     attr->cap.get.align_mtu       = attr->cap.get.opt_zcopy_align;
-    attr->cap.get.max_iov         = 1;
+    attr->cap.get.max_iov         = uct_sm_get_max_iov();
 
     attr->cap.am.max_short        = iface->send_size;
     attr->cap.am.max_bcopy        = iface->send_size;
     attr->cap.am.min_zcopy        = 0;
-    attr->cap.am.max_zcopy        = 0;
+    attr->cap.am.max_zcopy        = iface->send_size;
     attr->cap.am.opt_zcopy_align  = 1;
     attr->cap.am.align_mtu        = attr->cap.am.opt_zcopy_align;
-    attr->cap.am.max_hdr          = 0;
-    attr->cap.am.max_iov          = 1;
+    attr->cap.am.max_hdr          = iface->send_size;
+    attr->cap.am.max_iov          = uct_sm_get_max_iov();
 
     attr->latency.overhead        = 0;
     attr->latency.growth          = 0;
@@ -117,8 +121,8 @@ static int uct_self_iface_is_reachable(const uct_iface_h tl_iface,
     return (addr != NULL) && (iface->id == *addr);
 }
 
-static void uct_self_iface_sendrecv_am(uct_self_iface_t *iface, uint8_t am_id,
-                                       void *buffer, size_t length, const char *title)
+static void uct_self_iface_recv_am(uct_self_iface_t *iface, uint8_t am_id,
+                                   void *buffer, size_t length, const char *title)
 {
     ucs_status_t UCS_V_UNUSED status;
 
@@ -130,6 +134,12 @@ static void uct_self_iface_sendrecv_am(uct_self_iface_t *iface, uint8_t am_id,
     status = uct_iface_invoke_am(&iface->super, am_id, buffer,
                                  length, 0);
     ucs_assert(status == UCS_OK);
+}
+
+static void uct_self_iface_sendrecv_am(uct_self_iface_t *iface, uint8_t am_id,
+                                       void *buffer, size_t length, const char *title)
+{
+    uct_self_iface_recv_am(iface, am_id, buffer, length, title);
     ucs_mpool_put_inline(buffer);
 }
 
@@ -281,12 +291,102 @@ ssize_t uct_self_ep_am_bcopy(uct_ep_h tl_ep, uint8_t id,
     return length;
 }
 
+/*
+ * Copy between the iov and a contiguous buffer: from the iov to the buffer if
+ * 'is_put' is nonzero, and from the buffer to the iov otherwise.
+ */
+static UCS_F_ALWAYS_INLINE void
+uct_self_iov_copy(const uct_iov_t *iov, size_t iovcnt, void *buffer, int is_put)
+{
+    size_t iov_it, elem_it;
+    void *iov_elem;
+
+    for (iov_it = 0; iov_it < iovcnt; ++iov_it) {
+        for (elem_it = 0; elem_it < iov[iov_it].count; ++elem_it) {
+            iov_elem = UCS_PTR_BYTE_OFFSET(iov[iov_it].buffer,
+                                           elem_it * iov[iov_it].stride);
+            if (is_put) {
+                ucs_memcpy_relaxed(buffer, iov_elem, iov[iov_it].length);
+            } else {
+                ucs_memcpy_relaxed(iov_elem, buffer, iov[iov_it].length);
+            }
+            buffer = UCS_PTR_BYTE_OFFSET(buffer, iov[iov_it].length);
+        }
+    }
+}
+
+ucs_status_t uct_self_ep_am_zcopy(uct_ep_h tl_ep, uint8_t id, const void *header,
+                                  unsigned header_length, const uct_iov_t *iov,
+                                  size_t iovcnt, unsigned flags,
+                                  uct_completion_t *comp)
+{
+    uct_self_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_self_iface_t);
+    uct_self_ep_t UCS_V_UNUSED *ep = ucs_derived_of(tl_ep, uct_self_ep_t);
+    size_t total_length;
+    void *send_buffer;
+
+    UCT_CHECK_AM_ID(id);
+    UCT_CHECK_IOV_SIZE(iovcnt, uct_sm_get_max_iov(), "uct_self_ep_am_zcopy");
+
+    total_length = header_length + uct_iov_total_length(iov, iovcnt);
+    UCT_CHECK_LENGTH(total_length, 0, iface->send_size, "am_zcopy");
+    UCT_TL_EP_STAT_OP(&ep->super, AM, ZCOPY, total_length);
+
+    if ((header_length == 0) && (iovcnt == 1) && (iov->count == 1)) {
+        /* The handler is called synchronously, so a contiguous message can be
+         * passed to it from the user buffer */
+        uct_self_iface_recv_am(iface, id, iov->buffer, total_length, "ZCOPY");
+        return UCS_OK;
+    }
+
+    send_buffer = UCT_SELF_IFACE_SEND_BUFFER_GET(iface);
+    memcpy(send_buffer, header, header_length);
+    uct_self_iov_copy(iov, iovcnt,
+                      UCS_PTR_BYTE_OFFSET(send_buffer, header_length), 1);
+
+    uct_self_iface_sendrecv_am(iface, id, send_buffer, total_length, "ZCOPY");
+    return UCS_OK;
+}
+
+ucs_status_t uct_self_ep_put_zcopy(uct_ep_h tl_ep, const uct_iov_t *iov,
+                                   size_t iovcnt, uint64_t remote_addr,
+                                   uct_rkey_t rkey, uct_completion_t *comp)
+{
+    size_t length = uct_iov_total_length(iov, iovcnt);
+
+    UCT_CHECK_IOV_SIZE(iovcnt, uct_sm_get_max_iov(), "uct_self_ep_put_zcopy");
+
+    uct_self_iov_copy(iov, iovcnt, (void*)(rkey + remote_addr), 1);
+    ucs_trace_data("PUT_ZCOPY [length %zu] to 0x%"PRIx64"(%+ld)", length,
+                   remote_addr, rkey);
+    UCT_TL_EP_STAT_OP(ucs_derived_of(tl_ep, uct_base_ep_t), PUT, ZCOPY, length);
+    return UCS_OK;
+}
+
+ucs_status_t uct_self_ep_get_zcopy(uct_ep_h tl_ep, const uct_iov_t *iov,
+                                   size_t iovcnt, uint64_t remote_addr,
+                                   uct_rkey_t rkey, uct_completion_t *comp)
+{
+    size_t length = uct_iov_total_length(iov, iovcnt);
+
+    UCT_CHECK_IOV_SIZE(iovcnt, uct_sm_get_max_iov(), "uct_self_ep_get_zcopy");
+
+    uct_self_iov_copy(iov, iovcnt, (void*)(rkey + remote_addr), 0);
+    ucs_trace_data("GET_ZCOPY [length %zu] from 0x%"PRIx64"(%+ld)", length,
+                   remote_addr, rkey);
+    UCT_TL_EP_STAT_OP(ucs_derived_of(tl_ep, uct_base_ep_t), GET, ZCOPY, length);
+    return UCS_OK;
+}
+
 static uct_iface_ops_t uct_self_iface_ops = {
     .ep_put_short             = uct_sm_ep_put_short,
     .ep_put_bcopy             = uct_sm_ep_put_bcopy,
+    .ep_put_zcopy             = uct_self_ep_put_zcopy,
     .ep_get_bcopy             = uct_sm_ep_get_bcopy,
+    .ep_get_zcopy             = uct_self_ep_get_zcopy,
     .ep_am_short              = uct_self_ep_am_short,
     .ep_am_bcopy              = uct_self_ep_am_bcopy,
+    .ep_am_zcopy              = uct_self_ep_am_zcopy,
     .ep_atomic_cswap64        = uct_sm_ep_atomic_cswap64,
     .ep_atomic64_post         = uct_sm_ep_atomic64_post,
     .ep_atomic64_fetch        = uct_sm_ep_atomic64_fetch,
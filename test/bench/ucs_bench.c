@@ -0,0 +1,1040 @@
+/**
+* Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+*
+* See file LICENSE for terms.
+*/
+
+/*
+ * Microbenchmarks for UCS data structures used on the fast path.
+ *
+ * Every benchmark runs a number of iterations, each of them performs <size>
+ * operations on the data structure. The time is measured with ucs_get_time(),
+ * which reads the CPU cycle counter where available, and the result is reported
+ * in clock ticks and nanoseconds per operation.
+ *
+ * With more than one thread, all threads operate on the same data structure.
+ * Read-only operations (lookups) run without a lock, and the other operations
+ * are serialized with a spinlock, the same way UCP protects its shared worker
+ * resources. The callback queue benchmark exercises its own thread-safe API
+ * instead: thread 0 dispatches, and the other threads add callbacks.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <ucs/arch/atomic.h>
+#include <ucs/datastruct/arbiter.h>
+#include <ucs/datastruct/callbackq.h>
+#include <ucs/datastruct/frag_list.h>
+#include <ucs/datastruct/khash.h>
+#include <ucs/datastruct/mpool.inl>
+#include <ucs/datastruct/pgtable.h>
+#include <ucs/datastruct/ptr_array.h>
+#include <ucs/datastruct/queue.h>
+#include <ucs/datastruct/strided_alloc.h>
+#include <ucs/debug/memtrack.h>
+#include <ucs/sys/compiler_def.h>
+#include <ucs/sys/sys.h>
+#include <ucs/time/time.h>
+#include <ucs/type/spinlock.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdio.h>
+
+
+#define UCS_BENCH_PAGE_SIZE       4096
+#define UCS_BENCH_CBQ_PERSISTENT  4   /* Persistent callbacks in callbackq */
+
+
+typedef enum {
+    UCS_BENCH_FORMAT_TABLE,
+    UCS_BENCH_FORMAT_CSV,
+    UCS_BENCH_FORMAT_JSON
+} ucs_bench_format_t;
+
+
+typedef struct ucs_bench_params {
+    unsigned long                  iters;       /* Iterations per thread */
+    unsigned                       size;        /* Operations per iteration */
+    unsigned                       num_threads;
+    unsigned                       repeat;      /* How many times to repeat */
+    ucs_bench_format_t             format;
+} ucs_bench_params_t;
+
+
+KHASH_MAP_INIT_INT64(ucs_bench_hash, void*);
+
+
+typedef struct ucs_bench ucs_bench_t;
+
+
+typedef struct ucs_bench_ctx {
+    const ucs_bench_t              *bench;
+    const ucs_bench_params_t       *params;
+    ucs_spinlock_t                 lock;
+    int                            locked;      /* Serialize operations */
+    pthread_barrier_t              barrier;
+    volatile uint32_t              active;      /* Threads still running */
+    union {
+        ucs_mpool_t                mpool;
+        struct {
+            ucs_arbiter_t          arbiter;
+            ucs_arbiter_group_t    *groups;
+            ucs_arbiter_elem_t     *elems;
+        } arbiter;
+        struct {
+            ucs_callbackq_t        cbq;
+            int                    ids[UCS_BENCH_CBQ_PERSISTENT];
+            volatile unsigned long count;
+        } callbackq;
+        struct {
+            ucs_pgtable_t          pgtable;
+            ucs_pgt_region_t       *regions;
+            ucs_pgt_addr_t         base;
+        } pgtable;
+        ucs_frag_list_t            frag_list;
+        khash_t(ucs_bench_hash)    hash;
+        ucs_ptr_array_t            ptr_array;
+        ucs_queue_head_t           queue;
+        ucs_strided_alloc_t        strided;
+    };
+} ucs_bench_ctx_t;
+
+
+typedef struct ucs_bench_thread {
+    ucs_bench_ctx_t                *ctx;
+    unsigned                       index;
+    pthread_t                      thread;
+    unsigned                       seed;
+    ucs_time_t                     start_time;
+    ucs_time_t                     end_time;
+    unsigned long                  ops;
+} ucs_bench_thread_t;
+
+
+struct ucs_bench {
+    const char                     *name;
+    const char                     *op;
+    const char                     *desc;
+    ucs_status_t                   (*init)(ucs_bench_ctx_t *ctx);
+    void                           (*run)(ucs_bench_thread_t *thread);
+    void                           (*cleanup)(ucs_bench_ctx_t *ctx);
+};
+
+
+typedef struct ucs_bench_result {
+    double                         ticks_per_op;
+    double                         nsec_per_op;
+    double                         mops;        /* Total rate, million ops/sec */
+} ucs_bench_result_t;
+
+
+static inline void ucs_bench_lock(ucs_bench_ctx_t *ctx)
+{
+    if (ctx->locked) {
+        ucs_spin_lock(&ctx->lock);
+    }
+}
+
+static inline void ucs_bench_unlock(ucs_bench_ctx_t *ctx)
+{
+    if (ctx->locked) {
+        ucs_spin_unlock(&ctx->lock);
+    }
+}
+
+static void ucs_bench_thread_start(ucs_bench_thread_t *thread)
+{
+    pthread_barrier_wait(&thread->ctx->barrier);
+    thread->start_time = ucs_get_time();
+}
+
+static void ucs_bench_thread_stop(ucs_bench_thread_t *thread, unsigned long ops)
+{
+    thread->end_time = ucs_get_time();
+    thread->ops      = ops;
+}
+
+/* Random permutation of 0..size-1, used to spread lookups over the table */
+static unsigned *ucs_bench_permutation(ucs_bench_thread_t *thread)
+{
+    unsigned size = thread->ctx->params->size;
+    unsigned *perm;
+    unsigned i, j, tmp;
+
+    perm = ucs_malloc(size * sizeof(*perm), "bench_perm");
+    if (perm == NULL) {
+        ucs_fatal("failed to allocate permutation array");
+    }
+
+    for (i = 0; i < size; ++i) {
+        perm[i] = i;
+    }
+    for (i = size - 1; i > 0; --i) {
+        j       = rand_r(&thread->seed) % (i + 1);
+        tmp     = perm[i];
+        perm[i] = perm[j];
+        perm[j] = tmp;
+    }
+    return perm;
+}
+
+static void **ucs_bench_ptr_array_alloc(ucs_bench_thread_t *thread)
+{
+    void **ptrs = ucs_calloc(thread->ctx->params->size, sizeof(*ptrs),
+                             "bench_ptrs");
+    if (ptrs == NULL) {
+        ucs_fatal("failed to allocate pointers array");
+    }
+    return ptrs;
+}
+
+
+/* ucs_mpool: get <size> elements, then put them back */
+
+static ucs_status_t ucs_bench_mpool_init(ucs_bench_ctx_t *ctx)
+{
+    static ucs_mpool_ops_t ops = {
+        .chunk_alloc   = ucs_mpool_chunk_malloc,
+        .chunk_release = ucs_mpool_chunk_free,
+        .obj_init      = NULL,
+        .obj_cleanup   = NULL
+    };
+
+    return ucs_mpool_init(&ctx->mpool, 0, 64, 0, UCS_SYS_CACHE_LINE_SIZE,
+                          ctx->params->size, UINT_MAX, &ops, "bench_mpool");
+}
+
+static void ucs_bench_mpool_run(ucs_bench_thread_t *thread)
+{
+    ucs_bench_ctx_t *ctx = thread->ctx;
+    unsigned size        = ctx->params->size;
+    void **objs          = ucs_bench_ptr_array_alloc(thread);
+    unsigned long iter;
+    unsigned i;
+
+    ucs_bench_thread_start(thread);
+    for (iter = 0; iter < ctx->params->iters; ++iter) {
+        for (i = 0; i < size; ++i) {
+            ucs_bench_lock(ctx);
+            objs[i] = ucs_mpool_get_inline(&ctx->mpool);
+            ucs_bench_unlock(ctx);
+        }
+        for (i = 0; i < size; ++i) {
+            ucs_bench_lock(ctx);
+            ucs_mpool_put_inline(objs[i]);
+            ucs_bench_unlock(ctx);
+        }
+    }
+    ucs_bench_thread_stop(thread, ctx->params->iters * size * 2);
+
+    ucs_free(objs);
+}
+
+static void ucs_bench_mpool_cleanup(ucs_bench_ctx_t *ctx)
+{
+    ucs_mpool_cleanup(&ctx->mpool, 1);
+}
+
+
+/* ucs_arbiter: push an element to each of <size> groups and dispatch them */
+
+static ucs_status_t ucs_bench_arbiter_init(ucs_bench_ctx_t *ctx)
+{
+    unsigned count = ctx->params->size * ctx->params->num_threads;
+    unsigned i;
+
+    ctx->arbiter.groups = ucs_calloc(count, sizeof(*ctx->arbiter.groups),
+                                     "bench_arbiter_groups");
+    ctx->arbiter.elems  = ucs_calloc(count, sizeof(*ctx->arbiter.elems),
+                                     "bench_arbiter_elems");
+    if ((ctx->arbiter.groups == NULL) || (ctx->arbiter.elems == NULL)) {
+        ucs_free(ctx->arbiter.groups);
+        ucs_free(ctx->arbiter.elems);
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    ucs_arbiter_init(&ctx->arbiter.arbiter);
+    for (i = 0; i < count; ++i) {
+        ucs_arbiter_group_init(&ctx->arbiter.groups[i]);
+    }
+    return UCS_OK;
+}
+
+static ucs_arbiter_cb_result_t
+ucs_bench_arbiter_cb(ucs_arbiter_t *arbiter, ucs_arbiter_elem_t *elem,
+                     void *arg)
+{
+    ++(*(unsigned long*)arg);
+    return UCS_ARBITER_CB_RESULT_REMOVE_ELEM;
+}
+
+static void ucs_bench_arbiter_run(ucs_bench_thread_t *thread)
+{
+    ucs_bench_ctx_t *ctx         = thread->ctx;
+    unsigned size                = ctx->params->size;
+    ucs_arbiter_group_t *groups  = &ctx->arbiter.groups[thread->index * size];
+    ucs_arbiter_elem_t *elems    = &ctx->arbiter.elems[thread->index * size];
+    unsigned long dispatched     = 0;
+    unsigned long iter;
+    unsigned i;
+
+    ucs_bench_thread_start(thread);
+    for (iter = 0; iter < ctx->params->iters; ++iter) {
+        ucs_bench_lock(ctx);
+        for (i = 0; i < size; ++i) {
+            ucs_arbiter_elem_init(&elems[i]);
+            ucs_arbiter_group_push_elem(&groups[i], &elems[i]);
+            ucs_arbiter_group_schedule(&ctx->arbiter.arbiter, &groups[i]);
+        }
+        ucs_arbiter_dispatch(&ctx->arbiter.arbiter, 1, ucs_bench_arbiter_cb,
+                             &dispatched);
+        ucs_bench_unlock(ctx);
+    }
+    ucs_bench_thread_stop(thread, dispatched);
+}
+
+static void ucs_bench_arbiter_cleanup(ucs_bench_ctx_t *ctx)
+{
+    unsigned count = ctx->params->size * ctx->params->num_threads;
+    unsigned i;
+
+    for (i = 0; i < count; ++i) {
+        ucs_arbiter_group_cleanup(&ctx->arbiter.groups[i]);
+    }
+    ucs_arbiter_cleanup(&ctx->arbiter.arbiter);
+    ucs_free(ctx->arbiter.elems);
+    ucs_free(ctx->arbiter.groups);
+}
+
+
+/*
+ * ucs_callbackq: thread 0 dispatches a queue with a few persistent callbacks;
+ * the other threads add one-shot callbacks with the thread-safe API and wait
+ * for them to be called.
+ */
+
+static unsigned ucs_bench_callbackq_cb(void *arg)
+{
+    ++(*(volatile unsigned long*)arg);
+    return 1;
+}
+
+static unsigned ucs_bench_callbackq_oneshot_cb(void *arg)
+{
+    *(volatile int*)arg = 1;
+    return 1;
+}
+
+static ucs_status_t ucs_bench_callbackq_init(ucs_bench_ctx_t *ctx)
+{
+    ucs_status_t status;
+    unsigned i;
+
+    status = ucs_callbackq_init(&ctx->callbackq.cbq);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    ctx->callbackq.count = 0;
+    for (i = 0; i < UCS_BENCH_CBQ_PERSISTENT; ++i) {
+        ctx->callbackq.ids[i] = ucs_callbackq_add(&ctx->callbackq.cbq,
+                                                  ucs_bench_callbackq_cb,
+                                                  (void*)&ctx->callbackq.count,
+                                                  UCS_CALLBACKQ_FLAG_FAST);
+    }
+    return UCS_OK;
+}
+
+static void ucs_bench_callbackq_run(ucs_bench_thread_t *thread)
+{
+    ucs_bench_ctx_t *ctx = thread->ctx;
+    unsigned long count  = ctx->params->iters * ctx->params->size;
+    unsigned long i;
+    volatile int done;
+
+    ucs_bench_thread_start(thread);
+    if (thread->index == 0) {
+        /* Keep dispatching until all other threads are done adding */
+        for (i = 0; (i < count) || (ctx->active > 1); ++i) {
+            ucs_callbackq_dispatch(&ctx->callbackq.cbq);
+        }
+    } else {
+        for (i = 0; i < count; ++i) {
+            done = 0;
+            ucs_callbackq_add_safe(&ctx->callbackq.cbq,
+                                   ucs_bench_callbackq_oneshot_cb,
+                                   (void*)&done, UCS_CALLBACKQ_FLAG_ONESHOT);
+            /* Yield to let the dispatching thread run on a shared core */
+            while (!done) {
+                sched_yield();
+            }
+        }
+    }
+    ucs_bench_thread_stop(thread, i);
+
+    ucs_atomic_add32(&ctx->active, -1);
+}
+
+static void ucs_bench_callbackq_cleanup(ucs_bench_ctx_t *ctx)
+{
+    unsigned i;
+
+    for (i = 0; i < UCS_BENCH_CBQ_PERSISTENT; ++i) {
+        ucs_callbackq_remove(&ctx->callbackq.cbq, ctx->callbackq.ids[i]);
+    }
+    ucs_callbackq_cleanup(&ctx->callbackq.cbq);
+}
+
+
+/* ucs_pgtable: look up random addresses in a table of <size> regions */
+
+static ucs_pgt_dir_t *ucs_bench_pgt_dir_alloc(const ucs_pgtable_t *pgtable)
+{
+    return ucs_memalign(UCS_PGT_ENTRY_MIN_ALIGN, sizeof(ucs_pgt_dir_t),
+                        "bench_pgdir");
+}
+
+static void ucs_bench_pgt_dir_release(const ucs_pgtable_t *pgtable,
+                                      ucs_pgt_dir_t *dir)
+{
+    ucs_free(dir);
+}
+
+static ucs_status_t ucs_bench_pgtable_init(ucs_bench_ctx_t *ctx)
+{
+    unsigned size = ctx->params->size;
+    ucs_status_t status;
+    unsigned i;
+
+    status = ucs_pgtable_init(&ctx->pgtable.pgtable, ucs_bench_pgt_dir_alloc,
+                              ucs_bench_pgt_dir_release);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    ctx->pgtable.regions = ucs_memalign(UCS_SYS_CACHE_LINE_SIZE,
+                                        size * sizeof(*ctx->pgtable.regions),
+                                        "bench_pgt_regions");
+    if (ctx->pgtable.regions == NULL) {
+        ucs_pgtable_cleanup(&ctx->pgtable.pgtable);
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    /* Regions of growing size, separated by gaps, like registered buffers */
+    ctx->pgtable.base = 0x7f0000000000ul;
+    for (i = 0; i < size; ++i) {
+        ctx->pgtable.regions[i].start = ctx->pgtable.base +
+                                        (i * 16ul * UCS_BENCH_PAGE_SIZE);
+        ctx->pgtable.regions[i].end   = ctx->pgtable.regions[i].start +
+                                        ((i % 8) + 1) * UCS_BENCH_PAGE_SIZE;
+        status = ucs_pgtable_insert(&ctx->pgtable.pgtable,
+                                    &ctx->pgtable.regions[i]);
+        if (status != UCS_OK) {
+            ucs_fatal("failed to insert pgtable region: %s",
+                      ucs_status_string(status));
+        }
+    }
+    return UCS_OK;
+}
+
+static void ucs_bench_pgtable_run(ucs_bench_thread_t *thread)
+{
+    ucs_bench_ctx_t *ctx  = thread->ctx;
+    unsigned size         = ctx->params->size;
+    unsigned *perm        = ucs_bench_permutation(thread);
+    unsigned long found   = 0;
+    ucs_pgt_addr_t *addrs;
+    unsigned long iter;
+    unsigned i;
+
+    addrs = ucs_malloc(size * sizeof(*addrs), "bench_pgt_addrs");
+    if (addrs == NULL) {
+        ucs_fatal("failed to allocate addresses array");
+    }
+    for (i = 0; i < size; ++i) {
+        addrs[i] = ctx->pgtable.regions[perm[i]].start + (i % UCS_BENCH_PAGE_SIZE);
+    }
+
+    ucs_bench_thread_start(thread);
+    for (iter = 0; iter < ctx->params->iters; ++iter) {
+        for (i = 0; i < size; ++i) {
+            found += (ucs_pgtable_lookup(&ctx->pgtable.pgtable, addrs[i]) != NULL);
+        }
+    }
+    ucs_bench_thread_stop(thread, ctx->params->iters * size);
+
+    ucs_assert_always(found == ctx->params->iters * size);
+    ucs_free(addrs);
+    ucs_free(perm);
+}
+
+static void ucs_bench_pgtable_cleanup(ucs_bench_ctx_t *ctx)
+{
+    unsigned i;
+
+    for (i = 0; i < ctx->params->size; ++i) {
+        ucs_pgtable_remove(&ctx->pgtable.pgtable, &ctx->pgtable.regions[i]);
+    }
+    ucs_free(ctx->pgtable.regions);
+    ucs_pgtable_cleanup(&ctx->pgtable.pgtable);
+}
+
+
+/*
+ * ucs_frag_list: insert a window of <size> fragments with the first one
+ * arriving last, and pull them in order
+ */
+
+static ucs_status_t ucs_bench_frag_list_init(ucs_bench_ctx_t *ctx)
+{
+    return ucs_frag_list_init(0, &ctx->frag_list, -1 UCS_STATS_ARG(NULL));
+}
+
+static void ucs_bench_frag_list_run(ucs_bench_thread_t *thread)
+{
+    ucs_bench_ctx_t *ctx        = thread->ctx;
+    unsigned size               = ctx->params->size;
+    unsigned long pulled        = 0;
+    ucs_frag_list_elem_t *elems;
+    ucs_frag_list_ooo_type_t type;
+    ucs_frag_list_sn_t sn;
+    unsigned long iter;
+    unsigned i;
+
+    elems = ucs_calloc(size, sizeof(*elems), "bench_frag_elems");
+    if (elems == NULL) {
+        ucs_fatal("failed to allocate fragments array");
+    }
+
+    ucs_bench_thread_start(thread);
+    for (iter = 0; iter < ctx->params->iters; ++iter) {
+        ucs_bench_lock(ctx);
+        sn = ucs_frag_list_sn(&ctx->frag_list);
+        for (i = 1; i < size; ++i) {
+            ucs_frag_list_insert(&ctx->frag_list, &elems[i], sn + 1 + i);
+        }
+        type = ucs_frag_list_insert(&ctx->frag_list, &elems[0], sn + 1);
+        ++pulled;
+        if (type == UCS_FRAG_LIST_INSERT_FIRST) {
+            while (ucs_frag_list_pull(&ctx->frag_list) != NULL) {
+                ++pulled;
+            }
+        }
+        ucs_bench_unlock(ctx);
+    }
+    ucs_bench_thread_stop(thread, pulled);
+
+    ucs_free(elems);
+}
+
+static void ucs_bench_frag_list_cleanup(ucs_bench_ctx_t *ctx)
+{
+    ucs_frag_list_cleanup(&ctx->frag_list);
+}
+
+
+/* khash: look up random keys in a table of <size> entries */
+
+static ucs_status_t ucs_bench_khash_init(ucs_bench_ctx_t *ctx)
+{
+    khiter_t iter;
+    unsigned i;
+    int ret;
+
+    kh_init_inplace(ucs_bench_hash, &ctx->hash);
+    for (i = 0; i < ctx->params->size; ++i) {
+        iter = kh_put(ucs_bench_hash, &ctx->hash, (uint64_t)i * 0x9e3779b9ul,
+                      &ret);
+        if (ret < 0) {
+            kh_destroy_inplace(ucs_bench_hash, &ctx->hash);
+            return UCS_ERR_NO_MEMORY;
+        }
+        kh_value(&ctx->hash, iter) = ctx;
+    }
+    return UCS_OK;
+}
+
+static void ucs_bench_khash_run(ucs_bench_thread_t *thread)
+{
+    ucs_bench_ctx_t *ctx = thread->ctx;
+    unsigned size        = ctx->params->size;
+    unsigned *perm       = ucs_bench_permutation(thread);
+    unsigned long found  = 0;
+    uint64_t *keys;
+    unsigned long iter;
+    unsigned i;
+
+    keys = ucs_malloc(size * sizeof(*keys), "bench_khash_keys");
+    if (keys == NULL) {
+        ucs_fatal("failed to allocate keys array");
+    }
+    for (i = 0; i < size; ++i) {
+        keys[i] = (uint64_t)perm[i] * 0x9e3779b9ul;
+    }
+
+    ucs_bench_thread_start(thread);
+    for (iter = 0; iter < ctx->params->iters; ++iter) {
+        for (i = 0; i < size; ++i) {
+            found += (kh_get(ucs_bench_hash, &ctx->hash, keys[i]) !=
+                      kh_end(&ctx->hash));
+        }
+    }
+    ucs_bench_thread_stop(thread, ctx->params->iters * size);
+
+    ucs_assert_always(found == ctx->params->iters * size);
+    ucs_free(keys);
+    ucs_free(perm);
+}
+
+static void ucs_bench_khash_cleanup(ucs_bench_ctx_t *ctx)
+{
+    kh_destroy_inplace(ucs_bench_hash, &ctx->hash);
+}
+
+
+/* ucs_ptr_array: insert <size> values, look them up, and remove them */
+
+static ucs_status_t ucs_bench_ptr_array_init(ucs_bench_ctx_t *ctx)
+{
+    ucs_ptr_array_init(&ctx->ptr_array, 0, "bench_ptr_array");
+    return UCS_OK;
+}
+
+static void ucs_bench_ptr_array_run(ucs_bench_thread_t *thread)
+{
+    ucs_bench_ctx_t *ctx  = thread->ctx;
+    unsigned size         = ctx->params->size;
+    unsigned long found   = 0;
+    uint32_t placeholder;
+    unsigned *indices;
+    unsigned long iter;
+    unsigned i;
+    void *value;
+
+    indices = ucs_malloc(size * sizeof(*indices), "bench_ptr_indices");
+    if (indices == NULL) {
+        ucs_fatal("failed to allocate indices array");
+    }
+
+    ucs_bench_thread_start(thread);
+    for (iter = 0; iter < ctx->params->iters; ++iter) {
+        ucs_bench_lock(ctx);
+        for (i = 0; i < size; ++i) {
+            indices[i] = ucs_ptr_array_insert(&ctx->ptr_array, ctx,
+                                              &placeholder);
+        }
+        for (i = 0; i < size; ++i) {
+            found += ucs_ptr_array_lookup(&ctx->ptr_array, indices[i], value);
+        }
+        for (i = 0; i < size; ++i) {
+            ucs_ptr_array_remove(&ctx->ptr_array, indices[i], 0);
+        }
+        ucs_bench_unlock(ctx);
+    }
+    ucs_bench_thread_stop(thread, ctx->params->iters * size * 3);
+
+    ucs_assert_always(found == ctx->params->iters * size);
+    ucs_free(indices);
+}
+
+static void ucs_bench_ptr_array_cleanup(ucs_bench_ctx_t *ctx)
+{
+    ucs_ptr_array_cleanup(&ctx->ptr_array);
+}
+
+
+/* ucs_queue: push <size> elements and pull them */
+
+static ucs_status_t ucs_bench_queue_init(ucs_bench_ctx_t *ctx)
+{
+    ucs_queue_head_init(&ctx->queue);
+    return UCS_OK;
+}
+
+static void ucs_bench_queue_run(ucs_bench_thread_t *thread)
+{
+    ucs_bench_ctx_t *ctx = thread->ctx;
+    unsigned size        = ctx->params->size;
+    ucs_queue_elem_t *elems;
+    unsigned long iter;
+    unsigned i;
+
+    elems = ucs_calloc(size, sizeof(*elems), "bench_queue_elems");
+    if (elems == NULL) {
+        ucs_fatal("failed to allocate queue elements");
+    }
+
+    ucs_bench_thread_start(thread);
+    for (iter = 0; iter < ctx->params->iters; ++iter) {
+        for (i = 0; i < size; ++i) {
+            ucs_bench_lock(ctx);
+            ucs_queue_push(&ctx->queue, &elems[i]);
+            ucs_bench_unlock(ctx);
+        }
+        for (i = 0; i < size; ++i) {
+            ucs_bench_lock(ctx);
+            ucs_queue_pull(&ctx->queue);
+            ucs_bench_unlock(ctx);
+        }
+    }
+    ucs_bench_thread_stop(thread, ctx->params->iters * size * 2);
+
+    ucs_free(elems);
+}
+
+
+/* ucs_strided_alloc: get <size> objects, then put them back */
+
+static ucs_status_t ucs_bench_strided_init(ucs_bench_ctx_t *ctx)
+{
+    ucs_strided_alloc_init(&ctx->strided, 64, 3);
+    return UCS_OK;
+}
+
+static void ucs_bench_strided_run(ucs_bench_thread_t *thread)
+{
+    ucs_bench_ctx_t *ctx = thread->ctx;
+    unsigned size        = ctx->params->size;
+    void **objs          = ucs_bench_ptr_array_alloc(thread);
+    unsigned long iter;
+    unsigned i;
+
+    ucs_bench_thread_start(thread);
+    for (iter = 0; iter < ctx->params->iters; ++iter) {
+        for (i = 0; i < size; ++i) {
+            ucs_bench_lock(ctx);
+            objs[i] = ucs_strided_alloc_get(&ctx->strided, "bench_strided");
+            ucs_bench_unlock(ctx);
+        }
+        for (i = 0; i < size; ++i) {
+            ucs_bench_lock(ctx);
+            ucs_strided_alloc_put(&ctx->strided, objs[i]);
+            ucs_bench_unlock(ctx);
+        }
+    }
+    ucs_bench_thread_stop(thread, ctx->params->iters * size * 2);
+
+    ucs_free(objs);
+}
+
+static void ucs_bench_strided_cleanup(ucs_bench_ctx_t *ctx)
+{
+    ucs_strided_alloc_cleanup(&ctx->strided);
+}
+
+
+static ucs_bench_t ucs_benchmarks[] = {
+    {"mpool", "get/put", "memory pool get and put",
+     ucs_bench_mpool_init, ucs_bench_mpool_run, ucs_bench_mpool_cleanup},
+    {"arbiter", "dispatch", "arbiter push, schedule and dispatch",
+     ucs_bench_arbiter_init, ucs_bench_arbiter_run, ucs_bench_arbiter_cleanup},
+    {"callbackq", "dispatch", "callback queue dispatch and add_safe",
+     ucs_bench_callbackq_init, ucs_bench_callbackq_run,
+     ucs_bench_callbackq_cleanup},
+    {"pgtable", "lookup", "page table lookup",
+     ucs_bench_pgtable_init, ucs_bench_pgtable_run, ucs_bench_pgtable_cleanup},
+    {"frag_list", "insert/pull", "out-of-order fragment list insert and pull",
+     ucs_bench_frag_list_init, ucs_bench_frag_list_run,
+     ucs_bench_frag_list_cleanup},
+    {"khash", "lookup", "64-bit key hash table lookup",
+     ucs_bench_khash_init, ucs_bench_khash_run, ucs_bench_khash_cleanup},
+    {"ptr_array", "insert/lookup/remove", "pointer array insert, lookup and remove",
+     ucs_bench_ptr_array_init, ucs_bench_ptr_array_run,
+     ucs_bench_ptr_array_cleanup},
+    {"queue", "push/pull", "queue push and pull",
+     ucs_bench_queue_init, ucs_bench_queue_run, NULL},
+    {"strided_alloc", "get/put", "strided allocator get and put",
+     ucs_bench_strided_init, ucs_bench_strided_run, ucs_bench_strided_cleanup},
+    {NULL}
+};
+
+
+static void *ucs_bench_thread_main(void *arg)
+{
+    ucs_bench_thread_t *thread = arg;
+
+    thread->ctx->bench->run(thread);
+    return NULL;
+}
+
+static ucs_status_t ucs_bench_run_once(const ucs_bench_t *bench,
+                                       const ucs_bench_params_t *params,
+                                       ucs_bench_result_t *result)
+{
+    ucs_bench_thread_t *threads;
+    ucs_bench_ctx_t ctx;
+    ucs_time_t start_time, end_time, total_ticks;
+    unsigned long total_ops;
+    ucs_status_t status;
+    unsigned i;
+    int ret;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.bench  = bench;
+    ctx.params = params;
+    ctx.locked = (params->num_threads > 1);
+    ctx.active = params->num_threads;
+
+    threads = ucs_calloc(params->num_threads, sizeof(*threads), "bench_threads");
+    if (threads == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    status = ucs_spinlock_init(&ctx.lock);
+    if (status != UCS_OK) {
+        goto out_free_threads;
+    }
+
+    pthread_barrier_init(&ctx.barrier, NULL, params->num_threads);
+
+    status = bench->init(&ctx);
+    if (status != UCS_OK) {
+        goto out_destroy_barrier;
+    }
+
+    for (i = 0; i < params->num_threads; ++i) {
+        threads[i].ctx   = &ctx;
+        threads[i].index = i;
+        threads[i].seed  = i + 1;
+        if (i == 0) {
+            continue;
+        }
+
+        ret = pthread_create(&threads[i].thread, NULL, ucs_bench_thread_main,
+                             &threads[i]);
+        if (ret != 0) {
+            ucs_fatal("failed to create thread: %m");
+        }
+    }
+
+    bench->run(&threads[0]);
+    for (i = 1; i < params->num_threads; ++i) {
+        pthread_join(threads[i].thread, NULL);
+    }
+
+    /* Per-operation cost is averaged over all threads, and the rate is the
+     * total number of operations over the time from the first thread start to
+     * the last thread end */
+    start_time  = threads[0].start_time;
+    end_time    = threads[0].end_time;
+    total_ticks = 0;
+    total_ops   = 0;
+    for (i = 0; i < params->num_threads; ++i) {
+        start_time   = ucs_min(start_time, threads[i].start_time);
+        end_time     = ucs_max(end_time,   threads[i].end_time);
+        total_ticks += threads[i].end_time - threads[i].start_time;
+        total_ops   += threads[i].ops;
+    }
+
+    result->ticks_per_op = (double)total_ticks / ucs_max(total_ops, 1);
+    result->nsec_per_op  = result->ticks_per_op * UCS_NSEC_PER_SEC /
+                           ucs_time_sec_value();
+    result->mops         = total_ops / ucs_time_to_sec(end_time - start_time) /
+                           1e6;
+
+    if (bench->cleanup != NULL) {
+        bench->cleanup(&ctx);
+    }
+out_destroy_barrier:
+    pthread_barrier_destroy(&ctx.barrier);
+    ucs_spinlock_destroy(&ctx.lock);
+out_free_threads:
+    ucs_free(threads);
+    return status;
+}
+
+static ucs_status_t ucs_bench_run(const ucs_bench_t *bench,
+                                  const ucs_bench_params_t *params)
+{
+    ucs_bench_result_t best, avg, result;
+    ucs_status_t status;
+    unsigned i;
+
+    memset(&avg,  0, sizeof(avg));
+    memset(&best, 0, sizeof(best));
+    for (i = 0; i < params->repeat; ++i) {
+        status = ucs_bench_run_once(bench, params, &result);
+        if (status != UCS_OK) {
+            fprintf(stderr, "%s: %s\n", bench->name, ucs_status_string(status));
+            return status;
+        }
+
+        if ((i == 0) || (result.ticks_per_op < best.ticks_per_op)) {
+            best = result;
+        }
+        avg.ticks_per_op += result.ticks_per_op / params->repeat;
+        avg.nsec_per_op  += result.nsec_per_op  / params->repeat;
+        avg.mops         += result.mops         / params->repeat;
+    }
+
+    switch (params->format) {
+    case UCS_BENCH_FORMAT_TABLE:
+        printf("| %-14s| %-21s| %7u | %6u | %10.2f | %10.2f | %9.2f | %9.2f | %10.3f |\n",
+               bench->name, bench->op, params->num_threads, params->size,
+               best.ticks_per_op, avg.ticks_per_op, best.nsec_per_op,
+               avg.nsec_per_op, best.mops);
+        break;
+    case UCS_BENCH_FORMAT_CSV:
+        printf("%s,%s,%u,%u,%lu,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+               bench->name, bench->op, params->num_threads, params->size,
+               params->iters, best.ticks_per_op, avg.ticks_per_op,
+               best.nsec_per_op, avg.nsec_per_op, best.mops);
+        break;
+    case UCS_BENCH_FORMAT_JSON:
+        printf("{\"bench\": \"%s\", \"op\": \"%s\", \"threads\": %u, "
+               "\"size\": %u, \"iters\": %lu, \"repeat\": %u, "
+               "\"ticks_per_op\": {\"best\": %.3f, \"avg\": %.3f}, "
+               "\"nsec_per_op\": {\"best\": %.3f, \"avg\": %.3f}, "
+               "\"mops\": {\"best\": %.3f, \"avg\": %.3f}}\n",
+               bench->name, bench->op, params->num_threads, params->size,
+               params->iters, params->repeat, best.ticks_per_op,
+               avg.ticks_per_op, best.nsec_per_op, avg.nsec_per_op, best.mops,
+               avg.mops);
+        break;
+    }
+    fflush(stdout);
+    return UCS_OK;
+}
+
+static void ucs_bench_print_header(const ucs_bench_params_t *params)
+{
+    switch (params->format) {
+    case UCS_BENCH_FORMAT_TABLE:
+        printf("# clock: %.2f MHz, iterations: %lu, repeat: %u\n",
+               ucs_time_sec_value() / 1e6, params->iters, params->repeat);
+        printf("+---------------+----------------------+---------+--------+"
+               "-------------------------+-----------------------+------------+\n");
+        printf("| %-14s| %-21s| %7s | %6s | %23s | %21s | %10s |\n",
+               "", "", "", "", "ticks/op", "nsec/op", "Mops/s");
+        printf("| %-14s| %-21s| %7s | %6s | %10s | %10s | %9s | %9s | %10s |\n",
+               "benchmark", "operation", "threads", "size", "best", "average",
+               "best", "average", "best");
+        printf("+---------------+----------------------+---------+--------+"
+               "------------+------------+-----------+-----------+------------+\n");
+        break;
+    case UCS_BENCH_FORMAT_CSV:
+        printf("benchmark,operation,threads,size,iters,ticks_best,ticks_avg,"
+               "nsec_best,nsec_avg,mops_best\n");
+        break;
+    case UCS_BENCH_FORMAT_JSON:
+        break;
+    }
+}
+
+static void ucs_bench_usage(const ucs_bench_params_t *params)
+{
+    const ucs_bench_t *bench;
+
+    printf("Usage: ucs_bench [options]\n");
+    printf("\n");
+    printf("  -b <name>      Benchmark to run, may be given several times\n");
+    printf("                 (default: all of them):\n");
+    for (bench = ucs_benchmarks; bench->name != NULL; ++bench) {
+        printf("                   %-14s - %s\n", bench->name, bench->desc);
+    }
+    printf("  -n <iters>     Number of iterations per thread (%lu)\n",
+           params->iters);
+    printf("  -s <size>      Operations per iteration (%u)\n", params->size);
+    printf("  -t <threads>   Number of threads sharing the data structure (%u)\n",
+           params->num_threads);
+    printf("  -r <count>     Repeat every benchmark and report the best and\n");
+    printf("                 the average result (%u)\n", params->repeat);
+    printf("  -f <format>    Output format: table, csv, json (table)\n");
+    printf("  -h             Show this help message\n");
+}
+
+int main(int argc, char **argv)
+{
+    const ucs_bench_t *selected[ucs_static_array_size(ucs_benchmarks)];
+    unsigned num_selected = 0;
+    ucs_bench_params_t params;
+    const ucs_bench_t *bench;
+    int ret = 0;
+    unsigned i;
+    int c;
+
+    params.iters       = 10000;
+    params.size        = 64;
+    params.num_threads = 1;
+    params.repeat      = 5;
+    params.format      = UCS_BENCH_FORMAT_TABLE;
+
+    while ((c = getopt(argc, argv, "b:n:s:t:r:f:h")) != -1) {
+        switch (c) {
+        case 'b':
+            for (bench = ucs_benchmarks; bench->name != NULL; ++bench) {
+                if (!strcmp(bench->name, optarg)) {
+                    break;
+                }
+            }
+            if (bench->name == NULL) {
+                fprintf(stderr, "invalid benchmark: '%s'\n", optarg);
+                return -1;
+            } else if (num_selected >= ucs_static_array_size(selected)) {
+                fprintf(stderr, "too many benchmarks selected\n");
+                return -1;
+            }
+            selected[num_selected++] = bench;
+            break;
+        case 'n':
+            params.iters = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            params.size = atoi(optarg);
+            break;
+        case 't':
+            params.num_threads = atoi(optarg);
+            break;
+        case 'r':
+            params.repeat = atoi(optarg);
+            break;
+        case 'f':
+            if (!strcmp(optarg, "table")) {
+                params.format = UCS_BENCH_FORMAT_TABLE;
+            } else if (!strcmp(optarg, "csv")) {
+                params.format = UCS_BENCH_FORMAT_CSV;
+            } else if (!strcmp(optarg, "json")) {
+                params.format = UCS_BENCH_FORMAT_JSON;
+            } else {
+                fprintf(stderr, "invalid output format: '%s'\n", optarg);
+                return -1;
+            }
+            break;
+        case 'h':
+        default:
+            ucs_bench_usage(&params);
+            return (c == 'h') ? 0 : -1;
+        }
+    }
+
+    if ((params.iters == 0) || (params.size == 0) ||
+        (params.num_threads == 0) || (params.repeat == 0)) {
+        fprintf(stderr, "invalid parameters\n");
+        return -1;
+    }
+
+    if (num_selected == 0) {
+        for (bench = ucs_benchmarks; bench->name != NULL; ++bench) {
+            selected[num_selected++] = bench;
+        }
+    }
+
+    ucs_bench_print_header(&params);
+    for (i = 0; i < num_selected; ++i) {
+        if (ucs_bench_run(selected[i], &params) != UCS_OK) {
+            ret = -1;
+        }
+    }
+    if (params.format == UCS_BENCH_FORMAT_TABLE) {
+        printf("+---------------+----------------------+---------+--------+"
+               "------------+------------+-----------+-----------+------------+\n");
+    }
+
+    return ret;
+}
@@ -0,0 +1,456 @@
+/**
+* Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+*
+* See file LICENSE for terms.
+*/
+
+/*
+ * Single-process active message rate benchmark for UCT transports.
+ *
+ * Two interfaces are opened on the same worker, and the sender interface sends
+ * bursts of <window> active messages to the receiver interface, then progresses
+ * the worker until all of them arrive. Since both sides run on the same thread,
+ * the result does not depend on the scheduling of the two sides as with
+ * ucx_perftest, which makes it useful to compare the cost of the send and
+ * receive paths of a transport, such as the shared memory FIFO, between builds.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <uct/api/uct.h>
+#include <ucs/debug/memtrack.h>
+#include <ucs/sys/compiler.h>
+#include <ucs/time/time.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdio.h>
+
+
+#define UCT_AM_BENCH_AM_ID  1
+
+
+typedef struct uct_am_bench_params {
+    const char                     *tl_name;
+    const char                     *dev_name;
+    int                            bcopy;       /* Use am_bcopy instead of short */
+    size_t                         size;        /* Message size */
+    unsigned long                  iters;       /* Number of messages */
+    unsigned                       window;      /* Messages per burst */
+    unsigned                       repeat;      /* How many times to repeat */
+} uct_am_bench_params_t;
+
+
+typedef struct uct_am_bench_ctx {
+    const uct_am_bench_params_t    *params;
+    ucs_async_context_t            *async;
+    uct_worker_h                   worker;
+    uct_md_h                       md;
+    uct_iface_h                    sender;
+    uct_iface_h                    receiver;
+    uct_ep_h                       ep;
+    void                           *buffer;
+    volatile unsigned long         recv_count;
+} uct_am_bench_ctx_t;
+
+
+static ucs_status_t uct_am_bench_am_handler(void *arg, void *data,
+                                            size_t length, unsigned flags)
+{
+    uct_am_bench_ctx_t *ctx = arg;
+
+    ++ctx->recv_count;
+    return UCS_OK;
+}
+
+static size_t uct_am_bench_pack_cb(void *dest, void *arg)
+{
+    uct_am_bench_ctx_t *ctx = arg;
+
+    memcpy(dest, ctx->buffer, ctx->params->size);
+    return ctx->params->size;
+}
+
+static ucs_status_t uct_am_bench_iface_open(uct_am_bench_ctx_t *ctx,
+                                            uct_iface_h *iface_p)
+{
+    uct_iface_config_t *config;
+    uct_iface_params_t params;
+    ucs_status_t status;
+
+    memset(&params, 0, sizeof(params));
+    params.open_mode            = UCT_IFACE_OPEN_MODE_DEVICE;
+    params.mode.device.tl_name  = ctx->params->tl_name;
+    params.mode.device.dev_name = ctx->params->dev_name;
+    params.stats_root           = NULL;
+    params.rx_headroom          = 0;
+    UCS_CPU_ZERO(&params.cpu_mask);
+
+    status = uct_md_iface_config_read(ctx->md, ctx->params->tl_name, NULL, NULL,
+                                      &config);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    status = uct_iface_open(ctx->md, ctx->worker, &params, config, iface_p);
+    uct_config_release(config);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    uct_iface_progress_enable(*iface_p, UCT_PROGRESS_SEND | UCT_PROGRESS_RECV);
+    return UCS_OK;
+}
+
+/* Open the memory domain which provides the requested transport and device */
+static ucs_status_t uct_am_bench_md_open(uct_am_bench_ctx_t *ctx)
+{
+    uct_md_resource_desc_t *md_resources;
+    uct_tl_resource_desc_t *tl_resources;
+    unsigned num_md_resources, num_tl_resources;
+    uct_md_config_t *md_config;
+    ucs_status_t status;
+    unsigned i, j;
+    int found;
+
+    status = uct_query_md_resources(&md_resources, &num_md_resources);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    for (i = 0; i < num_md_resources; ++i) {
+        status = uct_md_config_read(md_resources[i].md_name, NULL, NULL,
+                                    &md_config);
+        if (status != UCS_OK) {
+            continue;
+        }
+
+        status = uct_md_open(md_resources[i].md_name, md_config, &ctx->md);
+        uct_config_release(md_config);
+        if (status != UCS_OK) {
+            continue;
+        }
+
+        status = uct_md_query_tl_resources(ctx->md, &tl_resources,
+                                           &num_tl_resources);
+        if (status != UCS_OK) {
+            uct_md_close(ctx->md);
+            continue;
+        }
+
+        found = 0;
+        for (j = 0; j < num_tl_resources; ++j) {
+            if (!strcmp(tl_resources[j].tl_name, ctx->params->tl_name) &&
+                !strcmp(tl_resources[j].dev_name, ctx->params->dev_name)) {
+                found = 1;
+            }
+        }
+        uct_release_tl_resource_list(tl_resources);
+
+        if (found) {
+            uct_release_md_resource_list(md_resources);
+            return UCS_OK;
+        }
+
+        uct_md_close(ctx->md);
+    }
+
+    uct_release_md_resource_list(md_resources);
+    fprintf(stderr, "transport %s/%s not found\n", ctx->params->tl_name,
+            ctx->params->dev_name);
+    return UCS_ERR_NO_DEVICE;
+}
+
+static ucs_status_t uct_am_bench_ep_create(uct_am_bench_ctx_t *ctx)
+{
+    uct_device_addr_t *dev_addr;
+    uct_iface_addr_t *iface_addr;
+    uct_iface_attr_t attr;
+    ucs_status_t status;
+
+    status = uct_iface_query(ctx->receiver, &attr);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    if (!(attr.cap.flags & UCT_IFACE_FLAG_CONNECT_TO_IFACE)) {
+        fprintf(stderr, "%s does not support connecting to an interface\n",
+                ctx->params->tl_name);
+        return UCS_ERR_UNSUPPORTED;
+    }
+
+    if (ctx->params->bcopy ?
+        (!(attr.cap.flags & UCT_IFACE_FLAG_AM_BCOPY) ||
+         (ctx->params->size > attr.cap.am.max_bcopy)) :
+        (!(attr.cap.flags & UCT_IFACE_FLAG_AM_SHORT) ||
+         (ctx->params->size > attr.cap.am.max_short))) {
+        fprintf(stderr, "%s does not support %s messages of %zu bytes\n",
+                ctx->params->tl_name, ctx->params->bcopy ? "bcopy" : "short",
+                ctx->params->size);
+        return UCS_ERR_UNSUPPORTED;
+    }
+
+    dev_addr   = ucs_alloca(attr.device_addr_len);
+    iface_addr = ucs_alloca(attr.iface_addr_len);
+
+    status = uct_iface_get_device_address(ctx->receiver, dev_addr);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    status = uct_iface_get_address(ctx->receiver, iface_addr);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    return uct_ep_create_connected(ctx->sender, dev_addr, iface_addr, &ctx->ep);
+}
+
+static ucs_status_t uct_am_bench_init(uct_am_bench_ctx_t *ctx)
+{
+    ucs_status_t status;
+
+    ctx->buffer = ucs_calloc(1, ucs_max(ctx->params->size, sizeof(uint64_t)),
+                             "am_bench_buffer");
+    if (ctx->buffer == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    status = ucs_async_context_create(UCS_ASYNC_MODE_THREAD, &ctx->async);
+    if (status != UCS_OK) {
+        goto err_free;
+    }
+
+    status = uct_worker_create(ctx->async, UCS_THREAD_MODE_SINGLE, &ctx->worker);
+    if (status != UCS_OK) {
+        goto err_async;
+    }
+
+    status = uct_am_bench_md_open(ctx);
+    if (status != UCS_OK) {
+        goto err_worker;
+    }
+
+    status = uct_am_bench_iface_open(ctx, &ctx->receiver);
+    if (status != UCS_OK) {
+        goto err_md;
+    }
+
+    status = uct_am_bench_iface_open(ctx, &ctx->sender);
+    if (status != UCS_OK) {
+        goto err_receiver;
+    }
+
+    status = uct_iface_set_am_handler(ctx->receiver, UCT_AM_BENCH_AM_ID,
+                                      uct_am_bench_am_handler, ctx, 0);
+    if (status != UCS_OK) {
+        goto err_sender;
+    }
+
+    status = uct_am_bench_ep_create(ctx);
+    if (status != UCS_OK) {
+        goto err_sender;
+    }
+
+    return UCS_OK;
+
+err_sender:
+    uct_iface_close(ctx->sender);
+err_receiver:
+    uct_iface_close(ctx->receiver);
+err_md:
+    uct_md_close(ctx->md);
+err_worker:
+    uct_worker_destroy(ctx->worker);
+err_async:
+    ucs_async_context_destroy(ctx->async);
+err_free:
+    ucs_free(ctx->buffer);
+    return status;
+}
+
+static void uct_am_bench_cleanup(uct_am_bench_ctx_t *ctx)
+{
+    uct_ep_destroy(ctx->ep);
+    uct_iface_close(ctx->sender);
+    uct_iface_close(ctx->receiver);
+    uct_md_close(ctx->md);
+    uct_worker_destroy(ctx->worker);
+    ucs_async_context_destroy(ctx->async);
+    ucs_free(ctx->buffer);
+}
+
+static inline ucs_status_t uct_am_bench_send(uct_am_bench_ctx_t *ctx)
+{
+    const uct_am_bench_params_t *params = ctx->params;
+    ssize_t packed_len;
+
+    if (params->bcopy) {
+        packed_len = uct_ep_am_bcopy(ctx->ep, UCT_AM_BENCH_AM_ID,
+                                     uct_am_bench_pack_cb, ctx, 0);
+        return (packed_len >= 0) ? UCS_OK : (ucs_status_t)packed_len;
+    }
+
+    return uct_ep_am_short(ctx->ep, UCT_AM_BENCH_AM_ID,
+                           *(uint64_t*)ctx->buffer,
+                           UCS_PTR_BYTE_OFFSET(ctx->buffer, sizeof(uint64_t)),
+                           ctx->params->size - sizeof(uint64_t));
+}
+
+/* Returns the time of sending and receiving all messages */
+static ucs_status_t uct_am_bench_run_once(uct_am_bench_ctx_t *ctx,
+                                          ucs_time_t *time_p)
+{
+    const uct_am_bench_params_t *params = ctx->params;
+    unsigned long sent = 0;
+    ucs_time_t start_time;
+    ucs_status_t status;
+    unsigned i;
+
+    ctx->recv_count = 0;
+    start_time      = ucs_get_time();
+    while (sent < params->iters) {
+        for (i = 0; (i < params->window) && (sent < params->iters); ++i) {
+            status = uct_am_bench_send(ctx);
+            if (status == UCS_ERR_NO_RESOURCE) {
+                break;
+            } else if (status != UCS_OK) {
+                fprintf(stderr, "send failed: %s\n", ucs_status_string(status));
+                return status;
+            }
+            ++sent;
+        }
+
+        while (ctx->recv_count < sent) {
+            uct_worker_progress(ctx->worker);
+        }
+    }
+
+    *time_p = ucs_get_time() - start_time;
+    return UCS_OK;
+}
+
+static ucs_status_t uct_am_bench_run(const uct_am_bench_params_t *params)
+{
+    double best_nsec = 0, total_nsec = 0, nsec;
+    uct_am_bench_ctx_t ctx;
+    ucs_status_t status;
+    ucs_time_t time;
+    unsigned i;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.params = params;
+
+    status = uct_am_bench_init(&ctx);
+    if (status != UCS_OK) {
+        fprintf(stderr, "failed to initialize: %s\n", ucs_status_string(status));
+        return status;
+    }
+
+    /* warmup */
+    status = uct_am_bench_run_once(&ctx, &time);
+    if (status != UCS_OK) {
+        goto out;
+    }
+
+    for (i = 0; i < params->repeat; ++i) {
+        status = uct_am_bench_run_once(&ctx, &time);
+        if (status != UCS_OK) {
+            goto out;
+        }
+
+        nsec        = ucs_time_to_nsec(time) / params->iters;
+        total_nsec += nsec;
+        if ((i == 0) || (nsec < best_nsec)) {
+            best_nsec = nsec;
+        }
+    }
+
+    printf("%s/%s am_%s size %zu window %u: best %.2f nsec/msg (%.3f Mmsg/s), "
+           "average %.2f nsec/msg\n", params->tl_name, params->dev_name,
+           params->bcopy ? "bcopy" : "short", params->size, params->window,
+           best_nsec, 1e3 / best_nsec, total_nsec / params->repeat);
+
+out:
+    uct_am_bench_cleanup(&ctx);
+    return status;
+}
+
+static void uct_am_bench_usage(const uct_am_bench_params_t *params)
+{
+    printf("Usage: uct_am_bench [options]\n");
+    printf("\n");
+    printf("  -x <tl>        Transport to use (%s)\n", params->tl_name);
+    printf("  -d <device>    Device to use (%s)\n", params->dev_name);
+    printf("  -D <type>      Message type: short, bcopy (short)\n");
+    printf("  -s <size>      Message size, at least 8 for short (%zu)\n",
+           params->size);
+    printf("  -n <iters>     Number of messages (%lu)\n", params->iters);
+    printf("  -w <window>    Messages to send before receiving them (%u)\n",
+           params->window);
+    printf("  -r <count>     Repeat the benchmark and report the best and\n");
+    printf("                 the average result (%u)\n", params->repeat);
+    printf("  -h             Show this help message\n");
+}
+
+int main(int argc, char **argv)
+{
+    uct_am_bench_params_t params;
+    int c;
+
+    params.tl_name  = "mm";
+    params.dev_name = "posix";
+    params.bcopy    = 0;
+    params.size     = 8;
+    params.iters    = 1000000;
+    params.window   = 32;
+    params.repeat   = 5;
+
+    while ((c = getopt(argc, argv, "x:d:D:s:n:w:r:h")) != -1) {
+        switch (c) {
+        case 'x':
+            params.tl_name = optarg;
+            break;
+        case 'd':
+            params.dev_name = optarg;
+            break;
+        case 'D':
+            if (!strcmp(optarg, "short")) {
+                params.bcopy = 0;
+            } else if (!strcmp(optarg, "bcopy")) {
+                params.bcopy = 1;
+            } else {
+                fprintf(stderr, "invalid message type: '%s'\n", optarg);
+                return -1;
+            }
+            break;
+        case 's':
+            params.size = strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            params.iters = strtoul(optarg, NULL, 0);
+            break;
+        case 'w':
+            params.window = atoi(optarg);
+            break;
+        case 'r':
+            params.repeat = atoi(optarg);
+            break;
+        case 'h':
+        default:
+            uct_am_bench_usage(&params);
+            return (c == 'h') ? 0 : -1;
+        }
+    }
+
+    if ((params.iters == 0) || (params.window == 0) || (params.repeat == 0) ||
+        (!params.bcopy && (params.size < sizeof(uint64_t)))) {
+        fprintf(stderr, "invalid parameters\n");
+        return -1;
+    }
+
+    return (uct_am_bench_run(&params) == UCS_OK) ? 0 : -1;
+}
@@ -51,6 +51,10 @@ static void modify_config_for_valgrind(const char *name, const char *value)
 }
 
 int main(int argc, char **argv) {
+    /* Test the transports over the memfd mapper, which is disabled by default.
+     * Must be set before the test resources are enumerated. */
+    setenv(UCS_CONFIG_PREFIX "MEMFD_ENABLE", "y", 0);
+
 	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
 	::testing::InitGoogleTest(&argc, argv);
 
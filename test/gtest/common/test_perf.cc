@@ -184,6 +184,7 @@ test_perf::test_result test_perf::run_multi_threaded(const test_spec &test, unsi
     params.api = test.api;
     params.command         = test.command;
     params.test_type       = test.test_type;
+    params.pattern         = UCX_PERF_PATTERN_PAIR;
     params.thread_mode     = UCS_THREAD_MODE_SINGLE;
     params.async_mode      = UCS_ASYNC_THREAD_LOCK_TYPE;
     params.thread_count    = 1;
@@ -214,6 +215,9 @@ test_perf::test_result test_perf::run_multi_threaded(const test_spec &test, unsi
     params.iov_stride      = test.msg_stride;
     params.ucp.send_datatype = (ucp_perf_datatype_t)test.data_layout;
     params.ucp.recv_datatype = (ucp_perf_datatype_t)test.data_layout;
+    params.ucp.wireup_eps    = 1;
+    params.ucp.tag_depth     = 64;
+    params.ucp.tag_count     = 64;
 
     thread_arg arg0;
     arg0.params   = params;
@@ -278,6 +282,16 @@ void test_perf::run_test(const test_spec& test, unsigned flags, bool check_perf,
 
         ASSERT_UCS_OK(result.status);
 
+        const ucx_perf_result_t *perf_result = &result.result;
+        EXPECT_LE(perf_result->latency_percentile.p50,
+                  perf_result->latency_percentile.p90);
+        EXPECT_LE(perf_result->latency_percentile.p90,
+                  perf_result->latency_percentile.p99);
+        EXPECT_LE(perf_result->latency_percentile.p99,
+                  perf_result->latency_percentile.p999);
+        EXPECT_LE(perf_result->latency_percentile.p999,
+                  perf_result->latency_percentile.max);
+
         double value = *(double*)( ((char*)&result.result) + test.field_offset) *
                         test.norm;
         char result_str[200] = {0};
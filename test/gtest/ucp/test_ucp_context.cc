@@ -49,6 +49,18 @@ UCS_TEST_P(test_ucp_context, minimal_field_mask) {
     }
 }
 
+UCS_TEST_P(test_ucp_context, worker_lock_waits) {
+    create_entity();
+
+    ucp_worker_attr_t attr;
+    attr.field_mask = UCP_WORKER_ATTR_FIELD_LOCK_WAITS;
+    ASSERT_UCS_OK(ucp_worker_query(sender().worker(), &attr));
+
+    /* No other thread used the worker */
+    EXPECT_EQ(0u, attr.lock_waits);
+    EXPECT_EQ(0.0, attr.lock_wait_time);
+}
+
 UCP_INSTANTIATE_TEST_CASE_TLS(test_ucp_context, all, "all")
 
 class test_ucp_aliases : public test_ucp_context {
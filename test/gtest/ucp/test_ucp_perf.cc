@@ -160,6 +160,18 @@ test_perf::test_spec test_ucp_perf::tests[] =
     ucs_offsetof(ucx_perf_result_t, latency.total_average), 1e6, 0.001, 30.0,
     0 },
 
+  { "endpoint create", "usec",
+    UCX_PERF_API_UCP, UCX_PERF_CMD_WIREUP, UCX_PERF_TEST_TYPE_STREAM_UNI,
+    UCP_PERF_DATATYPE_CONTIG, 0, 1, { 8 }, 1, 1000l,
+    ucs_offsetof(ucx_perf_result_t, wireup.ep_create), 1e6, 0.001, 1000.0,
+    0 },
+
+  { "tag match unexpected", "Mpps",
+    UCX_PERF_API_UCP, UCX_PERF_CMD_TAG_MATCH, UCX_PERF_TEST_TYPE_STREAM_UNI,
+    UCP_PERF_DATATYPE_CONTIG, 0, 1, { 8 }, 1, 10000l,
+    ucs_offsetof(ucx_perf_result_t, msgrate.total_average), 1e-6, 0.05, 100.0,
+    UCX_PERF_TEST_FLAG_TAG_UNEXP_PROBE | UCX_PERF_TEST_FLAG_TAG_RANDOM_ORDER },
+
   { NULL }
 };
 
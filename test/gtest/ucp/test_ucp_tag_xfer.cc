@@ -11,10 +11,12 @@
 
 extern "C" {
 #include <ucp/core/ucp_ep.inl>
+#include <ucp/tag/rndv.h>
 #include <ucs/datastruct/queue.h>
 }
 
 #include <iostream>
+#include <sstream>
 
 
 class test_ucp_tag_xfer : public test_ucp_tag {
@@ -996,6 +998,111 @@ UCS_TEST_P(test_ucp_tag_xfer, iov_with_empty_buffers, "ZCOPY_THRESH=512") {
 UCP_INSTANTIATE_TEST_CASE(test_ucp_tag_xfer)
 
 
+class test_ucp_tag_proto_select : public test_ucp_tag {
+protected:
+    typedef std::map<size_t, std::string> proto_map_t;
+
+    /* Protocols shown by ucp_ep_print_proto_select() for an operation */
+    proto_map_t explained_protos(const std::string &op_name, size_t max_length)
+    {
+        proto_map_t protos;
+        char *buf   = NULL;
+        size_t size = 0;
+        std::string line;
+        FILE *stream;
+
+        stream = open_memstream(&buf, &size);
+        EXPECT_TRUE(stream != NULL);
+        ucp_ep_print_proto_select(sender().ep(), NULL, 1, max_length, stream);
+        fclose(stream);
+
+        std::istringstream text(std::string(buf, size));
+        free(buf);
+
+        while (std::getline(text, line)) {
+            std::istringstream words(line);
+            std::string hash, op, proto;
+            size_t length;
+
+            if ((words >> hash >> op >> length >> proto) && (op == op_name)) {
+                protos[length] = proto;
+            }
+        }
+        return protos;
+    }
+
+    /* Protocol of a pending synchronous send, by its progress function */
+    std::string request_proto(request *req)
+    {
+        const ucp_proto_t *proto    = ucp_ep_config(sender().ep())->tag.sync_proto;
+        uct_pending_callback_t func = ((ucp_request_t*)req - 1)->send.uct.func;
+
+        if (func == proto->bcopy_single) {
+            return "bcopy";
+        } else if (func == proto->bcopy_multi) {
+            return "bcopy_multi";
+        } else if (func == proto->zcopy_single) {
+            return "zcopy";
+        } else if (func == proto->zcopy_multi) {
+            return "zcopy_multi";
+        } else if (func == ucp_proto_progress_rndv_rts) {
+            return "rndv";
+        }
+        return "unknown";
+    }
+
+    void test_sync_send(size_t max_length)
+    {
+        static const ucp_tag_t tag = 0x111337;
+        ucp_datatype_t datatype    = ucp_dt_make_contig(1);
+        std::vector<char> sendbuf(max_length, 's'), recvbuf(max_length);
+        request *sreq, *rreq;
+        std::string proto;
+
+        check_offload_support(false);
+
+        proto_map_t protos = explained_protos("tag_send_sync", max_length);
+        ASSERT_FALSE(protos.empty());
+
+        for (proto_map_t::iterator iter = protos.begin(); iter != protos.end();
+             ++iter) {
+            /* Synchronous send is in progress until the receiver matches it */
+            sreq = send_sync_nb(&sendbuf[0], iter->first, datatype, tag);
+            ASSERT_TRUE(!UCS_PTR_IS_ERR(sreq));
+            ASSERT_TRUE(sreq != NULL);
+
+            proto = request_proto(sreq);
+            if (proto == "rndv") {
+                EXPECT_EQ(0ul, iter->second.find(proto))
+                    << "length " << iter->first;
+            } else {
+                EXPECT_EQ(proto, iter->second) << "length " << iter->first;
+            }
+
+            rreq = recv_nb(&recvbuf[0], iter->first, datatype, tag,
+                           (ucp_tag_t)-1);
+            ASSERT_TRUE(!UCS_PTR_IS_ERR(rreq));
+            wait_and_validate(rreq);
+            wait_and_validate(sreq);
+        }
+    }
+};
+
+UCS_TEST_P(test_ucp_tag_proto_select, sync_send) {
+    test_sync_send(UCS_MBYTE);
+}
+
+UCS_TEST_P(test_ucp_tag_proto_select, sync_send_rndv, "RNDV_THRESH=4096") {
+    test_sync_send(64 * UCS_KBYTE);
+}
+
+UCS_TEST_P(test_ucp_tag_proto_select, sync_send_zcopy, "ZCOPY_THRESH=1024") {
+    test_sync_send(64 * UCS_KBYTE);
+}
+
+UCP_INSTANTIATE_TEST_CASE(test_ucp_tag_proto_select)
+
+
 #if ENABLE_STATS
 
 class test_ucp_tag_stats : public test_ucp_tag_xfer {
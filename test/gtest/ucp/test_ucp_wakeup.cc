@@ -6,6 +6,10 @@
 
 #include "ucp_test.h"
 
+extern "C" {
+#include <ucp/core/ucp_worker.h>
+}
+
 #include <algorithm>
 #include <sys/epoll.h>
 #include <sys/poll.h>
@@ -44,6 +48,40 @@ protected:
         ASSERT_EQ(UCS_OK, status);
     }
 
+    unsigned tx_wait() {
+        const ucp_datatype_t DATATYPE = ucp_dt_make_contig(1);
+        const size_t COUNT            = 20000;
+        const uint64_t TAG            = 0xdeadbeef;
+        std::string send_data(COUNT, '2'), recv_data(COUNT, '1');
+        unsigned num_waits            = 0;
+        void *sreq, *rreq;
+
+        sender().connect(&receiver(), get_ep_params());
+
+        rreq = ucp_tag_recv_nb(receiver().worker(), &recv_data[0], COUNT,
+                               DATATYPE, TAG, (ucp_tag_t)-1, recv_completion);
+
+        sreq = ucp_tag_send_nb(sender().ep(), &send_data[0], COUNT, DATATYPE,
+                               TAG, send_completion);
+
+        if (UCS_PTR_IS_PTR(sreq)) {
+            /* wait for send completion */
+            do {
+                ucp_worker_wait(sender().worker());
+                ++num_waits;
+                while (progress());
+            } while (!ucp_request_is_completed(sreq));
+            ucp_request_release(sreq);
+        } else {
+            ASSERT_UCS_OK(UCS_PTR_STATUS(sreq));
+        }
+
+        wait(rreq);
+
+        EXPECT_EQ(send_data, recv_data);
+        return num_waits;
+    }
+
     static size_t comp_cntr;
 };
 
@@ -111,34 +149,35 @@ UCS_TEST_P(test_ucp_wakeup, efd)
 
 UCS_TEST_P(test_ucp_wakeup, tx_wait, "ZCOPY_THRESH=10000")
 {
-    const ucp_datatype_t DATATYPE = ucp_dt_make_contig(1);
-    const size_t COUNT            = 20000;
-    const uint64_t TAG            = 0xdeadbeef;
-    std::string send_data(COUNT, '2'), recv_data(COUNT, '1');
-    void *sreq, *rreq;
-
-    sender().connect(&receiver(), get_ep_params());
+    tx_wait();
+}
 
-    rreq = ucp_tag_recv_nb(receiver().worker(), &recv_data[0], COUNT, DATATYPE,
-                           TAG, (ucp_tag_t)-1, recv_completion);
+UCS_TEST_P(test_ucp_wakeup, tx_wait_spin, "ZCOPY_THRESH=10000",
+           "WAIT_SPIN_TIME=100us")
+{
+    unsigned num_waits  = tx_wait();
+    ucp_worker_h worker = sender().worker();
 
-    sreq = ucp_tag_send_nb(sender().ep(), &send_data[0], COUNT, DATATYPE, TAG,
-                           send_completion);
+    /* every wait ends either by polling or by sleeping, unless the transports
+     * could not be armed */
+    EXPECT_LE(worker->wait.spin_hits + worker->wait.sleeps, num_waits);
+    EXPECT_LE(worker->wait.spin_budget, worker->wait.max_spin);
+}
 
-    if (UCS_PTR_IS_PTR(sreq)) {
-        /* wait for send completion */
-        do {
-            ucp_worker_wait(sender().worker());
-            while (progress());
-        } while (!ucp_request_is_completed(sreq));
-        ucp_request_release(sreq);
-    } else {
-        ASSERT_UCS_OK(UCS_PTR_STATUS(sreq));
-    }
+UCS_TEST_P(test_ucp_wakeup, signal_spin, "WAIT_SPIN_TIME=10s")
+{
+    ucp_worker_h worker = sender().worker();
+    ucs_time_t start_time;
 
-    wait(rreq);
+    /* a signal must stop the polling instead of waiting for the budget */
+    ASSERT_UCS_OK(ucp_worker_signal(worker));
+    start_time = ucs_get_time();
+    ASSERT_UCS_OK(ucp_worker_wait(worker));
+    EXPECT_LT(ucs_time_to_sec(ucs_get_time() - start_time), 1.0);
+    EXPECT_EQ(1ul, worker->wait.spin_hits);
 
-    EXPECT_EQ(send_data, recv_data);
+    /* the signal was consumed, so arming does not report a pending event */
+    EXPECT_EQ(UCS_OK, ucp_worker_arm(worker));
 }
 
 UCS_TEST_P(test_ucp_wakeup, signal)
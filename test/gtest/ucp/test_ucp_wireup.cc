@@ -15,8 +15,10 @@
 
 extern "C" {
 #include <ucp/wireup/address.h>
+#include <ucp/wireup/wireup.h>
 #include <ucp/proto/proto.h>
 #include <ucp/core/ucp_ep.inl>
+#include <ucp/core/ucp_mm.h>
 }
 
 class test_ucp_wireup : public ucp_test {
@@ -64,6 +66,10 @@ protected:
 
     void disconnect(ucp_test::entity &e);
 
+    void check_lazy_lanes(ucp_ep_h ep);
+
+    void check_lanes_connect(ucp_ep_h ep, const ucp_lane_index_t *lanes);
+
     static void send_completion(void *request, ucs_status_t status);
 
     static void tag_recv_completion(void *request, ucs_status_t status,
@@ -325,6 +331,59 @@ void test_ucp_wireup::disconnect(ucp_test::entity &e) {
     disconnect(e.revoke_ep());
 }
 
+/* Check that exactly the lanes which may connect on first use are lazy, and
+ * skip the test if there are none */
+void test_ucp_wireup::check_lazy_lanes(ucp_ep_h ep)
+{
+    const ucp_ep_config_key_t *key = &ucp_ep_config(ep)->key;
+    unsigned num_lazy              = 0;
+    ucp_lane_index_t lane, other_lane;
+    bool expect_lazy;
+
+    for (lane = 0; lane < ucp_ep_num_lanes(ep); ++lane) {
+        /* active message, wireup and signaling proxy lanes are connected,
+         * as well as lanes which connect endpoint-to-endpoint */
+        expect_lazy = (lane != key->am_lane) && (lane != key->wireup_lane) &&
+                      (ucp_ep_get_iface_attr(ep, lane)->cap.flags &
+                       UCT_IFACE_FLAG_CONNECT_TO_IFACE) &&
+                      (ucp_ep_get_proxy_lane(ep, lane) == UCP_NULL_LANE);
+        for (other_lane = 0; other_lane < ucp_ep_num_lanes(ep); ++other_lane) {
+            if (ucp_ep_get_proxy_lane(ep, other_lane) == lane) {
+                expect_lazy = false;
+            }
+        }
+
+        EXPECT_EQ(expect_lazy, !!ucp_lazy_ep_test(ep->uct_eps[lane]))
+            << "lane " << (int)lane;
+        num_lazy += expect_lazy;
+    }
+
+    if (num_lazy == 0) {
+        UCS_TEST_SKIP_R("no lanes connect on first use");
+    }
+}
+
+/* A lazy lane connects on the first operation, which returns an error so the
+ * caller retries it on the transport endpoint */
+void test_ucp_wireup::check_lanes_connect(ucp_ep_h ep,
+                                          const ucp_lane_index_t *lanes)
+{
+    uct_pending_req_t req;
+    ucp_lane_index_t lane;
+
+    for (int i = 0; (i < UCP_MAX_LANES) && (lanes[i] != UCP_NULL_LANE); ++i) {
+        lane = lanes[i];
+        if (!ucp_lazy_ep_test(ep->uct_eps[lane])) {
+            continue;
+        }
+
+        req.func = NULL;
+        EXPECT_EQ(UCS_ERR_BUSY, uct_ep_pending_add(ep->uct_eps[lane], &req, 0))
+            << "lane " << (int)lane;
+        EXPECT_FALSE(ucp_lazy_ep_test(ep->uct_eps[lane])) << "lane " << (int)lane;
+    }
+}
+
 void test_ucp_wireup::waitall(std::vector<void*> reqs)
 {
     while (!reqs.empty()) {
@@ -367,7 +426,7 @@ UCS_TEST_P(test_ucp_wireup_1sided, address) {
 
     ucp_unpacked_address unpacked_address;
 
-    status = ucp_address_unpack(buffer, &unpacked_address);
+    status = ucp_address_unpack(sender().worker(), buffer, &unpacked_address);
     ASSERT_UCS_OK(status);
 
     EXPECT_EQ(sender().worker()->uuid, unpacked_address.uuid);
@@ -406,7 +465,7 @@ UCS_TEST_P(test_ucp_wireup_1sided, empty_address) {
 
     ucp_unpacked_address unpacked_address;
 
-    status = ucp_address_unpack(buffer, &unpacked_address);
+    status = ucp_address_unpack(sender().worker(), buffer, &unpacked_address);
     ASSERT_UCS_OK(status);
 
     EXPECT_EQ(sender().worker()->uuid, unpacked_address.uuid);
@@ -420,6 +479,72 @@ UCS_TEST_P(test_ucp_wireup_1sided, empty_address) {
     ucs_free(buffer);
 }
 
+UCS_TEST_P(test_ucp_wireup_1sided, address_unified, "UNIFIED_MODE=y") {
+    ucp_worker_h worker = sender().worker();
+    ucs_status_t status;
+    size_t size;
+    void *buffer;
+
+    status = ucp_address_pack(worker, NULL, -1, NULL, &size, &buffer);
+    ASSERT_UCS_OK(status);
+    EXPECT_EQ(size, ucp_address_length(buffer));
+
+    /* Transports are packed by resource index, and take the attributes of the
+     * local resources, which have the same profile */
+    ucp_unpacked_address unpacked_address;
+
+    status = ucp_address_unpack(receiver().worker(), buffer, &unpacked_address);
+    ASSERT_UCS_OK(status);
+    EXPECT_EQ(worker->uuid, unpacked_address.uuid);
+
+    for (const ucp_address_entry_t *ae = unpacked_address.address_list;
+         ae < unpacked_address.address_list + unpacked_address.address_count;
+         ++ae) {
+        ucp_rsc_index_t rsc_index;
+        bool found = false;
+
+        ucs_for_each_bit(rsc_index, worker->context->tl_bitmap) {
+            const uct_iface_attr_t *iface_attr = &worker->ifaces[rsc_index].attr;
+
+            if ((worker->context->tl_rscs[rsc_index].tl_name_csum ==
+                 ae->tl_name_csum) &&
+                (iface_attr->priority == ae->iface_attr.priority)) {
+                EXPECT_NEAR(iface_attr->bandwidth, ae->iface_attr.bandwidth,
+                            iface_attr->bandwidth / 100);
+                found = true;
+            }
+        }
+        EXPECT_TRUE(found);
+    }
+
+    ucs_free(unpacked_address.address_list);
+    ucs_free(buffer);
+
+    sender().connect(&receiver(), get_ep_params());
+    send_recv(sender().ep(), receiver().worker(), receiver().ep(), 1, 1);
+    flush_worker(sender());
+}
+
+UCS_TEST_P(test_ucp_wireup_1sided, address_cache, "ADDRESS_CACHE_SIZE=2") {
+    skip_loopback();
+
+    const size_t count = 4;
+    while (entities().size() < count) {
+        create_entity();
+    }
+
+    /* the cache keeps the most recently used addresses, the second endpoint
+     * to every worker hits the cache */
+    for (size_t i = 1; i < count; ++i) {
+        sender().connect(&entities().at(i), get_ep_params(), 2 * (i - 1));
+        sender().connect(&entities().at(i), get_ep_params(), 2 * (i - 1) + 1);
+        EXPECT_EQ(std::min<unsigned>(i, 2), sender().worker()->address_cache.count);
+    }
+
+    /* the endpoints to the evicted address still work */
+    send_recv(sender().ep(0, 1), e(1).worker(), e(1).ep(), 8, 1);
+}
+
 UCS_TEST_P(test_ucp_wireup_1sided, one_sided_wireup) {
     sender().connect(&receiver(), get_ep_params());
     send_recv(sender().ep(), receiver().worker(), receiver().ep(), 1, 1);
@@ -437,6 +562,30 @@ UCS_TEST_P(test_ucp_wireup_1sided, one_sided_wireup_rndv, "RNDV_THRESH=1") {
     flush_worker(sender());
 }
 
+UCS_TEST_P(test_ucp_wireup_1sided, lazy_lanes, "LAZY_LANES=y",
+           "RNDV_THRESH=1024") {
+    sender().connect(&receiver(), get_ep_params());
+
+    ucp_ep_h ep = sender().ep();
+    const ucp_ep_config_key_t *key = &ucp_ep_config(ep)->key;
+    check_lazy_lanes(ep);
+
+    /* lazy lanes are connected when the protocols use them */
+    send_recv(ep, receiver().worker(), receiver().ep(), 1, 1);
+    send_recv(ep, receiver().worker(), receiver().ep(), BUFFER_LENGTH, 1);
+    flush_worker(sender());
+
+    if ((GetParam().variant == TEST_RMA) &&
+        (key->rma_lanes[0] != UCP_NULL_LANE)) {
+        EXPECT_FALSE(ucp_lazy_ep_test(ep->uct_eps[key->rma_lanes[0]]));
+    }
+
+    check_lanes_connect(ep, key->rma_lanes);
+    check_lanes_connect(ep, key->rma_bw_lanes);
+    check_lanes_connect(ep, key->am_bw_lanes);
+    check_lanes_connect(ep, key->amo_lanes);
+}
+
 UCS_TEST_P(test_ucp_wireup_1sided, multi_wireup) {
     skip_loopback();
 
@@ -591,6 +740,73 @@ UCS_TEST_P(test_ucp_wireup_1sided, multi_ep_1sided) {
 
 UCP_INSTANTIATE_TEST_CASE(test_ucp_wireup_1sided)
 
+class test_ucp_wireup_amo : public test_ucp_wireup {
+public:
+    static std::vector<ucp_test_param>
+    enum_test_params(const ucp_params_t& ctx_params, const std::string& name,
+                     const std::string& test_case_name, const std::string& tls)
+    {
+        std::vector<ucp_test_param> result;
+        ucp_params_t tmp_ctx_params = ctx_params;
+
+        tmp_ctx_params.features = UCP_FEATURE_RMA | UCP_FEATURE_AMO64;
+        generate_test_params_variant(tmp_ctx_params, name,
+                                     test_case_name + "/amo", tls, TEST_RMA,
+                                     result);
+        return result;
+    }
+};
+
+UCS_TEST_P(test_ucp_wireup_amo, lazy_lanes, "LAZY_LANES=y") {
+    uint64_t value = 0;
+    ucp_mem_map_params_t params;
+    ucs_status_t status;
+    void *rkey_buffer;
+    size_t rkey_size;
+    ucp_rkey_h rkey;
+    ucp_mem_h memh;
+
+    sender().connect(&receiver(), get_ep_params());
+
+    ucp_ep_h ep = sender().ep();
+    const ucp_ep_config_key_t *key = &ucp_ep_config(ep)->key;
+    check_lazy_lanes(ep);
+
+    params.field_mask = UCP_MEM_MAP_PARAM_FIELD_ADDRESS |
+                        UCP_MEM_MAP_PARAM_FIELD_LENGTH |
+                        UCP_MEM_MAP_PARAM_FIELD_FLAGS;
+    params.address    = &value;
+    params.length     = sizeof(value);
+    params.flags      = 0;
+    status = ucp_mem_map(receiver().ucph(), &params, &memh);
+    ASSERT_UCS_OK(status);
+
+    status = ucp_rkey_pack(receiver().ucph(), memh, &rkey_buffer, &rkey_size);
+    ASSERT_UCS_OK(status);
+    status = ucp_ep_rkey_unpack(ep, rkey_buffer, &rkey);
+    ucp_rkey_buffer_release(rkey_buffer);
+    ASSERT_UCS_OK(status);
+
+    /* the atomic operation connects the atomic lane it uses */
+    status = ucp_atomic_post(ep, UCP_ATOMIC_POST_OP_ADD, 1, sizeof(value),
+                             (uintptr_t)&value, rkey);
+    ASSERT_UCS_OK(status);
+    flush_worker(sender());
+    EXPECT_EQ(1ul, value);
+
+    if (rkey->cache.amo_lane != UCP_NULL_LANE) {
+        EXPECT_FALSE(ucp_lazy_ep_test(ep->uct_eps[rkey->cache.amo_lane]));
+    }
+
+    check_lanes_connect(ep, key->amo_lanes);
+    check_lanes_connect(ep, key->rma_lanes);
+
+    ucp_rkey_destroy(rkey);
+    ucp_mem_unmap(receiver().ucph(), memh);
+}
+
+UCP_INSTANTIATE_TEST_CASE(test_ucp_wireup_amo)
+
 class test_ucp_wireup_2sided : public test_ucp_wireup {
 public:
     static std::vector<ucp_test_param>
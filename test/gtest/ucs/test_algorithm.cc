@@ -56,3 +56,14 @@ UCS_TEST_F(test_algorithm, crc16_string) {
     EXPECT_NE(ucs_crc16_string("123456789"),
               ucs_crc16_string("12345"));
 }
+
+UCS_TEST_F(test_algorithm, crc32) {
+    const char *str = "123456789";
+
+    EXPECT_EQ(0xcbf43926u, ucs_crc32(0, str, strlen(str)));
+
+    /* calculating in parts must give the same result */
+    EXPECT_EQ(ucs_crc32(0, str, strlen(str)),
+              ucs_crc32(ucs_crc32(0, str, 4), str + 4, strlen(str) - 4));
+    EXPECT_EQ(0u, ucs_crc32(0, NULL, 0));
+}
@@ -0,0 +1,107 @@
+/**
+* Copyright (C) Mellanox Technologies Ltd. 2019.  ALL RIGHTS RESERVED.
+*
+* See file LICENSE for terms.
+*/
+
+#include <common/test.h>
+
+#include <ucs/arch/cpu.h>
+#include <ucs/config/global_opts.h>
+#include <ucs/sys/sys.h>
+
+#include <vector>
+
+
+class test_arch : public ucs::test {
+protected:
+    typedef void (*copy_func_t)(void *dst, const void *src, size_t len);
+
+    static const size_t GUARD = 64;
+    static const char   GUARD_BYTE = 0x5a;
+
+    /* Copy with every combination of source and destination misalignment,
+     * and check that no byte outside of the destination is modified */
+    void test_copy(copy_func_t copy_func, size_t length) {
+        std::vector<char> src(length + GUARD);
+        std::vector<char> dst(length + 2 * GUARD);
+
+        for (size_t i = 0; i < src.size(); ++i) {
+            src[i] = ucs::rand();
+        }
+
+        for (size_t src_offset = 0; src_offset < 8; src_offset += 3) {
+            for (size_t dst_offset = 0; dst_offset < GUARD; dst_offset += 7) {
+                std::fill(dst.begin(), dst.end(), GUARD_BYTE);
+
+                copy_func(&dst[dst_offset], &src[src_offset], length);
+
+                for (size_t i = 0; i < dst_offset; ++i) {
+                    ASSERT_EQ(GUARD_BYTE, dst[i]) << "length " << length;
+                }
+                for (size_t i = 0; i < length; ++i) {
+                    ASSERT_EQ(src[src_offset + i], dst[dst_offset + i])
+                        << "length " << length << " src_offset " << src_offset
+                        << " dst_offset " << dst_offset << " index " << i;
+                }
+                for (size_t i = dst_offset + length; i < dst.size(); ++i) {
+                    ASSERT_EQ(GUARD_BYTE, dst[i]) << "length " << length;
+                }
+            }
+        }
+    }
+
+    void test_copy_sizes(copy_func_t copy_func) {
+        static const size_t sizes[] = { 0, 1, 15, 16, 17, 63, 64, 65, 127, 255,
+                                        256, 257, 1000, 4095, 4096 + 17,
+                                        UCS_MBYTE + 3 };
+
+        for (size_t i = 0; i < ucs_static_array_size(sizes); ++i) {
+            test_copy(copy_func, sizes[i]);
+        }
+    }
+
+    static void memcpy_relaxed(void *dst, const void *src, size_t len) {
+        ucs_memcpy_relaxed(dst, src, len);
+    }
+};
+
+const size_t test_arch::GUARD;
+const char   test_arch::GUARD_BYTE;
+
+UCS_TEST_F(test_arch, cpu_flags) {
+    int cpu_flag = ucs_arch_get_cpu_flag();
+
+    if (cpu_flag == UCS_CPU_FLAG_UNKNOWN) {
+        UCS_TEST_SKIP_R("CPU flags are unknown");
+    }
+
+    /* wider vector instructions imply the narrower ones */
+    if (cpu_flag & UCS_CPU_FLAG_AVX512F) {
+        EXPECT_TRUE(cpu_flag & UCS_CPU_FLAG_AVX2);
+    }
+    if (cpu_flag & UCS_CPU_FLAG_AVX2) {
+        EXPECT_TRUE(cpu_flag & UCS_CPU_FLAG_AVX);
+    }
+}
+
+UCS_TEST_F(test_arch, memcpy_nontemporal) {
+    test_copy_sizes(ucs_memcpy_nontemporal);
+}
+
+UCS_TEST_F(test_arch, memcpy_relaxed) {
+    test_copy_sizes(memcpy_relaxed);
+}
+
+UCS_TEST_F(test_arch, memcpy_relaxed_thresh) {
+    modify_config("MEMCPY_NONTEMPORAL_THRESH", "100");
+    EXPECT_EQ(100u, ucs_memcpy_nontemporal_thresh);
+    test_copy_sizes(memcpy_relaxed);
+}
+
+UCS_TEST_F(test_arch, memcpy_relaxed_thresh_auto) {
+    modify_config("MEMCPY_NONTEMPORAL_THRESH", "auto");
+    EXPECT_EQ(UCS_CONFIG_MEMUNITS_AUTO, ucs_global_opts.memcpy_nontemporal_thresh);
+    EXPECT_EQ(ucs_get_llc_size() * 3 / 4, ucs_memcpy_nontemporal_thresh);
+    test_copy_sizes(memcpy_relaxed);
+}
@@ -685,53 +685,78 @@ UCS_TEST_P(test_async, event_add_from_handler) {
     le.unset_handler(1);
 }
 
-typedef test_async_mt<local_event> test_async_event_mt;
-typedef test_async_mt<local_timer> test_async_timer_mt;
-
-/*
- * Run multiple threads which all process events independently.
- */
-UCS_TEST_P(test_async_event_mt, multithread) {
-    if (!(HAVE_DECL_F_SETOWN_EX)) {
-        UCS_TEST_SKIP;
-    }
+class test_async_event_mt : public test_async_mt<local_event> {
+protected:
+    /*
+     * Run multiple threads which all process events independently.
+     */
+    void test_multithread() {
+        if (!(HAVE_DECL_F_SETOWN_EX)) {
+            UCS_TEST_SKIP;
+        }
 
-    spawn();
+        spawn();
 
-    for (int j = 0; j < COUNT; ++j) {
-        for (unsigned i = 0; i < NUM_THREADS; ++i) {
-            event(i)->push_event();
-            suspend();
+        for (int j = 0; j < COUNT; ++j) {
+            for (unsigned i = 0; i < NUM_THREADS; ++i) {
+                event(i)->push_event();
+                suspend();
+            }
         }
-    }
 
-    suspend();
+        suspend();
 
-    stop();
-
-    for (unsigned i = 0; i < NUM_THREADS; ++i) {
-        int count = thread_count(i);
-        EXPECT_GE(count, (int)(COUNT * 0.4));
-    }
-}
-UCS_TEST_P(test_async_timer_mt, multithread) {
-    const int exp_min_count = (int)(COUNT * 0.10);
-    int min_count = 0;
-    for (int r = 0; r < TIMER_RETRIES; ++r) {
-        spawn();
-        suspend(2 * COUNT);
         stop();
 
-        min_count = std::numeric_limits<int>::max();
         for (unsigned i = 0; i < NUM_THREADS; ++i) {
             int count = thread_count(i);
-            min_count = ucs_min(count, min_count);
+            EXPECT_GE(count, (int)(COUNT * 0.4));
         }
-        if (min_count >= exp_min_count) {
-            break;
+    }
+};
+
+class test_async_timer_mt : public test_async_mt<local_timer> {
+protected:
+    void test_multithread() {
+        const int exp_min_count = (int)(COUNT * 0.10);
+        int min_count = 0;
+        for (int r = 0; r < TIMER_RETRIES; ++r) {
+            spawn();
+            suspend(2 * COUNT);
+            stop();
+
+            min_count = std::numeric_limits<int>::max();
+            for (unsigned i = 0; i < NUM_THREADS; ++i) {
+                int count = thread_count(i);
+                min_count = ucs_min(count, min_count);
+            }
+            if (min_count >= exp_min_count) {
+                break;
+            }
         }
+        EXPECT_GE(min_count, exp_min_count);
     }
-    EXPECT_GE(min_count, exp_min_count);
+};
+
+UCS_TEST_P(test_async_event_mt, multithread) {
+    test_multithread();
+}
+
+UCS_TEST_P(test_async_event_mt, multithread_async_threads, "ASYNC_THREADS=4") {
+    test_multithread();
+}
+
+UCS_TEST_P(test_async_event_mt, multithread_affinity, "ASYNC_THREADS=4",
+           "ASYNC_THREAD_ASSIGN=affinity", "ASYNC_THREAD_CPUS=0,0-1") {
+    test_multithread();
+}
+
+UCS_TEST_P(test_async_timer_mt, multithread) {
+    test_multithread();
+}
+
+UCS_TEST_P(test_async_timer_mt, multithread_async_threads, "ASYNC_THREADS=4") {
+    test_multithread();
 }
 
 INSTANTIATE_TEST_CASE_P(signal,          test_async, ::testing::Values(UCS_ASYNC_MODE_SIGNAL));
@@ -147,6 +147,11 @@ protected:
             ucs_config_parser_set_value(&m_opts, car_opts_table, name, value);
         }
 
+        ucs_status_t apply_file(const char *env_prefix, const char *filename) {
+            return ucs_config_parser_apply_file(&m_opts, car_opts_table,
+                                                env_prefix, filename);
+        }
+
         const char* get(const char *name) {
             ucs_status_t status = ucs_config_parser_get_value(&m_opts,
                                                               car_opts_table,
@@ -181,6 +186,33 @@ protected:
         const size_t m_max;
         char         *m_value;
     };
+
+    /*
+     * Temporary configuration file, removed when going out of scope.
+     */
+    class config_file {
+    public:
+        config_file(const std::string& contents) {
+            char name[] = "/tmp/ucx_test_config_XXXXXX";
+            int fd = mkstemp(name);
+            EXPECT_GE(fd, 0);
+            EXPECT_EQ((ssize_t)contents.size(),
+                      write(fd, contents.c_str(), contents.size()));
+            close(fd);
+            m_name = name;
+        }
+
+        ~config_file() {
+            unlink(m_name.c_str());
+        }
+
+        const char *name() const {
+            return m_name.c_str();
+        }
+
+    private:
+        std::string m_name;
+    };
 };
 
 UCS_TEST_F(test_config, parse_default) {
@@ -256,6 +288,52 @@ UCS_TEST_F(test_config, set_get_with_env_prefix) {
               std::string(opts.get("COLOR")));
 }
 
+UCS_TEST_F(test_config, apply_file) {
+    config_file file("# tuned values\n"
+                     "\n"
+                     "UCX_COLOR=white\n"
+                     "  export UCX_PRICE = 100 \n"
+                     "UCX_MODEL=\"Model T\"\n"
+                     "UCX_ENGINE_VOLUME=3000\n"
+                     "UCX_TEST_VIN=42\n"
+                     "UCX_WHEELS=4\n");
+    /* coverity[tainted_string_argument] */
+    ucs::scoped_setenv env1("UCX_ENGINE_VOLUME", "5000");
+
+    car_opts opts("TEST", NULL);
+    ASSERT_UCS_OK(opts.apply_file("TEST", file.name()));
+    EXPECT_EQ((unsigned)COLOR_WHITE, opts->color);
+    EXPECT_EQ(100u, opts->price);
+    EXPECT_EQ(std::string("Model T"), opts->model);
+    EXPECT_EQ(42ul, opts->vin);
+    /* The environment takes precedence over the file */
+    EXPECT_EQ(5000u, opts->engine.volume);
+    /* Unchanged */
+    EXPECT_EQ(std::string("Chevy"), opts->brand);
+}
+
+UCS_TEST_F(test_config, apply_file_missing) {
+    car_opts opts(NULL, NULL);
+    ASSERT_UCS_OK(opts.apply_file(NULL, "/nonexistent/ucx.conf"));
+    EXPECT_EQ((unsigned)COLOR_RED, opts->color);
+}
+
+UCS_TEST_F(test_config, apply_file_invalid) {
+    car_opts opts(NULL, NULL);
+
+    {
+        config_file file("UCX_COLOR=purple\n");
+        scoped_log_handler wrap_err(wrap_errors_logger);
+        EXPECT_EQ(UCS_ERR_INVALID_PARAM, opts.apply_file(NULL, file.name()));
+    }
+
+    {
+        config_file file("COLOR\n");
+        scoped_log_handler wrap_err(wrap_errors_logger);
+        EXPECT_EQ(UCS_ERR_INVALID_PARAM, opts.apply_file(NULL, file.name()));
+    }
+}
+
 UCS_TEST_F(test_config, performance) {
 
     /* Add stuff to env to presumably make getenv() slower */
@@ -8,6 +8,10 @@ extern "C" {
 #include <ucs/debug/log.h>
 }
 
+#include <sys/wait.h>
+#include <pthread.h>
+#include <fstream>
+
 class log_test : public ucs::test {
 
 public:
@@ -101,3 +105,120 @@ UCS_TEST_F(log_test_print, print_off) {
     ucs_print("debug message");
 }
 
+
+
+class log_test_async : public log_test {
+public:
+    virtual void init() {
+        log_test::init();
+        reinit_log("LOG_ASYNC", "y");
+    }
+
+protected:
+    void reinit_log(const std::string& name, const std::string& value) {
+        ucs_log_cleanup();
+        modify_config(name, value);
+        ucs_log_init();
+    }
+
+    virtual void check_log_file() {
+        std::ifstream f(logfile);
+        std::string contents((std::istreambuf_iterator<char>(f)),
+                             std::istreambuf_iterator<char>());
+        for (std::vector<std::string>::iterator iter = m_expected.begin();
+             iter != m_expected.end(); ++iter) {
+            if (contents.find(*iter) == std::string::npos) {
+                ADD_FAILURE() << "'" << *iter << "' not found in log";
+            }
+        }
+    }
+
+    void expect(const char *fmt, ...) {
+        char buf[256];
+        va_list ap;
+
+        va_start(ap, fmt);
+        vsnprintf(buf, sizeof(buf), fmt, ap);
+        va_end(ap);
+        m_expected.push_back(std::string("UCX  INFO  ") + buf);
+    }
+
+    static void *thread_func(void *arg) {
+        ucs_info("message from thread %d", (int)(uintptr_t)arg);
+        return NULL;
+    }
+
+    std::vector<std::string> m_expected;
+};
+
+UCS_TEST_F(log_test_async, formats) {
+    const char *str = "async string";
+    void *ptr       = &str;
+
+    ucs_info("integers %d %5u %-3x %lu %lld %zu %hhd", -1, 17u, 0xau, 1ul << 40,
+             -5ll, (size_t)123, 7);
+    expect("integers %d %5u %-3x %lu %lld %zu %hhd", -1, 17u, 0xau, 1ul << 40,
+           -5ll, (size_t)123, 7);
+
+    ucs_info("double %.3f %e %g", 3.14159, 2.5e10, 0.5);
+    expect("double %.3f %e %g", 3.14159, 2.5e10, 0.5);
+
+    ucs_info("string '%s' '%10s' '%.5s' '%.*s' '%*d'", str, "pad", str, 3, str,
+             6, 42);
+    expect("string '%s' '%10s' '%.5s' '%.*s' '%*d'", str, "pad", str, 3, str,
+           6, 42);
+
+    ucs_info("pointer %p percent %% char %c", ptr, 'z');
+    expect("pointer %p percent %% char %c", ptr, 'z');
+
+    for (int i = 0; i < 100; ++i) {
+        ucs_info("iteration %d", i);
+    }
+    expect("iteration %d", 99);
+}
+
+UCS_TEST_F(log_test_async, multi_thread) {
+    static const int NUM_THREADS = 4;
+    std::vector<pthread_t> threads(NUM_THREADS);
+
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        int ret = pthread_create(&threads[i], NULL, thread_func,
+                                 reinterpret_cast<void*>(i));
+        ASSERT_EQ(0, ret);
+        expect("message from thread %d", i);
+    }
+
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+UCS_TEST_F(log_test_async, dropped) {
+    reinit_log("LOG_ASYNC_BUFFER", "4k");
+
+    /* Fill the buffer faster than the logging thread can drain it */
+    for (int i = 0; i < 10000; ++i) {
+        ucs_info("fill message number %d with some payload %s", i,
+                 "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx");
+    }
+    m_expected.push_back("log messages were dropped");
+}
+
+UCS_TEST_F(log_test_async, fork) {
+    ucs_info("message from parent");
+    expect("message from parent");
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        /* Must not wait for the logging thread of the parent */
+        ucs_info("message from child");
+        ucs_log_cleanup();
+        _exit(0);
+    }
+
+    ASSERT_GT(pid, 0);
+    int status;
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    EXPECT_TRUE(WIFEXITED(status));
+    expect("message from child");
+}
@@ -16,7 +16,9 @@ extern "C" {
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <limits>
+#include <vector>
 
 
 #if ENABLE_MEMTRACK
@@ -47,6 +49,24 @@ protected:
         EXPECT_EQ(peak_count, total.peak_count);
         EXPECT_EQ(peak_size,  total.peak_size);
     }
+
+    void reinit(const std::string& name, const std::string& value) {
+        ucs_memtrack_cleanup();
+        modify_config(name, value);
+        ucs_memtrack_init();
+    }
+
+    static void *alloc_thread_func(void *arg) {
+        std::vector<void*> ptrs(*(unsigned*)arg);
+
+        for (unsigned i = 0; i < ptrs.size(); ++i) {
+            ptrs[i] = ucs_malloc(ALLOC_SIZE, ALLOC_NAME);
+        }
+        for (unsigned i = 0; i < ptrs.size(); ++i) {
+            ucs_free(ptrs[i]);
+        }
+        return NULL;
+    }
 };
 
 const char test_memtrack::ALLOC_NAME[] = "memtrack_test";
@@ -201,4 +221,59 @@ UCS_TEST_F(test_memtrack, custom) {
     test_total(1, ALLOC_SIZE);
 }
 
+UCS_TEST_F(test_memtrack, multi_thread) {
+    static const unsigned NUM_THREADS = 8;
+    unsigned num_allocs               = 1000 / ucs::test_time_multiplier();
+    pthread_t threads[NUM_THREADS];
+    ucs_memtrack_entry_t total;
+
+    for (unsigned i = 0; i < NUM_THREADS; ++i) {
+        pthread_create(&threads[i], NULL, alloc_thread_func, &num_allocs);
+    }
+    for (unsigned i = 0; i < NUM_THREADS; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    ucs_memtrack_total(&total);
+    EXPECT_EQ(0lu, total.count);
+    EXPECT_EQ(0lu, total.size);
+    EXPECT_GE(NUM_THREADS * num_allocs, total.peak_count);
+    EXPECT_LE(num_allocs, total.peak_count);
+    EXPECT_GE(NUM_THREADS * num_allocs * ALLOC_SIZE, total.peak_size);
+    EXPECT_LE(num_allocs * ALLOC_SIZE, total.peak_size);
+}
+
+UCS_TEST_F(test_memtrack, sample) {
+    static const unsigned NUM_ALLOCS = 100;
+    static const unsigned SAMPLE     = 10;
+    std::vector<void*> ptrs(NUM_ALLOCS);
+    ucs_memtrack_entry_t total;
+    char *buf;
+    size_t size;
+
+    reinit("MEMTRACK_SAMPLE", ucs::to_string(SAMPLE));
+
+    for (unsigned i = 0; i < NUM_ALLOCS; ++i) {
+        ptrs[i] = ucs_malloc(ALLOC_SIZE, ALLOC_NAME);
+    }
+
+    ucs_memtrack_total(&total);
+    EXPECT_EQ(NUM_ALLOCS / SAMPLE, total.count);
+
+    {
+        FILE* tempf = open_memstream(&buf, &size);
+        ucs_memtrack_dump(tempf);
+        fclose(tempf);
+    }
+
+    EXPECT_NE((void *)NULL, strstr(buf, "call sites"));
+    free(buf);
+
+    for (unsigned i = 0; i < NUM_ALLOCS; ++i) {
+        ucs_free(ptrs[i]);
+    }
+
+    test_total(NUM_ALLOCS / SAMPLE, NUM_ALLOCS / SAMPLE * ALLOC_SIZE);
+}
+
 #endif
@@ -11,6 +11,7 @@ extern "C" {
 #include <ucs/profile/profile.h>
 }
 
+#include <pthread.h>
 #include <fstream>
 #include <set>
 
@@ -56,6 +57,10 @@ public:
     void test_header(ucs_profile_header_t *hdr, unsigned exp_mode);
     void test_locations(ucs_profile_location_t *locations, unsigned num_locations,
                         uint64_t exp_count);
+    void test_records(ucs_profile_location_t *locations, unsigned num_locations,
+                      ucs_profile_record_t *records, uint64_t num_records);
+
+    static void *profile_thread_func(void *arg);
 };
 
 const char* test_profile::UCS_PROFILE_FILENAME = "test.prof";
@@ -90,6 +95,7 @@ void test_profile::test_header(ucs_profile_header_t *hdr, unsigned exp_mode)
 {
     EXPECT_EQ(std::string(ucs_get_host_name()), std::string(hdr->hostname));
     EXPECT_EQ(getpid(),                         (pid_t)hdr->pid);
+    EXPECT_EQ(UCS_PROFILE_FILE_VERSION,         hdr->version);
     EXPECT_EQ(exp_mode,                         hdr->mode);
     EXPECT_NEAR(hdr->one_second / ucs_time_from_sec(1.0), 1.0, 0.01);
 }
@@ -117,6 +123,38 @@ void test_profile::test_locations(ucs_profile_location_t *locations,
     EXPECT_NE(loc_names.end(), loc_names.find("work"));
 }
 
+void test_profile::test_records(ucs_profile_location_t *locations,
+                                unsigned num_locations,
+                                ucs_profile_record_t *records,
+                                uint64_t num_records)
+{
+    uint64_t prev_ts = records[0].timestamp;
+    for (uint64_t i = 0; i < num_records; ++i) {
+        ucs_profile_record_t *rec = &records[i];
+        EXPECT_GE(rec->location, 0u);
+        EXPECT_LT(rec->location, num_locations);
+        EXPECT_GE(rec->timestamp, prev_ts);
+        prev_ts = rec->timestamp;
+        ucs_profile_location_t *loc = &locations[rec->location];
+        if ((loc->type == UCS_PROFILE_TYPE_REQUEST_NEW) ||
+            (loc->type == UCS_PROFILE_TYPE_REQUEST_EVENT) ||
+            (loc->type == UCS_PROFILE_TYPE_REQUEST_FREE))
+        {
+            EXPECT_EQ((uintptr_t)&test_request, rec->param64);
+        }
+    }
+}
+
+void *test_profile::profile_thread_func(void *arg)
+{
+    int iter = *(int*)arg;
+    for (int i = 0; i < iter; ++i) {
+        profile_test_func1();
+        profile_test_func2(1, 2);
+    }
+    return NULL;
+}
+
 UCS_TEST_F(test_profile, accum) {
     scoped_profile p(*this, UCS_PROFILE_FILENAME, "accum");
     profile_test_func1();
@@ -127,11 +165,23 @@ UCS_TEST_F(test_profile, accum) {
     test_header(hdr, UCS_BIT(UCS_PROFILE_MODE_ACCUM));
 
     EXPECT_EQ(12u, hdr->num_locations);
-    test_locations(reinterpret_cast<ucs_profile_location_t*>(hdr + 1),
-                   hdr->num_locations,
-                   1);
+    ucs_profile_location_t *locations = reinterpret_cast<ucs_profile_location_t*>(hdr + 1);
+    test_locations(locations, hdr->num_locations, 1);
+
+    EXPECT_EQ(1u, hdr->num_threads);
+    ucs_profile_thread_header_t *thread_hdr =
+                    reinterpret_cast<ucs_profile_thread_header_t*>(locations +
+                                                                   hdr->num_locations);
+    EXPECT_EQ(ucs_get_tid(), (pid_t)thread_hdr->tid);
+    EXPECT_EQ(0u, thread_hdr->num_records);
+    EXPECT_GE(thread_hdr->end_time, thread_hdr->start_time);
 
-    EXPECT_EQ(0u, hdr->num_records);
+    ucs_profile_thread_location_t *thread_locations =
+                    reinterpret_cast<ucs_profile_thread_location_t*>(thread_hdr + 1);
+    for (unsigned i = 0; i < hdr->num_locations; ++i) {
+        EXPECT_EQ(locations[i].count,      thread_locations[i].count);
+        EXPECT_EQ(locations[i].total_time, thread_locations[i].total_time);
+    }
 }
 
 UCS_TEST_F(test_profile, log) {
@@ -150,24 +200,65 @@ UCS_TEST_F(test_profile, log) {
     ucs_profile_location_t *locations = reinterpret_cast<ucs_profile_location_t*>(hdr + 1);
     test_locations(locations, hdr->num_locations, 0);
 
-    EXPECT_EQ(12 * ITER, (int)hdr->num_records);
-    ucs_profile_record_t *records = reinterpret_cast<ucs_profile_record_t*>(locations +
-                                                                            hdr->num_locations);
-    uint64_t prev_ts = records[0].timestamp;
-    for (uint64_t i = 0; i < hdr->num_records; ++i) {
-        ucs_profile_record_t *rec = &records[i];
-        EXPECT_GE(rec->location, 0u);
-        EXPECT_LT(rec->location, 12u);
-        EXPECT_GE(rec->timestamp, prev_ts);
-        prev_ts = rec->timestamp;
-        ucs_profile_location_t *loc = &locations[rec->location];
-        if ((loc->type == UCS_PROFILE_TYPE_REQUEST_NEW) ||
-            (loc->type == UCS_PROFILE_TYPE_REQUEST_EVENT) ||
-            (loc->type == UCS_PROFILE_TYPE_REQUEST_FREE))
-        {
-            EXPECT_EQ((uintptr_t)&test_request, rec->param64);
+    EXPECT_EQ(1u, hdr->num_threads);
+    ucs_profile_thread_header_t *thread_hdr =
+                    reinterpret_cast<ucs_profile_thread_header_t*>(locations +
+                                                                   hdr->num_locations);
+    EXPECT_EQ(ucs_get_tid(), (pid_t)thread_hdr->tid);
+    EXPECT_EQ(12 * ITER, (int)thread_hdr->num_records);
+    test_records(locations, hdr->num_locations,
+                 reinterpret_cast<ucs_profile_record_t*>(thread_hdr + 1),
+                 thread_hdr->num_records);
+}
+
+UCS_TEST_F(test_profile, log_multi_thread) {
+    static const int ITER        = 5;
+    static const int NUM_THREADS = 4;
+    scoped_profile p(*this, UCS_PROFILE_FILENAME, "log,accum");
+    std::vector<pthread_t> threads(NUM_THREADS);
+    int iter = ITER;
+
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        int ret = pthread_create(&threads[i], NULL, profile_thread_func, &iter);
+        ASSERT_EQ(0, ret);
+    }
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    std::string data = p.read();
+    ucs_profile_header_t *hdr = reinterpret_cast<ucs_profile_header_t*>(&data[0]);
+    test_header(hdr, UCS_BIT(UCS_PROFILE_MODE_LOG) | UCS_BIT(UCS_PROFILE_MODE_ACCUM));
+
+    EXPECT_EQ(12u, hdr->num_locations);
+    ucs_profile_location_t *locations = reinterpret_cast<ucs_profile_location_t*>(hdr + 1);
+    test_locations(locations, hdr->num_locations, ITER * NUM_THREADS);
+
+    EXPECT_EQ((unsigned)NUM_THREADS, hdr->num_threads);
+    char *ptr = reinterpret_cast<char*>(locations + hdr->num_locations);
+    std::set<uint32_t> tids;
+    for (unsigned i = 0; i < hdr->num_threads; ++i) {
+        ucs_profile_thread_header_t *thread_hdr =
+                        reinterpret_cast<ucs_profile_thread_header_t*>(ptr);
+        tids.insert(thread_hdr->tid);
+        EXPECT_EQ(12 * ITER, (int)thread_hdr->num_records);
+
+        ucs_profile_thread_location_t *thread_locations =
+                        reinterpret_cast<ucs_profile_thread_location_t*>(thread_hdr + 1);
+        for (unsigned j = 0; j < hdr->num_locations; ++j) {
+            EXPECT_EQ((size_t)ITER, thread_locations[j].count);
         }
+
+        ucs_profile_record_t *records =
+                        reinterpret_cast<ucs_profile_record_t*>(thread_locations +
+                                                                hdr->num_locations);
+        test_records(locations, hdr->num_locations, records,
+                     thread_hdr->num_records);
+        ptr = reinterpret_cast<char*>(records + thread_hdr->num_records);
     }
+
+    EXPECT_EQ((size_t)NUM_THREADS, tids.size());
+    EXPECT_EQ(&data[0] + data.size(), ptr);
 }
 
 #endif
@@ -216,6 +216,53 @@ UCS_MT_TEST_F(test_rcache, basic, 10) {
     free(ptr);
 }
 
+UCS_TEST_F(test_rcache, counters, "RCACHE_COUNTERS=y") {
+    static const size_t size = 1 * 1024 * 1024;
+    ucs_rcache_counters_t start, end;
+    region *region;
+    void *ptr;
+
+    ucs_rcache_get_counters(&start);
+
+    ptr = alloc_pages(size, PROT_READ|PROT_WRITE);
+    region = get(ptr, size); /* miss */
+    put(region);
+    region = get(ptr, size); /* hit */
+    put(region);
+    munmap(ptr, size);
+
+    /* unmap invalidation is deferred to the next lookup miss */
+    ptr = alloc_pages(size, PROT_READ|PROT_WRITE);
+    region = get(ptr, size);
+    put(region);
+    munmap(ptr, size);
+
+    ucs_rcache_get_counters(&end);
+    EXPECT_EQ(3u, end.gets - start.gets);
+    EXPECT_EQ(1u, end.hits - start.hits);
+    EXPECT_EQ(2u, end.regs - start.regs);
+    EXPECT_EQ(1u, end.invalidations - start.invalidations);
+    EXPECT_GE(end.reg_time, start.reg_time);
+}
+
+UCS_TEST_F(test_rcache, counters_disabled, "RCACHE_COUNTERS=n") {
+    static const size_t size = 1 * 1024 * 1024;
+    ucs_rcache_counters_t start, end;
+    region *region;
+    void *ptr;
+
+    ucs_rcache_get_counters(&start);
+
+    ptr = alloc_pages(size, PROT_READ|PROT_WRITE);
+    region = get(ptr, size);
+    put(region);
+    munmap(ptr, size);
+
+    ucs_rcache_get_counters(&end);
+    EXPECT_EQ(start.gets, end.gets);
+    EXPECT_EQ(start.regs, end.regs);
+}
+
 UCS_MT_TEST_F(test_rcache, get_unmapped, 6) {
     /*
      *  - allocate, get, put, get again -> should be same id
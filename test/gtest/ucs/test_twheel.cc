@@ -246,3 +246,71 @@ UCS_TEST_F(twheel, delayed_sweep) {
     }
 }
 
+
+UCS_TEST_F(twheel, multi_level) {
+    const ucs_time_t max_ticks = UCS_BIT(3 * UCS_TWHEEL_LEVEL_BITS);
+    std::vector<struct hr_timer> t(N_TIMERS / 10);
+    std::vector<bool> fired(t.size(), false);
+    ucs_time_t now = m_wheel.now;
+    ucs_time_t step;
+    unsigned num_fired;
+
+    init_timerv(&t[0], t.size());
+    for (unsigned i = 0; i < t.size(); i++) {
+        t[i].d          = m_wheel.res * (1 + (ucs::rand() % max_ticks));
+        t[i].end_time   = 0;
+        t[i].start_time = now;
+        ASSERT_EQ(UCS_OK, ucs_wtimer_add(&m_wheel, &t[i].timer, t[i].d));
+    }
+
+    /* advance the time by random steps, and check every timer fired in the
+     * first sweep after its expiration time */
+    num_fired = 0;
+    do {
+        step = 1 + (ucs::rand() % UCS_TWHEEL_LEVEL_SLOTS);
+        now += step * m_wheel.res;
+        ucs_twheel_sweep(&m_wheel, now);
+
+        for (unsigned i = 0; i < t.size(); i++) {
+            if (fired[i]) {
+                continue;
+            } else if (t[i].end_time == 0) {
+                EXPECT_GT(t[i].start_time + t[i].d, now) << "timer " << i;
+                continue;
+            }
+
+            fired[i] = true;
+            ++num_fired;
+            EXPECT_GE(t[i].end_time - t[i].start_time, t[i].d) << "timer " << i;
+            EXPECT_LT(t[i].end_time - t[i].start_time,
+                      t[i].d + step * m_wheel.res) << "timer " << i;
+        }
+    } while ((num_fired < t.size()) && !HasFailure());
+}
+
+UCS_TEST_F(twheel, remove) {
+    std::vector<struct hr_timer> t(N_TIMERS);
+
+    init_timerv(&t[0], N_TIMERS);
+    for (int i = 0; i < N_TIMERS; i++) {
+        set_timer_delta(&t[i], i);
+        t[i].d *= 1 + (i % 100);
+        add_timer(&t[i]);
+    }
+
+    for (int i = 0; i < N_TIMERS; i += 2) {
+        ucs_wtimer_remove(&t[i].timer);
+    }
+
+    /* one sweep after a long idle time */
+    ucs_twheel_sweep(&m_wheel, m_wheel.now + m_wheel.res *
+                     UCS_BIT(UCS_TWHEEL_LEVEL_BITS * UCS_TWHEEL_NUM_LEVELS));
+
+    for (int i = 0; i < N_TIMERS; i++) {
+        if (i % 2) {
+            EXPECT_NE(t[i].end_time, (ucs_time_t)0);
+        } else {
+            EXPECT_EQ(t[i].end_time, (ucs_time_t)0);
+        }
+    }
+}
@@ -12,6 +12,8 @@ extern "C" {
 #include <ucs/sys/sys.h>
 #include <ucs/sys/string.h>
 }
+#include <sys/mman.h>
+#include <sys/wait.h>
 #include <linux/sockios.h>
 #include <net/if_arp.h>
 #include <ifaddrs.h>
@@ -531,6 +533,7 @@ UCS_TEST_P(test_md, sockaddr_accessibility) {
                    cma, \
                    posix, \
                    sysv, \
+                   memfd, \
                    xpmem, \
                    cuda_cpy, \
                    cuda_ipc, \
@@ -543,3 +546,238 @@ UCS_TEST_P(test_md, sockaddr_accessibility) {
 
 UCT_MD_INSTANTIATE_TEST_CASE(test_md)
 
+
+class test_md_memfd : public test_md {
+protected:
+    virtual void init() {
+        modify_config("ENABLE", "y", false);
+        modify_config("HOOK_MMAP", "y", false);
+        test_md::init();
+    }
+
+    void *map_anon(size_t length) {
+        void *address = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        EXPECT_NE(MAP_FAILED, address);
+        return address;
+    }
+
+    static void expect_value(const void *address, size_t length, char value) {
+        const char *ptr = (const char*)address;
+        for (size_t i = 0; i < length; ++i) {
+            ASSERT_EQ(value, ptr[i]) << "offset " << i;
+        }
+    }
+};
+
+UCS_TEST_P(test_md_memfd, reg_rkey_ptr) {
+    const size_t size = 1024 * 1024;
+    uct_rkey_bundle_t rkey_bundle;
+    ucs_status_t status;
+    uct_mem_h memh;
+    char *address, *lva;
+
+    check_caps(UCT_MD_FLAG_REG | UCT_MD_FLAG_RKEY_PTR, "registration");
+
+    address = (char*)map_anon(size);
+    memset(address, 0x11, size);
+
+    /* register a range which is not page aligned */
+    status = uct_md_mem_reg(md(), address + 100, size - 200,
+                            UCT_MD_MEM_ACCESS_ALL, &memh);
+    ASSERT_UCS_OK(status);
+
+    std::vector<char> rkey_buffer(md_attr().rkey_packed_size);
+    status = uct_md_mkey_pack(md(), memh, &rkey_buffer[0]);
+    ASSERT_UCS_OK(status);
+
+    status = uct_rkey_unpack(&rkey_buffer[0], &rkey_bundle);
+    ASSERT_UCS_OK(status);
+
+    status = uct_rkey_ptr(&rkey_bundle, (uintptr_t)address + 100, (void**)&lva);
+    ASSERT_UCS_OK(status);
+    EXPECT_NE(address + 100, lva);
+
+    /* the second mapping shares the same pages */
+    expect_value(lva, size - 200, 0x11);
+    memset(lva, 0x22, size - 200);
+    expect_value(address + 100, size - 200, 0x22);
+
+    uct_rkey_release(&rkey_bundle);
+    status = uct_md_mem_dereg(md(), memh);
+    ASSERT_UCS_OK(status);
+    munmap(address, size);
+}
+
+UCS_TEST_P(test_md_memfd, reg_unsupported) {
+    const size_t size = 1024 * 1024;
+    ucs_status_t status;
+    uct_mem_h memh;
+    char buffer[64];
+    char *address;
+
+    check_caps(UCT_MD_FLAG_REG, "registration");
+
+    status = uct_md_mem_reg(md(), buffer, sizeof(buffer),
+                            UCT_MD_MEM_ACCESS_ALL, &memh);
+    EXPECT_EQ(UCS_ERR_UNSUPPORTED, status);
+
+    /* a range which extends beyond the mapping */
+    address = (char*)map_anon(size);
+    status  = uct_md_mem_reg(md(), address, size + ucs_get_page_size(),
+                             UCT_MD_MEM_ACCESS_ALL, &memh);
+    EXPECT_EQ(UCS_ERR_UNSUPPORTED, status);
+    munmap(address, size);
+
+    /* read-only mappings are not shared */
+    address = (char*)mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS,
+                          -1, 0);
+    ASSERT_NE(MAP_FAILED, address);
+    status = uct_md_mem_reg(md(), address, size, UCT_MD_MEM_ACCESS_ALL, &memh);
+    EXPECT_EQ(UCS_ERR_UNSUPPORTED, status);
+    munmap(address, size);
+}
+
+UCS_TEST_P(test_md_memfd, private_semantics) {
+    const size_t size = 256 * 1024;
+    char *address, *grown;
+    uct_mem_h memh;
+
+    check_caps(UCT_MD_FLAG_REG, "registration");
+
+    /* memory is zero when it's mapped again at the same address */
+    address = (char*)map_anon(size);
+    memset(address, 0x33, size);
+    munmap(address, size);
+    address = (char*)mmap(address, size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+    ASSERT_NE(MAP_FAILED, address);
+    expect_value(address, size, 0);
+
+    /* memory is zero after MADV_DONTNEED */
+    memset(address, 0x44, size);
+    madvise(address, size / 2, MADV_DONTNEED);
+    expect_value(address, size / 2, 0);
+    expect_value(address + size / 2, size / 2, 0x44);
+
+    /* shrinking and growing with mremap() zeroes the released part, and the
+     * result can be registered unless it was moved */
+    ASSERT_EQ(address, mremap(address, size, size / 2, 0));
+    grown = (char*)mremap(address, size / 2, size, MREMAP_MAYMOVE);
+    ASSERT_NE(MAP_FAILED, grown);
+
+    expect_value(grown, size / 2, 0);
+    expect_value(grown + size / 2, size / 2, 0);
+    if (grown == address) {
+        ASSERT_UCS_OK(uct_md_mem_reg(md(), grown, size, UCT_MD_MEM_ACCESS_ALL,
+                                     &memh));
+        ASSERT_UCS_OK(uct_md_mem_dereg(md(), memh));
+    }
+    munmap(grown, size);
+}
+
+UCS_TEST_P(test_md_memfd, mremap_move) {
+    const size_t size = 256 * 1024;
+    ucs_status_t status;
+    char *address, *moved;
+    uct_mem_h memh;
+
+    check_caps(UCT_MD_FLAG_REG, "registration");
+
+    /* the second half of the mapping prevents the first half from growing in
+     * place, so mremap() moves it */
+    address = (char*)map_anon(2 * size);
+    memset(address, 0x55, size);
+    memset(address + size, 0x66, size);
+    moved = (char*)mremap(address, size, 2 * size, MREMAP_MAYMOVE);
+    ASSERT_NE(MAP_FAILED, moved);
+    EXPECT_NE(address, moved);
+
+    /* the moved range keeps its contents but is private now, and the pages of
+     * the second half are not released */
+    expect_value(moved, size, 0x55);
+    expect_value(moved + size, size, 0);
+    expect_value(address + size, size, 0x66);
+
+    status = uct_md_mem_reg(md(), moved, 2 * size, UCT_MD_MEM_ACCESS_ALL,
+                            &memh);
+    EXPECT_EQ(UCS_ERR_UNSUPPORTED, status);
+
+    ASSERT_UCS_OK(uct_md_mem_reg(md(), address + size, size,
+                                 UCT_MD_MEM_ACCESS_ALL, &memh));
+    ASSERT_UCS_OK(uct_md_mem_dereg(md(), memh));
+
+    munmap(moved, 2 * size);
+    munmap(address + size, size);
+}
+
+UCS_TEST_P(test_md_memfd, fork_private) {
+    const size_t size = 256 * 1024;
+    int status, pipefd[2];
+    char *address, dummy;
+    pid_t pid;
+
+    check_caps(UCT_MD_FLAG_REG, "registration");
+
+    address = (char*)map_anon(size);
+    memset(address, 0x77, size);
+    ASSERT_EQ(0, pipe(pipefd));
+
+    pid = fork();
+    if (pid == 0) {
+        /* the child sees the data from the time of fork(), and its own writes
+         * are not visible to the parent */
+        close(pipefd[1]);
+        if (read(pipefd[0], &dummy, 1) != 1) {
+            _exit(2);
+        }
+        for (size_t i = 0; i < size; ++i) {
+            if (address[i] != 0x77) {
+                _exit(1);
+            }
+        }
+        memset(address, 0x88, size);
+        _exit(0);
+    }
+
+    ASSERT_GE(pid, 0);
+    close(pipefd[0]);
+    memset(address, 0x99, size);
+    ASSERT_EQ(1, write(pipefd[1], "", 1));
+    close(pipefd[1]);
+
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(0, WEXITSTATUS(status));
+    expect_value(address, size, 0x99);
+    munmap(address, size);
+}
+
+_UCT_MD_INSTANTIATE_TEST_CASE(test_md_memfd, memfd)
+
+
+class test_md_memfd_disabled : public test_md {
+protected:
+    virtual void init() {
+        modify_config("ENABLE", "n", false);
+        modify_config("HOOK_MMAP", "y", false);
+        test_md::init();
+    }
+};
+
+UCS_TEST_P(test_md_memfd_disabled, no_transport) {
+    uct_tl_resource_desc_t *tl_resources;
+    unsigned num_tl_resources;
+    ucs_status_t status;
+
+    /* neither the memory domain nor the mm transport creates the shared file */
+    EXPECT_FALSE(md_attr().cap.flags & (UCT_MD_FLAG_ALLOC | UCT_MD_FLAG_REG |
+                                        UCT_MD_FLAG_RKEY_PTR));
+
+    status = uct_md_query_tl_resources(md(), &tl_resources, &num_tl_resources);
+    ASSERT_UCS_OK(status);
+    EXPECT_EQ(0u, num_tl_resources);
+    uct_release_tl_resource_list(tl_resources);
+}
+
+_UCT_MD_INSTANTIATE_TEST_CASE(test_md_memfd_disabled, memfd)
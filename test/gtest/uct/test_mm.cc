@@ -100,3 +100,167 @@ UCS_TEST_P(test_uct_mm, open_for_posix) {
 }
 
 _UCT_INSTANTIATE_TEST_CASE(test_uct_mm, mm)
+
+class test_uct_mm_bcast : public uct_test {
+public:
+    static const unsigned NUM_RECEIVERS = 3;
+    static const uint8_t  AM_ID         = 0;
+
+    struct receiver_ctx {
+        unsigned count;
+        unsigned errors;
+    };
+
+    struct pack_arg {
+        uint64_t sn;
+        size_t   length;
+    };
+
+    virtual void init() {
+        uct_test::init();
+
+        m_sender = uct_test::create_entity(0);
+        m_entities.push_back(m_sender);
+        check_caps(UCT_IFACE_FLAG_AM_BCAST_BCOPY | UCT_IFACE_FLAG_AM_SHORT |
+                   UCT_IFACE_FLAG_CB_SYNC);
+
+        for (unsigned i = 0; i < NUM_RECEIVERS; ++i) {
+            entity *e = uct_test::create_entity(0);
+            m_entities.push_back(e);
+            m_sender->connect(i, *e, 0);
+
+            m_ctx[i].count  = 0;
+            m_ctx[i].errors = 0;
+            uct_iface_set_am_handler(e->iface(), AM_ID, am_handler, &m_ctx[i],
+                                     0);
+        }
+    }
+
+    static size_t pack_cb(void *dest, void *arg) {
+        pack_arg *parg = (pack_arg*)arg;
+        uint8_t  *data = (uint8_t*)dest + sizeof(parg->sn);
+
+        *(uint64_t*)dest = parg->sn;
+        for (size_t i = sizeof(parg->sn); i < parg->length; ++i) {
+            *(data++) = (uint8_t)(parg->sn + i);
+        }
+        return parg->length;
+    }
+
+    static ucs_status_t am_handler(void *arg, void *data, size_t length,
+                                   unsigned flags) {
+        receiver_ctx *ctx  = (receiver_ctx*)arg;
+        const uint8_t *buf = (const uint8_t*)data + sizeof(uint64_t);
+        uint64_t sn;
+
+        /* the data is shared with the other receivers */
+        EXPECT_FALSE(flags & UCT_CB_PARAM_FLAG_DESC);
+
+        memcpy(&sn, data, sizeof(sn));
+        if (sn != ctx->count) {
+            ++ctx->errors;
+        }
+        for (size_t i = sizeof(sn); i < length; ++i) {
+            if (*(buf++) != (uint8_t)(sn + i)) {
+                ++ctx->errors;
+                break;
+            }
+        }
+        ++ctx->count;
+        return UCS_OK;
+    }
+
+    ssize_t bcast(uint64_t sn, size_t length) {
+        pack_arg arg = { sn, length };
+        return uct_iface_am_bcast_bcopy(m_sender->iface(), m_eps,
+                                        NUM_RECEIVERS, AM_ID, pack_cb, &arg, 0);
+    }
+
+    void set_eps() {
+        for (unsigned i = 0; i < NUM_RECEIVERS; ++i) {
+            m_eps[i] = m_sender->ep(i);
+        }
+    }
+
+    void wait_for_count(unsigned count) {
+        ucs_time_t deadline = ucs_get_time() +
+                              ucs_time_from_sec(DEFAULT_TIMEOUT_SEC);
+        bool done;
+
+        do {
+            progress();
+            done = true;
+            for (unsigned i = 0; i < NUM_RECEIVERS; ++i) {
+                done = done && (m_ctx[i].count >= count);
+            }
+        } while (!done && (ucs_get_time() < deadline));
+    }
+
+protected:
+    entity       *m_sender;
+    uct_ep_h     m_eps[NUM_RECEIVERS];
+    receiver_ctx m_ctx[NUM_RECEIVERS];
+};
+
+UCS_TEST_P(test_uct_mm_bcast, send_recv) {
+    const unsigned num_msgs = 1000 / ucs::test_time_multiplier();
+    size_t max_length       = m_sender->iface_attr().cap.am.max_bcopy;
+    ssize_t packed_len;
+
+    set_eps();
+    for (unsigned sn = 0; sn < num_msgs; ++sn) {
+        size_t length = sizeof(uint64_t) + (sn % (max_length - sizeof(uint64_t)));
+        do {
+            packed_len = bcast(sn, length);
+            if (packed_len == UCS_ERR_NO_RESOURCE) {
+                progress();
+            }
+        } while (packed_len == UCS_ERR_NO_RESOURCE);
+        ASSERT_EQ((ssize_t)length, packed_len);
+    }
+
+    wait_for_count(num_msgs);
+    for (unsigned i = 0; i < NUM_RECEIVERS; ++i) {
+        EXPECT_EQ(num_msgs, m_ctx[i].count) << "receiver " << i;
+        EXPECT_EQ(0u, m_ctx[i].errors) << "receiver " << i;
+    }
+}
+
+UCS_TEST_P(test_uct_mm_bcast, no_resource_all_or_nothing) {
+    const uint8_t fill_am_id = 1;
+    uint64_t hdr             = 0;
+    unsigned num_short       = 0;
+    ucs_status_t status;
+
+    uct_iface_set_am_handler(m_entities.at(1).iface(), fill_am_id,
+                             (uct_am_callback_t)ucs_empty_function_return_success,
+                             NULL, 0);
+
+    /* fill the FIFO of the first receiver only */
+    do {
+        status = uct_ep_am_short(m_sender->ep(0), fill_am_id, hdr, NULL, 0);
+        num_short += (status == UCS_OK);
+    } while (status == UCS_OK);
+    ASSERT_EQ(UCS_ERR_NO_RESOURCE, status);
+    ASSERT_GT(num_short, 0u);
+
+    set_eps();
+    EXPECT_EQ((ssize_t)UCS_ERR_NO_RESOURCE, bcast(0, sizeof(uint64_t)));
+
+    /* the other receivers must not get the message */
+    short_progress_loop();
+    for (unsigned i = 0; i < NUM_RECEIVERS; ++i) {
+        EXPECT_EQ(0u, m_ctx[i].count) << "receiver " << i;
+    }
+
+    /* once the FIFO is drained, every receiver gets the message exactly once */
+    EXPECT_EQ((ssize_t)sizeof(uint64_t), bcast(0, sizeof(uint64_t)));
+    wait_for_count(1);
+    short_progress_loop();
+    for (unsigned i = 0; i < NUM_RECEIVERS; ++i) {
+        EXPECT_EQ(1u, m_ctx[i].count) << "receiver " << i;
+        EXPECT_EQ(0u, m_ctx[i].errors) << "receiver " << i;
+    }
+}
+
+_UCT_INSTANTIATE_TEST_CASE(test_uct_mm_bcast, mm)
@@ -134,3 +134,69 @@ UCS_TEST_P(uct_p2p_rma_test, get_zcopy) {
 }
 
 UCT_INSTANTIATE_TEST_CASE(uct_p2p_rma_test)
+
+
+class uct_p2p_rma_test_cma_chunks : public uct_p2p_rma_test {
+protected:
+    /* Small put after a fence, to the tail of a large put which is still
+     * copied in chunks */
+    void test_put_fence() {
+        const size_t large_length = 256 * UCS_KBYTE;
+        const size_t small_length = UCS_KBYTE;
+        const size_t offset       = large_length - small_length;
+        mapped_buffer large_buf(large_length, SEED1, sender());
+        mapped_buffer small_buf(small_length, SEED2, sender());
+        mapped_buffer recvbuf(large_length, SEED3, receiver());
+        ucs_status_t status;
+
+        status = uct_ep_put_zcopy(sender_ep(), large_buf.iov(), 1,
+                                  recvbuf.addr(), recvbuf.rkey(), NULL);
+        EXPECT_EQ(UCS_INPROGRESS, status);
+
+        status = uct_ep_fence(sender_ep(), 0);
+        ASSERT_UCS_OK(status);
+
+        status = uct_ep_put_zcopy(sender_ep(), small_buf.iov(), 1,
+                                  recvbuf.addr() + offset, recvbuf.rkey(),
+                                  NULL);
+        ASSERT_UCS_OK_OR_INPROGRESS(status);
+
+        sender().flush();
+        mapped_buffer::pattern_check(recvbuf.ptr(), offset, SEED1);
+        mapped_buffer::pattern_check((char*)recvbuf.ptr() + offset,
+                                     small_length, SEED2);
+    }
+};
+
+UCS_TEST_P(uct_p2p_rma_test_cma_chunks, put_zcopy, "CHUNK_SIZE=4k") {
+    test_xfer_multi(static_cast<send_func_t>(&uct_p2p_rma_test::put_zcopy),
+                    1ul, 1024 * 1024, TEST_UCT_FLAG_SEND_ZCOPY);
+}
+
+UCS_TEST_P(uct_p2p_rma_test_cma_chunks, get_zcopy, "CHUNK_SIZE=4k") {
+    test_xfer_multi(static_cast<send_func_t>(&uct_p2p_rma_test::get_zcopy),
+                    1ul, 1024 * 1024, TEST_UCT_FLAG_RECV_ZCOPY);
+}
+
+UCS_TEST_P(uct_p2p_rma_test_cma_chunks, put_zcopy_threads, "CHUNK_SIZE=4k",
+           "NUM_THREADS=2") {
+    test_xfer_multi(static_cast<send_func_t>(&uct_p2p_rma_test::put_zcopy),
+                    1ul, 1024 * 1024, TEST_UCT_FLAG_SEND_ZCOPY);
+}
+
+UCS_TEST_P(uct_p2p_rma_test_cma_chunks, get_zcopy_threads, "CHUNK_SIZE=4k",
+           "NUM_THREADS=2") {
+    test_xfer_multi(static_cast<send_func_t>(&uct_p2p_rma_test::get_zcopy),
+                    1ul, 1024 * 1024, TEST_UCT_FLAG_RECV_ZCOPY);
+}
+
+UCS_TEST_P(uct_p2p_rma_test_cma_chunks, put_zcopy_fence, "CHUNK_SIZE=4k") {
+    test_put_fence();
+}
+
+UCS_TEST_P(uct_p2p_rma_test_cma_chunks, put_zcopy_fence_threads,
+           "CHUNK_SIZE=4k", "NUM_THREADS=2") {
+    test_put_fence();
+}
+
+_UCT_INSTANTIATE_TEST_CASE(uct_p2p_rma_test_cma_chunks, cma)